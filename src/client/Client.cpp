@@ -20,6 +20,7 @@
 #include "network/EntityRemoveHandler.h"
 #include "network/EntitySpawnHandler.h"
 #include "network/EntityUpdateHandler.h"
+#include "network/EntitySnapshotHandler.h"
 #include "network/UserSpawnHandler.h"
 #include "network/UserInfoHandler.h"
 #include "network/VarUpdateHandler.h"
@@ -160,6 +161,7 @@ app::AppState Client::onInit() {
 	r->registerHandler(network::ServerMsgType::EntitySpawn, std::make_shared<EntitySpawnHandler>());
 	r->registerHandler(network::ServerMsgType::EntityRemove, std::make_shared<EntityRemoveHandler>());
 	r->registerHandler(network::ServerMsgType::EntityUpdate, std::make_shared<EntityUpdateHandler>());
+	r->registerHandler(network::ServerMsgType::EntitySnapshot, std::make_shared<EntitySnapshotHandler>());
 	r->registerHandler(network::ServerMsgType::UserSpawn, std::make_shared<UserSpawnHandler>());
 	r->registerHandler(network::ServerMsgType::AuthFailed, std::make_shared<AuthFailedHandler>());
 	r->registerHandler(network::ServerMsgType::StartCooldown, std::make_shared<StartCooldownHandler>());
@@ -397,6 +399,11 @@ void Client::entitySpawn(frontend::ClientEntityId id, network::EntityType type,
 	_worldRenderer.entityMgr().addEntity(entity);
 }
 
+void Client::ackSnapshot(uint32_t sequence) {
+	// a lost acknowledge only leads to a bigger snapshot
+	_messageSender->sendClientMessage(_snapshotAckFbb, network::ClientMsgType::SnapshotAck, CreateSnapshotAck(_snapshotAckFbb, sequence).Union(), 0u);
+}
+
 void Client::entityRemove(frontend::ClientEntityId id) {
 	_worldRenderer.entityMgr().removeEntity(id);
 }
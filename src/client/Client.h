@@ -41,6 +41,7 @@ protected:
 	flatbuffers::FlatBufferBuilder _moveFbb;
 	frontend::PlayerMovement _movement;
 	flatbuffers::FlatBufferBuilder _actionFbb;
+	flatbuffers::FlatBufferBuilder _snapshotAckFbb;
 	frontend::PlayerAction _action;
 	client::CooldownHandler _cooldownHandler;
 	network::MoveDirection _lastMoveMask = network::MoveDirection::NONE;
@@ -115,6 +116,10 @@ public:
 
 	void entitySpawn(frontend::ClientEntityId id, network::EntityType type, float orientation, const glm::vec3& pos, animation::Animation animation);
 	void entityRemove(frontend::ClientEntityId id);
+	/**
+	 * @brief Tells the server that the entity snapshot with the given sequence was applied
+	 */
+	void ackSnapshot(uint32_t sequence);
 	frontend::ClientEntityPtr getEntity(frontend::ClientEntityId id) const;
 };
 
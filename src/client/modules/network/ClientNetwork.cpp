@@ -4,6 +4,7 @@
 
 #include "ServerMessages_generated.h"
 #include "ClientNetwork.h"
+#include "network/PacketFrame.h"
 #include "core/Log.h"
 
 namespace network {
@@ -12,23 +13,35 @@ ClientNetwork::ClientNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRe
 		Super(protocolHandlerRegistry, eventBus) {
 }
 
-bool ClientNetwork::packetReceived(ENetEvent& event) {
-	flatbuffers::Verifier v(event.packet->data, event.packet->dataLength);
+bool ClientNetwork::messageReceived(ENetPeer* peer, const uint8_t* data, size_t dataLength) {
+	flatbuffers::Verifier v(data, dataLength);
 
 	if (!VerifyServerMessageBuffer(v)) {
-		Log::error("Illegal server packet received with length: %i", (int)event.packet->dataLength);
+		Log::error("Illegal server message received with length: %i", (int)dataLength);
 		return false;
 	}
-	const ServerMessage *req = GetServerMessage(event.packet->data);
+	const ServerMessage *req = GetServerMessage(data);
 	ServerMsgType type = req->data_type();
 	const char *typeName = EnumNameServerMsgType(type);
-	ProtocolHandlerPtr handler = _protocolHandlerRegistry->getHandler(type);
-	if (!handler) {
+	IProtocolHandler* handler = _protocolHandlerRegistry->handler(type);
+	if (handler == nullptr) {
 		Log::error("No handler for server msg type %s", typeName);
 		return false;
 	}
 	Log::debug("Received %s", typeName);
-	handler->executeWithRaw(event.peer, req->data(), (const uint8_t*)event.packet->data, event.packet->dataLength);
+	handler->executeWithRaw(peer, req->data(), data, dataLength);
+	return true;
+}
+
+bool ClientNetwork::packetReceived(ENetEvent& event) {
+	// the server coalesces several messages into one packet
+	const bool valid = visitFrames(event.packet->data, event.packet->dataLength, [&] (const uint8_t* data, size_t dataLength) {
+		return messageReceived(event.peer, data, dataLength);
+	});
+	if (!valid) {
+		Log::error("Illegal server packet received with length: %i", (int)event.packet->dataLength);
+		return false;
+	}
 	return true;
 }
 
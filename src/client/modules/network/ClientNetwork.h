@@ -11,6 +11,8 @@ namespace network {
 class ClientNetwork : public AbstractClientNetwork {
 private:
 	using Super = AbstractClientNetwork;
+
+	bool messageReceived(ENetPeer* peer, const uint8_t* data, size_t dataLength);
 public:
 	ClientNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry, const core::EventBusPtr& eventBus);
 
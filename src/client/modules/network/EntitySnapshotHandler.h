@@ -0,0 +1,25 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "IClientProtocolHandler.h"
+#include "shared/EntityState.h"
+
+/**
+ * Updates all @c frontend::ClientEntity instances that changed since the last acknowledged snapshot
+ */
+CLIENTPROTOHANDLERIMPL(EntitySnapshot) {
+	for (const network::EntityState* state : *message->entities()) {
+		const frontend::ClientEntityPtr& entity = client->getEntity(state->id());
+		if (!entity) {
+			continue;
+		}
+		entity->setPosition(shared::dequantizePosition(*state));
+		entity->setOrientation(shared::dequantizeOrientation(state->rotation()));
+		// TODO: get all animations from server - the full array
+		entity->setAnimation(state->animation(), true);
+	}
+	client->ackSnapshot(message->sequence());
+}
@@ -12,6 +12,7 @@
 #include "network/ProtocolHandlerRegistry.h"
 
 #include "backend/network/ServerNetwork.h"
+#include "backend/network/ServerMessageSender.h"
 
 namespace backend {
 
@@ -29,6 +30,9 @@ protected:
 	network::ClientMessageSenderPtr _clientMessageSender;
 
 	network::ServerNetworkPtr _serverNetwork;
+	metric::MetricPtr _metric;
+	// the server side peer of the client connection
+	ENetPeer* _serverPeer = nullptr;
 
 	uint16_t _port;
 	const core::String _host = "127.0.0.1";
@@ -36,6 +40,7 @@ protected:
 	int _disconnectEvent = 0;
 	int _connectEvent = 0;
 	int _userConnectHandlerCalled = 0;
+	int _entityRemoveHandlerCalled = 0;
 public:
 	void SetUp() override {
 		_clientEventBus = std::make_shared<core::EventBus>();
@@ -43,8 +48,8 @@ public:
 		_protocolHandlerRegistry = core::make_shared<network::ProtocolHandlerRegistry>();
 		_clientNetwork = std::make_shared<network::ClientNetwork>(_protocolHandlerRegistry, _clientEventBus);
 		_clientMessageSender = std::make_shared<network::ClientMessageSender>(_clientNetwork);
-		const metric::MetricPtr& metric = std::make_shared<metric::Metric>();
-		_serverNetwork = std::make_shared<network::ServerNetwork>(_protocolHandlerRegistry, _serverEventBus, metric);
+		_metric = std::make_shared<metric::Metric>();
+		_serverNetwork = std::make_shared<network::ServerNetwork>(_protocolHandlerRegistry, _serverEventBus, _metric);
 		_port = (uint16_t)((uint32_t)(intptr_t)this) + 1025;
 		Super::SetUp();
 	}
@@ -95,8 +100,22 @@ public:
 		class UserConnectHandler: public network::IProtocolHandler {
 		private:
 			int *_called;
+			ENetPeer **_peer;
 		public:
-			UserConnectHandler(int *called) : _called(called) {
+			UserConnectHandler(int *called, ENetPeer **peer) : _called(called), _peer(peer) {
+			}
+
+			void executeWithRaw(ENetPeer* peer, const void* message, const uint8_t* rawData, size_t rawDataSize) override {
+				(*_called)++;
+				*_peer = peer;
+			}
+		};
+
+		class CountHandler: public network::IProtocolHandler {
+		private:
+			int *_called;
+		public:
+			CountHandler(int *called) : _called(called) {
 			}
 
 			void executeWithRaw(ENetPeer* peer, const void* message, const uint8_t* rawData, size_t rawDataSize) override {
@@ -106,12 +125,15 @@ public:
 
 		_serverNetwork->init();
 		const network::ProtocolHandlerRegistryPtr& r = _serverNetwork->registry();
-		r->registerHandler(network::ClientMsgType::UserConnect, std::make_shared<UserConnectHandler>(&_userConnectHandlerCalled));
+		r->registerHandler(network::ClientMsgType::UserConnect, std::make_shared<UserConnectHandler>(&_userConnectHandlerCalled, &_serverPeer));
+		r->registerHandler(network::ServerMsgType::EntityRemove, std::make_shared<CountHandler>(&_entityRemoveHandlerCalled));
 		_clientNetwork->init();
 
 		_disconnectEvent = 0;
 		_connectEvent = 0;
 		_userConnectHandlerCalled = 0;
+		_entityRemoveHandlerCalled = 0;
+		_serverPeer = nullptr;
 
 		return true;
 	}
@@ -139,4 +161,37 @@ TEST_F(ConnectTest, testConnect) {
 	EXPECT_EQ(1, _userConnectHandlerCalled);
 }
 
+TEST_F(ConnectTest, testCoalescedServerMessages) {
+	ASSERT_TRUE(listen()) << "Failed to bind to port " << _port;
+	ASSERT_TRUE(connect()) << "Failed to connect to port " << _port;
+	update();
+	ASSERT_NE(nullptr, _serverPeer) << "The client didn't connect";
+
+	network::ServerMessageSender sender(_serverNetwork, _metric);
+	const int messages = 16;
+	for (int i = 0; i < messages; ++i) {
+		auto fbb = sender.builder();
+		sender.sendServerMessage(_serverPeer, *fbb, network::ServerMsgType::EntityRemove, network::CreateEntityRemove(*fbb, i).Union());
+	}
+	EXPECT_EQ(0u, sender.packets()) << "The messages should be queued until they are flushed";
+	sender.flush();
+	EXPECT_EQ(1u, sender.packets()) << "The messages should have been coalesced into one packet";
+	EXPECT_EQ((uint64_t)messages, sender.messageStats(network::ServerMsgType::EntityRemove).count);
+	update();
+	EXPECT_EQ(messages, _entityRemoveHandlerCalled) << "Every message of the packet should have been dispatched";
+
+	// exceed the packet size - the messages must be split over several packets
+	for (int i = 0; i < messages * 8; ++i) {
+		auto fbb = sender.builder();
+		sender.sendServerMessage(_serverPeer, *fbb, network::ServerMsgType::EntityRemove, network::CreateEntityRemove(*fbb, i).Union());
+	}
+	sender.flush();
+	EXPECT_GT(sender.packets(), 2u);
+	EXPECT_LT(sender.packets(), 1u + messages * 8);
+	update();
+	EXPECT_EQ(messages * 9, _entityRemoveHandlerCalled);
+	_clientNetwork->disconnect();
+	update();
+}
+
 }
@@ -58,8 +58,9 @@ App::App(const metric::MetricPtr& metric, const io::FilesystemPtr& filesystem, c
 
 App::~App() {
 	core_trace_set(nullptr);
-	_metricSender->shutdown();
+	// the metrics are flushing the aggregated values on shutdown
 	_metric->shutdown();
+	_metricSender->shutdown();
 	Log::shutdown();
 	_threadPool = core::ThreadPoolPtr();
 }
@@ -254,6 +255,8 @@ AppState App::onConstruct() {
 	}
 
 	core::Var::get(cfg::MetricFlavor, "telegraf");
+	// the aggregation changes the wire format of timings and histograms - see metric::Metric
+	core::Var::get(cfg::MetricFlushInterval, "0");
 	const core::String& host = core::Var::get(cfg::MetricHost, "127.0.0.1")->strVal();
 	const int port = core::Var::get(cfg::MetricPort, "8125")->intVal();
 	_metricSender = std::make_shared<metric::UDPMetricSender>(host, port);
@@ -527,6 +530,7 @@ AppState App::onRunning() {
 		Log::debug("Remaining events in queue: %i", remaining);
 	}
 	_filesystem->update();
+	_metric->update();
 
 	return AppState::Cleanup;
 }
@@ -648,12 +652,12 @@ AppState App::onCleanup() {
 
 	core_trace_shutdown();
 
-	if (_metricSender) {
-		_metricSender->shutdown();
-	}
 	if (_metric) {
 		_metric->shutdown();
 	}
+	if (_metricSender) {
+		_metricSender->shutdown();
+	}
 
 	SDL_Quit();
 
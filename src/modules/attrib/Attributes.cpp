@@ -14,86 +14,153 @@ Attributes::Attributes(Attributes* parent) :
 		_dirty(false), _lock("Attributes"), _attribLock("Attributes2"), _parent(parent) {
 	_current.fill(0.0);
 	_max.fill(0.0);
+	_absolutes.fill(0.0);
+	_percentages.fill(0.0);
+	_parentAbsolutes.fill(0.0);
+	_parentPercentages.fill(0.0);
+}
+
+Attributes::TypeMask Attributes::typeMask(const Container& container) {
+	TypeMask mask = 0u;
+	const Values& abs = container.absolute();
+	const Values& rel = container.percentage();
+	for (int i = 0; i < MaxTypes; ++i) {
+		if (abs[i] != 0.0 || rel[i] != 0.0) {
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
+Attributes::TypeMask Attributes::updateParent(long dt) {
+	if (_parent == nullptr) {
+		return 0u;
+	}
+	_parent->update(dt);
+	const int revision = _parent->_revision;
+	if (revision == _parentRevision) {
+		return 0u;
+	}
+	_parentRevision = revision;
+	TypeMask types = 0u;
+	core::ScopedReadLock scopedLock(_parent->_attribLock);
+	for (int i = 0; i < MaxTypes; ++i) {
+		if (_parentAbsolutes[i] == _parent->_absolutes[i] && _parentPercentages[i] == _parent->_percentages[i]) {
+			continue;
+		}
+		_parentAbsolutes[i] = _parent->_absolutes[i];
+		_parentPercentages[i] = _parent->_percentages[i];
+		types |= 1u << i;
+	}
+	return types;
 }
 
 bool Attributes::update(long dt) {
 	core_trace_scoped(AttributesUpdates);
-	bool updated = false;
-	if (_parent != nullptr) {
-		updated = _parent->update(dt);
-		if (updated) {
-			_dirty = true;
+	const TypeMask parentTypes = updateParent(dt);
+	// check before the exchange - most of the instances are not dirty
+	const bool dirty = _dirty && _dirty.exchange(false);
+	if (dirty || parentTypes != 0u) {
+		TypeMask types = parentTypes;
+		if (dirty) {
+			core::ScopedWriteLock scopedLock(_lock);
+			types |= _dirtyTypes;
+			_dirtyTypes = 0u;
 		}
+		calculateMax(types);
 	}
-	if (!_dirty.exchange(false)) {
-		return updated;
+	if (_notify && _notify.exchange(false)) {
+		notifyListeners();
 	}
+	return dirty || parentTypes != 0u;
+}
 
-	Values max;
+void Attributes::calculateMax(TypeMask types) {
+	if (types == 0u) {
+		return;
+	}
+	int indices[MaxTypes];
+	int n = 0;
+	Values absolutes;
 	Values percentages;
-	calculateMax(max, percentages);
-
-	for (size_t i = 0; i < percentages.size(); ++i) {
-		if (max[i] <= glm::epsilon<double>()) {
-			continue;
+	for (int i = 0; i < MaxTypes; ++i) {
+		if (types & (1u << i)) {
+			indices[n++] = i;
+			absolutes[i] = _parentAbsolutes[i];
+			percentages[i] = _parentPercentages[i];
 		}
-		max[i] *= 1.0 + (percentages[i] * 0.01);
 	}
 
-	core::ScopedReadLock scopedLock(_attribLock);
-	if (!_listeners.empty()) {
-		for (size_t i = 0; i < max.size(); ++i) {
-			const double oldValue = _max[i];
-			const double newValue = max[i];
-			if (glm::abs(newValue - oldValue) <= glm::epsilon<double>()) {
-				continue;
-			}
-			const DirtyValue v{(Type)i, false, max[i]};
-			for (const auto& listener : _listeners) {
-				listener(v);
+	{
+		core::ScopedReadLock scopedLock(_lock);
+		for (const auto& e : _containers) {
+			const Container& c = e->value;
+			const double stackCount = c.stackCount();
+			const Values& abs = c.absolute();
+			const Values& rel = c.percentage();
+			for (int j = 0; j < n; ++j) {
+				const int i = indices[j];
+				absolutes[i] += abs[i] * stackCount;
+				percentages[i] += rel[i] * stackCount;
 			}
 		}
 	}
-	_max = max;
 
-	// cap your currents to the max allowed value
-	for (size_t i = 0; i < _current.size(); ++i) {
+	core::ScopedWriteLock scopedLock(_attribLock);
+	bool changed = false;
+	for (int j = 0; j < n; ++j) {
+		const int i = indices[j];
+		if (_absolutes[i] != absolutes[i] || _percentages[i] != percentages[i]) {
+			_absolutes[i] = absolutes[i];
+			_percentages[i] = percentages[i];
+			changed = true;
+		}
+		double max = absolutes[i];
+		if (max > glm::epsilon<double>()) {
+			max *= 1.0 + (percentages[i] * 0.01);
+		}
+		if (glm::abs(max - _max[i]) > glm::epsilon<double>()) {
+			_notifyMax |= 1u << i;
+		}
+		_max[i] = max;
+
+		// cap your currents to the max allowed value
 		const double old = _current[i];
-		_current[i] = core_min(_max[i], old);
+		_current[i] = core_min(max, old);
 		if (glm::abs(old - _current[i]) > glm::epsilon<double>()) {
-			const DirtyValue v{(Type)i, true, _current[i]};
-			for (const auto& listener : _listeners) {
-				listener(v);
-			}
+			_notifyCurrent |= 1u << i;
 		}
 	}
-	return true;
-}
-
-void Attributes::calculateMax(Values& absolutes, Values& percentages) const {
-	absolutes.fill(0.0);
-	percentages.fill(0.0);
-
-	if (_parent != nullptr) {
-		_parent->calculateMax(absolutes, percentages);
+	if (changed) {
+		++_revision;
 	}
-
-	Containers containers;
-	{
-		core::ScopedReadLock scopedLock(_lock);
-		containers = _containers;
+	if (_notifyMax != 0u || _notifyCurrent != 0u) {
+		_notify = true;
 	}
+}
 
-	for (const auto& e : containers) {
-		const Container& c = e->value;
-		const double stackCount = c.stackCount();
-		const Values& abs = c.absolute();
-		for (size_t i = 0; i < abs.size(); ++i) {
-			absolutes[i] += abs[i] * stackCount;
+void Attributes::notifyListeners() {
+	DirtyValue values[MaxTypes * 2];
+	int n = 0;
+	{
+		core::ScopedWriteLock scopedLock(_attribLock);
+		for (int i = 0; i < MaxTypes; ++i) {
+			if (_notifyMax & (1u << i)) {
+				values[n++] = DirtyValue{(Type)i, false, _max[i]};
+			}
 		}
-		const Values& rel = c.percentage();
-		for (size_t i = 0; i < rel.size(); ++i) {
-			percentages[i] += rel[i] * stackCount;
+		for (int i = 0; i < MaxTypes; ++i) {
+			if (_notifyCurrent & (1u << i)) {
+				values[n++] = DirtyValue{(Type)i, true, _current[i]};
+			}
+		}
+		_notifyMax = 0u;
+		_notifyCurrent = 0u;
+	}
+	// the listeners are called without holding the lock - they may query the values
+	for (int i = 0; i < n; ++i) {
+		for (const auto& listener : _listeners) {
+			listener(values[i]);
 		}
 	}
 }
@@ -103,10 +170,12 @@ bool Attributes::add(const Container& container) {
 	auto i = _containers.find(container.name());
 	if (i == _containers.end()) {
 		_containers.put(container.name(), container);
+		_dirtyTypes |= typeMask(container);
 		_dirty = true;
 		return true;
 	}
 	if (i->value.increaseStackCount()) {
+		_dirtyTypes |= typeMask(i->value);
 		_dirty = true;
 	}
 	return false;
@@ -141,6 +210,7 @@ void Attributes::remove(const core::String& name) {
 	if (i == _containers.end()) {
 		return;
 	}
+	_dirtyTypes |= typeMask(i->value);
 	_dirty = true;
 	if (i->value.decreaseStackCount()) {
 		return;
@@ -153,26 +223,15 @@ double Attributes::setCurrent(Type type, double value) {
 	const auto idx = core::enumVal(type);
 	const double max = _max[idx] <= glm::epsilon<double>() ? value : core_min(_max[idx], value);
 	_current[idx] = max;
-	const DirtyValue v{type, true, max};
-	for (const auto& listener : _listeners) {
-		listener(v);
-	}
+	_notifyCurrent |= 1u << idx;
+	_notify = true;
 	return max;
 }
 
 void Attributes::markAsDirty() {
-	for (size_t i = 0; i < _current.size(); ++i) {
-		const DirtyValue v{(Type)i, true, _current[i]};
-		for (const auto& listener : _listeners) {
-			listener(v);
-		}
-	}
-	for (size_t i = 0; i < _max.size(); ++i) {
-		const DirtyValue v{(Type)i, false, _max[i]};
-		for (const auto& listener : _listeners) {
-			listener(v);
-		}
-	}
+	core::ScopedWriteLock scopedLock(_attribLock);
+	_notifyCurrent = _notifyMax = (TypeMask)((1ull << MaxTypes) - 1u);
+	_notify = true;
 }
 
 }
@@ -53,7 +53,9 @@ namespace attrib {
  * would get 22 as a final result.
  *
  * The system takes care about updating values in the @c Attributes::update() method. Adding and removing
- * @c Container instances will set the dirty flag and will lead to a recalculation of the final values.
+ * @c Container instances will set the dirty flag and will lead to a recalculation of the final values of
+ * those types that the container provides values for. The listeners are notified in @c Attributes::update(),
+ * too - once per changed value, no matter how often it was changed since the last call.
  *
  * The max values that are calculated here are just one value that this system provides. There are also the
  * current values provided. Let's take hit points as an example. You will have your current hit points, and
@@ -69,19 +71,44 @@ namespace attrib {
  */
 class Attributes {
 protected:
+	static constexpr int MaxTypes = (int)Type::MAX + 1;
+	// one bit per attrib::Type
+	using TypeMask = uint32_t;
+	static_assert(MaxTypes <= 32, "The type mask is too small for the attribute types");
+
 	core::AtomicBool _dirty { false };
+	// set if there are listener notifications queued for the next update() call
+	core::AtomicBool _notify { false };
+	// incremented whenever the sums changed - the children compare this to find out whether they have to
+	// check the sums of their parent
+	core::AtomicInt _revision { 0 };
+	// the types that are affected by the containers that were added or removed since the last update()
+	TypeMask _dirtyTypes core_thread_guarded_by(_lock) = 0u;
 	Values _current core_thread_guarded_by(_attribLock);
 	Values _max core_thread_guarded_by(_attribLock);
+	// the sums of the absolute and percentage values of all containers - including the parent ones
+	Values _absolutes core_thread_guarded_by(_attribLock);
+	Values _percentages core_thread_guarded_by(_attribLock);
+	// the current and max values that changed since the last notification of the listeners
+	TypeMask _notifyCurrent core_thread_guarded_by(_attribLock) = 0u;
+	TypeMask _notifyMax core_thread_guarded_by(_attribLock) = 0u;
 	Containers _containers core_thread_guarded_by(_lock);
 	// keep them here for ref counting
 	core::StringMap<ContainerPtr> _containerPtrs;
 	core::ReadWriteLock _lock;
 	core::ReadWriteLock _attribLock;
 	Attributes* _parent;
+	// the sums of the parent at the time of the last update() call
+	Values _parentAbsolutes;
+	Values _parentPercentages;
+	int _parentRevision = -1;
 	core::String _name = "unnamed";
 	std::vector<std::function<void(const DirtyValue&)> > _listeners;
 
-	void calculateMax(Values& absolutes, Values& percentages) const;
+	static TypeMask typeMask(const Container& container);
+	TypeMask updateParent(long dt);
+	void calculateMax(TypeMask types);
+	void notifyListeners();
 
 public:
 	/**
@@ -108,6 +135,9 @@ public:
 	 */
 	const core::String& name() const;
 
+	/**
+	 * @brief Notifies the listeners about all current and max values in the next @c update() call
+	 */
 	void markAsDirty();
 
 	/**
@@ -124,7 +154,9 @@ public:
 	}
 
 	/**
-	 * @brief Calculates the new max values for the currently assigned @c Container's
+	 * @brief Calculates the new max values for the types that are affected by the @c Container's that
+	 * were added or removed since the last call and notifies the listeners about the changed values.
+	 * @return @c true if the max values were recalculated
 	 */
 	bool update(long dt);
 
@@ -0,0 +1,111 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "attrib/Attributes.h"
+#include "core/ArrayLength.h"
+#include "core/StringUtil.h"
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Simulates the attribute updates of the entities of a map per tick
+ */
+class AttributesBenchmark: public app::AbstractBenchmark {
+protected:
+	static constexpr int Entities = 1000;
+	static constexpr int Containers = 8;
+	std::vector<std::unique_ptr<attrib::Attributes>> _attributes;
+	attrib::Container _buff { "buff" };
+	int _notifications = 0;
+
+	void init() {
+		_notifications = 0;
+		_attributes.clear();
+		_attributes.reserve(Entities);
+		const attrib::Type types[] = {attrib::Type::HEALTH, attrib::Type::SPEED, attrib::Type::VIEWDISTANCE,
+			attrib::Type::ATTACKRANGE, attrib::Type::STRENGTH, attrib::Type::FIELDOFVIEW};
+		for (int i = 0; i < Entities; ++i) {
+			attrib::Attributes* attributes = new attrib::Attributes();
+			attributes->addListener([this] (const attrib::DirtyValue& v) {
+				++_notifications;
+			});
+			for (int c = 0; c < Containers; ++c) {
+				attrib::ContainerBuilder builder("container" + core::string::toString(c));
+				builder.setAbsolute(types[c % lengthof(types)], 10.0 + c);
+				builder.setPercentage(types[(c + 1) % lengthof(types)], 5.0);
+				attributes->add(builder.create());
+			}
+			attributes->update(0L);
+			_attributes.emplace_back(attributes);
+		}
+		attrib::ContainerBuilder buff("buff");
+		buff.setPercentage(attrib::Type::SPEED, 20.0);
+		buff.setAbsolute(attrib::Type::STRENGTH, 5.0);
+		_buff = buff.create();
+	}
+
+public:
+	void TearDown(benchmark::State& st) override {
+		_attributes.clear();
+		app::AbstractBenchmark::TearDown(st);
+	}
+};
+
+BENCHMARK_DEFINE_F(AttributesBenchmark, updateIdle) (benchmark::State& state) {
+	init();
+	for (auto _ : state) {
+		for (const auto& a : _attributes) {
+			a->update(1L);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * Entities);
+}
+
+/**
+ * @brief Every tick a tenth of the entities gets a buff added or removed
+ */
+BENCHMARK_DEFINE_F(AttributesBenchmark, updateBuffs) (benchmark::State& state) {
+	init();
+	int tick = 0;
+	for (auto _ : state) {
+		const int offset = tick % 10;
+		const bool add = (tick / 10) % 2 == 0;
+		for (int i = offset; i < Entities; i += 10) {
+			if (add) {
+				_attributes[i]->add(_buff);
+			} else {
+				_attributes[i]->remove(_buff);
+			}
+		}
+		for (const auto& a : _attributes) {
+			a->update(1L);
+		}
+		++tick;
+	}
+	state.SetItemsProcessed(state.iterations() * Entities);
+	state.counters["notifications"] = benchmark::Counter((double)_notifications, benchmark::Counter::kIsRate);
+}
+
+/**
+ * @brief Every entity takes damage several times per tick
+ */
+BENCHMARK_DEFINE_F(AttributesBenchmark, updateDamage) (benchmark::State& state) {
+	init();
+	for (auto _ : state) {
+		for (const auto& a : _attributes) {
+			for (int i = 0; i < 4; ++i) {
+				a->setCurrent(attrib::Type::HEALTH, a->current(attrib::Type::HEALTH) - 1.0);
+			}
+			a->update(1L);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * Entities);
+}
+
+BENCHMARK_REGISTER_F(AttributesBenchmark, updateIdle);
+BENCHMARK_REGISTER_F(AttributesBenchmark, updateBuffs);
+BENCHMARK_REGISTER_F(AttributesBenchmark, updateDamage);
+
+BENCHMARK_MAIN();
@@ -155,4 +155,72 @@ TEST_F(AttributesTest, testListeners) {
 	ASSERT_EQ(changes[static_cast<int>(Type::SPEED)], 1);
 }
 
+TEST_F(AttributesTest, testListenersBatched) {
+	Attributes attributes;
+	ContainerBuilder test1("test1");
+	test1.setAbsolute(Type::HEALTH, 100);
+	attributes.add(test1.create());
+	ASSERT_TRUE(attributes.update(1L));
+
+	int changes = 0;
+	double value = 0.0;
+	attributes.addListener([&] (const DirtyValue& v) {
+		ASSERT_TRUE(v.current);
+		ASSERT_EQ(Type::HEALTH, v.type);
+		++changes;
+		value = v.value;
+	});
+	attributes.setCurrent(Type::HEALTH, 50);
+	attributes.setCurrent(Type::HEALTH, 40);
+	ASSERT_EQ(0, changes) << "The listeners should only be notified in update()";
+	ASSERT_FALSE(attributes.update(1L));
+	ASSERT_EQ(1, changes);
+	ASSERT_EQ(40, value);
+	ASSERT_FALSE(attributes.update(1L));
+	ASSERT_EQ(1, changes);
+}
+
+TEST_F(AttributesTest, testOnlyAffectedTypesChange) {
+	Attributes attributes;
+	ContainerBuilder test1("test1");
+	test1.setAbsolute(Type::HEALTH, 10);
+	attributes.add(test1.create());
+	ContainerBuilder test2("test2");
+	test2.setAbsolute(Type::SPEED, 2);
+	attributes.add(test2.create());
+	ASSERT_TRUE(attributes.update(1L));
+	ASSERT_EQ(2, attributes.setCurrent(Type::SPEED, 5));
+
+	int changes[static_cast<int>(Type::MAX) + 1];
+	SDL_zero(changes);
+	attributes.addListener([&] (const DirtyValue& v) {
+		++changes[static_cast<int>(v.type)];
+	});
+	attributes.remove(test1.create());
+	ASSERT_TRUE(attributes.update(1L));
+	ASSERT_EQ(0, attributes.max(Type::HEALTH));
+	ASSERT_EQ(2, attributes.max(Type::SPEED));
+	ASSERT_EQ(1, changes[static_cast<int>(Type::HEALTH)]);
+	ASSERT_EQ(1, changes[static_cast<int>(Type::SPEED)]) << "Only the pending current value of SPEED should be reported";
+}
+
+TEST_F(AttributesTest, testSharedParent) {
+	Attributes parent;
+	parent.setName("parent");
+	Attributes child1(&parent);
+	Attributes child2(&parent);
+	ASSERT_FALSE(child1.update(1L));
+	ASSERT_FALSE(child2.update(1L));
+
+	ContainerBuilder test1("test1");
+	test1.setAbsolute(Type::ATTACKRANGE, 3);
+	parent.add(test1.create());
+	ASSERT_TRUE(child1.update(1L));
+	ASSERT_TRUE(child2.update(1L)) << "The parent was already updated by the first child";
+	ASSERT_EQ(3, child1.max(Type::ATTACKRANGE));
+	ASSERT_EQ(3, child2.max(Type::ATTACKRANGE));
+	ASSERT_FALSE(child1.update(1L));
+	ASSERT_FALSE(child2.update(1L));
+}
+
 }
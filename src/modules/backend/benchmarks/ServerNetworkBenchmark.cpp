@@ -0,0 +1,143 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "backend/network/ServerNetwork.h"
+#include "network/ProtocolHandlerRegistry.h"
+#include "ClientMessages_generated.h"
+#include <vector>
+
+namespace {
+
+class CountHandler : public network::IProtocolHandler {
+public:
+	uint64_t count = 0u;
+
+	void executeWithRaw(ENetPeer* peer, const void* message, const uint8_t*, size_t) override {
+		benchmark::DoNotOptimize(message);
+		++count;
+	}
+};
+
+}
+
+/**
+ * @brief Replays recorded client packets into the handlers without any socket involved
+ */
+class ServerNetworkBenchmark: public app::AbstractBenchmark {
+protected:
+	network::ProtocolHandlerRegistryPtr _registry;
+	network::ServerNetworkPtr _network;
+	std::shared_ptr<CountHandler> _handler;
+	std::vector<ENetPacket*> _packets;
+	ENetPeer _peer;
+
+	void record(flatbuffers::FlatBufferBuilder& fbb, network::ClientMsgType type, flatbuffers::Offset<void> data) {
+		network::FinishClientMessageBuffer(fbb, network::CreateClientMessage(fbb, type, data));
+		_packets.push_back(enet_packet_create(fbb.GetBufferPointer(), fbb.GetSize(), ENET_PACKET_FLAG_RELIABLE));
+		fbb.Clear();
+	}
+
+	/**
+	 * @brief The mix of a user that is walking around - mostly movement and snapshot acknowledgements
+	 */
+	void recordSession() {
+		flatbuffers::FlatBufferBuilder fbb;
+		for (int i = 0; i < 64; ++i) {
+			record(fbb, network::ClientMsgType::Move, network::CreateMove(fbb,
+					network::MoveDirection::MOVEFORWARD, (float)i * 0.01f, (float)i * 0.1f).Union());
+			record(fbb, network::ClientMsgType::SnapshotAck, network::CreateSnapshotAck(fbb, (uint32_t)i + 1u).Union());
+			if ((i % 16) == 0) {
+				record(fbb, network::ClientMsgType::TriggerAction, network::CreateTriggerAction(fbb).Union());
+			}
+		}
+	}
+
+	void setup(bool trusted) {
+		SDL_zero(_peer);
+		_registry = core::make_shared<network::ProtocolHandlerRegistry>();
+		_network = std::make_shared<network::ServerNetwork>(_registry, _benchmarkApp->eventBus(), _benchmarkApp->metric());
+		_network->setTrusted(&_peer, trusted);
+		_handler = std::make_shared<CountHandler>();
+		_registry->registerHandler(network::ClientMsgType::Move, _handler);
+		_registry->registerHandler(network::ClientMsgType::SnapshotAck, _handler);
+		_registry->registerHandler(network::ClientMsgType::TriggerAction, _handler);
+		recordSession();
+	}
+
+	/**
+	 * @brief The dispatching as it was done before the handler table and the per type statistics: a
+	 * verification, a map lookup with a shared pointer copy and the tag maps for every packet
+	 */
+	void replayPrevious(benchmark::State& state) {
+		setup(false);
+		const metric::MetricPtr& metric = _benchmarkApp->metric();
+		for (auto _ : state) {
+			for (ENetPacket* packet : _packets) {
+				flatbuffers::Verifier v(packet->data, packet->dataLength);
+				if (!network::VerifyClientMessageBuffer(v)) {
+					state.SkipWithError("Invalid packet");
+					return;
+				}
+				const network::ClientMessage *req = network::GetClientMessage(packet->data);
+				const network::ClientMsgType type = req->data_type();
+				const char *clientMsgType = network::EnumNameClientMsgType(type);
+				network::ProtocolHandlerPtr handler = _registry->getHandler(type);
+				const metric::TagMap& tags {{"direction", "in"}, {"type", clientMsgType}};
+				metric->count("network_packet_count", 1, tags);
+				metric->count("network_packet_size", (int)packet->dataLength, tags);
+				handler->executeWithRaw(&_peer, req->data(), (const uint8_t*)packet->data, packet->dataLength);
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * (int64_t)_packets.size());
+	}
+
+	void replay(benchmark::State& state, bool trusted) {
+		setup(trusted);
+		ENetEvent event;
+		SDL_zero(event);
+		event.type = ENET_EVENT_TYPE_RECEIVE;
+		event.peer = &_peer;
+		for (auto _ : state) {
+			for (ENetPacket* packet : _packets) {
+				event.packet = packet;
+				_network->packetReceived(event);
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * (int64_t)_packets.size());
+	}
+
+public:
+	void TearDown(benchmark::State& st) override {
+		for (ENetPacket* packet : _packets) {
+			enet_packet_destroy(packet);
+		}
+		_packets.clear();
+		_network.reset();
+		_handler.reset();
+		if (_registry) {
+			_registry->shutdown();
+			_registry.release();
+		}
+		app::AbstractBenchmark::TearDown(st);
+	}
+};
+
+BENCHMARK_DEFINE_F(ServerNetworkBenchmark, replayPrevious) (benchmark::State& state) {
+	replayPrevious(state);
+}
+
+BENCHMARK_DEFINE_F(ServerNetworkBenchmark, replayVerified) (benchmark::State& state) {
+	replay(state, false);
+}
+
+BENCHMARK_DEFINE_F(ServerNetworkBenchmark, replayTrusted) (benchmark::State& state) {
+	replay(state, true);
+}
+
+BENCHMARK_REGISTER_F(ServerNetworkBenchmark, replayPrevious);
+BENCHMARK_REGISTER_F(ServerNetworkBenchmark, replayVerified);
+BENCHMARK_REGISTER_F(ServerNetworkBenchmark, replayTrusted);
+
+BENCHMARK_MAIN();
@@ -3,7 +3,7 @@
  */
 
 #include "Entity.h"
-#include "core/collection/SetUtil.h"
+#include <algorithm>
 #include "core/ArrayLength.h"
 #include "core/Assert.h"
 #include "core/Log.h"
@@ -15,6 +15,7 @@
 #include "poi/PoiProvider.h"
 #include "backend/network/ServerMessageSender.h"
 #include "shared/ProtocolEnum.h"
+#include "shared/EntityState.h"
 #include "attrib/ContainerProvider.h"
 #include <glm/trigonometric.hpp>
 
@@ -33,16 +34,17 @@ Entity::Entity(EntityId id,
 Entity::~Entity() {
 }
 
-void Entity::visibleAdd(const EntitySet& entities) {
+void Entity::visibleAdd(const EntityVector& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is visible for %i", (int)e->id(), (int)id());
 		sendEntitySpawn(e);
 	}
 }
 
-void Entity::visibleRemove(const EntitySet& entities) {
+void Entity::visibleRemove(const EntityVector& entities) {
 	for (const EntityPtr& e : entities) {
 		Log::trace("entity %i is no longer visible for %i", (int)e->id(), (int)id());
+		_snapshotMgr.forget(e->id());
 		sendEntityRemove(e);
 	}
 }
@@ -167,7 +169,8 @@ void Entity::broadcastAttribUpdate() {
 	core_assert_msg(dirtyCount > 0, "Unexpected dirty attributes - _dirtyAttributes and _dirtyAttributeTypes are out of sync.");
 	core_trace_scoped(BroadcastAttribUpdate);
 	auto iter = _dirtyAttributeTypes.begin();
-	auto attribs = _attribUpdateFBB.CreateVector<flatbuffers::Offset<network::AttribEntry>>(dirtyCount,
+	auto fbb = _messageSender->builder();
+	auto attribs = fbb->CreateVector<flatbuffers::Offset<network::AttribEntry>>(dirtyCount,
 		[&] (size_t i) {
 			while (iter->type == attrib::Type::NONE) {
 				++iter;
@@ -177,10 +180,10 @@ void Entity::broadcastAttribUpdate() {
 			// TODO: maybe not needed?
 			const network::AttribMode mode = network::AttribMode::Percentage;
 			const bool current = dirtyValue.current;
-			return network::CreateAttribEntry(_attribUpdateFBB, dirtyValue.type, (float)value, mode, current);
+			return network::CreateAttribEntry(*fbb, dirtyValue.type, (float)value, mode, current);
 		});
-	sendToVisible(_attribUpdateFBB, network::ServerMsgType::AttribUpdate,
-			network::CreateAttribUpdate(_attribUpdateFBB, id(), attribs).Union(), true);
+	sendToVisible(*fbb, network::ServerMsgType::AttribUpdate,
+			network::CreateAttribUpdate(*fbb, id(), attribs).Union(), true);
 	_dirtyAttributeTypes.fill(attrib::DirtyValue{});
 }
 
@@ -193,38 +196,65 @@ bool Entity::update(long dt) {
 	return true;
 }
 
-void Entity::updateVisible(const EntitySet& set) {
+void Entity::updateVisible(const EntityVector& visible) {
 	core_trace_scoped(UpdateVisible);
+	_visibleAdded.clear();
+	_visibleRemoved.clear();
 	_visibleLock.lockWrite();
-	const auto& stillVisible = core::setIntersection(set, _visible);
-	const EntitySet& remove = core::setDifference(stillVisible, _visible);
-	const EntitySet& add = core::setDifference(set, stillVisible);
-	_visible = core::setUnion(stillVisible, add);
-	_visibleLock.unlockWrite();
-
-	_visibleLock.lockRead();
-	for (const auto& e : _visible) {
-		sendEntityUpdate(e);
+	for (const EntityPtr& e : visible) {
+		if (_visible.insert(e).second) {
+			_visibleAdded.push_back(e);
+		}
 	}
-	_visibleLock.unlockRead();
+	// all given entities are part of the set now - if the size differs, some of them left the visible area
+	if (_visible.size() != visible.size()) {
+		_visibleSorted.clear();
+		_visibleSorted.reserve(visible.size());
+		for (const EntityPtr& e : visible) {
+			_visibleSorted.push_back(e.get());
+		}
+		std::sort(_visibleSorted.begin(), _visibleSorted.end());
+		for (auto i = _visible.begin(); i != _visible.end();) {
+			if (std::binary_search(_visibleSorted.begin(), _visibleSorted.end(), i->get())) {
+				++i;
+				continue;
+			}
+			_visibleRemoved.push_back(*i);
+			i = _visible.erase(i);
+		}
+	}
+	_visibleLock.unlockWrite();
 
-	if (!add.empty()) {
-		visibleAdd(add);
+	if (!_visibleAdded.empty()) {
+		visibleAdd(_visibleAdded);
 	}
-	if (!remove.empty()) {
-		visibleRemove(remove);
+	if (!_visibleRemoved.empty()) {
+		visibleRemove(_visibleRemoved);
 	}
 }
 
-void Entity::sendEntityUpdate(const EntityPtr& entity) const {
+void Entity::sendEntitySnapshot() {
 	if (_peer == nullptr) {
 		return;
 	}
-	const glm::vec3& _pos = entity->pos();
-	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	_entityUpdateFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityUpdateFBB, network::ServerMsgType::EntityUpdate,
-			network::CreateEntityUpdate(_entityUpdateFBB, entity->id(), &pos, entity->orientation(), entity->animation()).Union());
+	core_trace_scoped(SendEntitySnapshot);
+	_snapshotStates.clear();
+	_visibleLock.lockRead();
+	_snapshotStates.reserve(_visible.size());
+	for (const EntityPtr& e : _visible) {
+		_snapshotStates.push_back(shared::quantizeEntityState(e->id(), e->pos(), e->orientation(), e->animation()));
+	}
+	_visibleLock.unlockRead();
+
+	const uint32_t sequence = _snapshotMgr.create(_snapshotStates, _snapshotChanged);
+	if (sequence == 0u) {
+		return;
+	}
+	auto fbb = _messageSender->builder();
+	auto entities = fbb->CreateVectorOfStructs(_snapshotChanged);
+	// lost snapshots are compensated by the next one - see SnapshotMgr
+	_messageSender->sendServerMessage(_peer, *fbb, network::ServerMsgType::EntitySnapshot,
+			network::CreateEntitySnapshot(*fbb, sequence, entities).Union(), 0u);
 }
 
 void Entity::sendEntitySpawn(const EntityPtr& entity) const {
@@ -234,19 +264,19 @@ void Entity::sendEntitySpawn(const EntityPtr& entity) const {
 	const glm::vec3& pos = entity->pos();
 	const network::Vec3 vec3 { pos.x, pos.y, pos.z };
 	const EntityId entityId = id();
-	_entitySpawnFBB.Clear();
+	auto fbb = _messageSender->builder();
 	// TODO: User::sendUserSpawn()?
-	_messageSender->sendServerMessage(_peer, _entitySpawnFBB, network::ServerMsgType::EntitySpawn,
-			network::CreateEntitySpawn(_entitySpawnFBB, entity->id(), entity->entityType(), &vec3, entityId, entity->animation()).Union());
+	_messageSender->sendServerMessage(_peer, *fbb, network::ServerMsgType::EntitySpawn,
+			network::CreateEntitySpawn(*fbb, entity->id(), entity->entityType(), &vec3, entityId, entity->animation()).Union());
 }
 
 void Entity::sendEntityRemove(const EntityPtr& entity) const {
 	if (_peer == nullptr) {
 		return;
 	}
-	_entityRemoveFBB.Clear();
-	_messageSender->sendServerMessage(_peer, _entityRemoveFBB, network::ServerMsgType::EntityRemove,
-			network::CreateEntityRemove(_entityRemoveFBB, entity->id()).Union());
+	auto fbb = _messageSender->builder();
+	_messageSender->sendServerMessage(_peer, *fbb, network::ServerMsgType::EntityRemove,
+			network::CreateEntityRemove(*fbb, entity->id()).Union());
 }
 
 bool Entity::inFrustum(const glm::vec3& position) const {
@@ -12,6 +12,7 @@
 #include "attrib/Attributes.h"
 #include "poi/Type.h"
 #include "backend/ForwardDecl.h"
+#include "SnapshotMgr.h"
 #include "ServerMessages_generated.h"
 #include "network/IProtocolHandler.h"
 #include "core/Trace.h"
@@ -22,29 +23,32 @@
 namespace backend {
 
 typedef std::unordered_set<EntityPtr> EntitySet;
+typedef std::vector<EntityPtr> EntityVector;
 
 /**
  * @brief Every actor in the world is an entity
  *
- * Entities are updated via @c network::ServerMsgType::EntityUpdate
- * message for the clients that are seeing the entity
+ * Entities are updated via @c network::ServerMsgType::EntitySnapshot
+ * messages for the clients that are seeing the entity
  *
- * @sa EntityUpdateHandler
+ * @sa EntitySnapshotHandler
  */
 class Entity {
 private:
 	core::ReadWriteLock _visibleLock {"Entity"};
 	EntitySet _visible core_thread_guarded_by(_visibleLock);
-	// they are stored as members to reduce memory allocations
-	mutable flatbuffers::FlatBufferBuilder _attribUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityUpdateFBB;
-	mutable flatbuffers::FlatBufferBuilder _entitySpawnFBB;
-	mutable flatbuffers::FlatBufferBuilder _entityRemoveFBB;
+	// they are stored as members to reduce memory allocations in updateVisible()
+	EntityVector _visibleAdded;
+	EntityVector _visibleRemoved;
+	std::vector<const Entity*> _visibleSorted;
 
 protected:
 	// network stuff
 	network::ServerMessageSenderPtr _messageSender;
 	ENetPeer *_peer = nullptr;
+	SnapshotMgr _snapshotMgr;
+	SnapshotMgr::States _snapshotStates;
+	SnapshotMgr::States _snapshotChanged;
 
 	network::Animation _animation = network::Animation::IDLE;
 
@@ -65,14 +69,13 @@ protected:
 	/**
 	 * @brief Called with the set of entities that just get visible for this entity
 	 */
-	void visibleAdd(const EntitySet& entities);
+	void visibleAdd(const EntityVector& entities);
 	/**
 	 * @brief Called with the set of entities that just get invisible for this entity
 	 */
-	void visibleRemove(const EntitySet& entities);
+	void visibleRemove(const EntityVector& entities);
 
 	void broadcastAttribUpdate();
-	void sendEntityUpdate(const EntityPtr& entity) const;
 	void sendEntitySpawn(const EntityPtr& entity) const;
 	void sendEntityRemove(const EntityPtr& entity) const;
 
@@ -102,6 +105,7 @@ public:
 	bool attack(EntityId id);
 
 	ENetPeer* peer() const;
+	SnapshotMgr& snapshotMgr();
 
 	/**
 	 * @note The implementation behind this must ensure thread safety
@@ -146,11 +150,17 @@ public:
 
 	/**
 	 * @brief This will inform the entity about all the other entities that it can see.
-	 * @param[in] set The entities that are currently visible
-	 * @note All entities have the same view range - see @c Entity::regionRect
+	 * @param[in] visible The entities that are currently visible - without duplicates
+	 * @note Only the entities that entered or left the visible area are announced to the peer
 	 * @note This is thread safe
 	 */
-	void updateVisible(const EntitySet& set);
+	void updateVisible(const EntityVector& visible);
+
+	/**
+	 * @brief Sends the states of the visible entities that changed since the last acknowledged snapshot
+	 * @note This is done in an own phase of the map tick after the visibility of all entities was updated
+	 */
+	void sendEntitySnapshot();
 
 	/**
 	 * @brief The tick of the entity
@@ -197,10 +207,16 @@ public:
 
 	const char* type() const;
 
+	const network::ServerMessageSenderPtr& messageSender() const;
+
 	void sendToVisible(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type,
 			flatbuffers::Offset<void> data, bool sendToSelf = false, uint32_t flags = ENET_PACKET_FLAG_RELIABLE) const;
 };
 
+inline const network::ServerMessageSenderPtr& Entity::messageSender() const {
+	return _messageSender;
+}
+
 inline const MapPtr& Entity::map() const {
 	return _map;
 }
@@ -231,6 +247,10 @@ inline network::EntityType Entity::entityType() const {
 	return _entityType;
 }
 
+inline SnapshotMgr& Entity::snapshotMgr() {
+	return _snapshotMgr;
+}
+
 inline glm::vec3 Entity::pos() const {
 	return _pos;
 }
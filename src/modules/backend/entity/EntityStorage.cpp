@@ -14,6 +14,7 @@ namespace backend {
 EntityStorage::EntityStorage(const core::EventBusPtr& eventBus) :
 		_eventBus(eventBus) {
 	_eventBus->subscribe<EntityDeleteEvent>(*this);
+	_eventBus->subscribe<NpcSpawnEvent>(*this);
 }
 
 EntityStorage::~EntityStorage() {
@@ -23,6 +24,7 @@ EntityStorage::~EntityStorage() {
 
 void EntityStorage::shutdown() {
 	_eventBus->unsubscribe<EntityDeleteEvent>(*this);
+	_eventBus->unsubscribe<NpcSpawnEvent>(*this);
 	visit([](const EntityPtr &e) { e->shutdown(); });
 	_npcs.clear();
 	_users.clear();
@@ -104,6 +106,14 @@ bool EntityStorage::addNpc(const NpcPtr& npc) {
 	return true;
 }
 
+void EntityStorage::addNpcDeferred(const NpcPtr& npc) {
+	_eventBus->enqueue(std::make_shared<NpcSpawnEvent>(npc));
+}
+
+void EntityStorage::onEvent(const NpcSpawnEvent& event) {
+	addNpc(event.get());
+}
+
 void EntityStorage::onEvent(const EntityDeleteEvent& event) {
 	const EntityId id = event.entityId();
 	const network::EntityType type = event.entityType();
@@ -18,7 +18,9 @@ namespace backend {
  *
  * This includes calling the Entity::update() method as well as performing the visibility calculations.
  */
-class EntityStorage : public core::IEventBusHandler<EntityDeleteEvent>{
+class EntityStorage :
+	public core::IEventBusHandler<EntityDeleteEvent>,
+	public core::IEventBusHandler<NpcSpawnEvent> {
 private:
 	typedef std::unordered_map<EntityId, UserPtr> Users;
 	typedef Users::iterator UsersIter;
@@ -37,12 +39,18 @@ public:
 	bool init();
 
 	void onEvent(const EntityDeleteEvent& event) override;
+	void onEvent(const NpcSpawnEvent& event) override;
 
 	bool addUser(const UserPtr& user);
 	bool removeUser(EntityId userId);
 	UserPtr user(EntityId userId);
 
 	bool addNpc(const NpcPtr& npc);
+	/**
+	 * @brief Adds the npc once the event bus is processed on the main thread
+	 * @note This is thread safe
+	 */
+	void addNpcDeferred(const NpcPtr& npc);
 	bool removeNpc(EntityId id);
 	NpcPtr npc(EntityId id);
 
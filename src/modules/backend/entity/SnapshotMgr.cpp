@@ -0,0 +1,81 @@
+/**
+ * @file
+ */
+
+#include "SnapshotMgr.h"
+#include "shared/EntityState.h"
+#include <algorithm>
+
+namespace backend {
+
+static inline bool lessById(const network::EntityState& a, const network::EntityState& b) {
+	return a.id() < b.id();
+}
+
+static void removeById(SnapshotMgr::States& states, int64_t id) {
+	auto i = std::lower_bound(states.begin(), states.end(), network::EntityState(id, 0, 0, 0, 0u, network::Animation::IDLE), lessById);
+	if (i != states.end() && i->id() == id) {
+		states.erase(i);
+	}
+}
+
+uint32_t SnapshotMgr::create(States& states, States& changed) {
+	core_trace_scoped(SnapshotMgrCreate);
+	std::sort(states.begin(), states.end(), lessById);
+	changed.clear();
+
+	core::ScopedLock lock(_lock);
+	// both lists are sorted by id - collect everything that is new or differs from the baseline
+	auto base = _baseline.begin();
+	for (const network::EntityState& state : states) {
+		while (base != _baseline.end() && base->id() < state.id()) {
+			++base;
+		}
+		if (base != _baseline.end() && shared::sameEntityState(*base, state)) {
+			continue;
+		}
+		changed.push_back(state);
+	}
+	if (changed.empty()) {
+		return 0u;
+	}
+	++_sequence;
+	if (_sequence == 0u) {
+		// 0 is reserved for no snapshot
+		++_sequence;
+	}
+	Snapshot& snapshot = _history[_sequence % History];
+	snapshot.sequence = _sequence;
+	snapshot.states = states;
+	return _sequence;
+}
+
+bool SnapshotMgr::ack(uint32_t sequence) {
+	core::ScopedLock lock(_lock);
+	// serial number arithmetic to survive the wrap around
+	if (sequence == 0u || (int32_t)(sequence - _ackedSequence) <= 0) {
+		return false;
+	}
+	Snapshot& snapshot = _history[sequence % History];
+	if (snapshot.sequence != sequence) {
+		return false;
+	}
+	_baseline = snapshot.states;
+	_ackedSequence = sequence;
+	return true;
+}
+
+void SnapshotMgr::forget(int64_t id) {
+	core::ScopedLock lock(_lock);
+	removeById(_baseline, id);
+	for (Snapshot& snapshot : _history) {
+		removeById(snapshot.states, id);
+	}
+}
+
+uint32_t SnapshotMgr::ackedSequence() const {
+	core::ScopedLock lock(_lock);
+	return _ackedSequence;
+}
+
+}
@@ -0,0 +1,74 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "ServerMessages_generated.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
+#include <stdint.h>
+#include <vector>
+
+namespace backend {
+
+/**
+ * @brief Keeps track of the entity states that a peer knows about
+ *
+ * Every snapshot only contains the states that changed compared to the last snapshot the client acknowledged.
+ * Snapshots are sent unreliable - a state that didn't reach the client is sent again with the next snapshot,
+ * because the baseline is only moved forward by an acknowledge.
+ *
+ * @note This is thread safe - the acknowledges are coming in from the network thread.
+ * @sa EntitySnapshot
+ * @sa SnapshotAck
+ */
+class SnapshotMgr {
+public:
+	using States = std::vector<network::EntityState>;
+	/**
+	 * @brief The amount of not yet acknowledged snapshots that are remembered. Acknowledges for older
+	 * snapshots are ignored.
+	 */
+	static constexpr int History = 32;
+private:
+	struct Snapshot {
+		uint32_t sequence = 0u;
+		// the states the client knows about if it acknowledges this snapshot - sorted by id
+		States states;
+	};
+	core_trace_mutex(core::Lock, _lock, "SnapshotMgr");
+	Snapshot _history[History];
+	// the states of the acknowledged snapshot - sorted by id
+	States _baseline;
+	uint32_t _sequence = 0u;
+	uint32_t _ackedSequence = 0u;
+public:
+	/**
+	 * @brief Creates a new snapshot for the given entity states
+	 * @param[in,out] states The quantized states of all entities the peer can currently see. Will get sorted.
+	 * @param[out] changed The states that differ from the last acknowledged snapshot.
+	 * @return The sequence number of the new snapshot or @c 0 if nothing changed - there is nothing to send
+	 * in that case.
+	 */
+	uint32_t create(States& states, States& changed);
+
+	/**
+	 * @brief Use the given snapshot as baseline for the following snapshots
+	 * @return @c false if the sequence is unknown or older than the current baseline
+	 */
+	bool ack(uint32_t sequence);
+
+	/**
+	 * @brief Removes the entity from the baseline - e.g. because it's no longer visible for the peer.
+	 * The next snapshot will contain its full state again if it gets visible again.
+	 */
+	void forget(int64_t id);
+
+	/**
+	 * @return The sequence number of the last acknowledged snapshot
+	 */
+	uint32_t ackedSequence() const;
+};
+
+}
@@ -51,17 +51,17 @@ void User::sendVars() const {
 	core::Var::visitReplicate([&vars] (const core::VarPtr& var) {
 		vars.push_back(var);
 	});
-	flatbuffers::FlatBufferBuilder fbb;
-	auto fbbVars = fbb.CreateVector<flatbuffers::Offset<network::Var>>(vars.size(),
+	auto fbb = _messageSender->builder();
+	auto fbbVars = fbb->CreateVector<flatbuffers::Offset<network::Var>>(vars.size(),
 		[&] (size_t i) {
 			const core::String& sname = vars[i]->name();
 			const core::String& svalue = vars[i]->strVal();
-			auto name = fbb.CreateString(sname.c_str(), sname.size());
-			auto value = fbb.CreateString(svalue.c_str(), svalue.size());
-			return network::CreateVar(fbb, name, value);
+			auto name = fbb->CreateString(sname.c_str(), sname.size());
+			auto value = fbb->CreateString(svalue.c_str(), svalue.size());
+			return network::CreateVar(*fbb, name, value);
 		});
-	if (!_messageSender->sendServerMessage(_peer, fbb, network::ServerMsgType::VarUpdate,
-			network::CreateVarUpdate(fbb, fbbVars).Union())) {
+	if (!_messageSender->sendServerMessage(_peer, *fbb, network::ServerMsgType::VarUpdate,
+			network::CreateVarUpdate(*fbb, fbbVars).Union())) {
 		Log::warn("Failed to send var message to the client");
 	}
 }
@@ -121,22 +121,22 @@ void User::userinfo(const char *key, const char* value) {
 }
 
 void User::broadcastUserinfo() {
-	flatbuffers::FlatBufferBuilder fbb;
+	auto fbb = _messageSender->builder();
 	auto iter = _userinfo.begin();
-	auto fbbVars = fbb.CreateVector<flatbuffers::Offset<network::Var>>(_userinfo.size(),
+	auto fbbVars = fbb->CreateVector<flatbuffers::Offset<network::Var>>(_userinfo.size(),
 		[&] (size_t i, auto* iter) {
-			auto name = fbb.CreateString((*iter)->key.c_str(), (*iter)->key.size());
-			auto value = fbb.CreateString((*iter)->value.c_str(), (*iter)->value.size());
+			auto name = fbb->CreateString((*iter)->key.c_str(), (*iter)->key.size());
+			auto value = fbb->CreateString((*iter)->value.c_str(), (*iter)->value.size());
 			++(*iter);
-			return network::CreateVar(fbb, name, value);
+			return network::CreateVar(*fbb, name, value);
 		}, &iter);
-	sendToVisible(fbb, network::ServerMsgType::UserInfo, network::CreateUserInfo(fbb, id(), fbbVars).Union(), true);
+	sendToVisible(*fbb, network::ServerMsgType::UserInfo, network::CreateUserInfo(*fbb, id(), fbbVars).Union(), true);
 }
 
 void User::broadcastUserSpawn() const {
-	flatbuffers::FlatBufferBuilder fbb;
+	auto fbb = _messageSender->builder();
 	const network::Vec3 pos { _pos.x, _pos.y, _pos.z };
-	sendToVisible(fbb, network::ServerMsgType::UserSpawn, network::CreateUserSpawn(fbb, id(), fbb.CreateString(_name.c_str(), _name.size()), &pos).Union(), true);
+	sendToVisible(*fbb, network::ServerMsgType::UserSpawn, network::CreateUserSpawn(*fbb, id(), fbb->CreateString(_name.c_str(), _name.size()), &pos).Union(), true);
 }
 
 bool User::sendMessage(flatbuffers::FlatBufferBuilder& fbb, network::ServerMsgType type, flatbuffers::Offset<void> msg) const {
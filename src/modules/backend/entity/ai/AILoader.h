@@ -22,6 +22,10 @@ public:
 	AILoader(const AIRegistryPtr& registry) :
 			LUATreeLoader(*registry.get()), _registry(registry) {
 	}
+
+	inline const AIRegistryPtr& registry() const {
+		return _registry;
+	}
 };
 
 typedef std::shared_ptr<AILoader> AILoaderPtr;
@@ -58,6 +58,22 @@ static void luaAI_globalpointer(lua_State* s, void* pointer, const char *name) {
 	lua_setglobal(s, name);
 }
 
+static inline const char* luaAI_metapooled() {
+	return "__meta_pooled";
+}
+
+/***
+ * Pooled states only mirror the lua side of the nodes, conditions, filters and steerings. The factories
+ * are registered by the shared state of the registry.
+ * @return @c true if this is a state of the state pool
+ */
+static bool luaAI_ispooled(lua_State* s) {
+	lua_getglobal(s, luaAI_metapooled());
+	const bool pooled = lua_toboolean(s, -1) != 0;
+	lua_pop(s, 1);
+	return pooled;
+}
+
 /***
  * Gives you access the the light userdata for the LUAAIRegistry.
  * @return the registry userdata
@@ -130,10 +146,19 @@ static int luaAI_nodetostring(lua_State* s) {
 static int luaAI_createnode(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUATreeNodeFactoryPtr& factory = std::make_shared<LuaNodeFactory>(s, type);
-	const bool inserted = r->registerNodeFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "tree node %s is already registered", type.c_str());
+	LUATreeNodeFactoryPtr factory;
+	const bool pooled = luaAI_ispooled(s);
+	if (pooled) {
+		factory = r->treeNodeFactory(type);
+		if (!factory) {
+			return clua_error(s, "tree node %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaNodeFactory>(s, type);
+		const bool inserted = r->registerNodeFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "tree node %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaNodeFactory*>(s, factory.get());
@@ -144,7 +169,9 @@ static int luaAI_createnode(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "node");
-	r->addTreeNodeFactory(type, factory);
+	if (!pooled) {
+		r->addTreeNodeFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -171,10 +198,19 @@ static int luaAI_conditiontostring(lua_State* s) {
 static int luaAI_createcondition(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAConditionFactoryPtr& factory = std::make_shared<LuaConditionFactory>(s, type);
-	const bool inserted = r->registerConditionFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "condition %s is already registered", type.c_str());
+	LUAConditionFactoryPtr factory;
+	const bool pooled = luaAI_ispooled(s);
+	if (pooled) {
+		factory = r->conditionFactory(type);
+		if (!factory) {
+			return clua_error(s, "condition %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaConditionFactory>(s, type);
+		const bool inserted = r->registerConditionFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "condition %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaConditionFactory*>(s, factory.get());
@@ -185,7 +221,9 @@ static int luaAI_createcondition(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "condition");
-	r->addConditionFactory(type, factory);
+	if (!pooled) {
+		r->addConditionFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -208,10 +246,19 @@ static int luaAI_filtertostring(lua_State* s) {
 static int luaAI_createfilter(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUAFilterFactoryPtr& factory = std::make_shared<LuaFilterFactory>(s, type);
-	const bool inserted = r->registerFilterFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "filter %s is already registered", type.c_str());
+	LUAFilterFactoryPtr factory;
+	const bool pooled = luaAI_ispooled(s);
+	if (pooled) {
+		factory = r->filterFactory(type);
+		if (!factory) {
+			return clua_error(s, "filter %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaFilterFactory>(s, type);
+		const bool inserted = r->registerFilterFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "filter %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaFilterFactory*>(s, factory.get());
@@ -222,7 +269,9 @@ static int luaAI_createfilter(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "filter");
-	r->addFilterFactory(type, factory);
+	if (!pooled) {
+		r->addFilterFactory(type, factory);
+	}
 	return 1;
 }
 
@@ -240,10 +289,19 @@ static int luaAI_steeringtostring(lua_State* s) {
 static int luaAI_createsteering(lua_State* s) {
 	LUAAIRegistry* r = luaAI_toregistry(s);
 	const core::String type = luaL_checkstring(s, -1);
-	const LUASteeringFactoryPtr& factory = std::make_shared<LuaSteeringFactory>(s, type);
-	const bool inserted = r->registerSteeringFactory(type, *factory);
-	if (!inserted) {
-		return clua_error(s, "steering %s is already registered", type.c_str());
+	LUASteeringFactoryPtr factory;
+	const bool pooled = luaAI_ispooled(s);
+	if (pooled) {
+		factory = r->steeringFactory(type);
+		if (!factory) {
+			return clua_error(s, "steering %s is not registered", type.c_str());
+		}
+	} else {
+		factory = std::make_shared<LuaSteeringFactory>(s, type);
+		const bool inserted = r->registerSteeringFactory(type, *factory);
+		if (!inserted) {
+			return clua_error(s, "steering %s is already registered", type.c_str());
+		}
 	}
 
 	clua_newuserdata<LuaSteeringFactory*>(s, factory.get());
@@ -254,15 +312,21 @@ static int luaAI_createsteering(lua_State* s) {
 		{nullptr, nullptr}
 	};
 	luaAI_setupmetatable(s, type, nodes, "steering");
-	r->addSteeringFactory(type, factory);
+	if (!pooled) {
+		r->addSteeringFactory(type, factory);
+	}
 	return 1;
 }
 
 LUAAIRegistry::LUAAIRegistry() {
 	_s = _lua.state();
+	setupState(_s, false);
+}
+
+void LUAAIRegistry::setupState(lua_State* s, bool pooled) {
 	// TODO: random module
 
-	lua_gc(_s, LUA_GCSTOP, 0);
+	lua_gc(s, LUA_GCSTOP, 0);
 
 	static const luaL_Reg registryFuncs[] = {
 		{"createNode", luaAI_createnode},
@@ -271,10 +335,12 @@ LUAAIRegistry::LUAAIRegistry() {
 		{"createSteering", luaAI_createsteering},
 		{nullptr, nullptr}
 	};
-	clua_registerfuncsglobal(_s, registryFuncs, "META_REGISTRY", "REGISTRY");
+	clua_registerfuncsglobal(s, registryFuncs, "META_REGISTRY", "REGISTRY");
 
-	luaAI_globalpointer(_s, this, luaAI_metaregistry());
-	luaAI_registerAll(_s);
+	luaAI_globalpointer(s, this, luaAI_metaregistry());
+	lua_pushboolean(s, pooled ? 1 : 0);
+	lua_setglobal(s, luaAI_metapooled());
+	luaAI_registerAll(s);
 }
 
 lua_State* LUAAIRegistry::getLuaState() {
@@ -295,9 +361,7 @@ bool LUAAIRegistry::init(const core::String& file) {
 	const char* script = ""
 		"UNKNOWN, CANNOTEXECUTE, RUNNING, FINISHED, FAILED, EXCEPTION = 0, 1, 2, 3, 4, 5\n";
 
-	if (luaL_loadbufferx(_s, script, SDL_strlen(script), "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		Log::error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (!evaluate(script, SDL_strlen(script))) {
 		return false;
 	}
 	const core::String& btScript = io::filesystem()->load(file);
@@ -317,6 +381,13 @@ void LUAAIRegistry::shutdown() {
 		_filterFactories.clear();
 		_steeringFactories.clear();
 	}
+	{
+		core::ScopedLock scopedLock(_stateLock);
+		core_assert_msg(_freeStates.size() == _states.size(), "There are still pooled lua states in use");
+		_freeStates.clear();
+		_states.clear();
+		_scripts.clear();
+	}
 	_s = nullptr;
 }
 
@@ -329,14 +400,63 @@ bool LUAAIRegistry::evaluate(const char* luaBuffer, size_t size) {
 		Log::error("LUA state is not yet initialized");
 		return false;
 	}
-	if (luaL_loadbufferx(_s, luaBuffer, size, "", nullptr) || lua_pcall(_s, 0, 0, 0)) {
-		Log::error("%s", lua_tostring(_s, -1));
-		lua_pop(_s, 1);
+	if (!load(_s, luaBuffer, size)) {
 		return false;
 	}
+	core::ScopedLock scopedLock(_stateLock);
+	_scripts.emplace_back(luaBuffer, size);
 	return true;
 }
 
+bool LUAAIRegistry::load(lua_State* s, const char* luaBuffer, size_t size) {
+	if (luaL_loadbufferx(s, luaBuffer, size, "", nullptr) || lua_pcall(s, 0, 0, 0)) {
+		Log::error("%s", lua_tostring(s, -1));
+		lua_pop(s, 1);
+		return false;
+	}
+	return true;
+}
+
+lua_State* LUAAIRegistry::acquireState() {
+	if (_s == nullptr) {
+		return nullptr;
+	}
+	core::ScopedLock scopedLock(_stateLock);
+	PooledState* state;
+	if (_freeStates.empty()) {
+		core_trace_scoped(LUAAIRegistryCreateState);
+		_states.emplace_back(new PooledState());
+		state = _states.back().get();
+		setupState(state->lua.state(), true);
+		Log::debug("Created pooled lua state %i", (int)_states.size());
+	} else {
+		state = _freeStates.back();
+		_freeStates.pop_back();
+	}
+	// catch up with the scripts that were evaluated since the state was used the last time
+	for (; state->scripts < _scripts.size(); ++state->scripts) {
+		const core::String& script = _scripts[state->scripts];
+		load(state->lua.state(), script.c_str(), script.size());
+	}
+	return state->lua.state();
+}
+
+void LUAAIRegistry::releaseState(lua_State* s) {
+	core::ScopedLock scopedLock(_stateLock);
+	for (const auto& state : _states) {
+		if (state->lua.state() == s) {
+			_freeStates.push_back(state.get());
+			return;
+		}
+	}
+	core_assert_msg(false, "The lua state is not part of the pool");
+}
+
+int LUAAIRegistry::pooledStates() const {
+	core::ScopedLock scopedLock(_stateLock);
+	return (int)_states.size();
+}
+
 void LUAAIRegistry::addTreeNodeFactory(const core::String& type, const LUATreeNodeFactoryPtr& factory) {
 	core::ScopedLock scopedLock(_lock);
 	_treeNodeFactories.emplace(type, factory);
@@ -357,4 +477,33 @@ void LUAAIRegistry::addSteeringFactory(const core::String& type, const LUASteeri
 	_steeringFactories.emplace(type, factory);
 }
 
+template<class FactoryMap>
+static typename FactoryMap::mapped_type findFactory(const FactoryMap& factories, const core::String& type) {
+	auto i = factories.find(type);
+	if (i == factories.end()) {
+		return typename FactoryMap::mapped_type();
+	}
+	return i->second;
+}
+
+LUATreeNodeFactoryPtr LUAAIRegistry::treeNodeFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return findFactory(_treeNodeFactories, type);
+}
+
+LUAConditionFactoryPtr LUAAIRegistry::conditionFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return findFactory(_conditionFactories, type);
+}
+
+LUAFilterFactoryPtr LUAAIRegistry::filterFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return findFactory(_filterFactories, type);
+}
+
+LUASteeringFactoryPtr LUAAIRegistry::steeringFactory(const core::String& type) const {
+	core::ScopedLock scopedLock(_lock);
+	return findFactory(_steeringFactories, type);
+}
+
 }
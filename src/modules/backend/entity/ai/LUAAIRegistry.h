@@ -15,6 +15,8 @@
 #include "backend/entity/ai/filter/LUAFilter.h"
 #include "backend/entity/ai/movement/LUASteering.h"
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace backend {
 
@@ -86,6 +88,13 @@ typedef std::map<core::String, LUASteeringFactoryPtr> SteeringFactoryMap;
  * @par AI metatable
  * There is a metatable that you can modify by calling @ai{LUAAIRegistry::pushAIMetatable()}.
  * This metatable is applied to all @ai{AI} pointers that are forwarded to the lua functions.
+ *
+ * @par State pool
+ * The lua state is not thread safe. Every thread that executes @ai{AI} in parallel (see @ai{Zone::executeParallel()})
+ * gets its own lua state from a pool. The pooled states are loaded from the same scripts that were given to
+ * @c init() and @c evaluate(). Modifications of the metatables from the c side are only applied to the shared
+ * state that @c getLuaState() returns.
+ * @sa LUAStateScope
  */
 class LUAAIRegistry : public AIRegistry {
 protected:
@@ -97,6 +106,20 @@ protected:
 	ConditionFactoryMap _conditionFactories core_thread_guarded_by(_lock);
 	FilterFactoryMap _filterFactories core_thread_guarded_by(_lock);
 	SteeringFactoryMap _steeringFactories core_thread_guarded_by(_lock);
+
+	struct PooledState {
+		lua::LUA lua;
+		// the amount of scripts from @c _scripts that were loaded into this state
+		size_t scripts = 0u;
+	};
+	core_trace_mutex(core::Lock, _stateLock, "LUAAIRegistryStates");
+	// every script that was evaluated - they are replayed in the pooled states
+	std::vector<core::String> _scripts core_thread_guarded_by(_stateLock);
+	std::vector<std::unique_ptr<PooledState>> _states core_thread_guarded_by(_stateLock);
+	std::vector<PooledState*> _freeStates core_thread_guarded_by(_stateLock);
+
+	void setupState(lua_State* s, bool pooled);
+	static bool load(lua_State* s, const char* luaBuffer, size_t size);
 public:
 	LUAAIRegistry();
 
@@ -105,6 +128,25 @@ public:
 	void addFilterFactory(const core::String& type, const LUAFilterFactoryPtr& factory);
 	void addSteeringFactory(const core::String& type, const LUASteeringFactoryPtr& factory);
 
+	LUATreeNodeFactoryPtr treeNodeFactory(const core::String& type) const;
+	LUAConditionFactoryPtr conditionFactory(const core::String& type) const;
+	LUAFilterFactoryPtr filterFactory(const core::String& type) const;
+	LUASteeringFactoryPtr steeringFactory(const core::String& type) const;
+
+	/**
+	 * @brief Hands out a lua state that is loaded with all scripts of the shared state for the exclusive use
+	 * of the calling thread. A new state is created if no pooled state is free.
+	 * @return @c nullptr if the registry is not initialized
+	 * @note Give it back with @c releaseState()
+	 * @sa LUAStateScope
+	 */
+	lua_State* acquireState();
+	void releaseState(lua_State* s);
+	/**
+	 * @return The amount of lua states that were created for the pool
+	 */
+	int pooledStates() const;
+
 	/**
 	 * @brief Access to the lua state.
 	 * @see pushAIMetatable()
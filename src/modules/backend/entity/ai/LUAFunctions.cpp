@@ -4,6 +4,7 @@
  */
 
 #include "LUAFunctions.h"
+#include "LUAAIRegistry.h"
 #include "backend/entity/ai/group/GroupId.h"
 #include "backend/entity/ai/group/GroupMgr.h"
 #include "backend/entity/ai/zone/Zone.h"
@@ -15,6 +16,41 @@
 
 namespace backend {
 
+// the registry state and the pooled state that replaces it for the current thread
+static thread_local lua_State* _boundShared = nullptr;
+static thread_local lua_State* _boundState = nullptr;
+
+lua_State* luaAI_state(lua_State* s) {
+	if (_boundShared == s && _boundState != nullptr) {
+		return _boundState;
+	}
+	return s;
+}
+
+LUAStateScope::LUAStateScope(LUAAIRegistry* registry) :
+		_registry(registry) {
+	if (_registry == nullptr) {
+		return;
+	}
+	_state = _registry->acquireState();
+	if (_state == nullptr) {
+		return;
+	}
+	_prevShared = _boundShared;
+	_prevState = _boundState;
+	_boundShared = _registry->getLuaState();
+	_boundState = _state;
+}
+
+LUAStateScope::~LUAStateScope() {
+	if (_state == nullptr) {
+		return;
+	}
+	_boundShared = _prevShared;
+	_boundState = _prevState;
+	_registry->releaseState(_state);
+}
+
 struct luaAI_AI {
 	AIPtr ai;
 };
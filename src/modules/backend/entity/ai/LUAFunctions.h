@@ -5,12 +5,14 @@
 #pragma once
 
 #include "commonlua/LUA.h"
+#include "core/NonCopyable.h"
 #include <memory>
 
 namespace backend {
 
 class AI;
 typedef std::shared_ptr<AI> AIPtr;
+class LUAAIRegistry;
 
 template<class T>
 static T* luaAI_getlightuserdata(lua_State *s, const char *name) {
@@ -30,4 +32,30 @@ extern const char* luaAI_metacharacter();
 extern void luaAI_registerAll(lua_State* s);
 extern int luaAI_pushai(lua_State* s, const AIPtr& ai);
 
+/**
+ * @brief Resolves the lua state that should be used by the calling thread
+ * @param[in] s The shared state of the registry the lua node, condition, filter or steering was created by
+ * @return The pooled state that is bound to the calling thread for the given registry state - or @c s
+ * @sa LUAStateScope
+ */
+extern lua_State* luaAI_state(lua_State* s);
+
+/**
+ * @brief Binds a pooled lua state of the given registry to the calling thread for the lifetime of the
+ * scope. The lua tree nodes, conditions, filters and steerings are executed in this state instead of the
+ * shared registry state - this allows to run scripted @ai{AI} in parallel.
+ * @note A @c nullptr registry doesn't bind anything
+ * @sa LUAAIRegistry::acquireState()
+ */
+class LUAStateScope : public core::NonCopyable {
+private:
+	LUAAIRegistry* _registry;
+	lua_State* _state = nullptr;
+	lua_State* _prevShared = nullptr;
+	lua_State* _prevState = nullptr;
+public:
+	explicit LUAStateScope(LUAAIRegistry* registry);
+	~LUAStateScope();
+};
+
 }
@@ -4,15 +4,16 @@
 
 #include "Zone.h"
 #include "core/Trace.h"
+#include "core/TimeProvider.h"
 #include "backend/entity/ai/tree/TreeNode.h"
 
 namespace backend {
 
 Zone::~Zone() {
 	_threadPool.shutdown();
-	for (const auto& e : _ais) {
-		e.second->setZone(nullptr);
-		_groupManager.removeFromAllGroups(e.second);
+	for (const AIPtr& ai : *_ais) {
+		ai->setZone(nullptr);
+		_groupManager.removeFromAllGroups(ai);
 	}
 	for (const auto& ai : _scheduledAdd) {
 		ai->setZone(nullptr);
@@ -21,22 +22,43 @@ Zone::~Zone() {
 	for (const auto& ai : _scheduledRemove) {
 		doRemoveAI(ai);
 	}
-	_ais.clear();
+	_ais->clear();
+	_aiIndices.clear();
 }
 
 AIPtr Zone::getAI(ai::CharacterId id) const {
 	core::ScopedLock scopedLock(_lock);
-	auto i = _ais.find(id);
-	if (i == _ais.end()) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
 		return AIPtr();
 	}
-	const AIPtr& ai = i->second;
-	return ai;
+	return (*_ais)[i->second];
+}
+
+Zone::AIListPtr Zone::getAIs() const {
+	core::ScopedLock scopedLock(_lock);
+	return _ais;
+}
+
+Zone::AIScheduleList& Zone::mutableAIs() {
+	if (_ais.use_count() > 1) {
+		_ais = std::make_shared<AIScheduleList>(*_ais);
+	}
+	return *_ais;
+}
+
+int Zone::batchSize(int ais, int batchSize) const {
+	if (batchSize > 0) {
+		return batchSize;
+	}
+	// a few blocks per thread (including the calling thread) to balance the load by stealing
+	const int blocks = ((int)_threadPool.size() + 1) * 4;
+	return core_max(1, (ais + blocks - 1) / blocks);
 }
 
 size_t Zone::size() const {
 	core::ScopedLock scopedLock(_lock);
-	return _ais.size();
+	return _aiIndices.size();
 }
 
 bool Zone::doAddAI(const AIPtr& ai) {
@@ -44,32 +66,46 @@ bool Zone::doAddAI(const AIPtr& ai) {
 		return false;
 	}
 	const ai::CharacterId& id = ai->getCharacter()->getId();
-	if (_ais.find(id) != _ais.end()) {
+	if (_aiIndices.find(id) != _aiIndices.end()) {
 		return false;
 	}
-	_ais.insert(std::make_pair(id, ai));
+	AIScheduleList& ais = mutableAIs();
+	_aiIndices.insert(std::make_pair(id, ais.size()));
+	ais.push_back(ai);
 	ai->setZone(this);
 	return true;
 }
 
+AIPtr Zone::doEraseAI(const ai::CharacterId& id) {
+	auto i = _aiIndices.find(id);
+	if (i == _aiIndices.end()) {
+		return AIPtr();
+	}
+	const size_t index = i->second;
+	_aiIndices.erase(i);
+	AIScheduleList& ais = mutableAIs();
+	AIPtr ai = core::move(ais[index]);
+	// keep the list contiguous by moving the last member into the gap
+	if (index != ais.size() - 1) {
+		ais[index] = core::move(ais.back());
+		_aiIndices[ais[index]->getId()] = index;
+	}
+	ais.pop_back();
+	return ai;
+}
+
 bool Zone::doRemoveAI(const ai::CharacterId& id) {
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
+	const AIPtr& ai = doEraseAI(id);
+	if (!ai) {
 		return false;
 	}
-	i->second->setZone(nullptr);
-	_groupManager.removeFromAllGroups(i->second);
-	_ais.erase(i);
+	ai->setZone(nullptr);
+	_groupManager.removeFromAllGroups(ai);
 	return true;
 }
 
 bool Zone::doDestroyAI(const ai::CharacterId& id) {
-	AIMapIter i = _ais.find(id);
-	if (i == _ais.end()) {
-		return false;
-	}
-	_ais.erase(i);
-	return true;
+	return (bool)doEraseAI(id);
 }
 
 bool Zone::addAI(const AIPtr& ai) {
@@ -127,7 +163,15 @@ void Zone::update(int64_t dt) {
 		ai->update(dt, _debug);
 		ai->getBehaviour()->execute(ai, dt);
 	};
-	executeParallel(func);
+	const uint64_t start = core::TimeProvider::highResTime();
+	const int batches = executeParallel(func);
+	const uint64_t micros = (core::TimeProvider::highResTime() - start) * 1000000u / core::TimeProvider::highResTimeResolution();
+	++_updateStats.updates;
+	_updateStats.ais = (uint32_t)size();
+	_updateStats.batches = (uint32_t)batches;
+	_updateStats.lastMicros = micros;
+	_updateStats.maxMicros = core_max(_updateStats.maxMicros, micros);
+	_updateStats.totalMicros += micros;
 	_groupManager.update(dt);
 }
 
@@ -13,9 +13,12 @@
  */
 #pragma once
 
+#include "backend/ForwardDecl.h"
 #include "backend/entity/ai/ICharacter.h"
+#include "backend/entity/ai/LUAFunctions.h"
 #include "backend/entity/ai/group/GroupMgr.h"
 #include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/Parallel.h"
 #include "core/concurrent/Lock.h"
 #include "core/Trace.h"
 #include "ai-shared/common/CharacterId.h"
@@ -40,15 +43,37 @@ typedef std::shared_ptr<AI> AIPtr;
  */
 class Zone {
 public:
-	typedef std::unordered_map<ai::CharacterId, AIPtr> AIMap;
 	typedef std::vector<AIPtr> AIScheduleList;
 	typedef std::vector<ai::CharacterId> CharacterIdList;
-	typedef AIMap::const_iterator AIMapConstIter;
-	typedef AIMap::iterator AIMapIter;
+	/**
+	 * @brief Maps the id of the character to the index in the list of zone members
+	 */
+	typedef std::unordered_map<ai::CharacterId, size_t> AIIndexMap;
+	/**
+	 * @brief Immutable snapshot of the zone members that is shared by the parallel executions
+	 */
+	typedef std::shared_ptr<const AIScheduleList> AIListPtr;
+
+	/**
+	 * @brief Timing statistics of the @c AI updates in @c Zone::update
+	 */
+	struct UpdateStats {
+		/** amount of @c Zone::update calls */
+		uint32_t updates = 0u;
+		/** amount of @c AI instances that were updated in the last tick */
+		uint32_t ais = 0u;
+		/** amount of blocks the @c AI instances were split into in the last tick */
+		uint32_t batches = 0u;
+		uint64_t lastMicros = 0u;
+		uint64_t maxMicros = 0u;
+		uint64_t totalMicros = 0u;
+	};
 
 protected:
 	const core::String _name;
-	AIMap _ais core_thread_guarded_by(_lock);
+	AIIndexMap _aiIndices core_thread_guarded_by(_lock);
+	// the zone members - copied on write if an execution is still iterating over them
+	std::shared_ptr<AIScheduleList> _ais core_thread_guarded_by(_lock);
 	AIScheduleList _scheduledAdd core_thread_guarded_by(_scheduleLock);
 	CharacterIdList _scheduledRemove core_thread_guarded_by(_scheduleLock);
 	CharacterIdList _scheduledDestroy core_thread_guarded_by(_scheduleLock);
@@ -57,6 +82,9 @@ protected:
 	core_trace_mutex(core::Lock, _scheduleLock, "AIScheduleZone");
 	GroupMgr _groupManager;
 	mutable core::ThreadPool _threadPool;
+	// gives every thread its own lua state for the parallel execution
+	AIRegistryPtr _registry;
+	UpdateStats _updateStats;
 
 	/**
 	 * @brief called in the zone update to add new @c AI instances.
@@ -77,10 +105,28 @@ protected:
 	 * @note This doesn't lock the zone - because @c Zone::update already does it
 	 */
 	bool doDestroyAI(const ai::CharacterId& id);
+	/**
+	 * @brief Removes the @c AI with the given id from the zone members
+	 * @return empty @c AIPtr() if the id wasn't found
+	 */
+	AIPtr doEraseAI(const ai::CharacterId& id);
+	/**
+	 * @brief The zone members for modification. Creates a copy if a snapshot of the list is still in use.
+	 */
+	AIScheduleList& mutableAIs();
+
+	/**
+	 * @brief The amount of @c AI instances per block for the parallel execution
+	 */
+	int batchSize(int ais, int batchSize) const;
 
 public:
-	Zone(const core::String& name, int threadCount = 1) :
-			_name(name), _debug(false), _threadPool(threadCount) {
+	/**
+	 * @param registry The registry of the lua nodes that are used by the behaviour trees of the zone members.
+	 * The lua nodes are not thread safe without it.
+	 */
+	Zone(const core::String& name, int threadCount = 1, const AIRegistryPtr& registry = AIRegistryPtr()) :
+			_name(name), _ais(std::make_shared<AIScheduleList>()), _debug(false), _threadPool(threadCount), _registry(registry) {
 		_threadPool.init();
 	}
 
@@ -161,6 +207,17 @@ public:
 
 	GroupMgr& getGroupMgr();
 
+	/**
+	 * @brief The members of the zone as contiguous list.
+	 * @note The returned snapshot is not modified anymore - adding or removing an @c AI instance while the snapshot
+	 * is in use works on a copy.
+	 * @note This locks the zone for reading
+	 */
+	AIListPtr getAIs() const;
+
+	const UpdateStats& updateStats() const;
+	void resetUpdateStats();
+
 	const GroupMgr& getGroupMgr() const;
 
 	/**
@@ -246,45 +303,50 @@ public:
 	 * @note This is executed in a thread pool - so make sure to synchronize your lambda or functor.
 	 * We are waiting for the execution of this.
 	 *
+	 * The instances are split into contiguous blocks of @c batchSize instances. Each block is one task for
+	 * the thread pool - the calling thread helps to execute them while it waits. Each block is executed with
+	 * its own lua state of the registry pool.
+	 * @param batchSize The amount of instances per block. @c 0 picks the size based on the amount of threads.
+	 * @return The amount of blocks that were executed
+	 *
 	 * @note This locks the zone for reading
 	 */
 	template<typename Func>
-	void executeParallel(Func& func) {
+	int executeParallel(Func& func, int batchSize = 0) {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIListPtr ais = getAIs();
+		const int n = (int)ais->size();
+		const int step = this->batchSize(n, batchSize);
+		core::parallelFor(_threadPool, 0, n, [&] (int from, int to) {
+			const LUAStateScope luaState(_registry.get());
+			for (int i = from; i < to; ++i) {
+				func((*ais)[i]);
+			}
+		}, step);
+		return (n + step - 1) / step;
 	}
 
 	/**
 	 * @brief Executes a lambda or functor for all the @c AI instances in this zone.
 	 * @note This is executed in a thread pool - so make sure to synchronize your lambda or functor.
 	 * We are waiting for the execution of this.
+	 * @sa executeParallel()
 	 *
 	 * @note This locks the zone for reading
 	 */
 	template<typename Func>
-	void executeParallel(const Func& func) const {
+	int executeParallel(const Func& func, int batchSize = 0) const {
 		core_trace_scoped(ZoneExecuteParallel);
-		std::vector<std::future<void> > results;
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
-			results.emplace_back(executeAsync(ai, func));
-		}
-		for (auto & result: results) {
-			result.wait();
-		}
+		const AIListPtr ais = getAIs();
+		const int n = (int)ais->size();
+		const int step = this->batchSize(n, batchSize);
+		core::parallelFor(_threadPool, 0, n, [&] (int from, int to) {
+			const LUAStateScope luaState(_registry.get());
+			for (int i = from; i < to; ++i) {
+				func((*ais)[i]);
+			}
+		}, step);
+		return (n + step - 1) / step;
 	}
 
 	/**
@@ -296,11 +358,8 @@ public:
 	template<typename Func>
 	void execute(const Func& func) const {
 		core_trace_scoped(ZoneExecute);
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		const AIListPtr ais = getAIs();
+		for (const AIPtr& ai : *ais) {
 			func(ai);
 		}
 	}
@@ -314,11 +373,8 @@ public:
 	template<typename Func>
 	void execute(Func& func) {
 		core_trace_scoped(ZoneExecute);
-		_lock.lock();
-		AIMap copy(_ais);
-		_lock.unlock();
-		for (auto i = copy.begin(); i != copy.end(); ++i) {
-			const AIPtr& ai = i->second;
+		const AIListPtr ais = getAIs();
+		for (const AIPtr& ai : *ais) {
 			func(ai);
 		}
 	}
@@ -346,4 +402,12 @@ inline const GroupMgr& Zone::getGroupMgr() const {
 	return _groupManager;
 }
 
+inline const Zone::UpdateStats& Zone::updateStats() const {
+	return _updateStats;
+}
+
+inline void Zone::resetUpdateStats() {
+	_updateStats = UpdateStats();
+}
+
 }
@@ -8,6 +8,7 @@
 #include "persistence/PersistenceMgr.h"
 #include "core/Log.h"
 #include "backend/entity/User.h"
+#include "backend/network/ServerMessageSender.h"
 
 namespace backend {
 
@@ -62,18 +63,19 @@ cooldown::CooldownTriggerState UserCooldownMgr::triggerCooldown(cooldown::Type t
 }
 
 void UserCooldownMgr::sendCooldown(cooldown::Type type, bool started) const {
+	auto fbb = _user->messageSender()->builder();
 	network::ServerMsgType msgtype;
 	flatbuffers::Offset<void> msg;
 	if (started) {
 		const uint64_t duration = _cooldownProvider->duration(type);
 		const uint64_t now = _timeProvider->tickNow();
-		msg = network::CreateStartCooldown(_cooldownFBB, type, now, duration).Union();
+		msg = network::CreateStartCooldown(*fbb, type, now, duration).Union();
 		msgtype = network::ServerMsgType::StartCooldown;
 	} else {
-		msg = network::CreateStopCooldown(_cooldownFBB, type).Union();
+		msg = network::CreateStopCooldown(*fbb, type).Union();
 		msgtype = network::ServerMsgType::StopCooldown;
 	}
-	_user->sendMessage(_cooldownFBB, msgtype, msg);
+	_user->sendMessage(*fbb, msgtype, msg);
 }
 
 bool UserCooldownMgr::getDirtyModels(Models& models) {
@@ -27,7 +27,6 @@ private:
 	persistence::DBHandlerPtr _dbHandler;
 	persistence::PersistenceMgrPtr _persistenceMgr;
 	User* _user;
-	mutable flatbuffers::FlatBufferBuilder _cooldownFBB;
 	std::vector<db::CooldownModel> _dirtyModels;
 public:
 	UserCooldownMgr(User* user,
@@ -5,6 +5,7 @@
 #include "UserMovementMgr.h"
 #include "backend/entity/User.h"
 #include "backend/world/Map.h"
+#include "backend/network/ServerMessageSender.h"
 #include "core/Trace.h"
 #include "core/GLM.h"
 #include <glm/gtc/constants.hpp>
@@ -38,9 +39,10 @@ void UserMovementMgr::update(long dt) {
 
 	if (_sendUpdate || _movement.animation() != oldAnimation || !glm::all(glm::epsilonEqual(oldPos, newPos, glm::epsilon<float>()))) {
 		const network::Vec3 netPos { newPos.x, newPos.y, newPos.z };
-		_user->sendToVisible(_entityUpdateFBB,
+		auto fbb = _user->messageSender()->builder();
+		_user->sendToVisible(*fbb,
 				network::ServerMsgType::EntityUpdate,
-				network::CreateEntityUpdate(_entityUpdateFBB, _user->id(), &netPos, orientation, _movement.animation()).Union(), true, 0u);
+				network::CreateEntityUpdate(*fbb, _user->id(), &netPos, orientation, _movement.animation()).Union(), true, 0u);
 		_sendUpdate = false;
 	}
 
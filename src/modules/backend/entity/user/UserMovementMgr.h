@@ -15,7 +15,6 @@ class UserMovementMgr : public core::IComponent {
 private:
 	shared::SharedMovement _movement;
 	User* _user;
-	flatbuffers::FlatBufferBuilder _entityUpdateFBB;
 	bool _sendUpdate = false;
 public:
 	UserMovementMgr(User* user);
@@ -45,4 +45,11 @@ ENTITYIDTYPEEVENT(EntityDeleteEvent)
 
 ENTITYEVENT(EntityAddEvent)
 
+/**
+ * @brief Register a spawned npc in the @c EntityStorage
+ *
+ * @note The maps might be ticked in parallel - that's why they may not touch the storage directly.
+ */
+EVENTBUSPAYLOADEVENT(NpcSpawnEvent, NpcPtr);
+
 }
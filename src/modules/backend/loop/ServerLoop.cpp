@@ -8,6 +8,8 @@
 #include "command/Command.h"
 #include "core/Var.h"
 #include "core/Log.h"
+#include "core/StringUtil.h"
+#include "core/TimeProvider.h"
 #include "app/App.h"
 #include "io/Filesystem.h"
 #include "core/Password.h"
@@ -27,6 +29,7 @@
 #include "backend/network/MoveHandler.h"
 #include "backend/network/SignupHandler.h"
 #include "backend/network/SignupValidateHandler.h"
+#include "backend/network/SnapshotAckHandler.h"
 #include "persistence/PersistenceMgr.h"
 #include "backend/world/World.h"
 #include "command/CommandHandler.h"
@@ -234,19 +237,21 @@ bool ServerLoop::init() {
 	}
 
 	const int httpPort = core::Var::getSafe(cfg::ServerHttpPort)->intVal();
-	if (!_httpServer->init(httpPort)) {
+	// the requests are handled by the event loop that is run in update()
+	if (!_httpServer->init(httpPort, _loop)) {
 		Log::error("Failed to initialize the HTTP server on port %i", httpPort);
 		return false;
 	}
 	Log::info("Listen for HTTP requests at port %i", httpPort);
 
-	_httpServer->registerRoute(http::HttpMethod::GET, "/info", [] (const http::RequestParser& request, http::HttpResponse* response) {
-		response->setText("Server info");
+	_httpServer->registerRoute(http::HttpMethod::GET, "/info", [this] (const http::RequestParser& request, http::HttpResponse* response) {
+		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_JSON);
+		response->setText(infoJson());
 	});
 
-	_httpServer->registerRoute(http::HttpMethod::GET, "/health", [] (const http::RequestParser& request, http::HttpResponse* response) {
+	_httpServer->registerRoute(http::HttpMethod::GET, "/health", [this] (const http::RequestParser& request, http::HttpResponse* response) {
 		response->headers.put(http::header::CONTENT_TYPE, http::mimetype::APPLICATION_JSON);
-		response->setText("{\"status\": \"up\"}");
+		response->setText(healthJson());
 	});
 
 	if (!_entityStorage->init()) {
@@ -332,6 +337,7 @@ bool ServerLoop::init() {
 	r->registerHandler(network::ClientMsgType::UserDisconnect, std::make_shared<UserDisconnectHandler>());
 	r->registerHandler(network::ClientMsgType::TriggerAction, std::make_shared<TriggerActionHandler>());
 	r->registerHandler(network::ClientMsgType::Move, std::make_shared<MoveHandler>());
+	r->registerHandler(network::ClientMsgType::SnapshotAck, std::make_shared<SnapshotAckHandler>());
 	r->registerHandler(network::ClientMsgType::VarUpdate, std::make_shared<VarUpdateHandler>());
 
 	Log::info("Init material");
@@ -347,24 +353,28 @@ bool ServerLoop::init() {
 	}
 
 	Log::info("Init timers");
-	_worldTimer = new uv_timer_t;
-	uv_timer_init(_loop, _worldTimer);
-	addTimer(_worldTimer, [] (uv_timer_t* handle) {
-		core_trace_scoped(WorldTimer);
-		const ServerLoop* loop = (const ServerLoop*)handle->data;
-		loop->_world->update(handle->repeat);
-	}, 100);
+	_tickMillis = core::Var::getSafe(cfg::ServerTickMillis);
+	_maxCatchUpTicks = core::Var::getSafe(cfg::ServerMaxCatchUpTicks);
 
 	_persistenceMgrTimer = new uv_timer_t;
 	uv_timer_init(_loop, _persistenceMgrTimer);
 	addTimer(_persistenceMgrTimer, [] (uv_timer_t* handle) {
 		core_trace_scoped(PersistenceTimer);
-		const ServerLoop* loop = (const ServerLoop*)handle->data;
+		ServerLoop* loop = (ServerLoop*)handle->data;
 		const long dt = handle->repeat;
-		const persistence::PersistenceMgrPtr& persistenceMgr = loop->_persistenceMgr;
-		app::App::getInstance()->threadPool().enqueue([=] () {
-			persistenceMgr->update(dt);
-		});
+		const uint64_t start = core::TimeProvider::highResTime();
+		// only copies the dirty models - the database is written by the persistence writer thread
+		loop->_persistenceMgr->update(dt);
+		const uint32_t micros = TickScheduler::micros(start);
+		loop->_tickScheduler.addPhase(TickPhase::Persistence, micros);
+		loop->_metricMgr->onTickPhase(TickPhase::Persistence, micros);
+		const persistence::PersistenceMgr::Stats& stats = loop->_persistenceMgr->stats();
+		const metric::MetricPtr& metric = loop->_metricMgr->metric();
+		metric->gauge("persistence.pending", (uint32_t)stats.pending);
+		metric->count("persistence.failed", (int)(stats.failedRows - loop->_persistenceFailedRows));
+		metric->count("persistence.backpressure", (int)(stats.backPressureWaits - loop->_persistenceBackPressureWaits));
+		loop->_persistenceFailedRows = stats.failedRows;
+		loop->_persistenceBackPressureWaits = stats.backPressureWaits;
 	}, 10000);
 
 	_idleTimer = new uv_idle_t;
@@ -396,6 +406,9 @@ bool ServerLoop::init() {
 		return false;
 	}
 	Log::info("Server socket is up at %s:%i", host->strVal().c_str(), port->intVal());
+	if (!_network->setTrustedHosts(core::Var::getSafe(cfg::ServerTrustedHosts)->strVal())) {
+		Log::warn("Not all of the trusted hosts could get resolved");
+	}
 
 	return true;
 }
@@ -413,9 +426,6 @@ void ServerLoop::shutdown() {
 		if (_signal != nullptr) {
 			uv_close((uv_handle_t*)_signal, nullptr);
 		}
-		if (_worldTimer != nullptr) {
-			uv_close((uv_handle_t*)_worldTimer, nullptr);
-		}
 		if (_persistenceMgrTimer != nullptr) {
 			uv_close((uv_handle_t*)_persistenceMgrTimer, nullptr);
 		}
@@ -427,8 +437,6 @@ void ServerLoop::shutdown() {
 		core_assert_always(uv_loop_close(_loop) == 0);
 		delete _signal;
 		_signal = nullptr;
-		delete _worldTimer;
-		_worldTimer = nullptr;
 		delete _persistenceMgrTimer;
 		_persistenceMgrTimer = nullptr;
 		delete _idleTimer;
@@ -440,12 +448,79 @@ void ServerLoop::shutdown() {
 
 void ServerLoop::update() {
 	core_trace_scoped(ServerLoop);
-	// not everything is ticked in here directly, a lot is handled by libuv timers
+	// not everything is ticked in here directly, the persistence is handled by a libuv timer and the
+	// http requests are answered in here, too
 	uv_run(_loop, UV_RUN_NOWAIT);
-	_network->update();
-	_httpServer->update();
+	{
+		const TickScheduler::ScopedPhase phase(_tickScheduler, TickPhase::Network);
+		_network->update();
+	}
+
+	_tickScheduler.configure((uint32_t)core_max(1, _tickMillis->intVal()), _maxCatchUpTicks->intVal());
+	const uint64_t skippedBefore = _tickScheduler.skippedTicks();
+	const int ticks = _tickScheduler.advance(core::TimeProvider::systemMillis());
+	const uint64_t skipped = _tickScheduler.skippedTicks() - skippedBefore;
+	if (skipped > 0u) {
+		Log::warn("Server is behind - skipped %u ticks", (uint32_t)skipped);
+		_metricMgr->metric()->count("server.tick.skipped", (int)skipped);
+	}
+	for (int i = 0; i < ticks; ++i) {
+		tick();
+	}
 
 	replicateVars();
+	_messageSender->flush();
+}
+
+void ServerLoop::tick() {
+	core_trace_scoped(ServerTick);
+	_tickScheduler.beginTick();
+	_world->update((long)_tickScheduler.tickMillis());
+
+	// the maps only measure their own phases - sum them up to get the time of the whole tick
+	uint32_t phaseMicros[(int)TickPhase::Max] {};
+	_world->visit([&] (const MapPtr& map) {
+		const Map::TickStats& stats = map->tickStats();
+		for (int i = 0; i < (int)TickPhase::Max; ++i) {
+			phaseMicros[i] += stats.phaseMicros[i];
+		}
+	});
+	for (int i = (int)TickPhase::AI; i <= (int)TickPhase::Send; ++i) {
+		const TickPhase phase = (TickPhase)i;
+		_tickScheduler.addPhase(phase, phaseMicros[i]);
+		_metricMgr->onTickPhase(phase, phaseMicros[i]);
+	}
+	_metricMgr->onTickPhase(TickPhase::Network, _tickScheduler.lastMicros(TickPhase::Network));
+
+	const bool overrun = _tickScheduler.endTick();
+	if (overrun) {
+		Log::debug("Tick took %u micros - the budget is %u millis", _tickScheduler.lastTickMicros(), _tickScheduler.tickMillis());
+	}
+	_metricMgr->onTick(_tickScheduler.lastTickMicros(), overrun);
+}
+
+core::String ServerLoop::infoJson() const {
+	core::String json = "{\"tick\": ";
+	json += _tickScheduler.toJson();
+	json += ", \"maps\": [";
+	bool first = true;
+	_world->visit([&] (const MapPtr& map) {
+		const Map::TickStats& stats = map->tickStats();
+		if (!first) {
+			json += ", ";
+		}
+		first = false;
+		json += core::string::format("{\"id\": %i, \"users\": %i, \"npcs\": %i, \"ticks\": %u, \"overruns\": %u, \"lastmicros\": %u}",
+				(int)map->id(), map->userCount(), map->npcCount(), (uint32_t)stats.ticks, (uint32_t)stats.overruns, stats.lastMicros);
+	});
+	json += "]}";
+	return json;
+}
+
+core::String ServerLoop::healthJson() const {
+	const metric::Histogram& ticks = _tickScheduler.ticks();
+	return core::string::format("{\"status\": \"up\", \"tick\": {\"overruns\": %u, \"skipped\": %u, \"p99\": %u, \"max\": %u}}",
+			(uint32_t)_tickScheduler.overruns(), (uint32_t)_tickScheduler.skippedTicks(), ticks.percentile(99.0f), ticks.max());
 }
 
 void ServerLoop::replicateVars() const {
@@ -457,17 +532,17 @@ void ServerLoop::replicateVars() const {
 	if (vars.empty()) {
 		return;
 	}
-	static flatbuffers::FlatBufferBuilder fbb;
-	auto fbbVars = fbb.CreateVector<flatbuffers::Offset<network::Var>>(vars.size(),
+	auto fbb = _messageSender->builder();
+	auto fbbVars = fbb->CreateVector<flatbuffers::Offset<network::Var>>(vars.size(),
 		[&] (size_t i) {
 			const core::String& sname = vars[i]->name();
 			const core::String& svalue = vars[i]->strVal();
-			auto name = fbb.CreateString(sname.c_str(), sname.size());
-			auto value = fbb.CreateString(svalue.c_str(), svalue.size());
-			return network::CreateVar(fbb, name, value);
+			auto name = fbb->CreateString(sname.c_str(), sname.size());
+			auto value = fbb->CreateString(svalue.c_str(), svalue.size());
+			return network::CreateVar(*fbb, name, value);
 		});
-	_messageSender->broadcastServerMessage(fbb, network::ServerMsgType::VarUpdate,
-			network::CreateVarUpdate(fbb, fbbVars).Union());
+	_messageSender->broadcastServerMessage(*fbb, network::ServerMsgType::VarUpdate,
+			network::CreateVarUpdate(*fbb, fbbVars).Union());
 }
 
 // TODO: doesn't belong here
@@ -475,6 +550,7 @@ void ServerLoop::onEvent(const network::DisconnectEvent& event) {
 	core_trace_scoped(OnDisconnectEvent);
 	ENetPeer* peer = event.peer();
 	Log::info("disconnect peer: %u", peer->connectID);
+	_messageSender->discard(peer);
 	User* user = reinterpret_cast<User*>(peer->data);
 	if (user == nullptr) {
 		return;
@@ -16,6 +16,7 @@
 #include "backend/entity/EntityStorage.h"
 #include "persistence/DBHandler.h"
 #include "http/HttpServer.h"
+#include "TickScheduler.h"
 
 #include <uv.h>
 
@@ -43,13 +44,25 @@ private:
 	voxelformat::VolumeCachePtr _volumeCache;
 	http::HttpServerPtr _httpServer;
 
+	TickScheduler _tickScheduler;
+	core::VarPtr _tickMillis;
+	core::VarPtr _maxCatchUpTicks;
+
 	uv_loop_t *_loop = nullptr;
-	uv_timer_t *_worldTimer = nullptr;
 	uv_timer_t *_persistenceMgrTimer = nullptr;
+	// the persistence counters that were already reported as metric
+	uint32_t _persistenceFailedRows = 0u;
+	uint32_t _persistenceBackPressureWaits = 0u;
 	uv_idle_t *_idleTimer = nullptr;
 	uv_signal_t *_signal = nullptr;
 
 	void replicateVars() const;
+	/**
+	 * @brief Runs one fixed timestep tick of the world
+	 */
+	void tick();
+	core::String infoJson() const;
+	core::String healthJson() const;
 	static void onIdle(uv_idle_t* handle);
 	static void signalCallback(uv_signal_t* handle, int signum);
 	bool addTimer(uv_timer_t* timer, uv_timer_cb cb, uint64_t repeatMillis, uint64_t initialDelayMillis = 0);
@@ -70,9 +83,15 @@ public:
 	void shutdown() override;
 	void update();
 
+	const TickScheduler& tickScheduler() const;
+
 	void onEvent(const network::DisconnectEvent& event) override;
 };
 
+inline const TickScheduler& ServerLoop::tickScheduler() const {
+	return _tickScheduler;
+}
+
 typedef std::shared_ptr<ServerLoop> ServerLoopPtr;
 
 }
@@ -0,0 +1,112 @@
+/**
+ * @file
+ */
+
+#include "TickScheduler.h"
+#include "core/TimeProvider.h"
+#include "core/StringUtil.h"
+#include "core/Assert.h"
+#include "core/ArrayLength.h"
+
+namespace backend {
+
+static const char *TickPhaseNames[] = {
+	"network",
+	"ai",
+	"entities",
+	"visibility",
+	"send",
+	"persistence"
+};
+static_assert(lengthof(TickPhaseNames) == (int)TickPhase::Max, "Invalid tick phase mapping");
+
+const char* toString(TickPhase phase) {
+	return TickPhaseNames[(int)phase];
+}
+
+TickScheduler::TickScheduler(uint32_t tickMillis, int maxCatchUpTicks) {
+	configure(tickMillis, maxCatchUpTicks);
+}
+
+TickScheduler::ScopedPhase::ScopedPhase(TickScheduler& scheduler, TickPhase phase) :
+		_scheduler(scheduler), _phase(phase), _start(core::TimeProvider::highResTime()) {
+}
+
+TickScheduler::ScopedPhase::~ScopedPhase() {
+	_scheduler.addPhase(_phase, micros(_start));
+}
+
+uint32_t TickScheduler::micros(uint64_t highResStart) {
+	const uint64_t delta = core::TimeProvider::highResTime() - highResStart;
+	return (uint32_t)(delta * 1000000u / core::TimeProvider::highResTimeResolution());
+}
+
+void TickScheduler::configure(uint32_t tickMillis, int maxCatchUpTicks) {
+	core_assert_msg(tickMillis > 0u, "Invalid tick interval given: %u", tickMillis);
+	_tickMillis = tickMillis > 0u ? tickMillis : 1u;
+	_maxCatchUpTicks = maxCatchUpTicks > 0 ? maxCatchUpTicks : 1;
+}
+
+int TickScheduler::advance(uint64_t nowMillis) {
+	if (!_started) {
+		_started = true;
+		_lastMillis = nowMillis;
+		return 0;
+	}
+	if (nowMillis > _lastMillis) {
+		_accumulatedMillis += nowMillis - _lastMillis;
+	}
+	_lastMillis = nowMillis;
+	uint64_t ticks = _accumulatedMillis / _tickMillis;
+	if (ticks > (uint64_t)_maxCatchUpTicks) {
+		// we are too far behind - catching up would only lead to even longer frames
+		_skippedTicks += ticks - _maxCatchUpTicks;
+		ticks = _maxCatchUpTicks;
+		_accumulatedMillis %= _tickMillis;
+	} else {
+		_accumulatedMillis -= ticks * _tickMillis;
+	}
+	return (int)ticks;
+}
+
+void TickScheduler::beginTick() {
+	_tickStart = core::TimeProvider::highResTime();
+}
+
+bool TickScheduler::endTick() {
+	_lastTickMicros = micros(_tickStart);
+	_ticks.add(_lastTickMicros);
+	++_tickCount;
+	if (_lastTickMicros <= _tickMillis * 1000u) {
+		return false;
+	}
+	++_overruns;
+	return true;
+}
+
+void TickScheduler::addPhase(TickPhase phase, uint32_t micros) {
+	_phases[(int)phase].add(micros);
+	_lastPhaseMicros[(int)phase] = micros;
+}
+
+static void appendHistogram(core::String& json, const char *name, const metric::Histogram& h) {
+	json += core::string::format("\"%s\": {\"count\": %u, \"min\": %u, \"max\": %u, \"mean\": %u, \"p50\": %u, \"p90\": %u, \"p99\": %u}",
+			name, h.count(), h.min(), h.max(), h.mean(), h.percentile(50.0f), h.percentile(90.0f), h.percentile(99.0f));
+}
+
+core::String TickScheduler::toJson() const {
+	core::String json = core::string::format("{\"tickmillis\": %u, \"ticks\": %u, \"overruns\": %u, \"skipped\": %u, \"lastmicros\": %u, ",
+			_tickMillis, (uint32_t)_tickCount, (uint32_t)_overruns, (uint32_t)_skippedTicks, _lastTickMicros);
+	appendHistogram(json, "tick", _ticks);
+	json += ", \"phases\": {";
+	for (int i = 0; i < (int)TickPhase::Max; ++i) {
+		if (i > 0) {
+			json += ", ";
+		}
+		appendHistogram(json, toString((TickPhase)i), _phases[i]);
+	}
+	json += "}}";
+	return json;
+}
+
+}
@@ -0,0 +1,140 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/String.h"
+#include "metric/Histogram.h"
+#include <stdint.h>
+
+namespace backend {
+
+/**
+ * @brief The phases of a server tick in the order they are executed
+ */
+enum class TickPhase : uint8_t {
+	Network,
+	AI,
+	Entities,
+	Visibility,
+	Send,
+	Persistence,
+
+	Max
+};
+
+const char* toString(TickPhase phase);
+
+/**
+ * @brief Fixed timestep scheduler for the server tick
+ *
+ * Collects the timings of the single @c TickPhase values in histograms and detects ticks that
+ * took longer than the tick interval. If the server falls behind, up to @c maxCatchUpTicks
+ * ticks are executed in one frame - the remaining backlog is dropped.
+ */
+class TickScheduler {
+private:
+	uint32_t _tickMillis;
+	int _maxCatchUpTicks;
+	uint64_t _lastMillis = 0u;
+	uint64_t _accumulatedMillis = 0u;
+	bool _started = false;
+
+	uint64_t _tickStart = 0u;
+	metric::Histogram _phases[(int)TickPhase::Max];
+	uint32_t _lastPhaseMicros[(int)TickPhase::Max] {};
+	metric::Histogram _ticks;
+	uint64_t _tickCount = 0u;
+	uint64_t _overruns = 0u;
+	uint64_t _skippedTicks = 0u;
+	uint32_t _lastTickMicros = 0u;
+public:
+	TickScheduler(uint32_t tickMillis = 100u, int maxCatchUpTicks = 3);
+
+	/**
+	 * @brief Measures the duration of a @c TickPhase and records it in the scheduler
+	 */
+	class ScopedPhase {
+	private:
+		TickScheduler& _scheduler;
+		const TickPhase _phase;
+		const uint64_t _start;
+	public:
+		ScopedPhase(TickScheduler& scheduler, TickPhase phase);
+		~ScopedPhase();
+	};
+
+	/**
+	 * @brief Changes the tick interval and the catch-up policy - the accumulated time is kept
+	 */
+	void configure(uint32_t tickMillis, int maxCatchUpTicks);
+
+	/**
+	 * @param[in] nowMillis The current time in millis
+	 * @return The amount of ticks that should get executed now. Never more than the configured
+	 * max catch-up ticks.
+	 */
+	int advance(uint64_t nowMillis);
+
+	void beginTick();
+	/**
+	 * @return @c true if the tick took longer than the tick interval
+	 */
+	bool endTick();
+
+	void addPhase(TickPhase phase, uint32_t micros);
+
+	/**
+	 * @return The phase histograms, the tick histogram and the counters as json object
+	 */
+	core::String toJson() const;
+
+	const metric::Histogram& phase(TickPhase phase) const;
+	const metric::Histogram& ticks() const;
+	uint32_t lastMicros(TickPhase phase) const;
+	uint32_t tickMillis() const;
+	uint64_t tickCount() const;
+	uint64_t overruns() const;
+	uint64_t skippedTicks() const;
+	uint32_t lastTickMicros() const;
+
+	/**
+	 * @return The elapsed micros since the given @c core::TimeProvider::highResTime() value
+	 */
+	static uint32_t micros(uint64_t highResStart);
+};
+
+inline const metric::Histogram& TickScheduler::phase(TickPhase phase) const {
+	return _phases[(int)phase];
+}
+
+inline uint32_t TickScheduler::lastMicros(TickPhase phase) const {
+	return _lastPhaseMicros[(int)phase];
+}
+
+inline const metric::Histogram& TickScheduler::ticks() const {
+	return _ticks;
+}
+
+inline uint32_t TickScheduler::tickMillis() const {
+	return _tickMillis;
+}
+
+inline uint64_t TickScheduler::tickCount() const {
+	return _tickCount;
+}
+
+inline uint64_t TickScheduler::overruns() const {
+	return _overruns;
+}
+
+inline uint64_t TickScheduler::skippedTicks() const {
+	return _skippedTicks;
+}
+
+inline uint32_t TickScheduler::lastTickMicros() const {
+	return _lastTickMicros;
+}
+
+}
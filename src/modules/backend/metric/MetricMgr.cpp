@@ -5,6 +5,7 @@
 #include "MetricMgr.h"
 #include "core/Log.h"
 #include "core/EventBus.h"
+#include "core/StringUtil.h"
 #include "backend/entity/Entity.h"
 #include "metric/UDPMetricSender.h"
 #include "shared/ProtocolEnum.h"
@@ -16,6 +17,9 @@ MetricMgr::MetricMgr(
 		const metric::MetricPtr& metric,
 		const core::EventBusPtr& eventBus) :
 		_metric(metric) {
+	for (int i = 0; i < (int)TickPhase::Max; ++i) {
+		_tickPhaseKeys[i] = core::string::format("server.tick.%s", toString((TickPhase)i));
+	}
 	eventBus->subscribe<EntityAddToMapEvent>(*this);
 	eventBus->subscribe<EntityRemoveFromMapEvent>(*this);
 	eventBus->subscribe<EntityAddEvent>(*this);
@@ -53,6 +57,17 @@ void MetricMgr::onEvent(const metric::MetricEvent& event) {
 	}
 }
 
+void MetricMgr::onTickPhase(TickPhase phase, uint32_t micros) {
+	_metric->histogram(_tickPhaseKeys[(int)phase].c_str(), micros);
+}
+
+void MetricMgr::onTick(uint32_t micros, bool overrun) {
+	_metric->histogram("server.tick", micros);
+	if (overrun) {
+		_metric->increment("server.tick.overruns");
+	}
+}
+
 void MetricMgr::onEvent(const network::NewConnectionEvent& event) {
 	Log::info("new connection - waiting for login request from %u", event.get()->connectID);
 	_metric->increment("count.user");
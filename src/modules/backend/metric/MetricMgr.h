@@ -7,6 +7,7 @@
 #include "core/EventBus.h"
 #include "core/IComponent.h"
 #include "backend/eventbus/Event.h"
+#include "backend/loop/TickScheduler.h"
 #include "metric/Metric.h"
 #include "metric/MetricEvent.h"
 #include "metric/IMetricSender.h"
@@ -25,6 +26,7 @@ class MetricMgr :
 	public core::IEventBusHandler<EntityAddEvent> {
 private:
 	metric::MetricPtr _metric;
+	core::String _tickPhaseKeys[(int)TickPhase::Max];
 public:
 	MetricMgr(const metric::MetricPtr& metric, const core::EventBusPtr& eventBus);
 
@@ -35,6 +37,12 @@ public:
 	void onEvent(const EntityDeleteEvent& event) override;
 	void onEvent(const EntityAddEvent& event) override;
 
+	void onTickPhase(TickPhase phase, uint32_t micros);
+	/**
+	 * @param[in] overrun @c true if the tick took longer than the tick interval
+	 */
+	void onTick(uint32_t micros, bool overrun);
+
 	metric::MetricPtr& metric();
 
 	bool init() override;
@@ -0,0 +1,91 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
+#include <flatbuffers/flatbuffers.h>
+#include <memory>
+#include <vector>
+
+namespace network {
+
+/**
+ * @brief Hands out cleared @c flatbuffers::FlatBufferBuilder instances and takes them back once the
+ * message was queued. The builders keep their grown buffers - so after a few ticks no allocation
+ * is needed anymore to build a message.
+ *
+ * @note The pool is thread safe - the maps are ticked in parallel.
+ */
+class FlatBufferBuilderPool {
+public:
+	/**
+	 * @brief RAII handle that gives the builder back to the pool
+	 */
+	class Builder {
+	private:
+		FlatBufferBuilderPool* _pool;
+		flatbuffers::FlatBufferBuilder* _fbb;
+	public:
+		Builder(FlatBufferBuilderPool* pool, flatbuffers::FlatBufferBuilder* fbb) :
+				_pool(pool), _fbb(fbb) {
+		}
+		Builder(Builder&& other) noexcept :
+				_pool(other._pool), _fbb(other._fbb) {
+			other._fbb = nullptr;
+		}
+		Builder(const Builder&) = delete;
+		Builder& operator=(const Builder&) = delete;
+		~Builder() {
+			if (_fbb != nullptr) {
+				_pool->release(_fbb);
+			}
+		}
+
+		inline flatbuffers::FlatBufferBuilder& operator*() const {
+			return *_fbb;
+		}
+		inline flatbuffers::FlatBufferBuilder* operator->() const {
+			return _fbb;
+		}
+	};
+
+private:
+	std::vector<std::unique_ptr<flatbuffers::FlatBufferBuilder>> _builders;
+	std::vector<flatbuffers::FlatBufferBuilder*> _free;
+	core_trace_mutex(core::Lock, _lock, "FlatBufferBuilderPool");
+	size_t _initialSize;
+
+	void release(flatbuffers::FlatBufferBuilder* fbb) {
+		fbb->Clear();
+		core::ScopedLock<core::Lock> scoped(_lock);
+		_free.push_back(fbb);
+	}
+public:
+	FlatBufferBuilderPool(size_t initialSize = 1024u) :
+			_initialSize(initialSize) {
+	}
+
+	Builder acquire() {
+		core::ScopedLock<core::Lock> scoped(_lock);
+		if (_free.empty()) {
+			_builders.emplace_back(new flatbuffers::FlatBufferBuilder(_initialSize));
+			return Builder(this, _builders.back().get());
+		}
+		flatbuffers::FlatBufferBuilder* fbb = _free.back();
+		_free.pop_back();
+		return Builder(this, fbb);
+	}
+
+	/**
+	 * @return The amount of builders that were created by this pool
+	 */
+	size_t size() const {
+		core::ScopedLock<core::Lock> scoped(_lock);
+		return _builders.size();
+	}
+};
+
+}
@@ -3,6 +3,8 @@
  */
 
 #include "ServerMessageSender.h"
+#include "network/PacketFrame.h"
+#include "core/TimeProvider.h"
 #include "core/Log.h"
 #include "core/Common.h"
 #include "core/Assert.h"
@@ -10,24 +12,102 @@
 
 namespace network {
 
+ServerMessageSender::ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric, size_t maxPacketSize) :
+		_network(network), _metric(metric), _maxPacketSize(maxPacketSize) {
+}
+
+ServerMessageSender::~ServerMessageSender() {
+	core::ScopedLock<core::Lock> scoped(_lock);
+	for (auto& e : _queues) {
+		for (ENetPacket* packet : e.second.packets) {
+			enet_packet_destroy(packet);
+		}
+	}
+	_queues.clear();
+}
+
+int ServerMessageSender::queue(uint32_t flags) {
+	if (flags == ENET_PACKET_FLAG_RELIABLE) {
+		return Queue::Reliable;
+	}
+	if (flags == 0u) {
+		return Queue::Unreliable;
+	}
+	return -1;
+}
+
 ENetPacket* ServerMessageSender::createServerPacket(ServerMsgType type, const void * data, size_t dataLength, uint32_t flags) {
-	ENetPacket* packet = enet_packet_create(data, dataLength, flags);
-	const char *msgType = EnumNameServerMsgType(type);
-	Log::trace(logid, "Create server package: %s - size %u", msgType, (unsigned int)dataLength);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)dataLength, tags);
+	ENetPacket* packet = enet_packet_create(nullptr, frameSize(dataLength), flags);
+	writeFrame(packet->data, data, dataLength);
+	Log::trace(logid, "Create server package: %s - size %u", EnumNameServerMsgType(type), (unsigned int)dataLength);
+	core::ScopedLock<core::Lock> scoped(_lock);
+	MessageStats& stats = _messageStats[(int)type];
+	++stats.count;
+	stats.bytes += dataLength;
 	return packet;
 }
 
-ENetPacket* ServerMessageSender::createServerPacket(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
+const uint8_t* ServerMessageSender::finish(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data) const {
 	auto msg = CreateServerMessage(fbb, type, data);
 	FinishServerMessageBuffer(fbb, msg);
-	return createServerPacket(type, fbb.GetBufferPointer(), fbb.GetSize(), flags);
+	return fbb.GetBufferPointer();
+}
+
+bool ServerMessageSender::send(ENetPeer* peer, ENetPacket* packet) {
+	++_packets;
+	// the network serializes the enet calls - the maps send from their own threads
+	if (_network->queuePacket(peer, packet)) {
+		return true;
+	}
+	Log::trace(logid, "Could not send packet of size %u to peer %u", (unsigned int)packet->dataLength, peer->connectID);
+	++_notSent;
+	return false;
+}
+
+void ServerMessageSender::release(ENetPacket* packet) {
+	// enet takes the ownership once the packet was queued for at least one peer
+	if (packet->referenceCount == 0u) {
+		enet_packet_destroy(packet);
+	}
+}
+
+void ServerMessageSender::flushQueue(ENetPeer* peer, PeerQueue& queue, int index) {
+	ENetPacket* packet = queue.packets[index];
+	if (packet == nullptr) {
+		return;
+	}
+	queue.packets[index] = nullptr;
+	send(peer, packet);
+	release(packet);
 }
 
-ServerMessageSender::ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric) :
-		_network(network), _metric(metric) {
+bool ServerMessageSender::enqueue(ENetPeer* peer, const uint8_t* message, size_t size, uint32_t flags) {
+	const size_t frame = frameSize(size);
+	const int index = queue(flags);
+	PeerQueue& peerQueue = _queues[peer];
+	if (index == -1 || frame > _maxPacketSize) {
+		// keep the order of the reliable messages
+		flushQueue(peer, peerQueue, Queue::Reliable);
+		ENetPacket* packet = enet_packet_create(nullptr, frame, flags);
+		writeFrame(packet->data, message, size);
+		const bool sent = send(peer, packet);
+		release(packet);
+		return sent;
+	}
+	ENetPacket* packet = peerQueue.packets[index];
+	if (packet != nullptr && packet->dataLength + frame > _maxPacketSize) {
+		flushQueue(peer, peerQueue, index);
+		packet = nullptr;
+	}
+	if (packet == nullptr) {
+		// allocated with the max size - the data length is the part that is already filled
+		packet = enet_packet_create(nullptr, _maxPacketSize, flags);
+		packet->dataLength = 0u;
+		peerQueue.packets[index] = packet;
+	}
+	writeFrame(packet->data + packet->dataLength, message, size);
+	packet->dataLength += frame;
+	return true;
 }
 
 bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
@@ -36,28 +116,34 @@ bool ServerMessageSender::sendServerMessage(ENetPeer* peer, FlatBufferBuilder& f
 }
 
 bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags) {
-	const char *msgType = network::EnumNameServerMsgType(type);
-	Log::debug(logid, "Send %s to %i peers", msgType, numPeers);
+	Log::debug(logid, "Send %s to %i peers", EnumNameServerMsgType(type), numPeers);
 	core_assert(numPeers > 0);
+	const uint8_t* message = finish(fbb, type, data);
+	const size_t size = fbb.GetSize();
+	const size_t frame = frameSize(size);
 	int sent = 0;
-	int notsent = 0;
-	auto packet = createServerPacket(fbb, type, data, flags);
-	const metric::TagMap& tags {{"direction", "out"}, {"type", msgType}};
 	{
-		// TODO: lock
-		for (int i = 0; i < numPeers; ++i) {
-			if (!_network->sendMessage(peers[i], packet)) {
-				++notsent;
-				Log::trace(logid, "Could not send message of type %s to peer %i", msgType, i);
-			} else {
-				++sent;
+		core::ScopedLock<core::Lock> scoped(_lock);
+		MessageStats& stats = _messageStats[(int)type];
+		stats.count += numPeers;
+		stats.bytes += (uint64_t)size * numPeers;
+		if (numPeers > 1 && frame > _maxPacketSize) {
+			// too big to be coalesced - share one packet between all peers
+			ENetPacket* packet = enet_packet_create(nullptr, frame, flags);
+			writeFrame(packet->data, message, size);
+			for (int i = 0; i < numPeers; ++i) {
+				flushQueue(peers[i], _queues[peers[i]], Queue::Reliable);
+				if (send(peers[i], packet)) {
+					++sent;
+				}
+			}
+			release(packet);
+		} else {
+			for (int i = 0; i < numPeers; ++i) {
+				if (enqueue(peers[i], message, size, flags)) {
+					++sent;
+				}
 			}
-		}
-		if (notsent > 0) {
-			_metric->count("network_not_sent", notsent, tags);
-		}
-		if (sent > 0) {
-			_metric->count("network_sent", sent, tags);
 		}
 	}
 	fbb.Clear();
@@ -65,17 +151,92 @@ bool ServerMessageSender::sendServerMessage(ENetPeer** peers, int numPeers, Flat
 }
 
 bool ServerMessageSender::broadcastServerMessage(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, int channel, uint32_t flags) {
-	const char *msgType = network::EnumNameServerMsgType(type);
-	Log::debug(logid, "Broadcast %s on channel %i", msgType, channel);
+	Log::debug(logid, "Broadcast %s on channel %i", EnumNameServerMsgType(type), channel);
+	const uint8_t* message = finish(fbb, type, data);
+	const size_t size = fbb.GetSize();
 	bool success = false;
 	{
-		// TODO: lock
-		success = _network->broadcast(createServerPacket(fbb, type, data, flags), channel);
-		const metric::TagMap& tags {{"direction", "broadcast"}, {"type", msgType}};
-		_metric->count("network_sent", 1, tags);
+		core::ScopedLock<core::Lock> scoped(_lock);
+		flushAll();
+		MessageStats& stats = _messageStats[(int)type];
+		++stats.count;
+		stats.bytes += size;
+		ENetPacket* packet = enet_packet_create(nullptr, frameSize(size), flags);
+		writeFrame(packet->data, message, size);
+		++_packets;
+		success = _network->broadcast(packet, channel);
+		if (!success) {
+			++_notSent;
+			enet_packet_destroy(packet);
+		}
 	}
 	fbb.Clear();
 	return success;
 }
 
+void ServerMessageSender::flushAll() {
+	for (auto& e : _queues) {
+		for (int i = 0; i < Queue::Max; ++i) {
+			flushQueue(e.first, e.second, i);
+		}
+	}
+}
+
+void ServerMessageSender::flush() {
+	core_trace_scoped(ServerMessageSenderFlush);
+	core::ScopedLock<core::Lock> scoped(_lock);
+	flushAll();
+	const uint64_t now = core::TimeProvider::systemMillis();
+	if (now < _nextMetricsMillis) {
+		return;
+	}
+	_nextMetricsMillis = now + 1000u;
+	sendMetrics();
+}
+
+void ServerMessageSender::discard(ENetPeer* peer) {
+	core::ScopedLock<core::Lock> scoped(_lock);
+	auto i = _queues.find(peer);
+	if (i == _queues.end()) {
+		return;
+	}
+	for (ENetPacket* packet : i->second.packets) {
+		enet_packet_destroy(packet);
+	}
+	_queues.erase(i);
+}
+
+void ServerMessageSender::sendMetrics() {
+	for (int i = 0; i < MessageTypes; ++i) {
+		MessageStats& stats = _messageStats[i];
+		MessageStats& sent = _sentStats[i];
+		const uint64_t count = stats.count - sent.count;
+		if (count == 0u) {
+			continue;
+		}
+		const metric::TagMap& tags {{"direction", "out"}, {"type", EnumNameServerMsgType((ServerMsgType)i)}};
+		_metric->count("network_packet_count", (int)count, tags);
+		_metric->count("network_packet_size", (int)(stats.bytes - sent.bytes), tags);
+		sent = stats;
+	}
+	if (_packets != _sentPackets) {
+		_metric->count("network_sent", (int)(_packets - _sentPackets), {{"direction", "out"}});
+		_sentPackets = _packets;
+	}
+	if (_notSent != _sentNotSent) {
+		_metric->count("network_not_sent", (int)(_notSent - _sentNotSent), {{"direction", "out"}});
+		_sentNotSent = _notSent;
+	}
+}
+
+uint64_t ServerMessageSender::packets() const {
+	core::ScopedLock<core::Lock> scoped(_lock);
+	return _packets;
+}
+
+ServerMessageSender::MessageStats ServerMessageSender::messageStats(ServerMsgType type) const {
+	core::ScopedLock<core::Lock> scoped(_lock);
+	return _messageStats[(int)type];
+}
+
 }
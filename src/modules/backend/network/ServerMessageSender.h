@@ -6,8 +6,12 @@
 
 #include "ServerMessages_generated.h"
 #include "ServerNetwork.h"
+#include "FlatBufferBuilderPool.h"
 #include "metric/Metric.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
 #include "core/Log.h"
+#include <unordered_map>
 #include <memory>
 
 namespace network {
@@ -16,22 +20,99 @@ using namespace flatbuffers;
 
 /**
  * @brief Send messages from the server to the client(s)
+ *
+ * The messages for a peer are not sent directly, but coalesced into as few packets as possible until
+ * @c flush() is called. Every packet is split into frames - see @c PacketFrame.h. Reliable and unreliable
+ * messages are collected in different packets. Messages that don't fit into @c maxPacketSize() are
+ * sent in their own packet - if they go to several peers, the packet is shared and reference counted by enet.
+ *
+ * @note The messages can be queued from any thread - the maps are ticked in parallel.
  */
 class ServerMessageSender {
+public:
+	/**
+	 * @brief Counters of one @c ServerMsgType
+	 */
+	struct MessageStats {
+		uint64_t count = 0u;
+		uint64_t bytes = 0u;
+	};
 private:
 	static constexpr auto logid = Log::logid("ServerMessageSender");
+	static constexpr int MessageTypes = (int)ServerMsgType::MAX + 1;
+	// the queues are indexed by this - other flags are not coalesced
+	enum Queue { Reliable, Unreliable, Max };
+
+	struct PeerQueue {
+		ENetPacket* packets[Queue::Max] {};
+	};
+
 	ServerNetworkPtr _network;
 	metric::MetricPtr _metric;
+	FlatBufferBuilderPool _builderPool;
+	std::unordered_map<ENetPeer*, PeerQueue> _queues;
+	size_t _maxPacketSize;
+	mutable core_trace_mutex(core::Lock, _lock, "ServerMessageSender");
+
+	MessageStats _messageStats[MessageTypes];
+	MessageStats _sentStats[MessageTypes];
+	uint64_t _packets = 0u;
+	uint64_t _notSent = 0u;
+	uint64_t _sentPackets = 0u;
+	uint64_t _sentNotSent = 0u;
+	uint64_t _nextMetricsMillis = 0u;
 
+	static int queue(uint32_t flags);
+	const uint8_t* finish(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data) const;
+	bool send(ENetPeer* peer, ENetPacket* packet);
+	static void release(ENetPacket* packet);
+	void flushQueue(ENetPeer* peer, PeerQueue& queue, int index);
+	bool enqueue(ENetPeer* peer, const uint8_t* message, size_t size, uint32_t flags);
+	void flushAll();
+	void sendMetrics();
 public:
+	/**
+	 * @param maxPacketSize The size the coalesced packets may grow to - leave some room for the enet and udp
+	 * headers to prevent fragmentation.
+	 */
+	ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric, size_t maxPacketSize = ENET_HOST_DEFAULT_MTU - 100u);
+	~ServerMessageSender();
+
+	/**
+	 * @brief Creates a packet that only contains the given finished @c ServerMessage
+	 */
 	ENetPacket* createServerPacket(ServerMsgType type, const void * data, size_t dataLength, uint32_t flags);
-	ENetPacket* createServerPacket(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags);
-	ServerMessageSender(const ServerNetworkPtr& network, const metric::MetricPtr& metric);
+
+	/**
+	 * @return A cleared builder from the pool - it is given back once the handle goes out of scope
+	 */
+	FlatBufferBuilderPool::Builder builder();
 
 	bool sendServerMessage(ENetPeer* peer, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
 	bool sendServerMessage(std::vector<ENetPeer*> peers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
 	bool sendServerMessage(ENetPeer** peers, int numPeers, FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
+	/**
+	 * @note Flushes all queued messages before the broadcast is done
+	 */
 	bool broadcastServerMessage(FlatBufferBuilder& fbb, ServerMsgType type, Offset<void> data, int channel = 0, uint32_t flags = ENET_PACKET_FLAG_RELIABLE);
+
+	/**
+	 * @brief Hands the coalesced packets of all peers over to enet - call this once per frame
+	 * after the world was ticked.
+	 */
+	void flush();
+
+	/**
+	 * @brief Drops the queued messages of a peer - e.g. because it disconnected
+	 */
+	void discard(ENetPeer* peer);
+
+	size_t maxPacketSize() const;
+	/**
+	 * @return The amount of packets that were handed over to enet
+	 */
+	uint64_t packets() const;
+	MessageStats messageStats(ServerMsgType type) const;
 };
 
 typedef std::shared_ptr<ServerMessageSender> ServerMessageSenderPtr;
@@ -40,4 +121,12 @@ inline bool ServerMessageSender::sendServerMessage(std::vector<ENetPeer*> peers,
 	return sendServerMessage(&peers.front(), peers.size(), fbb, type, data, flags);
 }
 
+inline FlatBufferBuilderPool::Builder ServerMessageSender::builder() {
+	return _builderPool.acquire();
+}
+
+inline size_t ServerMessageSender::maxPacketSize() const {
+	return _maxPacketSize;
+}
+
 }
@@ -2,8 +2,9 @@
  * @file
  */
 
-#include "ClientMessages_generated.h"
 #include "ServerNetwork.h"
+#include "core/StringUtil.h"
+#include "core/TimeProvider.h"
 #include "core/Trace.h"
 #include "core/Log.h"
 
@@ -15,27 +16,105 @@ ServerNetwork::ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRe
 }
 
 bool ServerNetwork::packetReceived(ENetEvent& event) {
-	flatbuffers::Verifier v(event.packet->data, event.packet->dataLength);
-
-	if (!VerifyClientMessageBuffer(v)) {
-		Log::error("Illegal client packet received with length: %i", (int)event.packet->dataLength);
-		return false;
+	const uint8_t* data = (const uint8_t*)event.packet->data;
+	const size_t dataLength = event.packet->dataLength;
+	if (trusted(event.peer)) {
+		// the root offset and the vtable offset must at least be readable
+		if (dataLength < 2 * sizeof(flatbuffers::uoffset_t)) {
+			Log::error("Illegal client packet received with length: %i", (int)dataLength);
+			return false;
+		}
+	} else {
+		flatbuffers::Verifier v(data, dataLength);
+		if (!VerifyClientMessageBuffer(v)) {
+			Log::error("Illegal client packet received with length: %i", (int)dataLength);
+			return false;
+		}
 	}
-	const ClientMessage *req = GetClientMessage(event.packet->data);
-	ClientMsgType type = req->data_type();
-	const char *clientMsgType = EnumNameClientMsgType(type);
-	ProtocolHandlerPtr handler = _protocolHandlerRegistry->getHandler(type);
-	if (!handler) {
-		Log::error("No handler for client msg type %s", clientMsgType);
+	const ClientMessage *req = GetClientMessage(data);
+	const ClientMsgType type = req->data_type();
+	IProtocolHandler* handler = _protocolHandlerRegistry->handler(type);
+	if (handler == nullptr) {
+		Log::error("No handler for client msg type %s", EnumNameClientMsgType(type));
 		return false;
 	}
-	const metric::TagMap& tags  {{"direction", "in"}, {"type", clientMsgType}};
-	_metric->count("network_packet_count", 1, tags);
-	_metric->count("network_packet_size", (int)event.packet->dataLength, tags);
 
-	Log::debug("Received %s", clientMsgType);
-	handler->executeWithRaw(event.peer, req->data(), (const uint8_t*)event.packet->data, event.packet->dataLength);
+	Log::debug("Received %s", EnumNameClientMsgType(type));
+	const uint64_t start = core::TimeProvider::highResTime();
+	handler->executeWithRaw(event.peer, req->data(), data, dataLength);
+	const uint64_t delta = core::TimeProvider::highResTime() - start;
+	const uint32_t micros = (uint32_t)(delta * 1000000u / core::TimeProvider::highResTimeResolution());
+
+	// the type was either verified or the handler lookup would have failed
+	MessageStats& stats = _messageStats[(int)type];
+	++stats.count;
+	stats.bytes += dataLength;
+	stats.micros += micros;
+	if (micros > stats.maxMicros) {
+		stats.maxMicros = micros;
+	}
 	return true;
 }
 
+bool ServerNetwork::setTrustedHosts(const core::String& hosts) {
+	_trustedHosts.clear();
+	core::DynamicArray<core::String> tokens;
+	core::string::splitString(hosts, tokens, ", ");
+	bool success = true;
+	for (const core::String& host : tokens) {
+		ENetAddress address;
+		if (enet_address_set_host(&address, host.c_str()) < 0) {
+			Log::error("Could not resolve trusted host %s", host.c_str());
+			success = false;
+			continue;
+		}
+		_trustedHosts.push_back(address.host);
+	}
+	return success;
+}
+
+void ServerNetwork::peerConnected(ENetPeer* peer) {
+	for (enet_uint32 host : _trustedHosts) {
+		if (peer->address.host == host) {
+			Log::info("Trust peer %u", peer->connectID);
+			setTrusted(peer, true);
+			return;
+		}
+	}
+}
+
+void ServerNetwork::peerDisconnected(ENetPeer* peer) {
+	// enet reuses the peer slots
+	setTrusted(peer, false);
+}
+
+void ServerNetwork::update() {
+	Super::update();
+	const uint64_t now = core::TimeProvider::systemMillis();
+	if (now < _nextMetricsMillis) {
+		return;
+	}
+	_nextMetricsMillis = now + 1000u;
+	sendMetrics();
+}
+
+void ServerNetwork::sendMetrics() {
+	core_trace_scoped(ServerNetworkMetrics);
+	for (int i = 0; i < MessageTypes; ++i) {
+		MessageStats& stats = _messageStats[i];
+		MessageStats& sent = _sentStats[i];
+		const uint64_t count = stats.count - sent.count;
+		if (count == 0u) {
+			continue;
+		}
+		const metric::TagMap& tags {{"direction", "in"}, {"type", EnumNameClientMsgType((ClientMsgType)i)}};
+		_metric->count("network_packet_count", (int)count, tags);
+		_metric->count("network_packet_size", (int)(stats.bytes - sent.bytes), tags);
+		_metric->gauge("network_handler_micros", (uint32_t)((stats.micros - sent.micros) / count), tags);
+		_metric->gauge("network_handler_maxmicros", stats.maxMicros, tags);
+		stats.maxMicros = 0u;
+		sent = stats;
+	}
+}
+
 }
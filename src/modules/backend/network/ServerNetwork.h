@@ -5,19 +5,83 @@
 #pragma once
 
 #include "network/AbstractServerNetwork.h"
+#include "ClientMessages_generated.h"
+#include "core/String.h"
+#include <unordered_set>
+#include <vector>
 
 namespace network {
 
 class ServerNetwork : public AbstractServerNetwork {
 private:
 	using Super = AbstractServerNetwork;
+public:
+	/**
+	 * @brief Counters and handler timings of one @c ClientMsgType
+	 */
+	struct MessageStats {
+		uint64_t count = 0u;
+		uint64_t bytes = 0u;
+		/** the accumulated time that was spent in the handler */
+		uint64_t micros = 0u;
+		uint32_t maxMicros = 0u;
+	};
+private:
+	static constexpr int MessageTypes = (int)ClientMsgType::MAX + 1;
+	MessageStats _messageStats[MessageTypes];
+	// the values that were already sent to the metrics
+	MessageStats _sentStats[MessageTypes];
+	uint64_t _nextMetricsMillis = 0u;
+	// the addresses whose peers are trusted once they connected
+	std::vector<enet_uint32> _trustedHosts;
+	std::unordered_set<const ENetPeer*> _trustedPeers;
+
+	void sendMetrics();
+protected:
+	void peerConnected(ENetPeer* peer) override;
+	void peerDisconnected(ENetPeer* peer) override;
 public:
 	ServerNetwork(const ProtocolHandlerRegistryPtr& protocolHandlerRegistry,
 			const core::EventBusPtr& eventBus, const metric::MetricPtr& metric);
 
 	bool packetReceived(ENetEvent& event) override;
+
+	void update();
+
+	/**
+	 * @brief The packets of trusted peers are not verified before they are dispatched
+	 * @note Only trust peers that are under your control - a malformed packet could crash the server.
+	 * The trust is a decision of the server and is dropped once the peer disconnects.
+	 */
+	void setTrusted(const ENetPeer* peer, bool trusted);
+	bool trusted(const ENetPeer* peer) const;
+	/**
+	 * @brief Peers that connect from one of these addresses are trusted - e.g. the internal bots
+	 * @param[in] hosts Comma separated list of host names or ip addresses
+	 * @return @c false if one of the hosts couldn't get resolved
+	 * @sa setTrusted()
+	 */
+	bool setTrustedHosts(const core::String& hosts);
+
+	const MessageStats& messageStats(ClientMsgType type) const;
 };
 
+inline void ServerNetwork::setTrusted(const ENetPeer* peer, bool trusted) {
+	if (trusted) {
+		_trustedPeers.insert(peer);
+	} else {
+		_trustedPeers.erase(peer);
+	}
+}
+
+inline bool ServerNetwork::trusted(const ENetPeer* peer) const {
+	return !_trustedPeers.empty() && _trustedPeers.find(peer) != _trustedPeers.end();
+}
+
+inline const ServerNetwork::MessageStats& ServerNetwork::messageStats(ClientMsgType type) const {
+	return _messageStats[(int)type];
+}
+
 typedef std::shared_ptr<ServerNetwork> ServerNetworkPtr;
 
 }
@@ -0,0 +1,18 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "IUserProtocolHandler.h"
+
+namespace backend {
+
+/**
+ * @brief The client acknowledged an @c EntitySnapshot - following snapshots are based on it
+ */
+USERPROTOHANDLERIMPL(SnapshotAck) {
+	user->snapshotMgr().ack(message->sequence());
+}
+
+}
@@ -81,7 +81,8 @@ bool SpawnMgr::onSpawn(const NpcPtr& npc, const glm::ivec3* pos) {
 	npc->init(pos);
 	// now let it tick
 	if (_map->addNpc(npc)) {
-		_entityStorage->addNpc(npc);
+		// the map might be ticked in parallel to other maps
+		_entityStorage->addNpcDeferred(npc);
 		return true;
 	}
 	return false;
@@ -0,0 +1,138 @@
+/**
+ * @file
+ */
+
+#include "NpcTest.h"
+#include "backend/world/InterestGrid.h"
+
+namespace backend {
+
+class InterestGridTest: public NpcTest {
+protected:
+	NpcPtr create(const glm::vec3& pos) {
+		const NpcPtr& npc = NpcTest::create();
+		npc->setPos(pos);
+		return npc;
+	}
+
+	bool contains(const InterestGrid::Entities& entities, const EntityPtr& entity) const {
+		return std::find(entities.begin(), entities.end(), entity) != entities.end();
+	}
+};
+
+TEST_F(InterestGridTest, testAddRemove) {
+	InterestGrid grid(10.0f);
+	const NpcPtr& npc1 = create(glm::vec3(1.0f, 0.0f, 1.0f));
+	const NpcPtr& npc2 = create(glm::vec3(-1.0f, 0.0f, -1.0f));
+	EXPECT_TRUE(grid.add(npc1));
+	EXPECT_FALSE(grid.add(npc1)) << "Entity was added twice";
+	EXPECT_TRUE(grid.add(npc2));
+	EXPECT_EQ(2, grid.size());
+	EXPECT_EQ(2, grid.cellCount()) << "Negative coordinates should end up in their own cell";
+	EXPECT_TRUE(grid.remove(npc1->id()));
+	EXPECT_FALSE(grid.remove(npc1->id()));
+	EXPECT_EQ(1, grid.size());
+	EXPECT_EQ(1, grid.cellCount()) << "Empty cells should get removed";
+	grid.clear();
+	EXPECT_EQ(0, grid.size());
+	EXPECT_EQ(0, grid.cellCount());
+}
+
+TEST_F(InterestGridTest, testUpdateCellCrossing) {
+	InterestGrid grid(10.0f);
+	const NpcPtr& npc = create(glm::vec3(1.0f, 0.0f, 1.0f));
+	ASSERT_TRUE(grid.add(npc));
+	npc->setPos(glm::vec3(9.0f, 100.0f, 9.0f));
+	EXPECT_FALSE(grid.update(npc)) << "The height must not have an influence on the cell";
+	npc->setPos(glm::vec3(11.0f, 0.0f, 9.0f));
+	EXPECT_TRUE(grid.update(npc));
+	EXPECT_EQ(1, grid.cellCount());
+
+	InterestGrid::Entities entities;
+	grid.query(glm::vec3(11.0f, 0.0f, 9.0f), 1.0f, -1, entities);
+	ASSERT_EQ(1u, entities.size());
+	EXPECT_EQ(npc, entities[0]);
+}
+
+TEST_F(InterestGridTest, testQueryRadius) {
+	InterestGrid grid(10.0f);
+	const NpcPtr& viewer = create(glm::vec3(0.0f));
+	const NpcPtr& near = create(glm::vec3(5.0f, 0.0f, 5.0f));
+	// inside of the bounding square of the view circle - but not inside of the circle
+	const NpcPtr& corner = create(glm::vec3(19.0f, 0.0f, 19.0f));
+	const NpcPtr& far = create(glm::vec3(100.0f, 0.0f, 0.0f));
+	ASSERT_TRUE(grid.add(viewer));
+	ASSERT_TRUE(grid.add(near));
+	ASSERT_TRUE(grid.add(corner));
+	ASSERT_TRUE(grid.add(far));
+
+	InterestGrid::Entities entities;
+	grid.query(viewer->pos(), 20.0f, viewer->id(), entities);
+	EXPECT_EQ(1u, entities.size());
+	EXPECT_TRUE(contains(entities, near));
+	EXPECT_FALSE(contains(entities, viewer)) << "The excluded entity should not be part of the result";
+	EXPECT_FALSE(contains(entities, corner)) << "The distance should be checked";
+	EXPECT_FALSE(contains(entities, far));
+}
+
+TEST_F(InterestGridTest, testSwapRemove) {
+	InterestGrid grid(100.0f);
+	std::vector<NpcPtr> npcs;
+	for (int i = 0; i < 5; ++i) {
+		npcs.push_back(create(glm::vec3((float)i, 0.0f, 0.0f)));
+		ASSERT_TRUE(grid.add(npcs.back()));
+	}
+	ASSERT_EQ(1, grid.cellCount());
+	// remove from the middle - the last entity takes the free slot
+	ASSERT_TRUE(grid.remove(npcs[1]->id()));
+	// the moved entity must still be removable and movable
+	npcs[4]->setPos(glm::vec3(1000.0f, 0.0f, 0.0f));
+	EXPECT_TRUE(grid.update(npcs[4]));
+	EXPECT_TRUE(grid.remove(npcs[0]->id()));
+	EXPECT_TRUE(grid.remove(npcs[4]->id()));
+
+	InterestGrid::Entities entities;
+	grid.query(glm::vec3(0.0f), 50.0f, -1, entities);
+	ASSERT_EQ(2u, entities.size());
+	EXPECT_TRUE(contains(entities, npcs[2]));
+	EXPECT_TRUE(contains(entities, npcs[3]));
+}
+
+TEST_F(InterestGridTest, testQueryChanged) {
+	InterestGrid grid(10.0f);
+	const NpcPtr& viewer = create(glm::vec3(0.0f));
+	const NpcPtr& near = create(glm::vec3(5.0f, 0.0f, 5.0f));
+	const NpcPtr& far = create(glm::vec3(1000.0f, 0.0f, 0.0f));
+	ASSERT_TRUE(grid.add(viewer));
+	ASSERT_TRUE(grid.add(near));
+	ASSERT_TRUE(grid.add(far));
+
+	InterestGrid::Entities entities;
+	ASSERT_TRUE(grid.queryChanged(viewer, 20.0f, entities)) << "The first query must not be skipped";
+	EXPECT_EQ(1u, entities.size());
+	grid.clearDirty();
+	EXPECT_EQ(0, grid.dirtyCellCount());
+
+	entities.clear();
+	EXPECT_FALSE(grid.queryChanged(viewer, 20.0f, entities)) << "Nothing changed in the view";
+	EXPECT_TRUE(grid.queryChanged(viewer, 30.0f, entities)) << "The view distance changed";
+	grid.clearDirty();
+
+	far->setPos(glm::vec3(1001.0f, 0.0f, 0.0f));
+	EXPECT_FALSE(grid.update(far));
+	entities.clear();
+	EXPECT_FALSE(grid.queryChanged(viewer, 30.0f, entities)) << "An entity moved outside of the view";
+	grid.clearDirty();
+
+	near->setPos(glm::vec3(6.0f, 0.0f, 5.0f));
+	EXPECT_FALSE(grid.update(near));
+	EXPECT_TRUE(grid.queryChanged(viewer, 30.0f, entities)) << "An entity moved inside of the cell of the viewer";
+	grid.clearDirty();
+
+	ASSERT_TRUE(grid.remove(near->id()));
+	entities.clear();
+	EXPECT_TRUE(grid.queryChanged(viewer, 30.0f, entities)) << "An entity left the view";
+	EXPECT_TRUE(entities.empty());
+}
+
+}
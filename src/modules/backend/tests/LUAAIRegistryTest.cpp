@@ -158,4 +158,74 @@ TEST_F(LUAAIRegistryTest, testSteeringEmpty) {
 	testSteering("LuaSteeringTest");
 }
 
+TEST_F(LUAAIRegistryTest, testStatePool) {
+	lua_State* s1 = _registry.acquireState();
+	lua_State* s2 = _registry.acquireState();
+	ASSERT_NE(nullptr, s1);
+	ASSERT_NE(nullptr, s2);
+	EXPECT_NE(s1, s2);
+	EXPECT_NE(_registry.getLuaState(), s1);
+	EXPECT_EQ(2, _registry.pooledStates());
+	_registry.releaseState(s1);
+	EXPECT_EQ(s1, _registry.acquireState()) << "A released state should be reused";
+	EXPECT_EQ(2, _registry.pooledStates());
+	_registry.releaseState(s1);
+	_registry.releaseState(s2);
+}
+
+TEST_F(LUAAIRegistryTest, testStatePoolScope) {
+	lua_State* shared = _registry.getLuaState();
+	// create the pooled state before the script is evaluated - it has to catch up
+	_registry.releaseState(_registry.acquireState());
+	ASSERT_TRUE(_registry.evaluate(
+		"local luacondition = REGISTRY.createCondition(\"LuaCounter\")\n"
+		"function luacondition:evaluate(ai)\n"
+		"  counter = (counter or 0) + 1\n"
+		"  return true\n"
+		"end\n"));
+	const ConditionPtr& condition = _registry.createCondition("LuaCounter", ctxCondition);
+	ASSERT_TRUE((bool)condition);
+	const AIPtr& ai = std::make_shared<AI>(TreeNodePtr());
+	ai->setCharacter(_chr);
+	{
+		const LUAStateScope scope(&_registry);
+		EXPECT_NE(shared, luaAI_state(shared));
+		EXPECT_TRUE(condition->evaluate(ai));
+	}
+	EXPECT_EQ(shared, luaAI_state(shared));
+	EXPECT_EQ(1, _registry.pooledStates());
+
+	lua_getglobal(shared, "counter");
+	EXPECT_TRUE(lua_isnil(shared, -1)) << "The condition was executed in the shared state";
+	lua_pop(shared, 1);
+
+	lua_State* pooled = _registry.acquireState();
+	lua_getglobal(pooled, "counter");
+	EXPECT_EQ(1, lua_tointeger(pooled, -1));
+	lua_pop(pooled, 1);
+	lua_gc(pooled, LUA_GCCOLLECT, 0);
+	_registry.releaseState(pooled);
+	EXPECT_EQ(1, ai.use_count()) << "Someone is still referencing the AI instance";
+}
+
+TEST_F(LUAAIRegistryTest, testZoneParallel) {
+	const AIRegistryPtr& registry = std::make_shared<LUAAIRegistry>();
+	ASSERT_TRUE(registry->init());
+	ASSERT_TRUE(registry->evaluate(_luaCode));
+	const int threads = 2;
+	Zone zone("TestZoneParallel", threads, registry);
+	const TreeNodeFactoryContext ctx = TreeNodeFactoryContext("TreeNodeName", "", True::get());
+	for (int i = 0; i < 100; ++i) {
+		const TreeNodePtr& node = registry->createNode("LuaTest2", ctx);
+		ASSERT_TRUE((bool)node);
+		const AIPtr& ai = std::make_shared<AI>(node);
+		ai->setCharacter(core::make_shared<TestEntity>(i + 1));
+		ASSERT_TRUE(zone.addAI(ai));
+	}
+	zone.update(1l);
+	zone.update(1l);
+	EXPECT_GE(registry->pooledStates(), 1);
+	EXPECT_LE(registry->pooledStates(), threads + 1) << "Only one state per executing thread is expected";
+}
+
 }
@@ -88,6 +88,7 @@ TEST_F(MapTest, testUpdate) {
 	create(map, 1);
 	EXPECT_TRUE(map.init()) << "Failed to initialize the map " << map.id();
 	map.update(0ul);
+	EXPECT_EQ(1u, map.tickStats().ticks);
 	map.shutdown();
 }
 
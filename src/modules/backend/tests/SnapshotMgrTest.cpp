@@ -0,0 +1,101 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "backend/entity/SnapshotMgr.h"
+#include "shared/EntityState.h"
+
+namespace backend {
+
+class SnapshotMgrTest: public app::AbstractTest {
+protected:
+	network::EntityState state(int64_t id, const glm::vec3& pos, float orientation = 0.0f) const {
+		return shared::quantizeEntityState(id, pos, orientation, network::Animation::IDLE);
+	}
+};
+
+TEST_F(SnapshotMgrTest, testQuantize) {
+	const glm::vec3 pos(10.5f, -3.25f, 1000.0f);
+	const network::EntityState s = state(1, pos, glm::pi<float>());
+	EXPECT_EQ(pos, shared::dequantizePosition(s));
+	EXPECT_EQ(32768, s.rotation());
+	EXPECT_NEAR(glm::pi<float>(), shared::dequantizeOrientation(s.rotation()), 0.0001f);
+	EXPECT_EQ(shared::quantizeOrientation(0.0f), shared::quantizeOrientation(glm::two_pi<float>()));
+	EXPECT_EQ(shared::quantizeOrientation(-glm::half_pi<float>()), shared::quantizeOrientation(glm::three_over_two_pi<float>()));
+}
+
+TEST_F(SnapshotMgrTest, testUnacknowledgedStatesAreResent) {
+	SnapshotMgr mgr;
+	SnapshotMgr::States states { state(2, glm::vec3(1.0f)), state(1, glm::vec3(0.0f)) };
+	SnapshotMgr::States changed;
+	const uint32_t first = mgr.create(states, changed);
+	ASSERT_NE(0u, first);
+	ASSERT_EQ(2u, changed.size());
+	EXPECT_EQ(1, changed[0].id()) << "States should be sorted by id";
+
+	// nothing was acknowledged - the full state is sent again
+	const uint32_t second = mgr.create(states, changed);
+	EXPECT_NE(first, second);
+	EXPECT_EQ(2u, changed.size());
+}
+
+TEST_F(SnapshotMgrTest, testDeltaToAcknowledged) {
+	SnapshotMgr mgr;
+	SnapshotMgr::States states { state(1, glm::vec3(0.0f)), state(2, glm::vec3(1.0f)) };
+	SnapshotMgr::States changed;
+	const uint32_t first = mgr.create(states, changed);
+	ASSERT_TRUE(mgr.ack(first));
+	EXPECT_EQ(first, mgr.ackedSequence());
+
+	EXPECT_EQ(0u, mgr.create(states, changed)) << "Nothing changed - no snapshot expected";
+	EXPECT_TRUE(changed.empty());
+
+	// changes below the quantization don't count
+	states = { state(1, glm::vec3(0.001f)), state(2, glm::vec3(1.0f, 1.0f, 2.0f)) };
+	const uint32_t second = mgr.create(states, changed);
+	ASSERT_NE(0u, second);
+	ASSERT_EQ(1u, changed.size());
+	EXPECT_EQ(2, changed[0].id());
+
+	// an entity that gets visible
+	states.push_back(state(3, glm::vec3(3.0f)));
+	const uint32_t third = mgr.create(states, changed);
+	ASSERT_EQ(2u, changed.size()) << "Entity 2 wasn't acknowledged yet and should be sent again";
+	EXPECT_EQ(2, changed[0].id());
+	EXPECT_EQ(3, changed[1].id());
+
+	EXPECT_TRUE(mgr.ack(third));
+	EXPECT_FALSE(mgr.ack(second)) << "Acknowledges of older snapshots must be ignored";
+	EXPECT_EQ(0u, mgr.create(states, changed));
+}
+
+TEST_F(SnapshotMgrTest, testForget) {
+	SnapshotMgr mgr;
+	SnapshotMgr::States states { state(1, glm::vec3(0.0f)), state(2, glm::vec3(1.0f)) };
+	SnapshotMgr::States changed;
+	ASSERT_TRUE(mgr.ack(mgr.create(states, changed)));
+	mgr.forget(2);
+	mgr.create(states, changed);
+	ASSERT_EQ(1u, changed.size());
+	EXPECT_EQ(2, changed[0].id());
+}
+
+TEST_F(SnapshotMgrTest, testAckUnknown) {
+	SnapshotMgr mgr;
+	EXPECT_FALSE(mgr.ack(0u));
+	EXPECT_FALSE(mgr.ack(42u));
+	SnapshotMgr::States states { state(1, glm::vec3(0.0f)) };
+	SnapshotMgr::States changed;
+	uint32_t sequence = 0u;
+	for (int i = 0; i < SnapshotMgr::History + 1; ++i) {
+		states[0] = state(1, glm::vec3((float)i));
+		const uint32_t s = mgr.create(states, changed);
+		if (i == 0) {
+			sequence = s;
+		}
+	}
+	EXPECT_FALSE(mgr.ack(sequence)) << "The snapshot should have been dropped from the history";
+}
+
+}
@@ -0,0 +1,70 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "backend/loop/TickScheduler.h"
+#include <SDL_timer.h>
+
+namespace backend {
+
+class TickSchedulerTest: public app::AbstractTest {
+};
+
+TEST_F(TickSchedulerTest, testFixedTimestep) {
+	TickScheduler scheduler(100u, 3);
+	EXPECT_EQ(0, scheduler.advance(1000u)) << "The first call should only initialize the clock";
+	EXPECT_EQ(0, scheduler.advance(1050u));
+	EXPECT_EQ(1, scheduler.advance(1100u));
+	EXPECT_EQ(0, scheduler.advance(1150u));
+	// the remaining 50 millis of the last call are accumulated
+	EXPECT_EQ(2, scheduler.advance(1310u));
+	EXPECT_EQ(1, scheduler.advance(1400u));
+	EXPECT_EQ(0u, scheduler.skippedTicks());
+	EXPECT_EQ(0, scheduler.advance(1300u)) << "A clock that goes backwards must not produce ticks";
+}
+
+TEST_F(TickSchedulerTest, testCatchUp) {
+	TickScheduler scheduler(100u, 3);
+	scheduler.advance(0u);
+	EXPECT_EQ(3, scheduler.advance(350u)) << "Up to the max catch-up ticks should be executed";
+	EXPECT_EQ(0u, scheduler.skippedTicks());
+	EXPECT_EQ(3, scheduler.advance(1000u)) << "The catch-up ticks should be limited";
+	EXPECT_EQ(4u, scheduler.skippedTicks());
+	// the backlog was dropped, only the remainder is kept
+	EXPECT_EQ(0, scheduler.advance(1040u));
+	EXPECT_EQ(1, scheduler.advance(1100u));
+}
+
+TEST_F(TickSchedulerTest, testOverrun) {
+	TickScheduler scheduler(1u, 1);
+	scheduler.beginTick();
+	EXPECT_FALSE(scheduler.endTick());
+	scheduler.beginTick();
+	SDL_Delay(5);
+	EXPECT_TRUE(scheduler.endTick());
+	EXPECT_EQ(2u, scheduler.tickCount());
+	EXPECT_EQ(1u, scheduler.overruns());
+	EXPECT_GE(scheduler.lastTickMicros(), 5000u);
+	EXPECT_EQ(2u, scheduler.ticks().count());
+}
+
+TEST_F(TickSchedulerTest, testPhases) {
+	TickScheduler scheduler;
+	scheduler.addPhase(TickPhase::AI, 100u);
+	scheduler.addPhase(TickPhase::AI, 300u);
+	{
+		const TickScheduler::ScopedPhase phase(scheduler, TickPhase::Send);
+	}
+	EXPECT_EQ(2u, scheduler.phase(TickPhase::AI).count());
+	EXPECT_EQ(300u, scheduler.lastMicros(TickPhase::AI));
+	EXPECT_EQ(200u, scheduler.phase(TickPhase::AI).mean());
+	EXPECT_EQ(1u, scheduler.phase(TickPhase::Send).count());
+	EXPECT_EQ(0u, scheduler.phase(TickPhase::Network).count());
+
+	const core::String& json = scheduler.toJson();
+	EXPECT_NE(nullptr, SDL_strstr(json.c_str(), "\"ai\": {\"count\": 2, \"min\": 100, \"max\": 300")) << json;
+	EXPECT_NE(nullptr, SDL_strstr(json.c_str(), "\"persistence\": {\"count\": 0")) << json;
+}
+
+}
@@ -100,6 +100,40 @@ TEST_F(WorldTest, testUpdate) {
 	world.shutdown();
 }
 
+TEST_F(WorldTest, testSequentialUpdate) {
+	core::Var::get(cfg::ServerMapThreads, "")->setVal("1");
+	core::Var::get(cfg::ServerMaps, "")->setVal("2");
+	create(world);
+	ASSERT_TRUE(world.init());
+	EXPECT_FALSE(world.parallel()) << "One map thread should tick the maps sequentially";
+	world.update(0ul);
+	world.visit([] (const MapPtr& map) {
+		EXPECT_EQ(1u, map->tickStats().ticks);
+	});
+	world.shutdown();
+	core::Var::get(cfg::ServerMaps, "")->setVal("1");
+}
+
+TEST_F(WorldTest, testParallelUpdate) {
+	core::Var::get(cfg::ServerMapThreads, "")->setVal("2");
+	core::Var::get(cfg::ServerMaps, "")->setVal("3");
+	create(world);
+	ASSERT_TRUE(world.init());
+	EXPECT_TRUE(world.parallel());
+	for (int i = 0; i < 5; ++i) {
+		world.update(100ul);
+	}
+	int maps = 0;
+	world.visit([&maps] (const MapPtr& map) {
+		EXPECT_EQ(5u, map->tickStats().ticks) << "Map " << map->id() << " wasn't ticked in every world update";
+		++maps;
+	});
+	EXPECT_EQ(3, maps);
+	world.shutdown();
+	core::Var::get(cfg::ServerMapThreads, "")->setVal("1");
+	core::Var::get(cfg::ServerMaps, "")->setVal("1");
+}
+
 #undef create
 
 }
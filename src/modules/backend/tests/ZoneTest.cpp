@@ -52,4 +52,41 @@ TEST_F(ZoneTest, testAdd100) {
 	ASSERT_EQ(n, (int)zone.size());
 }
 
+TEST_F(ZoneTest, testExecuteParallelBatched) {
+	Zone zone("test1", 3);
+	TreeNodePtr root = std::make_shared<PrioritySelector>("test", "", True::get());
+	const int n = 1000;
+	for (int i = 0; i < n; ++i) {
+		ICharacterPtr character = core::make_shared<TestEntity>(i);
+		AIPtr ai = std::make_shared<AI>(root);
+		ai->setCharacter(character);
+		ASSERT_TRUE(zone.addAI(ai)) << "Could not add ai to the zone";
+	}
+	zone.update(1l);
+	const Zone::UpdateStats& stats = zone.updateStats();
+	EXPECT_EQ(1u, stats.updates);
+	EXPECT_EQ((uint32_t)n, stats.ais);
+	EXPECT_GT(stats.batches, 1u);
+
+	core::AtomicInt visited;
+	const int batches = zone.executeParallel([&visited] (const AIPtr& ai) {
+		visited.increment((int)ai->getId() + 1);
+	}, 64);
+	EXPECT_EQ((n + 63) / 64, batches);
+	EXPECT_EQ(n * (n + 1) / 2, (int)visited) << "Each ai must be visited exactly once";
+
+	// the snapshot is shared as long as the members don't change
+	const Zone::AIListPtr before = zone.getAIs();
+	EXPECT_EQ(before, zone.getAIs());
+	ASSERT_TRUE(zone.removeAI(0));
+	zone.update(1l);
+	const Zone::AIListPtr after = zone.getAIs();
+	EXPECT_NE(before, after);
+	EXPECT_EQ(n - 1, (int)after->size());
+	EXPECT_EQ(n, (int)before->size());
+	EXPECT_EQ(2u, zone.updateStats().updates);
+	zone.resetUpdateStats();
+	EXPECT_EQ(0u, zone.updateStats().updates);
+}
+
 }
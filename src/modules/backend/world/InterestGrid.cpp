@@ -0,0 +1,185 @@
+/**
+ * @file
+ */
+
+#include "InterestGrid.h"
+#include "backend/entity/Entity.h"
+#include "core/Assert.h"
+#include "core/Trace.h"
+#include <glm/common.hpp>
+
+namespace backend {
+
+InterestGrid::InterestGrid(float cellSize) :
+		_cellSize(cellSize) {
+	core_assert_msg(_cellSize > 0.0f, "Invalid cell size given: %f", _cellSize);
+}
+
+uint64_t InterestGrid::key(const glm::ivec2& cell) {
+	return ((uint64_t)(uint32_t)cell.x << 32) | (uint64_t)(uint32_t)cell.y;
+}
+
+glm::ivec2 InterestGrid::cell(const glm::vec3& pos) const {
+	return glm::ivec2(glm::floor(glm::vec2(pos.x, pos.z) / _cellSize));
+}
+
+void InterestGrid::insertIntoCell(const EntityPtr& entity, uint64_t cellKey, Membership& membership) {
+	Entities& entities = _cells[cellKey];
+	entities.push_back(entity);
+	membership.cell = cellKey;
+	membership.index = (int)entities.size() - 1;
+	_dirtyCells.insert(cellKey);
+}
+
+void InterestGrid::removeFromCell(const Membership& membership) {
+	auto i = _cells.find(membership.cell);
+	core_assert(i != _cells.end());
+	Entities& entities = i->second;
+	const int last = (int)entities.size() - 1;
+	if (membership.index != last) {
+		// swap remove - fix the index of the entity that took the free slot
+		entities[membership.index] = core::move(entities[last]);
+		_members[entities[membership.index]->id()].index = membership.index;
+	}
+	entities.pop_back();
+	if (entities.empty()) {
+		_cells.erase(i);
+	}
+	_dirtyCells.insert(membership.cell);
+}
+
+bool InterestGrid::add(const EntityPtr& entity) {
+	if (_members.find(entity->id()) != _members.end()) {
+		return false;
+	}
+	Membership membership;
+	membership.pos = entity->pos();
+	membership.radius = -1.0f;
+	insertIntoCell(entity, key(cell(membership.pos)), membership);
+	_members.insert(std::make_pair(entity->id(), membership));
+	return true;
+}
+
+bool InterestGrid::remove(EntityId id) {
+	auto i = _members.find(id);
+	if (i == _members.end()) {
+		return false;
+	}
+	const Membership membership = i->second;
+	_members.erase(i);
+	removeFromCell(membership);
+	return true;
+}
+
+bool InterestGrid::update(const EntityPtr& entity) {
+	auto i = _members.find(entity->id());
+	if (i == _members.end()) {
+		return false;
+	}
+	const glm::vec3& pos = entity->pos();
+	if (i->second.pos == pos) {
+		return false;
+	}
+	i->second.pos = pos;
+	const uint64_t cellKey = key(cell(pos));
+	if (i->second.cell == cellKey) {
+		// the entity might have entered or left the view of its neighbours
+		_dirtyCells.insert(cellKey);
+		return false;
+	}
+	const Membership old = i->second;
+	insertIntoCell(entity, cellKey, i->second);
+	removeFromCell(old);
+	return true;
+}
+
+void InterestGrid::queryCells(const glm::vec3& pos, float radius, glm::ivec2& mins, glm::ivec2& maxs) const {
+	// the cells are assigned by the center of an entity - but an entity is also found if only its
+	// rect touches the circle. The additional cell border covers this.
+	mins = cell(glm::vec3(pos.x - radius, 0.0f, pos.z - radius)) - 1;
+	maxs = cell(glm::vec3(pos.x + radius, 0.0f, pos.z + radius)) + 1;
+}
+
+bool InterestGrid::dirty(const glm::vec3& pos, float radius) const {
+	if (_dirtyCells.empty()) {
+		return false;
+	}
+	glm::ivec2 mins;
+	glm::ivec2 maxs;
+	queryCells(pos, radius, mins, maxs);
+	const int64_t cells = (int64_t)(maxs.x - mins.x + 1) * (int64_t)(maxs.y - mins.y + 1);
+	if ((int64_t)_dirtyCells.size() < cells) {
+		for (uint64_t cellKey : _dirtyCells) {
+			const glm::ivec2 c((int32_t)(uint32_t)(cellKey >> 32), (int32_t)(uint32_t)cellKey);
+			if (c.x >= mins.x && c.x <= maxs.x && c.y >= mins.y && c.y <= maxs.y) {
+				return true;
+			}
+		}
+		return false;
+	}
+	for (int z = mins.y; z <= maxs.y; ++z) {
+		for (int x = mins.x; x <= maxs.x; ++x) {
+			if (_dirtyCells.find(key(glm::ivec2(x, z))) != _dirtyCells.end()) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void InterestGrid::clearDirty() {
+	_dirtyCells.clear();
+}
+
+bool InterestGrid::queryChanged(const EntityPtr& entity, float radius, Entities& entities) {
+	auto i = _members.find(entity->id());
+	if (i == _members.end()) {
+		query(entity->pos(), radius, entity->id(), entities);
+		return true;
+	}
+	Membership& membership = i->second;
+	const glm::vec3& pos = entity->pos();
+	// the own movement marks the own cell as dirty - which is part of the view
+	if (membership.radius == radius && !dirty(pos, radius)) {
+		return false;
+	}
+	membership.radius = radius;
+	query(pos, radius, entity->id(), entities);
+	return true;
+}
+
+void InterestGrid::query(const glm::vec3& pos, float radius, EntityId exclude, Entities& entities) const {
+	core_trace_scoped(InterestGridQuery);
+	const glm::vec2 center(pos.x, pos.z);
+	glm::ivec2 mins;
+	glm::ivec2 maxs;
+	queryCells(pos, radius, mins, maxs);
+	for (int z = mins.y; z <= maxs.y; ++z) {
+		for (int x = mins.x; x <= maxs.x; ++x) {
+			auto i = _cells.find(key(glm::ivec2(x, z)));
+			if (i == _cells.end()) {
+				continue;
+			}
+			for (const EntityPtr& e : i->second) {
+				if (e->id() == exclude) {
+					continue;
+				}
+				const glm::vec3& epos = e->pos();
+				const glm::vec2 delta = glm::vec2(epos.x, epos.z) - center;
+				const float distance = radius + e->size() * 0.5f;
+				if (delta.x * delta.x + delta.y * delta.y > distance * distance) {
+					continue;
+				}
+				entities.push_back(e);
+			}
+		}
+	}
+}
+
+void InterestGrid::clear() {
+	_cells.clear();
+	_members.clear();
+	_dirtyCells.clear();
+}
+
+}
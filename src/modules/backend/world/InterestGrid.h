@@ -0,0 +1,129 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "backend/ForwardDecl.h"
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace backend {
+
+/**
+ * @brief Uniform spatial hash grid on the x/z plane that is used for the interest management of a map.
+ *
+ * The grid membership is maintained incrementally - an entity only changes its cell if it crossed the cell
+ * border. Queries visit the cells that overlap the view circle and check the real distance.
+ *
+ * The cells that got an entity added, removed or moved are marked as dirty until @c clearDirty() is called.
+ * @c queryChanged() uses this to skip the query for all members that have nothing changed in their view.
+ */
+class InterestGrid {
+public:
+	using Entities = std::vector<EntityPtr>;
+private:
+	struct Membership {
+		uint64_t cell;
+		// index in the entity list of the cell
+		int index;
+		// the position the cell was assigned for
+		glm::vec3 pos;
+		// the radius of the last queryChanged() call - negative if there was none yet
+		float radius;
+	};
+	const float _cellSize;
+	std::unordered_map<uint64_t, Entities> _cells;
+	std::unordered_map<EntityId, Membership> _members;
+	std::unordered_set<uint64_t> _dirtyCells;
+
+	static uint64_t key(const glm::ivec2& cell);
+	glm::ivec2 cell(const glm::vec3& pos) const;
+	void removeFromCell(const Membership& membership);
+	void insertIntoCell(const EntityPtr& entity, uint64_t cellKey, Membership& membership);
+	/**
+	 * @brief The cells a query visits - including the border for entities that only touch the circle
+	 */
+	void queryCells(const glm::vec3& pos, float radius, glm::ivec2& mins, glm::ivec2& maxs) const;
+public:
+	/**
+	 * @param[in] cellSize The size of a cell in world units. This should be in the magnitude of the view distance.
+	 */
+	InterestGrid(float cellSize = 64.0f);
+
+	/**
+	 * @return @c false if the entity is already part of the grid
+	 */
+	bool add(const EntityPtr& entity);
+	/**
+	 * @return @c false if the entity is not part of the grid
+	 */
+	bool remove(EntityId id);
+	/**
+	 * @brief Updates the cell membership of the entity after it moved
+	 * @return @c true if the entity crossed a cell border
+	 */
+	bool update(const EntityPtr& entity);
+
+	/**
+	 * @return @c true if an entity was added, removed or moved in one of the cells a query with the given
+	 * parameters would visit
+	 */
+	bool dirty(const glm::vec3& pos, float radius) const;
+	/**
+	 * @brief Forget about the changes - call this after all members were queried
+	 */
+	void clearDirty();
+
+	/**
+	 * @brief Collects all entities whose rect touches the circle around the given position
+	 * @param[in] exclude The id of an entity that should not be part of the result - usually the
+	 * entity that is looking.
+	 * @param[out] entities The result list - the entities are appended
+	 */
+	void query(const glm::vec3& pos, float radius, EntityId exclude, Entities& entities) const;
+	/**
+	 * @brief Collects the entities in the view of the given member - but only if the member moved, the radius
+	 * changed or one of the cells of the view is dirty
+	 * @return @c false if the query was skipped - the result of the last query is still valid then
+	 * @see query()
+	 */
+	bool queryChanged(const EntityPtr& entity, float radius, Entities& entities);
+
+	void clear();
+
+	float cellSize() const;
+	/**
+	 * @return The amount of entities in the grid
+	 */
+	int size() const;
+	/**
+	 * @return The amount of not empty cells
+	 */
+	int cellCount() const;
+	/**
+	 * @return The amount of cells that changed since the last @c clearDirty() call
+	 */
+	int dirtyCellCount() const;
+};
+
+inline float InterestGrid::cellSize() const {
+	return _cellSize;
+}
+
+inline int InterestGrid::size() const {
+	return (int)_members.size();
+}
+
+inline int InterestGrid::cellCount() const {
+	return (int)_cells.size();
+}
+
+inline int InterestGrid::dirtyCellCount() const {
+	return (int)_dirtyCells.size();
+}
+
+}
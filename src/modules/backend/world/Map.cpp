@@ -9,11 +9,12 @@
 #include "core/EventBus.h"
 #include "app/App.h"
 #include "core/Trace.h"
-#include "math/QuadTree.h"
+#include "core/TimeProvider.h"
 #include "io/Filesystem.h"
 #include "backend/entity/Npc.h"
 #include "backend/entity/User.h"
 #include "ai/zone/Zone.h"
+#include "backend/entity/ai/AILoader.h"
 #include "metric/MetricEvent.h"
 #include "backend/eventbus/Event.h"
 #include "backend/spawn/SpawnMgr.h"
@@ -22,14 +23,6 @@
 
 namespace backend {
 
-math::RectFloat Map::QuadTreeNode::getRect() const {
-	return entity->rect();
-}
-
-bool Map::QuadTreeNode::operator==(const QuadTreeNode& rhs) const {
-	return rhs.entity == entity;
-}
-
 Map::Map(MapId mapId,
 		const core::EventBusPtr& eventBus,
 		const core::TimeProviderPtr& timeProvider,
@@ -44,9 +37,10 @@ Map::Map(MapId mapId,
 		const DBChunkPersisterPtr& chunkPersister) :
 		_mapId(mapId), _mapIdStr(core::string::toString(mapId)),
 		_eventBus(eventBus), _filesystem(filesystem), _persistenceMgr(persistenceMgr),
-		_volumeCache(volumeCache), _attackMgr(this), _poiProvider(timeProvider), _spawnMgr(this, filesystem, entityStorage, messageSender,
+		_volumeCache(volumeCache), _aiRegistry(loader->registry()), _attackMgr(this), _poiProvider(timeProvider), _spawnMgr(this, filesystem, entityStorage, messageSender,
 			timeProvider, loader, containerProvider, cooldownProvider),
-		_quadTree(math::RectFloat::getMaxRect(), 100.0f), _chunkPersister(chunkPersister) {
+		_interestGrid(core::Var::get(cfg::ServerInterestCellSize, "64")->floatVal()), _chunkPersister(chunkPersister),
+		_tickBudget(core::Var::get(cfg::ServerMapTickBudget, "50")) {
 }
 
 Map::~Map() {
@@ -62,28 +56,35 @@ bool Map::updateEntity(const EntityPtr& entity, long dt) {
 	if (!entity->update(dt)) {
 		return false;
 	}
-	const math::RectFloat& rect = entity->viewRect();
-	// TODO: maybe move into the entity instance to reduce memory allocations.
-	math::QuadTree<QuadTreeNode, float>::Contents contents;
-	_quadTree.query(rect, contents);
-	EntitySet set;
-	set.reserve(contents.size());
-	for (const QuadTreeNode& node : contents) {
-		// TODO: check the distance - the rect might contain more than the circle would...
-		if (node.entity->id() != entity->id()) {
-			set.insert(node.entity);
-		}
-	}
-	entity->updateVisible(set);
+	_interestGrid.update(entity);
 	return true;
 }
 
+void Map::updateVisible(const EntityPtr& entity) {
+	core_trace_scoped(EntityUpdateVisible);
+	const float viewDistance = (float)entity->current(attrib::Type::VIEWDISTANCE);
+	_visibleEntities.clear();
+	if (!_interestGrid.queryChanged(entity, viewDistance, _visibleEntities)) {
+		// nothing entered or left the cells of the view
+		return;
+	}
+	entity->updateVisible(_visibleEntities);
+}
+
+uint64_t Map::finishPhase(TickPhase phase, uint64_t start) {
+	const uint64_t now = core::TimeProvider::highResTime();
+	_tickStats.phaseMicros[(int)phase] = (uint32_t)((now - start) * 1000000u / core::TimeProvider::highResTimeResolution());
+	return now;
+}
+
 void Map::update(long dt) {
 	core_trace_scoped(MapUpdate);
 	Log::trace("tick map %i", (int)_mapId);
+	const uint64_t start = core::TimeProvider::highResTime();
 	_spawnMgr.update(dt);
 	_zone->update(dt);
 	_attackMgr.update(dt);
+	uint64_t phaseStart = finishPhase(TickPhase::AI, start);
 
 	for (auto i = _users.begin(); i != _users.end();) {
 		UserPtr user = i->second;
@@ -92,7 +93,7 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove user " PRIEntId, user->id());
-		_quadTree.remove(QuadTreeNode { user });
+		_interestGrid.remove(user->id());
 		i = _users.erase(i);
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(user->id(), user->entityType()));
 	}
@@ -103,11 +104,112 @@ void Map::update(long dt) {
 			continue;
 		}
 		Log::debug("remove npc " PRIEntId, npc->id());
-		_quadTree.remove(QuadTreeNode { npc });
+		_interestGrid.remove(npc->id());
 		i = _npcs.erase(i);
 		_zone->removeAI(npc->id());
 		_eventBus->enqueue(std::make_shared<EntityDeleteEvent>(npc->id(), npc->entityType()));
 	}
+	phaseStart = finishPhase(TickPhase::Entities, phaseStart);
+
+	// the visibility is updated after all entities moved and changed their cells
+	{
+		core_trace_scoped(MapUpdateVisible);
+		for (const auto& entry : _users) {
+			updateVisible(entry.second);
+		}
+		for (const auto& entry : _npcs) {
+			updateVisible(entry.second);
+		}
+		_interestGrid.clearDirty();
+	}
+	phaseStart = finishPhase(TickPhase::Visibility, phaseStart);
+
+	// only users have a peer to send the snapshots to
+	{
+		core_trace_scoped(MapSendSnapshots);
+		for (const auto& entry : _users) {
+			entry.second->sendEntitySnapshot();
+		}
+	}
+	finishPhase(TickPhase::Send, phaseStart);
+
+	prefetchChunks();
+
+	const uint32_t micros = TickScheduler::micros(start);
+	_tickStats.lastMicros = micros;
+	_tickStats.maxMicros = core_max(_tickStats.maxMicros, micros);
+	++_tickStats.ticks;
+	const uint32_t budgetMicros = (uint32_t)core_max(0, _tickBudget->intVal()) * 1000u;
+	if (budgetMicros > 0u && micros > budgetMicros) {
+		++_tickStats.overruns;
+		Log::debug("Map %i exceeded its tick budget: %u/%u micros", (int)_mapId, micros, budgetMicros);
+	}
+	sendMetrics(dt);
+}
+
+void Map::prefetchChunks() {
+	core_trace_scoped(MapPrefetchChunks);
+	for (const auto& entry : _users) {
+		const UserPtr& user = entry.second;
+		const int viewDistance = (int)user->current(attrib::Type::VIEWDISTANCE);
+		_voxelWorldMgr->prefetch(glm::ivec3(user->pos()), viewDistance);
+	}
+}
+
+void Map::sendMetrics(long dt) {
+	_metricsDelta += dt;
+	if (_metricsDelta < 1000l) {
+		return;
+	}
+	_metricsDelta = 0l;
+	sendPagingMetrics();
+	sendZoneMetrics();
+	sendTickMetrics();
+}
+
+void Map::sendTickMetrics() {
+	if (_tickStats.ticks == 0u) {
+		return;
+	}
+	metric::TagMap tags;
+	tags.put("map", _mapIdStr);
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.tick.maxmicros", _tickStats.maxMicros, tags)));
+	const uint64_t overruns = _tickStats.overruns - _lastOverruns;
+	if (overruns > 0u) {
+		_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("map.tick.overruns", (int)overruns, tags)));
+	}
+	_lastOverruns = _tickStats.overruns;
+	_tickStats.maxMicros = 0u;
+}
+
+void Map::sendZoneMetrics() {
+	const Zone::UpdateStats& stats = _zone->updateStats();
+	if (stats.updates == 0u) {
+		return;
+	}
+	metric::TagMap tags;
+	tags.put("map", _mapIdStr);
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.zone.ais", stats.ais, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.zone.batches", stats.batches, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.zone.updatemicros", (uint32_t)(stats.totalMicros / stats.updates), tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.zone.maxupdatemicros", (uint32_t)stats.maxMicros, tags)));
+	_zone->resetUpdateStats();
+}
+
+void Map::sendPagingMetrics() {
+	const voxel::PagedVolume::PagingStats& stats = _voxelWorldMgr->pagingStats();
+	metric::TagMap tags;
+	tags.put("map", _mapIdStr);
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.paging.queue", stats.queueDepth, tags)));
+	_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::gauge("map.paging.maxpagein", stats.maxPageInMillis, tags)));
+	const uint32_t pageIns = stats.pageIns - _lastPageIns;
+	if (pageIns > 0u) {
+		const uint32_t millis = stats.pageInMillis - _lastPageInMillis;
+		_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::count("map.paging.pageins", (int)pageIns, tags)));
+		_eventBus->enqueue(std::make_shared<metric::MetricEvent>(metric::timing("map.paging.pagein", millis / pageIns, tags)));
+	}
+	_lastPageIns = stats.pageIns;
+	_lastPageInMillis = stats.pageInMillis;
 }
 
 bool Map::init() {
@@ -136,7 +238,8 @@ bool Map::init() {
 	_pager->setNoiseOffset(glm::vec2(0.0f));
 
 	_voxelWorldMgr->setSeed(seed->uintVal());
-	_zone = new Zone(core::string::format("Zone %i", _mapId));
+	_voxelWorldMgr->startAsyncPaging(core::Var::get(cfg::ServerPagingThreads, "1")->intVal());
+	_zone = new Zone(core::string::format("Zone %i", _mapId), core::Var::get(cfg::ServerZoneThreads, "2")->intVal(), _aiRegistry);
 
 	if (!_spawnMgr.init()) {
 		Log::error("Failed to init the spawn manager");
@@ -159,7 +262,7 @@ void Map::shutdown() {
 	}
 	delete _zone;
 	_zone = nullptr;
-	_quadTree.clear();
+	_interestGrid.clear();
 	_npcs.clear();
 	_users.clear();
 	_persistenceMgr->unregisterSavable(FOURCC, this);
@@ -180,7 +283,7 @@ void Map::addUser(const UserPtr& user) {
 	}
 	const glm::vec3& pos = findStartPosition(user);
 	user->setMap(ptr(), pos);
-	_quadTree.insert(QuadTreeNode { user });
+	_interestGrid.add(user);
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(user));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 }
@@ -191,7 +294,7 @@ bool Map::removeUser(EntityId id) {
 		return false;
 	}
 	UserPtr user = i->second;
-	_quadTree.remove(QuadTreeNode { user });
+	_interestGrid.remove(user->id());
 	_users.erase(i);
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(user));
 	return true;
@@ -214,7 +317,7 @@ bool Map::addNpc(const NpcPtr& npc) {
 	const glm::vec3& pos = findStartPosition(npc);
 	npc->setMap(ptr(), pos);
 	_zone->addAI(npc->ai());
-	_quadTree.insert(QuadTreeNode { npc });
+	_interestGrid.add(npc);
 	_eventBus->enqueue(std::make_shared<EntityAddToMapEvent>(npc));
 	_poiProvider.add(pos, poi::Type::SPAWN);
 	return true;
@@ -226,7 +329,7 @@ bool Map::removeNpc(EntityId id) {
 		return false;
 	}
 	NpcPtr npc = i->second;
-	_quadTree.remove(QuadTreeNode { npc });
+	_interestGrid.remove(npc->id());
 	_npcs.erase(i);
 	_zone->removeAI(npc->id());
 	_eventBus->enqueue(std::make_shared<EntityRemoveFromMapEvent>(npc));
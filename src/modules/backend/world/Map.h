@@ -5,20 +5,22 @@
 #pragma once
 
 #include "backend/ForwardDecl.h"
-#include "math/QuadTree.h"
 #include "math/Rect.h"
 #include "core/Common.h"
 #include "core/FourCC.h"
 #include "ai-shared/common/CharacterId.h"
 #include "voxelutil/FloorTraceResult.h"
 #include "core/IComponent.h"
+#include "core/Var.h"
 #include "backend/attack/AttackMgr.h"
 #include "persistence/ISavable.h"
 #include "persistence/ForwardDecl.h"
 #include "poi/PoiProvider.h"
 #include "backend/spawn/SpawnMgr.h"
+#include "backend/loop/TickScheduler.h"
 #include "voxel/Constants.h"
 #include "DBChunkPersister.h"
+#include "InterestGrid.h"
 #include "MapId.h"
 #include <memory>
 #include <unordered_map>
@@ -31,6 +33,20 @@ namespace backend {
  * @brief A map contains the Entity instances. This is where the players are moving and npcs are living.
  */
 class Map : public std::enable_shared_from_this<Map>, public core::IComponent, public persistence::ISavable {
+public:
+	/**
+	 * @brief Timing statistics of the @c Map::update calls
+	 */
+	struct TickStats {
+		/** the micros of the single phases of the last tick - only the map related phases are filled */
+		uint32_t phaseMicros[(int)TickPhase::Max] {};
+		uint32_t lastMicros = 0u;
+		/** the longest tick since the metrics were sent the last time */
+		uint32_t maxMicros = 0u;
+		uint64_t ticks = 0u;
+		/** amount of ticks that took longer than the configured map tick budget */
+		uint64_t overruns = 0u;
+	};
 private:
 	static constexpr uint32_t FOURCC = FourCC('M', 'A', 'P', '\0');
 	MapId _mapId;
@@ -42,6 +58,7 @@ private:
 	io::FilesystemPtr _filesystem;
 	persistence::PersistenceMgrPtr _persistenceMgr;
 	voxelformat::VolumeCachePtr _volumeCache;
+	AIRegistryPtr _aiRegistry;
 
 	Zone* _zone = nullptr;
 
@@ -57,19 +74,39 @@ private:
 	poi::PoiProvider _poiProvider;
 	SpawnMgr _spawnMgr;
 
-	struct QuadTreeNode {
-		EntityPtr entity;
-
-		math::RectFloat getRect() const;
-		bool operator==(const QuadTreeNode& rhs) const;
-	};
-
-	math::QuadTree<QuadTreeNode, float> _quadTree;
+	InterestGrid _interestGrid;
+	// reused for the interest queries to reduce memory allocations
+	InterestGrid::Entities _visibleEntities;
 	DBChunkPersisterPtr _chunkPersister;
+	// accumulated time since the metrics were sent the last time
+	long _metricsDelta = 0l;
+	uint32_t _lastPageIns = 0u;
+	uint32_t _lastPageInMillis = 0u;
+	core::VarPtr _tickBudget;
+	TickStats _tickStats;
+	uint64_t _lastOverruns = 0u;
+
+	/**
+	 * @brief Queues the chunks in the view distance of the users for async paging
+	 */
+	void prefetchChunks();
+	void sendMetrics(long dt);
+	void sendPagingMetrics();
+	void sendZoneMetrics();
+	void sendTickMetrics();
+	/**
+	 * @return The current high resolution time that is the start of the next phase
+	 */
+	uint64_t finishPhase(TickPhase phase, uint64_t start);
 	/**
 	 * @return @c false if the entity should be removed from the server.
 	 */
 	bool updateEntity(const EntityPtr& entity, long dt);
+	/**
+	 * @brief Informs the entity about the entities in its view distance
+	 * @note The view is only queried again if something moved in the cells of the view
+	 */
+	void updateVisible(const EntityPtr& entity);
 
 	glm::vec3 findStartPosition(const EntityPtr& entity, poi::Type type = poi::Type::GENERIC) const;
 
@@ -88,7 +125,12 @@ public:
 			const DBChunkPersisterPtr& chunkPersister);
 	~Map();
 
+	/**
+	 * @brief Runs the ai, entity, visibility and send phases of the map tick
+	 * @sa tickStats()
+	 */
 	void update(long dt);
+	const TickStats& tickStats() const;
 
 	bool init() override;
 	void shutdown() override;
@@ -150,6 +192,10 @@ inline const DBChunkPersisterPtr& Map::chunkPersister() {
 	return _chunkPersister;
 }
 
+inline const Map::TickStats& Map::tickStats() const {
+	return _tickStats;
+}
+
 inline const voxelworld::WorldPagerPtr& Map::pager() const {
 	return _pager;
 }
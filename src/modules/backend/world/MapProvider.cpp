@@ -110,16 +110,18 @@ bool MapProvider::init() {
 		blob.release();
 	});
 
-	const MapId mapId = 1;
-	const MapPtr& map = std::make_shared<Map>(mapId, _eventBus, _timeProvider,
-			_filesystem, _entityStorage, _messageSender, _volumeCache,
-			_loader, _containerProvider, _cooldownProvider, _persistenceMgr,
-			_chunkPersisterFactory.create(_dbHandler, mapId));
-	if (!map->init()) {
-		Log::warn("Failed to init map %i", mapId);
-		return false;
+	const int mapCount = core_max(1, core::Var::get(cfg::ServerMaps, "1")->intVal());
+	for (MapId mapId = 1; mapId <= mapCount; ++mapId) {
+		const MapPtr& map = std::make_shared<Map>(mapId, _eventBus, _timeProvider,
+				_filesystem, _entityStorage, _messageSender, _volumeCache,
+				_loader, _containerProvider, _cooldownProvider, _persistenceMgr,
+				_chunkPersisterFactory.create(_dbHandler, mapId));
+		if (!map->init()) {
+			Log::warn("Failed to init map %i", mapId);
+			return false;
+		}
+		_maps.put(mapId, map);
 	}
-	_maps.put(mapId, map);
 	Log::info("Map provider initialized with %i maps", (int)_maps.size());
 	return true;
 }
@@ -14,6 +14,9 @@
 #include "core/StringUtil.h"
 #include "core/Common.h"
 #include "core/Trace.h"
+#include "core/Var.h"
+#include "core/GameConfig.h"
+#include "core/concurrent/Parallel.h"
 #include "LUAFunctions.h"
 #include "attrib/ContainerProvider.h"
 
@@ -23,7 +26,8 @@ World::World(const MapProviderPtr& mapProvider, const AIRegistryPtr& registry,
 		const core::EventBusPtr& eventBus, const io::FilesystemPtr& filesystem,
 		const metric::MetricPtr& metric) :
 		_mapProvider(mapProvider), _registry(registry),
-		_eventBus(eventBus), _filesystem(filesystem), _metric(metric) {
+		_eventBus(eventBus), _filesystem(filesystem), _metric(metric),
+		_threadPool(core_max(1, core::Var::get(cfg::ServerMapThreads, "1")->intVal()), "World") {
 }
 
 World::~World() {
@@ -32,9 +36,17 @@ World::~World() {
 
 void World::update(long dt) {
 	core_trace_scoped(WorldUpdate);
-	for (const auto& e : _maps) {
-		const MapPtr& map = e->value;
-		map->update(dt);
+	if (_parallel) {
+		// one map per task - the calling thread helps while it waits
+		core::parallelFor(_threadPool, 0, (int)_tickMaps.size(), [this, dt] (int from, int to) {
+			for (int i = from; i < to; ++i) {
+				_tickMaps[i]->update(dt);
+			}
+		}, 1);
+	} else {
+		for (const MapPtr& map : _tickMaps) {
+			map->update(dt);
+		}
 	}
 	_aiServer->update(dt);
 }
@@ -113,12 +125,27 @@ bool World::init() {
 	for (const auto& e : _maps) {
 		const MapPtr& map = e->value;
 		_aiServer->addZone(map->zone());
+		_tickMaps.push_back(map);
+	}
+	std::sort(_tickMaps.begin(), _tickMaps.end(), [] (const MapPtr& a, const MapPtr& b) {
+		return a->id() < b->id();
+	});
+
+	_parallel = _threadPool.size() > 1u && _tickMaps.size() > 1u;
+	if (_parallel) {
+		_threadPool.init();
+		Log::info("Tick %i maps with %i threads", (int)_tickMaps.size(), (int)_threadPool.size());
 	}
 
 	return true;
 }
 
 void World::shutdown() {
+	if (_parallel) {
+		_threadPool.shutdown(true);
+		_parallel = false;
+	}
+	_tickMaps.clear();
 	for (const auto& e : _maps) {
 		const MapPtr& map = e->value;
 		_aiServer->removeZone(map->zone());
@@ -6,6 +6,7 @@
 
 #include "Map.h"
 #include "core/IComponent.h"
+#include "core/concurrent/ThreadPool.h"
 #include "backend/ForwardDecl.h"
 #include "backend/entity/ai/server/Server.h"
 
@@ -13,6 +14,18 @@ namespace backend {
 
 /**
  * @brief The world is the whole universe of all @c Map instances.
+ *
+ * The maps are ticked in parallel. A map and everything it owns (entities, @c SpawnMgr, @c AttackMgr
+ * and @c Zone) is only touched by one worker per tick. Actions that affect other maps or the
+ * @c EntityStorage are deferred via the @c core::EventBus and executed on the main thread.
+ * With only one map thread configured the maps are ticked sequentially in the order of their ids.
+ *
+ * The objects that are shared between the maps are either owned by the main thread or synchronized:
+ * @li @c network::ServerMessageSender queues the messages under its own lock and the enet calls are
+ * serialized by the network host lock
+ * @li @c MetricMgr is only used on the main thread - the maps enqueue @c metric::MetricEvent instances
+ * instead. @c metric::Metric itself can be used from any thread.
+ * @li @c voxelformat::VolumeCache and @c persistence::PersistenceMgr lock on their own
  */
 class World : public core::IComponent {
 private:
@@ -23,6 +36,10 @@ private:
 	metric::MetricPtr _metric;
 	Server* _aiServer = nullptr;
 	core::Map<MapId, MapPtr> _maps;
+	// sorted by id - the order the maps are ticked in if they are not ticked in parallel
+	std::vector<MapPtr> _tickMaps;
+	core::ThreadPool _threadPool;
+	bool _parallel = false;
 public:
 	World(const MapProviderPtr& mapProvider, const AIRegistryPtr& registry,
 			const core::EventBusPtr& eventBus, const io::FilesystemPtr& filesystem,
@@ -30,14 +47,29 @@ public:
 	~World();
 
 	void update(long dt);
+	/**
+	 * @return @c true if the maps are ticked in parallel
+	 */
+	bool parallel() const;
 
 	MapPtr map(MapId id) const;
 
+	template<class FUNC>
+	void visit(FUNC&& func) const {
+		for (const auto& e : _maps) {
+			func(e->value);
+		}
+	}
+
 	void construct() override;
 	bool init() override;
 	void shutdown() override;
 };
 
+inline bool World::parallel() const {
+	return _parallel;
+}
+
 inline MapPtr World::map(MapId id) const {
 	auto i = _maps.find(id);
 	if (i == _maps.end()) {
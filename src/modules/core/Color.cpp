@@ -158,7 +158,10 @@ float Color::getDistance(const glm::vec4& color, float hue, float saturation, fl
 	float csaturation;
 	float cbrightness;
 	core::Color::getHSB(color, chue, csaturation, cbrightness);
+	return getDistance(chue, csaturation, cbrightness, hue, saturation, brightness);
+}
 
+float Color::getDistance(float chue, float csaturation, float cbrightness, float hue, float saturation, float brightness) {
 	const float weightHue = 0.8f;
 	const float weightSaturation = 0.1f;
 	const float weightValue = 0.1f;
@@ -52,6 +52,10 @@ public:
 		DarkBrown;
 
 	static float getDistance(const glm::vec4& color, float hue, float saturation, float brightness);
+	/**
+	 * @brief The weighted distance of two colors that are given in their hsb representation
+	 */
+	static float getDistance(float chue, float csaturation, float cbrightness, float hue, float saturation, float brightness);
 
 	/**
 	 * @brief Get the nearest matching color index from the list
@@ -54,6 +54,24 @@ constexpr const char *ServerPort = "sv_port";
 constexpr const char *ServerMaxClients = "sv_maxclients";
 constexpr const char *ServerPostgresLib = "sv_postgreslib";
 constexpr const char *ServerHttpPort = "sv_httpport";
+// comma separated list of the addresses of internal peers whose client messages are dispatched without verification
+constexpr const char *ServerTrustedHosts = "sv_trustedhosts";
+// the amount of threads that page in the world chunks around the users in the background
+constexpr const char *ServerPagingThreads = "sv_pagingthreads";
+// the amount of threads that update the ai of the npcs of a map
+constexpr const char *ServerZoneThreads = "sv_zonethreads";
+// the amount of maps the server hosts
+constexpr const char *ServerMaps = "sv_maps";
+// the amount of threads that tick the maps in parallel - 1 ticks them sequentially
+constexpr const char *ServerMapThreads = "sv_mapthreads";
+// the cell size of the grid that is used to find the entities in the view distance of an entity
+constexpr const char *ServerInterestCellSize = "sv_interestcellsize";
+// the fixed interval of the server tick in millis
+constexpr const char *ServerTickMillis = "sv_tickmillis";
+// the max amount of ticks that are executed in one frame if the server falls behind - the rest is skipped
+constexpr const char *ServerMaxCatchUpTicks = "sv_maxcatchupticks";
+// the time in millis a map tick may take before it is counted as overrun - 0 disables the check
+constexpr const char *ServerMapTickBudget = "sv_maptickbudget";
 // the download urls for the chunks
 constexpr const char *ServerChunkBaseUrl = "sv_httpchunkurl";
 
@@ -81,5 +99,7 @@ constexpr const char *AppBasePath = "app_basepath";
 constexpr const char *MetricPort = "metric_port";
 constexpr const char *MetricHost = "metric_host";
 constexpr const char *MetricFlavor = "metric_flavor";
+// the interval in millis the metrics are aggregated in before they are sent - 0 sends every metric immediately
+constexpr const char *MetricFlushInterval = "metric_flushinterval";
 
 }
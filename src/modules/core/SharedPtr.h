@@ -113,6 +113,14 @@ public:
 		return _refCnt;
 	}
 
+	/**
+	 * @return The amount of references to the object - @c 0 for an empty pointer
+	 * @note Another thread might change this value right after it was returned
+	 */
+	int use_count() const {
+		return count();
+	}
+
 	void release() {
 		if (decrease() == 0) {
 			if (_ptr != nullptr) {
@@ -0,0 +1,161 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/TaskGroup.h"
+#include "core/concurrent/Parallel.h"
+#include "core/concurrent/Concurrency.h"
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The former ThreadPool implementation as baseline: one locked queue of heap allocated tasks
+ */
+class LockedQueuePool {
+private:
+	std::vector<std::thread> _workers;
+	std::queue<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stop = false;
+public:
+	explicit LockedQueuePool(size_t threads) {
+		for (size_t i = 0; i < threads; ++i) {
+			_workers.emplace_back([this] {
+				for (;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(_mutex);
+						_condition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+						if (_stop && _tasks.empty()) {
+							return;
+						}
+						task = std::move(_tasks.front());
+						_tasks.pop();
+					}
+					task();
+				}
+			});
+		}
+	}
+
+	~LockedQueuePool() {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_condition.notify_all();
+		for (std::thread &worker : _workers) {
+			worker.join();
+		}
+	}
+
+	template<class F>
+	std::future<void> enqueue(F&& f) {
+		auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+		std::future<void> res = task->get_future();
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_tasks.emplace([task]() { (*task)(); });
+		}
+		_condition.notify_one();
+		return res;
+	}
+};
+
+}
+
+class ThreadPoolBenchmark: public app::AbstractBenchmark {
+};
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, LockedQueueEnqueue) (benchmark::State& state) {
+	LockedQueuePool pool(core::cpus());
+	core::AtomicInt count;
+	std::vector<std::future<void>> futures;
+	futures.reserve(state.range(0));
+	for (auto _ : state) {
+		futures.clear();
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			futures.emplace_back(pool.enqueue([&count] () { ++count; }));
+		}
+		for (std::future<void>& f : futures) {
+			f.get();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, Enqueue) (benchmark::State& state) {
+	core::ThreadPool pool(core::cpus(), "Bench");
+	pool.init();
+	core::AtomicInt count;
+	std::vector<std::future<void>> futures;
+	futures.reserve(state.range(0));
+	for (auto _ : state) {
+		futures.clear();
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			futures.emplace_back(pool.enqueue([&count] () { ++count; }));
+		}
+		for (std::future<void>& f : futures) {
+			f.get();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, TaskGroup) (benchmark::State& state) {
+	core::ThreadPool pool(core::cpus(), "Bench");
+	pool.init();
+	core::AtomicInt count;
+	for (auto _ : state) {
+		core::TaskGroup group(pool);
+		for (int64_t i = 0; i < state.range(0); ++i) {
+			group.run([&count] () { ++count; });
+		}
+		group.wait();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, ParallelReduce) (benchmark::State& state) {
+	core::ThreadPool pool(core::cpus(), "Bench");
+	pool.init();
+	std::vector<float> values(state.range(0), 1.0f);
+	for (auto _ : state) {
+		const float sum = core::parallelReduce(pool, 0, (int)values.size(), 0.0f, [&values] (int from, int to) {
+			float partial = 0.0f;
+			for (int i = from; i < to; ++i) {
+				partial += values[i];
+			}
+			return partial;
+		}, [] (float a, float b) {
+			return a + b;
+		});
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolBenchmark, SerialReduce) (benchmark::State& state) {
+	std::vector<float> values(state.range(0), 1.0f);
+	for (auto _ : state) {
+		float sum = 0.0f;
+		for (float v : values) {
+			sum += v;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, LockedQueueEnqueue)->RangeMultiplier(8)->Range(64, 4096)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, Enqueue)->RangeMultiplier(8)->Range(64, 4096)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, TaskGroup)->RangeMultiplier(8)->Range(64, 4096)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, ParallelReduce)->RangeMultiplier(16)->Range(1024, 1024 * 1024)->UseRealTime();
+BENCHMARK_REGISTER_F(ThreadPoolBenchmark, SerialReduce)->RangeMultiplier(16)->Range(1024, 1024 * 1024);
@@ -0,0 +1,80 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/concurrent/TaskGroup.h"
+#include "core/Common.h"
+#include <vector>
+
+namespace core {
+
+namespace priv {
+
+inline int grainSize(const ThreadPool& threadPool, int start, int end, int grain) {
+	if (grain > 0) {
+		return grain;
+	}
+	// a few chunks per worker to be able to balance the load by stealing
+	const int chunks = (int)threadPool.size() * 4;
+	return core_max(1, (end - start + chunks - 1) / core_max(1, chunks));
+}
+
+}
+
+/**
+ * @brief Splits the range [start, end) into chunks of @c grain elements and calls @c func(from, to) for each of
+ * them on the thread pool. Blocks until all chunks are processed.
+ * @param grain The amount of elements per chunk - @c 0 picks a chunk size based on the amount of workers
+ */
+template<class F>
+void parallelFor(ThreadPool& threadPool, int start, int end, F&& func, int grain = 0) {
+	if (start >= end) {
+		return;
+	}
+	const int step = priv::grainSize(threadPool, start, end, grain);
+	TaskGroup group(threadPool);
+	for (int from = start; from < end; from += step) {
+		const int to = core_min(from + step, end);
+		group.run([&func, from, to] () {
+			func(from, to);
+		});
+	}
+	group.wait();
+}
+
+/**
+ * @brief Calls @c func(from, to) for chunks of the range [start, end) on the thread pool and combines the
+ * returned values with @c reduce(a, b).
+ * @note The chunk results are reduced in the order of the chunks - the result doesn't depend on the scheduling,
+ * even if @c reduce is not associative (like floating point addition).
+ */
+template<class T, class F, class R>
+T parallelReduce(ThreadPool& threadPool, int start, int end, const T& identity, F&& func, R&& reduce, int grain = 0) {
+	if (start >= end) {
+		return identity;
+	}
+	const int step = priv::grainSize(threadPool, start, end, grain);
+	const int chunks = (end - start + step - 1) / step;
+	std::vector<T> results(chunks, identity);
+	{
+		TaskGroup group(threadPool);
+		for (int i = 0; i < chunks; ++i) {
+			const int from = start + i * step;
+			const int to = core_min(from + step, end);
+			T* result = &results[i];
+			group.run([&func, from, to, result] () {
+				*result = func(from, to);
+			});
+		}
+		group.wait();
+	}
+	T value = identity;
+	for (const T& result : results) {
+		value = reduce(value, result);
+	}
+	return value;
+}
+
+}
@@ -0,0 +1,44 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ReadWriteLock.h"
+#include <shared_mutex>
+
+namespace core {
+
+/**
+ * @brief Reader writer lock that allows several readers at the same time
+ *
+ * Unlike @c ReadWriteLock this lock is not recursive - don't acquire it again on the same thread.
+ * Use it with @c ScopedReadLock and @c ScopedWriteLock.
+ */
+class core_thread_capability("mutex") SharedLock {
+private:
+	mutable std::shared_mutex _mutex;
+public:
+	SharedLock() = default;
+	SharedLock(const SharedLock&) = delete;
+	SharedLock& operator=(const SharedLock&) = delete;
+
+	inline void lockRead() const core_thread_acquire_shared() {
+		_mutex.lock_shared();
+	}
+
+	inline void unlockRead() const core_thread_release() {
+		_mutex.unlock_shared();
+	}
+
+	inline void lockWrite() core_thread_acquire() {
+		_mutex.lock();
+	}
+
+	inline void unlockWrite() core_thread_release() {
+		_mutex.unlock();
+	}
+};
+
+}
@@ -0,0 +1,150 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/Common.h"
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+
+namespace core {
+
+/**
+ * @brief Move-only type erased callable for the ThreadPool
+ *
+ * Functors up to @c InlineSize bytes are stored in the task itself - there is no heap allocation involved for
+ * scheduling them. This covers lambdas that capture a few pointers or values. Larger functors are still supported,
+ * but are moved to the heap.
+ */
+class Task {
+public:
+	static constexpr size_t InlineSize = 48;
+
+	Task() = default;
+
+	template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+	Task(F&& func) {
+		using Func = typename std::decay<F>::type;
+		using FitsInline = std::integral_constant<bool, sizeof(Func) <= InlineSize && alignof(Func) <= alignof(Storage)
+				&& std::is_nothrow_move_constructible<Func>::value>;
+		construct<Func>(core::forward<F>(func), FitsInline());
+	}
+
+	Task(Task&& other) noexcept {
+		moveFrom(other);
+	}
+
+	Task& operator=(Task&& other) noexcept {
+		if (this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		reset();
+	}
+
+	/**
+	 * @brief Destroys the stored functor without executing it
+	 */
+	void reset() {
+		if (_ops != nullptr) {
+			_ops->destroy(&_storage);
+			_ops = nullptr;
+		}
+	}
+
+	/**
+	 * @return @c true if the functor is stored in the task and not on the heap
+	 */
+	bool isInline() const {
+		return _ops != nullptr && _ops->isInline;
+	}
+
+	explicit operator bool() const {
+		return _ops != nullptr;
+	}
+
+	void operator()() {
+		_ops->invoke(&_storage);
+	}
+
+private:
+	using Storage = typename std::aligned_storage<InlineSize, alignof(max_align_t)>::type;
+
+	struct Ops {
+		void (*invoke)(void *storage);
+		/** move constructs the functor into the destination storage and destroys the source */
+		void (*relocate)(void *dst, void *src);
+		void (*destroy)(void *storage);
+		bool isInline;
+	};
+
+	template<class Func>
+	struct InlineOps {
+		static void invoke(void *storage) {
+			(*(Func*)storage)();
+		}
+		static void relocate(void *dst, void *src) {
+			new (dst) Func(core::move(*(Func*)src));
+			((Func*)src)->~Func();
+		}
+		static void destroy(void *storage) {
+			((Func*)storage)->~Func();
+		}
+		static constexpr Ops ops { invoke, relocate, destroy, true };
+	};
+
+	template<class Func>
+	struct HeapOps {
+		static void invoke(void *storage) {
+			(**(Func**)storage)();
+		}
+		static void relocate(void *dst, void *src) {
+			new (dst) Func*(*(Func**)src);
+		}
+		static void destroy(void *storage) {
+			delete *(Func**)storage;
+		}
+		static constexpr Ops ops { invoke, relocate, destroy, false };
+	};
+
+	template<class Func, class F>
+	void construct(F&& func, std::true_type) {
+		new (&_storage) Func(core::forward<F>(func));
+		_ops = &InlineOps<Func>::ops;
+	}
+
+	template<class Func, class F>
+	void construct(F&& func, std::false_type) {
+		Func *ptr = new Func(core::forward<F>(func));
+		new (&_storage) Func*(ptr);
+		_ops = &HeapOps<Func>::ops;
+	}
+
+	void moveFrom(Task& other) {
+		_ops = other._ops;
+		if (_ops != nullptr) {
+			_ops->relocate(&_storage, &other._storage);
+			other._ops = nullptr;
+		}
+	}
+
+	Storage _storage;
+	const Ops *_ops = nullptr;
+};
+
+template<class Func>
+constexpr Task::Ops Task::InlineOps<Func>::ops;
+
+template<class Func>
+constexpr Task::Ops Task::HeapOps<Func>::ops;
+
+}
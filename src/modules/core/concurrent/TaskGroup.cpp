@@ -0,0 +1,58 @@
+/**
+ * @file
+ */
+
+#include "TaskGroup.h"
+
+namespace core {
+
+TaskGroup::TaskGroup(ThreadPool& threadPool) :
+		_threadPool(threadPool), _state(std::make_shared<State>()) {
+}
+
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+bool TaskGroup::State::executeTask() {
+	Task task;
+	{
+		core::ScopedLock scoped(lock);
+		if (tasks.empty()) {
+			return false;
+		}
+		// the most recently added task - its data is most likely still in the cache
+		task = core::move(tasks.back());
+		tasks.pop_back();
+	}
+	task();
+	core::ScopedLock scoped(lock);
+	--pending;
+	if (waiting > 0) {
+		condition.notify_all();
+	}
+	return true;
+}
+
+void TaskGroup::wait() {
+	State& state = *_state;
+	for (;;) {
+		if (state.executeTask()) {
+			continue;
+		}
+		core::ScopedLock lock(state.lock);
+		if (state.pending <= 0) {
+			break;
+		}
+		if (!state.tasks.empty()) {
+			continue;
+		}
+		// the remaining tasks are running on other threads
+		++state.waiting;
+		state.condition.wait(state.lock);
+		--state.waiting;
+	}
+	state.canceled = false;
+}
+
+}
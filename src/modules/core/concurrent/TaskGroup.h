@@ -0,0 +1,113 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/NonCopyable.h"
+#include <memory>
+#include <vector>
+
+namespace core {
+
+/**
+ * @brief Tracks a set of tasks that are executed on a ThreadPool to be able to wait for or cancel them
+ *
+ * The tasks are kept in a queue of the group. For each task a small runner is scheduled on the pool that executes
+ * one of the queued tasks of the group - or nothing, if a waiting thread already executed them all.
+ *
+ * @code
+ * core::TaskGroup group(threadPool);
+ * for (Chunk& chunk : chunks) {
+ *   group.run([&chunk] () { chunk.update(); });
+ * }
+ * group.wait();
+ * @endcode
+ *
+ * @note The destructor waits for all tasks of the group.
+ */
+class TaskGroup : public core::NonCopyable {
+private:
+	// shared with the runners that are scheduled on the pool - they might outlive the group
+	struct State {
+		core_trace_mutex(core::Lock, lock, "TaskGroup");
+		core::ConditionVariable condition;
+		std::vector<Task> tasks core_thread_guarded_by(lock);
+		// tasks that are queued or running
+		int pending core_thread_guarded_by(lock) = 0;
+		// threads that are blocked in wait()
+		int waiting core_thread_guarded_by(lock) = 0;
+		core::AtomicBool canceled { false };
+
+		/**
+		 * @return @c false if there was no queued task
+		 */
+		bool executeTask();
+	};
+	ThreadPool& _threadPool;
+	std::shared_ptr<State> _state;
+public:
+	explicit TaskGroup(ThreadPool& threadPool);
+	~TaskGroup();
+
+	/**
+	 * @brief Schedules the functor on the thread pool. If the pool is not running, the functor is executed on the
+	 * calling thread.
+	 */
+	template<class F>
+	void run(F&& func);
+
+	/**
+	 * @brief Blocks until all tasks of the group are finished. The calling thread executes the queued tasks of this
+	 * group while it waits - so this may also be called from a task that is running on the same pool. Tasks of
+	 * other groups or the pool are never executed here. If all remaining tasks are already running on other threads,
+	 * the calling thread sleeps until they are finished.
+	 * @note Resets the canceled state - the group can be reused afterwards.
+	 */
+	void wait();
+
+	/**
+	 * @brief Tasks of this group that were not yet started are skipped. Running tasks can check @c canceled()
+	 * to return early.
+	 */
+	void cancel();
+
+	bool canceled() const;
+};
+
+template<class F>
+void TaskGroup::run(F&& func) {
+	State* state = _state.get();
+	{
+		core::ScopedLock lock(state->lock);
+		++state->pending;
+		state->tasks.emplace_back([state, f = core::forward<F>(func)] () mutable {
+			if (!state->canceled) {
+				f();
+			}
+		});
+		if (state->waiting > 0) {
+			state->condition.notify_all();
+		}
+	}
+	Task runner([s = _state] () {
+		s->executeTask();
+	});
+	if (!_threadPool.schedule(core::move(runner))) {
+		state->executeTask();
+	}
+}
+
+inline void TaskGroup::cancel() {
+	_state->canceled = true;
+}
+
+inline bool TaskGroup::canceled() const {
+	return _state->canceled;
+}
+
+}
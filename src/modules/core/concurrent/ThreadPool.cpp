@@ -9,62 +9,180 @@
 
 namespace core {
 
+/**
+ * @brief Ring buffer of tasks. The owning worker pushes and pops at the back, other threads steal from the front.
+ * The injection queue is only popped at the front.
+ */
+struct ThreadPool::Queue {
+	core_trace_mutex(core::Lock, mutex, "ThreadPoolQueue");
+	std::vector<Task> tasks core_thread_guarded_by(mutex);
+	size_t head core_thread_guarded_by(mutex) = 0u;
+	size_t count core_thread_guarded_by(mutex) = 0u;
+
+	Queue() {
+		tasks.resize(64);
+	}
+
+	void push(Task&& task) {
+		core::ScopedLock lock(mutex);
+		const size_t capacity = tasks.size();
+		if (count == capacity) {
+			std::vector<Task> grown(capacity * 2);
+			for (size_t i = 0u; i < count; ++i) {
+				grown[i] = core::move(tasks[(head + i) & (capacity - 1)]);
+			}
+			tasks = core::move(grown);
+			head = 0u;
+		}
+		tasks[(head + count) & (tasks.size() - 1)] = core::move(task);
+		++count;
+	}
+
+	bool popBack(Task& task) {
+		core::ScopedLock lock(mutex);
+		if (count == 0u) {
+			return false;
+		}
+		--count;
+		task = core::move(tasks[(head + count) & (tasks.size() - 1)]);
+		return true;
+	}
+
+	bool popFront(Task& task) {
+		core::ScopedLock lock(mutex);
+		if (count == 0u) {
+			return false;
+		}
+		task = core::move(tasks[head]);
+		head = (head + 1) & (tasks.size() - 1);
+		--count;
+		return true;
+	}
+
+	size_t clear() {
+		core::ScopedLock lock(mutex);
+		const size_t removed = count;
+		for (size_t i = 0u; i < count; ++i) {
+			tasks[(head + i) & (tasks.size() - 1)].reset();
+		}
+		head = 0u;
+		count = 0u;
+		return removed;
+	}
+};
+
+// the worker index of the current thread in the pool it belongs to
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
 ThreadPool::ThreadPool(size_t threads, const char *name) :
-		_threads(threads), _name(name) {
+		_threads(threads), _name(name), _injection(new Queue()) {
 	if (_name == nullptr) {
 		_name = "ThreadPool";
 	}
+	_queues.reserve(_threads);
+	for (size_t i = 0; i < _threads; ++i) {
+		_queues.emplace_back(new Queue());
+	}
 }
 
 void ThreadPool::abort() {
-	core::ScopedLock lock(_queueMutex);
-	while (!_tasks.empty()) {
-		_tasks.pop();
+	_pending.decrement((int)_injection->clear());
+	for (std::unique_ptr<Queue>& queue : _queues) {
+		const size_t removed = queue->clear();
+		_pending.decrement((int)removed);
 	}
 }
 
+bool ThreadPool::schedule(Task&& task) {
+	if (_stop || _queues.empty()) {
+		return false;
+	}
+	Queue* queue;
+	if (currentPool == this) {
+		queue = _queues[currentWorker].get();
+	} else {
+		queue = _injection.get();
+	}
+	_pending.increment();
+	queue->push(core::move(task));
+	// a worker that is about to fall asleep increments the sleep counter before it checks the
+	// pending tasks - so either we see the sleeping worker here, or it sees our task
+	if (_sleeping > 0) {
+		core::ScopedLock lock(_sleepMutex);
+		_sleepCondition.notify_one();
+	}
+	return true;
+}
+
+bool ThreadPool::popTask(int worker, Task& task) {
+	const int n = (int)_queues.size();
+	if (worker >= 0 && _queues[worker]->popBack(task)) {
+		return true;
+	}
+	if (_injection->popFront(task)) {
+		return true;
+	}
+	// steal the oldest task of one of the other workers
+	const int start = worker >= 0 ? worker + 1 : 0;
+	for (int i = 0; i < n; ++i) {
+		const int victim = (start + i) % n;
+		if (victim == worker) {
+			continue;
+		}
+		if (_queues[victim]->popFront(task)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::run(int worker) {
+	const core::String n = core::string::format("%s-%i", _name, worker);
+	if (!setThreadName(n.c_str())) {
+		Log::error("Failed to set thread name for pool thread %i", worker);
+	}
+	core_trace_thread(n.c_str());
+	currentPool = this;
+	currentWorker = worker;
+	for (;;) {
+		if (_stop && _force) {
+			break;
+		}
+		Task task;
+		if (popTask(worker, task)) {
+			_pending.decrement();
+			core_trace_begin_frame(n.c_str());
+			core_trace_scoped(ThreadPoolWorker);
+			Log::trace(logid, "Execute task in %i", (int)getThreadId());
+			task();
+			Log::trace(logid, "End of task in %i", (int)getThreadId());
+			core_trace_end_frame(n.c_str());
+			continue;
+		}
+		core::ScopedLock lock(_sleepMutex);
+		_sleeping.increment();
+		_sleepCondition.wait(_sleepMutex, [this] {
+			// predicate must return false if the waiting should continue
+			return _stop || _pending > 0;
+		});
+		_sleeping.decrement();
+		if (_stop && (_force || _pending <= 0)) {
+			break;
+		}
+	}
+	Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
+	currentPool = nullptr;
+	currentWorker = -1;
+}
+
 void ThreadPool::init() {
 	_force = false;
 	_stop = false;
 	_workers.reserve(_threads);
 	for (size_t i = 0; i < _threads; ++i) {
 		_workers.emplace_back([this, i] {
-			const core::String n = core::string::format("%s-%i", this->_name, (int)i);
-			if (!setThreadName(n.c_str())) {
-				Log::error("Failed to set thread name for pool thread %i", (int)i);
-			}
-			core_trace_thread(n.c_str());
-			for (;;) {
-				std::function<void()> task;
-				{
-					core::ScopedLock lock(this->_queueMutex);
-					if (!this->_stop) {
-						this->_queueCondition.wait(this->_queueMutex, [this] {
-							// predicate must return false if the waiting should continue
-							if (this->_stop) {
-								return true;
-							}
-							if (!this->_tasks.empty()) {
-								return true;
-							}
-							return false;
-						});
-					}
-					if (this->_stop && (this->_force || this->_tasks.empty())) {
-						Log::debug(logid, "Shutdown worker thread for %i", (int)getThreadId());
-						break;
-					}
-					task = core::move(this->_tasks.front());
-					this->_tasks.pop();
-				}
-
-				core_trace_begin_frame(n.c_str());
-				core_trace_scoped(ThreadPoolWorker);
-				Log::trace(logid, "Execute task in %i", (int)getThreadId());
-				task();
-				Log::trace(logid, "End of task in %i", (int)getThreadId());
-				core_trace_end_frame(n.c_str());
-			}
+			run((int)i);
 		});
 	}
 }
@@ -79,11 +197,16 @@ void ThreadPool::shutdown(bool wait) {
 	}
 	_force = !wait;
 	_stop = true;
-	_queueCondition.notify_all();
+	{
+		core::ScopedLock lock(_sleepMutex);
+		_sleepCondition.notify_all();
+	}
 	for (std::thread &worker : _workers) {
 		worker.join();
 	}
 	_workers.clear();
+	// drop the tasks that were not executed
+	abort();
 }
 
 }
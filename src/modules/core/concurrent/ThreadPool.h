@@ -28,7 +28,6 @@
 #pragma once
 
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <future>
@@ -36,11 +35,29 @@
 #include "core/concurrent/Atomic.h"
 #include "core/concurrent/Lock.h"
 #include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/Task.h"
 #include "core/Trace.h"
 #include "core/Log.h"
 
 namespace core {
 
+/**
+ * @brief Work stealing thread pool
+ *
+ * Every worker owns a task queue. Tasks that are scheduled from within a worker are pushed to the queue of that
+ * worker and are executed in LIFO order, because their data is most likely still in the cache. Tasks from other
+ * threads are pushed to a shared injection queue that the workers drain in FIFO order once their own queue is
+ * empty. A worker that runs out of tasks steals the oldest task from the queues of the other workers before it
+ * goes to sleep.
+ *
+ * The queues are ring buffers that are guarded by a mutex. They are not lock-free deques, but a worker mostly
+ * locks its own queue, so the locks are rarely contended.
+ *
+ * @note Tasks from outside of the pool are started in the order they were scheduled. Tasks that a worker schedules
+ * itself are not - use a TaskGroup to wait for the tasks that depend on each other.
+ *
+ * @see TaskGroup
+ */
 class ThreadPool final {
 private:
 	static constexpr auto logid = Log::logid("ThreadPool");
@@ -50,10 +67,17 @@ public:
 
 	/**
 	 * Enqueue functors or lambdas into the thread pool
+	 * @return An invalid future if the pool is not running
 	 */
 	template<class F, class ... Args>
 	auto enqueue(F&& f, Args&&... args) -> std::future<typename std::result_of<F(Args...)>::type>;
 
+	/**
+	 * @brief Schedule a task without the overhead of a shared state for a future
+	 * @return @c false if the pool is not running - the task was not scheduled and is left untouched then
+	 */
+	bool schedule(Task&& task);
+
 	size_t size() const;
 	void init();
 	/**
@@ -63,16 +87,25 @@ public:
 	void abort();
 	void shutdown(bool wait = false);
 private:
+	struct Queue;
+
+	bool popTask(int worker, Task& task);
+	void run(int worker);
+
 	const size_t _threads;
 	const char *_name;
 	// need to keep track of threads so we can join them
 	std::vector<std::thread> _workers;
-	// the task queue
-	std::queue<std::function<void()> > _tasks core_thread_guarded_by(_queueMutex);
-
-	// synchronization
-	core_trace_mutex(core::Lock, _queueMutex, "ThreadPoolQueue");
-	core::ConditionVariable _queueCondition;
+	std::vector<std::unique_ptr<Queue>> _queues;
+	// the tasks that were scheduled from outside of the pool
+	std::unique_ptr<Queue> _injection;
+	// the amount of tasks in all queues
+	core::AtomicInt _pending { 0 };
+	core::AtomicInt _sleeping { 0 };
+
+	// synchronization for the idle workers
+	core_trace_mutex(core::Lock, _sleepMutex, "ThreadPoolSleep");
+	core::ConditionVariable _sleepCondition;
 	core::AtomicBool _stop { false };
 	core::AtomicBool _force { false };
 };
@@ -86,17 +119,11 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
 		return std::future<return_type>();
 	}
 
-	auto task = std::make_shared<std::packaged_task<return_type()> >(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-
-	std::future<return_type> res = task->get_future();
-	{
-		core::ScopedLock lock(_queueMutex);
-		if (_stop) {
-			return std::future<return_type>();
-		}
-		_tasks.emplace([task]() {(*task)();});
+	std::packaged_task<return_type()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+	std::future<return_type> res = task.get_future();
+	if (!schedule(Task(core::move(task)))) {
+		return std::future<return_type>();
 	}
-	_queueCondition.notify_one();
 	return res;
 }
 
@@ -4,6 +4,8 @@
 
 #include <gtest/gtest.h>
 #include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/SharedLock.h"
+#include <chrono>
 #include <future>
 
 namespace core {
@@ -77,4 +79,33 @@ TEST_F(ReadWriteLockTest, testMoreWritersThanReaders) {
 	EXPECT_EQ(n1, limit);
 }
 
+TEST(SharedLockTest, testConcurrentReaders) {
+	core::SharedLock lock;
+	core::ScopedReadLock scoped(lock);
+	// a second reader doesn't have to wait for the first one
+	auto futureRead = std::async(std::launch::async, [&] {
+		core::ScopedReadLock scopedOther(lock);
+		return true;
+	});
+	ASSERT_EQ(std::future_status::ready, futureRead.wait_for(std::chrono::seconds(10)));
+	EXPECT_TRUE(futureRead.get());
+}
+
+TEST(SharedLockTest, testWriters) {
+	core::SharedLock lock;
+	int value = 0;
+	const int limit = 10000;
+	auto write = [&] {
+		for (int i = 0; i < limit; ++i) {
+			core::ScopedWriteLock scoped(lock);
+			++value;
+		}
+	};
+	auto futureWrite1 = std::async(std::launch::async, write);
+	auto futureWrite2 = std::async(std::launch::async, write);
+	futureWrite1.wait();
+	futureWrite2.wait();
+	EXPECT_EQ(limit * 2, value);
+}
+
 }
@@ -56,6 +56,18 @@ TEST_F(PtrTest, testRelease) {
 	EXPECT_EQ(2, value->b);
 }
 
+TEST_F(PtrTest, testUseCount) {
+	SharedPtr<SharedPtrFoo> empty;
+	EXPECT_EQ(0, empty.use_count());
+	auto p = make_shared<SharedPtrFoo>(1, 2);
+	EXPECT_EQ(1, p.use_count());
+	{
+		auto p2 = p;
+		EXPECT_EQ(2, p.use_count());
+	}
+	EXPECT_EQ(1, p.use_count());
+}
+
 TEST_F(PtrTest, testMakeShared) {
 	auto p = make_shared<SharedPtrFoo>(1, 2);
 	SharedPtrFoo* value = p.get();
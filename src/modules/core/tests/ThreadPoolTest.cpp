@@ -4,7 +4,10 @@
 
 #include <gtest/gtest.h>
 #include "core/concurrent/ThreadPool.h"
+#include "core/concurrent/TaskGroup.h"
+#include "core/concurrent/Parallel.h"
 #include "core/concurrent/Atomic.h"
+#include <vector>
 
 namespace core {
 
@@ -42,4 +45,213 @@ TEST_F(ThreadPoolTest, testMultiplePush) {
 	ASSERT_EQ(x, _count) << "Not all threads were executed";
 }
 
+TEST_F(ThreadPoolTest, testExternalTasksInOrder) {
+	const int x = 1000;
+	core::ThreadPool pool(1);
+	pool.init();
+	std::vector<int> order;
+	order.reserve(x);
+	for (int i = 0; i < x; ++i) {
+		pool.enqueue([&order, i] () {
+			order.push_back(i);
+		});
+	}
+	pool.shutdown(true);
+	ASSERT_EQ(x, (int)order.size());
+	for (int i = 0; i < x; ++i) {
+		ASSERT_EQ(i, order[i]) << "The tasks from outside of the pool should be executed in the order they were scheduled";
+	}
+}
+
+TEST_F(ThreadPoolTest, testEnqueueReturnValue) {
+	core::ThreadPool pool(2);
+	pool.init();
+	auto future = pool.enqueue([] (int a, int b) {
+		return a + b;
+	}, 1, 2);
+	ASSERT_EQ(3, future.get());
+}
+
+TEST_F(ThreadPoolTest, testEnqueueAfterShutdown) {
+	core::ThreadPool pool(1);
+	pool.init();
+	pool.shutdown();
+	auto future = pool.enqueue([this] () {
+		_executed = true;
+	});
+	ASSERT_FALSE(future.valid());
+	ASSERT_FALSE(_executed);
+}
+
+TEST_F(ThreadPoolTest, testNestedSchedule) {
+	const int x = 100;
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup group(pool);
+	for (int i = 0; i < x; ++i) {
+		group.run([this, &group] () {
+			// scheduled from within a worker - ends up in the queue of that worker
+			group.run([this] () {
+				++_count;
+			});
+		});
+	}
+	group.wait();
+	ASSERT_EQ(x, _count);
+}
+
+TEST_F(ThreadPoolTest, testTaskInlineStorage) {
+	int value = 0;
+	core::Task small([&value] () {
+		++value;
+	});
+	EXPECT_TRUE(small.isInline());
+	char buf[core::Task::InlineSize * 2] = {};
+	core::Task large([buf, &value] () {
+		value += (int)sizeof(buf);
+	});
+	EXPECT_FALSE(large.isInline());
+	core::Task moved(core::move(large));
+	EXPECT_FALSE((bool)large);
+	small();
+	moved();
+	EXPECT_EQ(1 + (int)sizeof(buf), value);
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupWait) {
+	const int x = 1000;
+	core::ThreadPool pool(2);
+	pool.init();
+	core::TaskGroup group(pool);
+	for (int i = 0; i < x; ++i) {
+		group.run([this] () {
+			++_count;
+		});
+	}
+	group.wait();
+	ASSERT_EQ(x, _count);
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupNestedWait) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::TaskGroup outer(pool);
+	for (int i = 0; i < 10; ++i) {
+		outer.run([this, &pool] () {
+			// the only worker waits for the inner group and has to execute the tasks itself
+			core::TaskGroup inner(pool);
+			for (int j = 0; j < 10; ++j) {
+				inner.run([this] () {
+					++_count;
+				});
+			}
+			inner.wait();
+		});
+	}
+	outer.wait();
+	ASSERT_EQ(100, _count);
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupWaitOnlyExecutesOwnTasks) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::AtomicBool started { false };
+	core::AtomicBool release { false };
+	// keep the only worker busy
+	auto blocker = pool.enqueue([&] () {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	const std::thread::id waitingThread = std::this_thread::get_id();
+	core::AtomicBool foreignTaskOnWaitingThread { false };
+	pool.enqueue([&] () {
+		if (std::this_thread::get_id() == waitingThread) {
+			foreignTaskOnWaitingThread = true;
+		}
+	});
+	core::TaskGroup group(pool);
+	group.run([this] () {
+		++_count;
+	});
+	group.wait();
+	EXPECT_EQ(1, _count);
+	EXPECT_FALSE(foreignTaskOnWaitingThread) << "The waiting thread should only execute the tasks of its group";
+	release = true;
+	blocker.wait();
+	pool.shutdown(true);
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupCancel) {
+	core::ThreadPool pool(1);
+	pool.init();
+	core::TaskGroup group(pool);
+	core::AtomicBool started { false };
+	core::AtomicBool release { false };
+	group.run([&] () {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	for (int i = 0; i < 10; ++i) {
+		group.run([this] () {
+			++_count;
+		});
+	}
+	group.cancel();
+	EXPECT_TRUE(group.canceled());
+	release = true;
+	group.wait();
+	EXPECT_EQ(0, _count);
+	EXPECT_FALSE(group.canceled());
+}
+
+TEST_F(ThreadPoolTest, testTaskGroupWithoutRunningPool) {
+	core::ThreadPool pool(1);
+	pool.shutdown();
+	core::TaskGroup group(pool);
+	group.run([this] () {
+		_executed = true;
+	});
+	group.wait();
+	ASSERT_TRUE(_executed);
+}
+
+TEST_F(ThreadPoolTest, testParallelFor) {
+	core::ThreadPool pool(3);
+	pool.init();
+	std::vector<int> values(1000, 0);
+	core::parallelFor(pool, 0, (int)values.size(), [&values] (int from, int to) {
+		for (int i = from; i < to; ++i) {
+			values[i] += i;
+		}
+	});
+	for (int i = 0; i < (int)values.size(); ++i) {
+		ASSERT_EQ(i, values[i]) << "Element " << i << " was not visited exactly once";
+	}
+}
+
+TEST_F(ThreadPoolTest, testParallelReduce) {
+	core::ThreadPool pool(3);
+	pool.init();
+	const int64_t sum = core::parallelReduce(pool, 0, 10000, (int64_t)0, [] (int from, int to) {
+		int64_t partial = 0;
+		for (int i = from; i < to; ++i) {
+			partial += i;
+		}
+		return partial;
+	}, [] (int64_t a, int64_t b) {
+		return a + b;
+	}, 7);
+	ASSERT_EQ(int64_t(9999) * 10000 / 2, sum);
+}
+
 }
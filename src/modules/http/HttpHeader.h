@@ -10,6 +10,12 @@ namespace http {
 
 using HeaderMap = core::CharPointerMap;
 
+/**
+ * @brief The maps are pool allocated - the per request maps are limited to this amount of entries
+ * instead of reserving the default pool size for every request
+ */
+static constexpr int MaxHeaders = 64;
+
 namespace header {
 
 static constexpr const char *CONTENT_ENCODING = "Content-Encoding";
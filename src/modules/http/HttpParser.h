@@ -40,6 +40,7 @@ protected:
 	uint8_t *buf = nullptr;
 	size_t bufSize = 0u;
 	bool _valid = false;
+	bool _freeBuffer = true;
 
 	size_t remainingBufSize(const char *bufPos) const;
 	char* getHeaderLine(char **buffer);
@@ -48,10 +49,10 @@ protected:
 public:
 	/**
 	 * @brief Parses a http response/request buffer
-	 * @note The given memory is owned by this class. You may not
-	 * release it on your own.
+	 * @param freeBuffer If this is @c true, the given memory is owned by this class. You may not
+	 * release it on your own. Otherwise the memory must outlive the parser.
 	 */
-	HttpParser(uint8_t* buffer, const size_t bufferSize);
+	HttpParser(uint8_t* buffer, const size_t bufferSize, bool freeBuffer = true);
 
 	/**
 	 * @brief Pointer to that part of the protocol header that stores
@@ -12,6 +12,8 @@ namespace http {
 
 using HttpQuery = core::CharPointerMap;
 
+static constexpr int MaxQueryParameters = 64;
+
 #define HTTP_QUERY_GET_INT(name) \
 	const char *name##value; \
 	if (!request.query.get(CORE_STRINGIFY(name), name##value)) { \
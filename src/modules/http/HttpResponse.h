@@ -9,11 +9,19 @@
 #include "HttpHeader.h"
 #include "HttpMimeType.h"
 #include <SDL_stdinc.h>
+#include <functional>
 
 namespace http {
 
 struct HttpResponse {
-	HeaderMap headers;
+	/**
+	 * @brief Produces the body of a streamed response piece by piece
+	 * @param[out] chunk The next part of the body is appended to this string
+	 * @return @c false if this was the last part. An empty chunk ends the body, too.
+	 */
+	using BodyCallback = std::function<bool(core::String& chunk)>;
+
+	HeaderMap headers = HeaderMap(MaxHeaders);
 	HttpStatus status = HttpStatus::Ok;
 	// the memory is managed by the server and freed after the response was sent.
 	const char *body = nullptr;
@@ -21,6 +29,9 @@ struct HttpResponse {
 	// if the route handler sets this to false, the memory is not freed. Can be useful for static content
 	// like error pages.
 	bool freeBody = true;
+	// if this is set, the @c body is ignored and the response is sent with chunked transfer encoding. The
+	// callback is called again once the previous chunk was handed over to the socket.
+	BodyCallback bodyCallback;
 
 	void contentLength(size_t len) {
 		bodySize = len;
@@ -6,22 +6,54 @@
 #include "RequestParser.h"
 #include "core/Assert.h"
 #include "core/ArrayLength.h"
+#include "core/Common.h"
+#include "core/Trace.h"
 #include "core/Log.h"
-#include "Network.cpp.h"
 #include "app/App.h"
 #include <string.h>
 #include <SDL_stdinc.h>
 
 namespace http {
 
+/**
+ * @brief A keep-alive client connection. The received data is stored in @c buf until a complete
+ * request is available.
+ */
+struct HttpServer::Connection {
+	// must be the first member - the libuv callbacks only give us the handle
+	uv_tcp_t handle;
+	HttpServer *server = nullptr;
+
+	uint8_t *buf = nullptr;
+	size_t length = 0u;
+	size_t capacity = 0u;
+
+	uint64_t lastActivity = 0u;
+	int pendingWrites = 0;
+	// no further requests are read - the connection is closed once the pending writes are done
+	bool closeAfterWrite = false;
+	bool closing = false;
+	// the client is done with sending - but the received requests are still answered
+	bool eof = false;
+	// the body of the streamed response that is currently written - the following requests wait for it
+	HttpResponse::BodyCallback stream;
+};
+
+struct HttpServer::WriteRequest {
+	uv_write_t req;
+	char *header;
+	const char *body;
+	bool freeBody;
+	// the next chunk of the streamed response is written once this write is done
+	bool stream;
+};
+
 HttpServer::HttpServer(const metric::MetricPtr& metric) :
-		_socketFD(INVALID_SOCKET), _metric(metric) {
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
+		_metric(metric) {
 }
 
 HttpServer::~HttpServer() {
-	core_assert(_socketFD == INVALID_SOCKET);
+	core_assert(_server == nullptr);
 }
 
 void HttpServer::setErrorText(HttpStatus status, const char *body) {
@@ -52,185 +84,298 @@ bool HttpServer::unregisterRoute(HttpMethod method, const char *path) {
 	return routes->remove(path);
 }
 
-bool HttpServer::init(int16_t port) {
-	_socketFD = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (_socketFD == INVALID_SOCKET) {
-		network_cleanup();
-		return false;
-	}
-	struct sockaddr_in sin;
-	SDL_memset(&sin, 0, sizeof(sin));
-	sin.sin_family = AF_INET;
-	sin.sin_addr.s_addr = INADDR_ANY;
-	sin.sin_port = htons(port);
-
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-
-	int t = 1;
-#ifdef _WIN32
-	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, (char*) &t, sizeof(t)) != 0) {
-#else
-	if (setsockopt(_socketFD, SOL_SOCKET, SO_REUSEADDR, &t, sizeof(t)) != 0) {
-#endif
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
-		return false;
+bool HttpServer::init(int16_t port, uv_loop_t *loop) {
+	core_assert(_server == nullptr);
+	if (loop == nullptr) {
+		_loop = new uv_loop_t;
+		if (uv_loop_init(_loop) != 0) {
+			Log::error("Failed to init the http event loop");
+			delete _loop;
+			_loop = nullptr;
+			return false;
+		}
+		_ownLoop = true;
+	} else {
+		_loop = loop;
+		_ownLoop = false;
 	}
 
-	if (bind(_socketFD, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
-		return false;
-	}
+	_server = new uv_tcp_t;
+	uv_tcp_init(_loop, _server);
+	_server->data = this;
 
-	if (listen(_socketFD, 5) < 0) {
-		network_cleanup();
-		closesocket(_socketFD);
-		_socketFD = INVALID_SOCKET;
+	struct sockaddr_in addr;
+	uv_ip4_addr("0.0.0.0", (uint16_t)port, &addr);
+	int error = uv_tcp_bind(_server, (const struct sockaddr*)&addr, 0);
+	if (error == 0) {
+		error = uv_listen((uv_stream_t*)_server, 128, onConnection);
+	}
+	if (error != 0) {
+		Log::error("Failed to listen on port %i: %s", (int)port, uv_strerror(error));
+		closeServer();
 		return false;
 	}
 
-	networkNonBlocking(_socketFD);
-
-	FD_SET(_socketFD, &_readFDSet);
-
+	_timer = new uv_timer_t;
+	uv_timer_init(_loop, _timer);
+	_timer->data = this;
+	uv_timer_start(_timer, onTimer, 1000, 1000);
+	// the timer alone should not keep the loop alive
+	uv_unref((uv_handle_t*)_timer);
 	return true;
 }
 
-HttpServer::ClientSocketsIter HttpServer::closeClient(ClientSocketsIter& iter) {
-	Client& client = *iter;
-	const SOCKET clientSocket = client.socket;
-	FD_CLR(clientSocket, &_readFDSet);
-	FD_CLR(clientSocket, &_writeFDSet);
-	closesocket(clientSocket);
-	client.socket = INVALID_SOCKET;
-	SDL_free(client.request);
-	SDL_free(client.response);
-	return _clientSockets.erase(iter);
+void HttpServer::onConnection(uv_stream_t *stream, int status) {
+	HttpServer* server = (HttpServer*)stream->data;
+	if (status < 0) {
+		Log::debug("Failed to accept http connection: %s", uv_strerror(status));
+		return;
+	}
+	Connection* connection = new Connection();
+	uv_tcp_init(server->_loop, &connection->handle);
+	connection->handle.data = connection;
+	connection->server = server;
+	if (uv_accept(stream, (uv_stream_t*)&connection->handle) != 0) {
+		server->_connections.insert(connection);
+		server->closeConnection(connection);
+		return;
+	}
+	uv_tcp_nodelay(&connection->handle, 1);
+	connection->lastActivity = uv_now(server->_loop);
+	server->_connections.insert(connection);
+	uv_read_start((uv_stream_t*)&connection->handle, onAlloc, onRead);
 }
 
-bool HttpServer::update() {
-	core_trace_scoped(HttpServerUpdate);
-	fd_set readFDsOut;
-	fd_set writeFDsOut;
+void HttpServer::onAlloc(uv_handle_t *handle, size_t suggestedSize, uv_buf_t *buf) {
+	Connection* connection = (Connection*)handle->data;
+	// the data is received directly into the request buffer
+	const size_t minFree = 2048u;
+	if (connection->capacity - connection->length < minFree) {
+		const size_t capacity = core_max(connection->capacity * 2u, connection->length + 4096u);
+		connection->buf = (uint8_t*)SDL_realloc(connection->buf, capacity);
+		connection->capacity = capacity;
+	}
+	buf->base = (char*)connection->buf + connection->length;
+	buf->len = connection->capacity - connection->length;
+}
 
-	SDL_memcpy(&readFDsOut, &_readFDSet, sizeof(readFDsOut));
-	SDL_memcpy(&writeFDsOut, &_writeFDSet, sizeof(writeFDsOut));
+void HttpServer::onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+	Connection* connection = (Connection*)stream->data;
+	HttpServer* server = connection->server;
+	if (nread < 0) {
+		if (nread == UV_EOF && connection->pendingWrites > 0) {
+			// the client is done with sending - but still waits for the responses
+			connection->eof = true;
+			// the requests that wait for the streamed response are answered once it is done
+			connection->closeAfterWrite = !connection->stream;
+			uv_read_stop(stream);
+			return;
+		}
+		server->closeConnection(connection);
+		return;
+	}
+	if (nread == 0) {
+		return;
+	}
+	connection->length += (size_t)nread;
+	connection->lastActivity = uv_now(server->_loop);
+	server->processRequests(connection);
+}
 
-	struct timeval tv;
-	tv.tv_sec = 0;
-	tv.tv_usec = 0;
-	const int ready = select(FD_SETSIZE, &readFDsOut, &writeFDsOut, nullptr, &tv);
-	if (ready < 0) {
-		return false;
+int64_t HttpServer::requestSize(const char *data, size_t length, HttpStatus& error) const {
+	if (length >= 4 && SDL_memcmp(data, "GET ", 4) != 0 && SDL_memcmp(data, "POST", 4) != 0) {
+		error = HttpStatus::NotImplemented;
+		return -1;
 	}
-	if (_socketFD != INVALID_SOCKET && FD_ISSET(_socketFD, &readFDsOut)) {
-		const SOCKET clientSocket = accept(_socketFD, nullptr, nullptr);
-		if (clientSocket != INVALID_SOCKET) {
-			FD_SET(clientSocket, &_readFDSet);
-			Client c;
-			c.socket = clientSocket;
-			_clientSockets.insert(c);
-			networkNonBlocking(clientSocket);
+	size_t headerEnd = 0u;
+	for (size_t i = 3u; i < length; ++i) {
+		if (data[i] == '\n' && data[i - 1] == '\r' && data[i - 2] == '\n' && data[i - 3] == '\r') {
+			headerEnd = i + 1u;
+			break;
 		}
 	}
-
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		Client& client = *i;
-		const SOCKET clientSocket = client.socket;
-		if (clientSocket == INVALID_SOCKET) {
-			i = closeClient(i);
-			continue;
+	if (headerEnd == 0u) {
+		if (length > _maxRequestBytes) {
+			error = HttpStatus::PayloadTooLarge;
+			return -1;
 		}
-
-		if (FD_ISSET(clientSocket, &writeFDsOut)) {
-			if (!sendMessage(client) || client.finished()) {
-				i = closeClient(i);
-			} else {
-				++i;
-			}
-			continue;
+		return 0;
+	}
+	size_t contentLength = 0u;
+	const size_t keyLength = SDL_strlen(header::CONTENT_LENGTH);
+	for (const char *line = data; line < data + headerEnd;) {
+		const char *lineEnd = (const char*)memchr(line, '\n', data + headerEnd - line);
+		if (lineEnd == nullptr) {
+			break;
 		}
-
-		if (!FD_ISSET(clientSocket, &readFDsOut)) {
-			++i;
-			continue;
+		if ((size_t)(lineEnd - line) > keyLength && SDL_strncasecmp(line, header::CONTENT_LENGTH, keyLength) == 0 && line[keyLength] == ':') {
+			if (!parseContentLength(line + keyLength + 1, lineEnd, contentLength)) {
+				error = HttpStatus::BadRequest;
+				return -1;
+			}
+			break;
 		}
+		line = lineEnd + 1;
+	}
+	const size_t size = headerEnd + contentLength;
+	if (size > _maxRequestBytes) {
+		error = HttpStatus::PayloadTooLarge;
+		return -1;
+	}
+	if (size > length) {
+		return 0;
+	}
+	return (int64_t)size;
+}
 
-		constexpr const int BUFFERSIZE = 2048;
-		uint8_t recvBuf[BUFFERSIZE];
-		const network_return len = recv(clientSocket, (char*)recvBuf, BUFFERSIZE - 1, 0);
-		if (len < 0) {
-			i = closeClient(i);
-			continue;
+bool HttpServer::parseContentLength(const char *value, const char *end, size_t& contentLength) {
+	while (value < end && (*value == ' ' || *value == '\t')) {
+		++value;
+	}
+	if (value >= end || *value < '0' || *value > '9') {
+		return false;
+	}
+	size_t length = 0u;
+	for (; value < end && *value >= '0' && *value <= '9'; ++value) {
+		const size_t digit = (size_t)(*value - '0');
+		if (length > (SIZE_MAX - digit) / 10u) {
+			return false;
 		}
-		if (len == 0) {
-			++i;
-			continue;
+		length = length * 10u + digit;
+	}
+	// only trailing whitespace is allowed
+	for (; value < end; ++value) {
+		if (*value != ' ' && *value != '\t' && *value != '\r') {
+			return false;
 		}
+	}
+	contentLength = length;
+	return true;
+}
 
-		client.request = (uint8_t*)SDL_realloc(client.request, client.requestLength + len);
-		SDL_memcpy(client.request + client.requestLength, recvBuf, len);
-		client.requestLength += len;
-
-		if (client.requestLength == 0) {
-			++i;
-			continue;
+void HttpServer::processRequests(Connection* connection) {
+	core_trace_scoped(HttpServerRequests);
+	size_t offset = 0u;
+	// the responses must keep the order of the requests - wait for a streamed response to finish
+	while (!connection->closeAfterWrite && !connection->stream && offset < connection->length) {
+		HttpStatus error = HttpStatus::BadRequest;
+		uint8_t *data = connection->buf + offset;
+		const int64_t size = requestSize((const char*)data, connection->length - offset, error);
+		if (size == 0) {
+			break;
 		}
-
-		// GET / HTTP/1.1\r\n\r\n
-		if (client.requestLength < 18) {
-			++i;
-			continue;
+		if (size < 0) {
+			sendError(connection, error);
+			break;
 		}
+		offset += (size_t)size;
+		// the request is parsed in place - the parser only stores pointers into the receive buffer
+		RequestParser request(data, (size_t)size, false);
+		handleRequest(connection, request);
+	}
+	// keep the incomplete request at the beginning of the buffer
+	if (offset >= connection->length) {
+		connection->length = 0u;
+	} else if (offset > 0u) {
+		connection->length -= offset;
+		SDL_memmove(connection->buf, connection->buf + offset, connection->length);
+	}
+}
 
-		if (SDL_memcmp(client.request, "GET", 3) != 0 && SDL_memcmp(client.request, "POST", 4) != 0) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::NotImplemented);
-			++i;
-			continue;
+void HttpServer::handleRequest(Connection* connection, RequestParser& request) {
+	if (!request.valid()) {
+		sendError(connection, HttpStatus::BadRequest);
+		return;
+	}
+	const bool http11 = request.protocolVersion != nullptr && SDL_strcmp(request.protocolVersion, "HTTP/1.0") != 0;
+	bool keepAlive = http11;
+	const char *connectionHeader = request.headerValue(header::CONNECTION);
+	if (connectionHeader != nullptr) {
+		if (SDL_strcasecmp(connectionHeader, "close") == 0) {
+			keepAlive = false;
+		} else if (SDL_strcasecmp(connectionHeader, "keep-alive") == 0) {
+			keepAlive = true;
 		}
+	}
 
-		if (client.requestLength > _maxRequestBytes) {
-			FD_CLR(clientSocket, &_readFDSet);
-			FD_CLR(clientSocket, &readFDsOut);
-			assembleError(client, HttpStatus::InternalServerError);
-			++i;
-			continue;
-		}
+	HttpResponse response;
+	if (!route(request, response)) {
+		sendError(connection, HttpStatus::NotFound);
+		return;
+	}
+	sendResponse(connection, response, keepAlive, http11);
+}
 
-		uint8_t *mem = (uint8_t *)SDL_malloc(client.requestLength);
-		SDL_memcpy(mem, client.request, client.requestLength);
-		const RequestParser request(mem, client.requestLength);
-		if (!request.valid()) {
-			++i;
-			continue;
-		}
+void HttpServer::write(Connection* connection, char* header, size_t headerSize, const char* body, size_t bodySize, bool freeBody, bool stream) {
+	WriteRequest *w = new WriteRequest();
+	w->req.data = connection;
+	w->header = header;
+	w->body = body;
+	w->freeBody = freeBody;
+	w->stream = stream;
+	uv_buf_t bufs[2];
+	bufs[0] = uv_buf_init(header, (unsigned int)headerSize);
+	bufs[1] = uv_buf_init((char*)body, (unsigned int)bodySize);
+	++connection->pendingWrites;
+	const int error = uv_write(&w->req, (uv_stream_t*)&connection->handle, bufs, bodySize > 0u ? 2 : 1, onWrite);
+	if (error != 0) {
+		Log::debug("Failed to send the http response: %s", uv_strerror(error));
+		onWrite(&w->req, error);
+	}
+}
 
-		FD_CLR(clientSocket, &_readFDSet);
-		FD_CLR(clientSocket, &readFDsOut);
+void HttpServer::onWrite(uv_write_t *req, int status) {
+	WriteRequest *w = (WriteRequest*)req;
+	Connection* connection = (Connection*)req->data;
+	const bool stream = w->stream;
+	SDL_free(w->header);
+	if (w->freeBody) {
+		SDL_free((char*)w->body);
+	}
+	delete w;
+	--connection->pendingWrites;
+	if (status != 0) {
+		connection->server->closeConnection(connection);
+		return;
+	}
+	if (stream && connection->stream && !connection->closing) {
+		connection->server->streamNext(connection);
+	}
+	if (connection->closeAfterWrite && connection->pendingWrites == 0 && !connection->stream) {
+		connection->server->closeConnection(connection);
+	}
+}
 
-		HttpResponse response;
-		if (!route(request, response)) {
-			assembleError(client, HttpStatus::NotFound);
-			++i;
-			continue;
-		}
-		assembleResponse(client, response);
-		if (response.freeBody) {
-			SDL_free((char*)response.body);
+void HttpServer::streamNext(Connection* connection) {
+	core::String chunk;
+	const bool more = connection->stream(chunk) && !chunk.empty();
+	if (!chunk.empty()) {
+		const size_t bufSize = chunk.size() + 32u;
+		char *buf = (char*)SDL_malloc(bufSize);
+		size_t len = (size_t)SDL_snprintf(buf, bufSize, "%x\r\n", (unsigned int)chunk.size());
+		SDL_memcpy(buf + len, chunk.c_str(), chunk.size());
+		len += chunk.size();
+		SDL_memcpy(buf + len, "\r\n", 2u);
+		len += 2u;
+		write(connection, buf, len, nullptr, 0u, false, more);
+	}
+	if (more) {
+		return;
+	}
+	connection->stream = HttpResponse::BodyCallback();
+	write(connection, SDL_strdup("0\r\n\r\n"), 5u, nullptr, 0u, false);
+	if (!connection->closeAfterWrite) {
+		// answer the requests that were pipelined behind the streamed response
+		processRequests(connection);
+		if (connection->eof && !connection->stream) {
+			connection->closeAfterWrite = true;
 		}
 	}
-	return true;
 }
 
-void HttpServer::assembleError(Client& client, HttpStatus status) {
-	char buf[512];
-	SDL_snprintf(buf, sizeof(buf),
+void HttpServer::sendError(Connection* connection, HttpStatus status) {
+	char *header = (char*)SDL_malloc(512);
+	const int headerSize = SDL_snprintf(header, 512,
 			"HTTP/1.1 %i %s\r\n"
 			"Connection: close\r\n"
 			"Server: %s\r\n"
@@ -242,70 +387,127 @@ void HttpServer::assembleError(Client& client, HttpStatus status) {
 	const char *errorPage = "";
 	_errorPages.get((int)status, errorPage);
 
-	const size_t responseSize = SDL_strlen(errorPage) + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize + 1);
-	SDL_snprintf(responseBuf, responseSize + 1, "%s%s", buf, errorPage);
-	client.setResponse(responseBuf, responseSize);
+	// the connection state is unknown after an error - don't read any further requests
+	connection->closeAfterWrite = true;
+	uv_read_stop((uv_stream_t*)&connection->handle);
 	metric(status);
-	FD_SET(client.socket, &_writeFDSet);
+	++_requests;
+	write(connection, header, core_min(headerSize, 511), errorPage, SDL_strlen(errorPage), false);
 }
 
-void HttpServer::assembleResponse(Client& client, const HttpResponse& response) {
+void HttpServer::sendResponse(Connection* connection, HttpResponse& response, bool keepAlive, bool chunked) {
+	if (response.bodyCallback && !chunked) {
+		// the client doesn't know about chunked transfer encoding - collect the whole body
+		core::String body;
+		for (;;) {
+			const size_t before = body.size();
+			if (!response.bodyCallback(body) || body.size() == before) {
+				break;
+			}
+		}
+		if (response.freeBody) {
+			SDL_free((char*)response.body);
+		}
+		char *buf = (char*)SDL_malloc(body.size() + 1u);
+		SDL_memcpy(buf, body.c_str(), body.size() + 1u);
+		response.body = buf;
+		response.bodySize = body.size();
+		response.freeBody = true;
+		response.bodyCallback = HttpResponse::BodyCallback();
+	}
+	const bool stream = (bool)response.bodyCallback;
+	if (stream && response.freeBody) {
+		SDL_free((char*)response.body);
+		response.body = nullptr;
+		response.bodySize = 0u;
+	}
+
 	char headers[2048];
 	if (!buildHeaderBuffer(headers, lengthof(headers), response.headers)) {
-		assembleError(client, HttpStatus::InternalServerError);
+		if (response.freeBody) {
+			SDL_free((char*)response.body);
+		}
+		sendError(connection, HttpStatus::InternalServerError);
 		return;
 	}
 
-	char buf[4096];
-	const int headerSize = SDL_snprintf(buf, sizeof(buf),
+	char length[64];
+	if (stream) {
+		SDL_strlcpy(length, "Transfer-Encoding: chunked\r\n", sizeof(length));
+	} else {
+		SDL_snprintf(length, sizeof(length), "Content-length: %u\r\n", (unsigned int)response.bodySize);
+	}
+	const size_t headerBufSize = 4096;
+	char *header = (char*)SDL_malloc(headerBufSize);
+	const int headerSize = SDL_snprintf(header, headerBufSize,
 			"HTTP/1.1 %i %s\r\n"
-			"Content-length: %u\r\n"
+			"%s"
+			"Connection: %s\r\n"
 			"%s"
 			"\r\n",
 			(int)response.status,
 			toStatusString(response.status),
-			(unsigned int)response.bodySize,
+			length,
+			keepAlive ? "keep-alive" : "close",
 			headers);
-	if (headerSize >= lengthof(buf)) {
-		assembleError(client, HttpStatus::InternalServerError);
+	if (headerSize >= (int)headerBufSize) {
+		SDL_free(header);
+		if (response.freeBody) {
+			SDL_free((char*)response.body);
+		}
+		sendError(connection, HttpStatus::InternalServerError);
 		return;
 	}
-
-	const size_t responseSize = response.bodySize + SDL_strlen(buf);
-	char *responseBuf = (char*)SDL_malloc(responseSize);
-	SDL_memcpy(responseBuf, buf, headerSize);
-	SDL_memcpy(responseBuf + headerSize, response.body, response.bodySize);
-	client.setResponse(responseBuf, responseSize);
-	Log::trace("Response buffer of size %i", (int)responseSize);
+	if (!keepAlive) {
+		connection->closeAfterWrite = true;
+		uv_read_stop((uv_stream_t*)&connection->handle);
+	}
 	metric(response.status);
-	FD_SET(client.socket, &_writeFDSet);
+	++_requests;
+	if (stream) {
+		Log::trace("Streamed response");
+		// the first chunk is requested once the header was written
+		connection->stream = core::move(response.bodyCallback);
+		write(connection, header, headerSize, nullptr, 0u, false, true);
+		return;
+	}
+	Log::trace("Response of size %i", (int)(headerSize + response.bodySize));
+	write(connection, header, headerSize, response.body, response.bodySize, response.freeBody);
 }
 
-void HttpServer::metric(HttpStatus status) const {
-	char buf[8];
-	SDL_snprintf(buf, sizeof(buf), "%u", (uint32_t)status);
-	_metric->count("http.request", 1, {{"status", buf}});
+void HttpServer::metric(HttpStatus status) {
+	// the tags are expensive - so the counts are aggregated and sent by the timer
+	uint32_t count = 0u;
+	_statusCounts.get((int)status, count);
+	_statusCounts.put((int)status, count + 1u);
 }
 
-bool HttpServer::sendMessage(Client& client) {
-	core_assert(client.response != nullptr);
-	int remaining = (int)client.responseLength - (int)client.alreadySent;
-	if (remaining <= 0) {
-		return false;
+void HttpServer::flushMetrics() {
+	for (const auto& e : _statusCounts) {
+		if (e->value == 0u) {
+			continue;
+		}
+		char buf[8];
+		SDL_snprintf(buf, sizeof(buf), "%u", (uint32_t)e->key);
+		_metric->count("http.request", (int)e->value, {{"status", buf}});
 	}
-	const char* p = client.response + client.alreadySent;
-	const network_return sent = ::send(client.socket, p, remaining, 0);
-	if (sent < 0) {
-		Log::debug("Failed to send to the client");
-		return false;
+	_statusCounts.clear();
+}
+
+void HttpServer::onTimer(uv_timer_t *timer) {
+	HttpServer* server = (HttpServer*)timer->data;
+	server->flushMetrics();
+	const uint64_t now = uv_now(server->_loop);
+	std::vector<Connection*> idle;
+	for (Connection* connection : server->_connections) {
+		if (connection->pendingWrites == 0 && now - connection->lastActivity > server->_keepAliveMillis) {
+			idle.push_back(connection);
+		}
 	}
-	if (sent == 0) {
-		return true;
+	for (Connection* connection : idle) {
+		Log::debug("Close idle http connection");
+		server->closeConnection(connection);
 	}
-	remaining -= sent;
-	client.alreadySent += sent;
-	return remaining > 0;
 }
 
 bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
@@ -340,7 +542,6 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 		return false;
 	}
 	response.headers.put(header::CONTENT_TYPE, http::mimetype::TEXT_PLAIN);
-	response.headers.put(header::CONNECTION, "close");
 	response.headers.put(header::SERVER, app::App::getInstance()->appname().c_str());
 	// TODO urldecode of request data
 	//core::string::urlDecode(request.query);
@@ -348,43 +549,69 @@ bool HttpServer::route(const RequestParser& request, HttpResponse& response) {
 	return true;
 }
 
+void HttpServer::closeConnection(Connection* connection) {
+	if (connection->closing) {
+		return;
+	}
+	connection->closing = true;
+	uv_close((uv_handle_t*)&connection->handle, onClose);
+}
+
+void HttpServer::onClose(uv_handle_t *handle) {
+	Connection* connection = (Connection*)handle->data;
+	connection->server->_connections.erase(connection);
+	SDL_free(connection->buf);
+	delete connection;
+}
+
+bool HttpServer::update() {
+	core_trace_scoped(HttpServerUpdate);
+	if (!_ownLoop || _loop == nullptr) {
+		return true;
+	}
+	uv_run(_loop, UV_RUN_NOWAIT);
+	return true;
+}
+
+void HttpServer::closeServer() {
+	const std::vector<Connection*> connections(_connections.begin(), _connections.end());
+	for (Connection* connection : connections) {
+		closeConnection(connection);
+	}
+	if (_server != nullptr) {
+		uv_close((uv_handle_t*)_server, [] (uv_handle_t* handle) {
+			delete (uv_tcp_t*)handle;
+		});
+		_server = nullptr;
+	}
+	if (_timer != nullptr) {
+		uv_close((uv_handle_t*)_timer, [] (uv_handle_t* handle) {
+			delete (uv_timer_t*)handle;
+		});
+		_timer = nullptr;
+	}
+	if (_loop != nullptr && _ownLoop) {
+		// let the close callbacks run
+		uv_run(_loop, UV_RUN_DEFAULT);
+		core_assert_always(uv_loop_close(_loop) == 0);
+		delete _loop;
+	}
+	_loop = nullptr;
+	_ownLoop = false;
+}
+
 void HttpServer::shutdown() {
 	const size_t l = lengthof(_routes);
 	for (size_t i = 0; i < l; ++i) {
 		_routes[i].clear();
 	}
-	for (ClientSocketsIter i = _clientSockets.begin(); i != _clientSockets.end();) {
-		i = closeClient(i);
-	}
+	closeServer();
+	flushMetrics();
 
 	for (auto i : _errorPages) {
 		SDL_free((char*)i->second);
 	}
 	_errorPages.clear();
-
-	FD_ZERO(&_readFDSet);
-	FD_ZERO(&_writeFDSet);
-	closesocket(_socketFD);
-	_socketFD = INVALID_SOCKET;
-	network_cleanup();
-}
-
-HttpServer::Client::Client() :
-		socket(INVALID_SOCKET) {
-}
-
-void HttpServer::Client::setResponse(char* responseBuf, size_t responseBufLength) {
-	core_assert(response == nullptr);
-	response = responseBuf;
-	responseLength = responseBufLength;
-	alreadySent = 0u;
-}
-
-bool HttpServer::Client::finished() const {
-	if (response == nullptr) {
-		return false;
-	}
-	return responseLength == alreadySent;
 }
 
 }
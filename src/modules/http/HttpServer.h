@@ -8,60 +8,99 @@
 #include "HttpResponse.h"
 #include "HttpStatus.h"
 #include "RequestParser.h"
-#include "Network.h"
 #include "HttpHeader.h"
 #include "HttpQuery.h"
 #include "core/collection/Map.h"
-#include "core/collection/List.h"
 #include "metric/Metric.h"
 #include <stdint.h>
 #include <functional>
 #include <memory>
+#include <unordered_set>
+#include <uv.h>
 
 namespace http {
 
 class RequestParser;
 
+/**
+ * @brief Event driven http server on top of libuv
+ *
+ * The connections are kept alive and pipelined requests are parsed directly from the receive buffer
+ * of the connection. The response header and body are handed over to the socket without assembling
+ * them into one buffer. Responses with a @c HttpResponse::bodyCallback are streamed with chunked transfer
+ * encoding - the next chunk is requested once the previous one was written.
+ *
+ * @note The server can either run in its own event loop that is polled in @c update() or it can be
+ * attached to an existing loop. In the latter case the owner of the loop is responsible for running it.
+ */
 class HttpServer {
 public:
 	using RouteCallback = std::function<void(const RequestParser& query, HttpResponse* response)>;
 private:
-	SOCKET _socketFD;
-	fd_set _readFDSet;
-	fd_set _writeFDSet;
+	struct Connection;
+	struct WriteRequest;
+
 	using Routes = core::Map<const char*, RouteCallback, 8, core::hashCharPtr, core::hashCharCompare>;
 	core::Map<int, const char*, 8, std::hash<int>> _errorPages;
 	Routes _routes[2];
 	size_t _maxRequestBytes = 1 * 1024 * 1024;
+	uint64_t _keepAliveMillis = 5000u;
 	metric::MetricPtr _metric;
 
-	struct Client {
-		Client();
-		SOCKET socket;
-
-		uint8_t *request = nullptr;
-		size_t requestLength = 0u;
-
-		char* response = nullptr;
-		size_t responseLength = 0u;
-		size_t alreadySent = 0u;
-
-		void setResponse(char* responseBuf, size_t responseBufLength);
-		bool finished() const;
-	};
-
-	using ClientSockets = core::List<Client>;
-	using ClientSocketsIter = ClientSockets::iterator;
-	ClientSockets _clientSockets { 1024 };
-
-	ClientSocketsIter closeClient (ClientSocketsIter& i);
+	uv_loop_t *_loop = nullptr;
+	bool _ownLoop = false;
+	uv_tcp_t *_server = nullptr;
+	// closes idle connections and flushes the metrics
+	uv_timer_t *_timer = nullptr;
+	std::unordered_set<Connection*> _connections;
+	// requests per status code since the last metric flush
+	core::Map<int, uint32_t, 8, std::hash<int>> _statusCounts;
+	uint64_t _requests = 0u;
+
+	static void onConnection(uv_stream_t *server, int status);
+	static void onAlloc(uv_handle_t *handle, size_t suggestedSize, uv_buf_t *buf);
+	static void onRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
+	static void onWrite(uv_write_t *req, int status);
+	static void onClose(uv_handle_t *handle);
+	static void onTimer(uv_timer_t *timer);
+
+	void closeConnection(Connection* connection);
+	/**
+	 * @brief Closes all handles - if the server owns the loop, the loop is closed, too. Otherwise
+	 * the close callbacks are executed the next time the owner runs the loop.
+	 */
+	void closeServer();
+	void processRequests(Connection* connection);
+	/**
+	 * @return The size of the request at the beginning of the given buffer or @c 0 if it
+	 * isn't complete yet. @c -1 on error.
+	 */
+	int64_t requestSize(const char *data, size_t length, HttpStatus& error) const;
+	/**
+	 * @brief Parses the value of the content length header
+	 * @return @c false if the value is no number or doesn't fit into @c size_t
+	 */
+	static bool parseContentLength(const char *value, const char *end, size_t& contentLength);
+	void handleRequest(Connection* connection, RequestParser& request);
 
-	void metric(HttpStatus status) const;
+	void metric(HttpStatus status);
+	void flushMetrics();
 
 	bool route(const RequestParser& request, HttpResponse& response);
-	void assembleResponse(Client& client, const HttpResponse& response);
-	void assembleError(Client& client, HttpStatus status);
-	bool sendMessage(Client& client);
+	/**
+	 * @param[in] chunked @c false if the client doesn't support chunked transfer encoding - a streamed
+	 * body is collected and sent at once then
+	 */
+	void sendResponse(Connection* connection, HttpResponse& response, bool keepAlive, bool chunked);
+	void sendError(Connection* connection, HttpStatus status);
+	/**
+	 * @param[in] stream @c true if the next chunk of the streamed response should be written once this write is done
+	 */
+	void write(Connection* connection, char* header, size_t headerSize, const char* body, size_t bodySize, bool freeBody, bool stream = false);
+	/**
+	 * @brief Writes the next chunk of the streamed response - or the end of the body
+	 */
+	void streamNext(Connection* connection);
 
 	Routes* getRoutes(HttpMethod method);
 
@@ -70,24 +109,55 @@ public:
 	~HttpServer();
 
 	void setMaxRequestSize(size_t maxBytes);
+	/**
+	 * @brief Idle keep-alive connections are closed after the given amount of millis
+	 */
+	void setKeepAliveTimeout(uint64_t millis);
 
 	/**
 	 * @param[in] body The status code body. The pointer is copied and then released by the server.
 	 */
 	void setErrorText(HttpStatus status, const char *body);
 
-	bool init(int16_t port = 8080);
+	/**
+	 * @param[in] loop The event loop to attach the server to. If this is @c nullptr, the server
+	 * creates its own loop that is polled in @c update()
+	 */
+	bool init(int16_t port = 8080, uv_loop_t *loop = nullptr);
+	/**
+	 * @brief Processes the pending socket events if the server owns the event loop
+	 */
 	bool update();
 	void shutdown();
 
 	void registerRoute(HttpMethod method, const char *path, const RouteCallback& callback);
 	bool unregisterRoute(HttpMethod method, const char *path);
+
+	/**
+	 * @return The amount of currently open client connections
+	 */
+	size_t connections() const;
+	/**
+	 * @return The amount of requests that were answered
+	 */
+	uint64_t requests() const;
 };
 
 inline void HttpServer::setMaxRequestSize(size_t maxBytes) {
 	_maxRequestBytes = maxBytes;
 }
 
+inline void HttpServer::setKeepAliveTimeout(uint64_t millis) {
+	_keepAliveMillis = millis;
+}
+
+inline size_t HttpServer::connections() const {
+	return _connections.size();
+}
+
+inline uint64_t HttpServer::requests() const {
+	return _requests;
+}
 
 typedef std::shared_ptr<HttpServer> HttpServerPtr;
 
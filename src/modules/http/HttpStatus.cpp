@@ -15,6 +15,10 @@ const char* toStatusString(HttpStatus status) {
 		return "Not Found";
 	} else if (status == HttpStatus::NotImplemented) {
 		return "Not Implemented";
+	} else if (status == HttpStatus::BadRequest) {
+		return "Bad Request";
+	} else if (status == HttpStatus::PayloadTooLarge) {
+		return "Payload Too Large";
 	}
 	return "Unknown";
 }
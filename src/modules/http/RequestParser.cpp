@@ -44,8 +44,8 @@ RequestParser::RequestParser(const RequestParser &other) :
 	path = HTTP_PARSER_NEW_BASE(other.path);
 }
 
-RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize)
-		: Super(requestBuffer, requestBufferSize) {
+RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize, bool freeBuffer)
+		: Super(requestBuffer, requestBufferSize, freeBuffer), query(MaxQueryParameters) {
 	if (buf == nullptr || bufSize == 0) {
 		return;
 	}
@@ -97,6 +97,9 @@ RequestParser::RequestParser(uint8_t* requestBuffer, size_t requestBufferSize)
 				static const char *EMPTY = "";
 				value = (char*)EMPTY;
 			}
+			if (query.size() >= MaxQueryParameters && query.find(key) == query.end()) {
+				return;
+			}
 			query.put(key, value);
 
 			if (last) {
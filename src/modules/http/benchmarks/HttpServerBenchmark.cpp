@@ -0,0 +1,192 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "http/HttpServer.h"
+#include "http/Network.h"
+#include "http/Network.cpp.h"
+#include <SDL_stdinc.h>
+#include <vector>
+
+/**
+ * @brief Local load generator for the http server - the server and the clients share one thread
+ */
+class HttpServerBenchmark: public app::AbstractBenchmark {
+protected:
+	static constexpr const char *Request = "GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	static constexpr const char *CloseRequest = "GET /health HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+	std::shared_ptr<http::HttpServer> _server;
+	uint16_t _port = 0u;
+
+	struct Client {
+		SOCKET socket = INVALID_SOCKET;
+		// the amount of bytes of "HTTP/1.1 " that were already matched
+		int match = 0;
+	};
+	std::vector<Client> _clients;
+
+	void init(uint16_t port) {
+		_port = port;
+		_server = std::make_shared<http::HttpServer>(std::make_shared<metric::Metric>());
+		if (!_server->init((int16_t)port)) {
+			Log::error("Failed to listen on port %i", (int)port);
+		}
+		_server->registerRoute(http::HttpMethod::GET, "/health", [] (const http::RequestParser& request, http::HttpResponse* response) {
+			response->setText("{\"status\": \"up\"}");
+		});
+	}
+
+	SOCKET connect() {
+		const SOCKET s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+		struct sockaddr_in sin;
+		SDL_zero(sin);
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sin.sin_port = htons(_port);
+		if (::connect(s, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+			closesocket(s);
+			return INVALID_SOCKET;
+		}
+		networkNonBlocking(s);
+		return s;
+	}
+
+	void sendRequests(Client& client, const char *request, int amount) {
+		const size_t len = SDL_strlen(request);
+		for (int i = 0; i < amount; ++i) {
+			::send(client.socket, request, len, 0);
+		}
+	}
+
+	/**
+	 * @return The amount of responses that were received - the response start lines are counted
+	 */
+	int receive(Client& client, bool* closed) {
+		static const char *Status = "HTTP/1.1 ";
+		static const int StatusLength = (int)SDL_strlen(Status);
+		char buf[4096];
+		int responses = 0;
+		for (;;) {
+			const network_return len = recv(client.socket, buf, sizeof(buf), 0);
+			if (len == 0) {
+				*closed = true;
+				return responses;
+			}
+			if (len < 0) {
+				return responses;
+			}
+			for (network_return i = 0; i < len; ++i) {
+				if (buf[i] == Status[client.match]) {
+					if (++client.match == StatusLength) {
+						++responses;
+						client.match = 0;
+					}
+				} else {
+					client.match = buf[i] == Status[0] ? 1 : 0;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Every connection sends the given amount of pipelined requests and waits for the responses
+	 */
+	void keepAlive(benchmark::State& state, uint16_t port, int connections, int pipelined) {
+		init(port);
+		_clients.resize(connections);
+		for (Client& c : _clients) {
+			c.socket = connect();
+		}
+		for (auto _ : state) {
+			int pending = 0;
+			for (Client& c : _clients) {
+				sendRequests(c, Request, pipelined);
+				pending += pipelined;
+			}
+			while (pending > 0) {
+				_server->update();
+				for (Client& c : _clients) {
+					bool closed = false;
+					pending -= receive(c, &closed);
+					if (closed) {
+						// the server doesn't support keep-alive - reconnect and resend what is missing
+						closesocket(c.socket);
+						c.socket = connect();
+						c.match = 0;
+						sendRequests(c, Request, pipelined);
+					}
+				}
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * connections * pipelined);
+	}
+
+public:
+	void TearDown(benchmark::State& st) override {
+		for (Client& c : _clients) {
+			if (c.socket != INVALID_SOCKET) {
+				closesocket(c.socket);
+			}
+		}
+		_clients.clear();
+		if (_server) {
+			_server->shutdown();
+			_server.reset();
+		}
+		app::AbstractBenchmark::TearDown(st);
+	}
+};
+
+BENCHMARK_DEFINE_F(HttpServerBenchmark, keepAlive) (benchmark::State& state) {
+	keepAlive(state, 10201, 8, 1);
+}
+
+BENCHMARK_DEFINE_F(HttpServerBenchmark, keepAlivePipelined) (benchmark::State& state) {
+	keepAlive(state, 10202, 8, 16);
+}
+
+BENCHMARK_DEFINE_F(HttpServerBenchmark, connectionPerRequest) (benchmark::State& state) {
+	init(10203);
+	_clients.resize(1);
+	Client& c = _clients[0];
+	for (auto _ : state) {
+		c.socket = connect();
+		c.match = 0;
+		sendRequests(c, CloseRequest, 1);
+		bool closed = false;
+		while (!closed) {
+			_server->update();
+			receive(c, &closed);
+		}
+		closesocket(c.socket);
+		c.socket = INVALID_SOCKET;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief The costs of the server in the main loop while scrapers keep their connections open
+ */
+BENCHMARK_DEFINE_F(HttpServerBenchmark, idleConnections) (benchmark::State& state) {
+	init(10204);
+	_clients.resize(state.range(0));
+	for (Client& c : _clients) {
+		c.socket = connect();
+		// accept the connection before the listen backlog is full
+		_server->update();
+	}
+	for (int i = 0; i < 10; ++i) {
+		_server->update();
+	}
+	for (auto _ : state) {
+		_server->update();
+	}
+}
+
+BENCHMARK_REGISTER_F(HttpServerBenchmark, keepAlive);
+BENCHMARK_REGISTER_F(HttpServerBenchmark, keepAlivePipelined);
+BENCHMARK_REGISTER_F(HttpServerBenchmark, connectionPerRequest);
+BENCHMARK_REGISTER_F(HttpServerBenchmark, idleConnections)->Arg(16)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -4,10 +4,60 @@
 
 #include "app/tests/AbstractTest.h"
 #include "http/HttpServer.h"
+#include "http/Network.h"
+#include "http/Network.cpp.h"
+#include "core/String.h"
+#include <SDL_timer.h>
 
 namespace http {
 
 class HttpServerTest : public app::AbstractTest {
+protected:
+	SOCKET connect(uint16_t port) {
+		const SOCKET s = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+		struct sockaddr_in sin;
+		SDL_zero(sin);
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sin.sin_port = htons(port);
+		if (::connect(s, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+			closesocket(s);
+			return INVALID_SOCKET;
+		}
+		networkNonBlocking(s);
+		return s;
+	}
+
+	/**
+	 * @brief Runs the server until the given amount of responses was received or the peer closed the connection
+	 */
+	core::String receive(HttpServer& server, SOCKET s, int responses, bool* closed = nullptr, uint32_t timeoutMillis = 2000u) {
+		core::String received;
+		const uint64_t end = SDL_GetTicks() + timeoutMillis;
+		while (SDL_GetTicks() < end) {
+			server.update();
+			char buf[1024];
+			const network_return len = recv(s, buf, sizeof(buf) - 1, 0);
+			if (len == 0) {
+				if (closed != nullptr) {
+					*closed = true;
+				}
+				break;
+			}
+			if (len > 0) {
+				buf[len] = '\0';
+				received.append(buf, (size_t)len);
+			}
+			int found = 0;
+			for (const char *p = SDL_strstr(received.c_str(), "HTTP/1.1 "); p != nullptr; p = SDL_strstr(p + 1, "HTTP/1.1 ")) {
+				++found;
+			}
+			if (found >= responses && closed == nullptr) {
+				break;
+			}
+		}
+		return received;
+	}
 };
 
 TEST_F(HttpServerTest, testSimple) {
@@ -19,4 +69,128 @@ TEST_F(HttpServerTest, testSimple) {
 	server.shutdown();
 }
 
+TEST_F(HttpServerTest, testKeepAlivePipelined) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10102));
+	server.registerRoute(HttpMethod::GET, "/health", [] (const http::RequestParser& request, HttpResponse* response) {
+		response->setText("up");
+	});
+	const SOCKET s = connect(10102);
+	ASSERT_NE(INVALID_SOCKET, s);
+	const char *requests =
+			"GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			"GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			"GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(requests), send(s, requests, SDL_strlen(requests), 0));
+	const core::String& received = receive(server, s, 3);
+	EXPECT_EQ(3u, server.requests()) << received;
+	EXPECT_EQ(1u, server.connections()) << "The connection should be kept alive";
+	EXPECT_NE(core::String::npos, received.find("Connection: keep-alive")) << received;
+	EXPECT_EQ(received.size() - 2u, received.rfind("up")) << received;
+
+	// the second request is split over two packets
+	const char *part1 = "GET /health HTTP/1.1\r\nHo";
+	const char *part2 = "st: localhost\r\nConnection: close\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(part1), send(s, part1, SDL_strlen(part1), 0));
+	receive(server, s, 1, nullptr, 100u);
+	EXPECT_EQ(3u, server.requests()) << "The request is not yet complete";
+	ASSERT_EQ((network_return)SDL_strlen(part2), send(s, part2, SDL_strlen(part2), 0));
+	bool closed = false;
+	const core::String& last = receive(server, s, 1, &closed);
+	EXPECT_TRUE(closed) << "The connection should be closed after the response";
+	EXPECT_NE(core::String::npos, last.find("Connection: close")) << last;
+	EXPECT_EQ(4u, server.requests());
+	closesocket(s);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testNotFound) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10103));
+	const SOCKET s = connect(10103);
+	ASSERT_NE(INVALID_SOCKET, s);
+	const char *request = "GET /unknown HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(request), send(s, request, SDL_strlen(request), 0));
+	bool closed = false;
+	const core::String& received = receive(server, s, 1, &closed);
+	EXPECT_TRUE(closed);
+	EXPECT_EQ(0u, received.find("HTTP/1.1 404 Not Found")) << received;
+	closesocket(s);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testInvalidContentLength) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10104));
+	server.registerRoute(HttpMethod::POST, "/", [] (const http::RequestParser& request, HttpResponse* response) {
+		response->setText("ok");
+	});
+	const SOCKET s = connect(10104);
+	ASSERT_NE(INVALID_SOCKET, s);
+	const char *request = "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 99999999999999999999999\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(request), send(s, request, SDL_strlen(request), 0));
+	bool closed = false;
+	const core::String& received = receive(server, s, 1, &closed);
+	EXPECT_TRUE(closed);
+	EXPECT_EQ(0u, received.find("HTTP/1.1 400 Bad Request")) << received;
+	closesocket(s);
+
+	const SOCKET s2 = connect(10104);
+	ASSERT_NE(INVALID_SOCKET, s2);
+	const char *request2 = "POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 2x\r\n\r\nab";
+	ASSERT_EQ((network_return)SDL_strlen(request2), send(s2, request2, SDL_strlen(request2), 0));
+	closed = false;
+	const core::String& received2 = receive(server, s2, 1, &closed);
+	EXPECT_TRUE(closed);
+	EXPECT_EQ(0u, received2.find("HTTP/1.1 400 Bad Request")) << received2;
+	closesocket(s2);
+	server.shutdown();
+}
+
+TEST_F(HttpServerTest, testStreamed) {
+	HttpServer server(_testApp->metric());
+	ASSERT_TRUE(server.init(10105));
+	server.registerRoute(HttpMethod::GET, "/stream", [] (const http::RequestParser& request, HttpResponse* response) {
+		int part = 0;
+		response->bodyCallback = [part] (core::String& chunk) mutable {
+			chunk += (char)('a' + part);
+			return ++part < 3;
+		};
+	});
+	server.registerRoute(HttpMethod::GET, "/health", [] (const http::RequestParser& request, HttpResponse* response) {
+		response->setText("up");
+	});
+	const SOCKET s = connect(10105);
+	ASSERT_NE(INVALID_SOCKET, s);
+	// the second response must wait for the streamed one
+	const char *requests =
+			"GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n"
+			"GET /health HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(requests), send(s, requests, SDL_strlen(requests), 0));
+	// the client is done with sending - the pending responses must still arrive
+	shutdown(s, 1);
+	bool closed = false;
+	const core::String& received = receive(server, s, 2, &closed);
+	EXPECT_TRUE(closed);
+	EXPECT_NE(core::String::npos, received.find("Transfer-Encoding: chunked")) << received;
+	const size_t body = received.find("1\r\na\r\n1\r\nb\r\n1\r\nc\r\n0\r\n\r\nHTTP/1.1 200");
+	EXPECT_NE(core::String::npos, body) << received;
+	EXPECT_EQ(received.size() - 2u, received.rfind("up")) << received;
+	EXPECT_EQ(2u, server.requests());
+	closesocket(s);
+
+	// no chunked transfer encoding for HTTP/1.0 clients
+	const SOCKET s2 = connect(10105);
+	ASSERT_NE(INVALID_SOCKET, s2);
+	const char *request = "GET /stream HTTP/1.0\r\nHost: localhost\r\n\r\n";
+	ASSERT_EQ((network_return)SDL_strlen(request), send(s2, request, SDL_strlen(request), 0));
+	closed = false;
+	const core::String& received2 = receive(server, s2, 1, &closed);
+	EXPECT_TRUE(closed);
+	EXPECT_NE(core::String::npos, received2.find("Content-length: 3")) << received2;
+	EXPECT_EQ(received2.size() - 3u, received2.rfind("abc")) << received2;
+	closesocket(s2);
+	server.shutdown();
+}
+
 }
@@ -7,6 +7,7 @@
 #include "io/File.h"
 #include "core/Assert.h"
 #include "core/Log.h"
+#include "core/StandardLib.h"
 #include <stdarg.h>
 
 namespace io {
@@ -22,6 +23,79 @@ FileStream::FileStream(SDL_RWops* rwops) :
 }
 
 FileStream::~FileStream() {
+	flushBuffer();
+	core_free(_buffer);
+}
+
+bool FileStream::flush() {
+	return flushBuffer();
+}
+
+bool FileStream::flushBuffer() const {
+	if (!_dirty) {
+		return true;
+	}
+	_dirty = false;
+	SDL_RWseek(_rwops, _bufferPos, RW_SEEK_SET);
+	if (!writeDirect(_buffer, _bufferSize)) {
+		Log::error("Failed to write %i bytes at offset %i", (int)_bufferSize, (int)_bufferPos);
+		_bufferSize = 0;
+		return false;
+	}
+	return true;
+}
+
+bool FileStream::writeDirect(const uint8_t *buf, size_t size) const {
+	size_t completeBytesWritten = 0;
+	int32_t bytesWritten = 1;
+	const uint8_t* b = buf;
+	while (completeBytesWritten < size && bytesWritten > 0) {
+		bytesWritten = (int32_t)SDL_RWwrite(_rwops, b, 1, (size - completeBytesWritten));
+		b += bytesWritten;
+		completeBytesWritten += bytesWritten;
+	}
+	return completeBytesWritten == size;
+}
+
+int FileStream::peekBuf(uint8_t *buf, size_t size) const {
+	if (remaining() < (int64_t)size) {
+		return -1;
+	}
+	if (buffered(size)) {
+		core_memcpy(buf, _buffer + (_pos - _bufferPos), size);
+		return 0;
+	}
+	if (!flushBuffer()) {
+		return -1;
+	}
+	uint8_t *target = buf;
+	size_t targetSize = size;
+	if (size <= BufferSize) {
+		// refill the window at the current position
+		if (_buffer == nullptr) {
+			_buffer = (uint8_t*)core_malloc(BufferSize);
+		}
+		target = _buffer;
+		targetSize = (size_t)core_min(remaining(), (int64_t)BufferSize);
+		_bufferPos = _pos;
+		_bufferSize = 0;
+	}
+	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
+	size_t completeBytesRead = 0;
+	size_t bytesRead = 1;
+	while (completeBytesRead < targetSize && bytesRead != 0) {
+		bytesRead = SDL_RWread(_rwops, target + completeBytesRead, 1, targetSize - completeBytesRead);
+		completeBytesRead += bytesRead;
+	}
+	if (target == _buffer) {
+		_bufferSize = (int64_t)completeBytesRead;
+		if (completeBytesRead < size) {
+			return -1;
+		}
+		core_memcpy(buf, _buffer, size);
+		return 0;
+	}
+	return completeBytesRead == size ? 0 : -1;
 }
 
 int FileStream::peekInt(uint32_t& val) const {
@@ -57,10 +131,8 @@ bool FileStream::addStringFormat(bool terminate, const char *fmt, ...) {
 	text[sizeof(text) - 1] = '\0';
 	va_end(ap);
 	const size_t length = SDL_strlen(text);
-	for (size_t i = 0u; i < length; i++) {
-		if (!addByte(uint8_t(text[i]))) {
-			return false;
-		}
+	if (!append((const uint8_t*)text, length)) {
+		return false;
 	}
 	if (!terminate) {
 		return true;
@@ -283,11 +355,10 @@ int FileStream::readIntBE(uint32_t& val) {
 }
 
 int FileStream::readBuf(uint8_t *buf, size_t bufSize) {
-	for (size_t i = 0; i < bufSize; ++i) {
-		if (readByte(buf[i]) != 0) {
-			return -1;
-		}
+	if (peekBuf(buf, bufSize) != 0) {
+		return -1;
 	}
+	_pos += (int64_t)bufSize;
 	return 0;
 }
 
@@ -312,43 +383,44 @@ int FileStream::readLongBE(uint64_t& val) {
 }
 
 bool FileStream::addByte(uint8_t val) {
-	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-	if (SDL_RWwrite(_rwops, &val, 1, 1) != 1) {
-		return false;
-	}
-	if (_pos >= _size) {
-		++_size;
-	}
-	++_pos;
-	return true;
+	return append(&val, 1);
 }
 
 bool FileStream::append(const uint8_t *buf, size_t size) {
-	SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-	size_t completeBytesWritten = 0;
-	int32_t bytesWritten = 1;
-	const uint8_t* b = buf;
-	while (completeBytesWritten < size && bytesWritten > 0) {
-		bytesWritten = (int32_t)SDL_RWwrite(_rwops, b, 1, (size - completeBytesWritten));
-		b += bytesWritten;
-		completeBytesWritten += bytesWritten;
-	}
-	if (completeBytesWritten != size) {
-		return false;
-	}
-	if (_pos >= _size) {
-		_size += size;
+	const int64_t end = _pos + (int64_t)size;
+	if (size > BufferSize) {
+		if (!flushBuffer()) {
+			return false;
+		}
+		_bufferSize = 0;
+		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
+		if (!writeDirect(buf, size)) {
+			return false;
+		}
+	} else {
+		// the bytes must extend or overwrite the buffered window
+		if (_buffer == nullptr || _pos < _bufferPos || _pos > _bufferPos + _bufferSize || end > _bufferPos + (int64_t)BufferSize) {
+			if (!flushBuffer()) {
+				return false;
+			}
+			if (_buffer == nullptr) {
+				_buffer = (uint8_t*)core_malloc(BufferSize);
+			}
+			_bufferPos = _pos;
+			_bufferSize = 0;
+		}
+		core_memcpy(_buffer + (_pos - _bufferPos), buf, size);
+		_bufferSize = core_max(_bufferSize, end - _bufferPos);
+		_dirty = true;
 	}
-	_pos += size;
+	_size = core_max(_size, end);
+	_pos = end;
 	return true;
 }
 
 bool FileStream::addString(const core::String& string, bool terminate) {
-	const size_t length = string.size();
-	for (size_t i = 0u; i < length; i++) {
-		if (!addByte(uint8_t(string[i]))) {
-			return false;
-		}
+	if (!append((const uint8_t*)string.c_str(), string.size())) {
+		return false;
 	}
 	if (!terminate) {
 		return true;
@@ -10,6 +10,7 @@
 #include <SDL_rwops.h>
 #include "core/Common.h"
 #include "core/SharedPtr.h"
+#include "core/StandardLib.h"
 #include <limits.h>
 
 namespace io {
@@ -19,19 +20,51 @@ typedef core::SharedPtr<File> FilePtr;
 
 /**
  * @brief Little endian file stream
+ *
+ * Reads and writes go through a buffer that caches a window of the file. Writes are only handed over to
+ * the file once the window is left, on @c flush() or on destruction of the stream.
  */
 class FileStream {
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
 private:
 	int64_t _pos = 0;
 	int64_t _size = 0;
 	mutable SDL_RWops *_rwops;
 
+	mutable uint8_t *_buffer = nullptr;
+	/** the file offset of the first byte in the buffer */
+	mutable int64_t _bufferPos = 0;
+	/** the amount of valid bytes in the buffer */
+	mutable int64_t _bufferSize = 0;
+	/** the buffer contains bytes that were not yet written to the file */
+	mutable bool _dirty = false;
+
+	bool flushBuffer() const;
+	bool writeDirect(const uint8_t *buf, size_t size) const;
+	/**
+	 * @return A value of @c 0 indicates no error
+	 */
+	int peekBuf(uint8_t *buf, size_t size) const;
+
+	inline bool buffered(int64_t size) const {
+		return _pos >= _bufferPos && _pos + size <= _bufferPos + _bufferSize;
+	}
+
 public:
 	FileStream(File* file);
 	FileStream(const FilePtr& file) : FileStream(file.get()) {}
 	FileStream(SDL_RWops* rwops);
+	FileStream(const FileStream&) = delete;
+	FileStream& operator=(const FileStream&) = delete;
 	virtual ~FileStream();
 
+	/**
+	 * @brief Writes the buffered bytes to the file
+	 * @note This is done automatically on destruction - but errors can only be detected by calling this manually
+	 */
+	bool flush();
+
 	inline int64_t remaining() const {
 		return _size - _pos;
 	}
@@ -65,50 +98,21 @@ public:
 		if (remaining() < (int64_t)bufSize) {
 			return -1;
 		}
-		uint8_t buf[bufSize];
-		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
-		uint8_t *b = buf;
-
-		size_t completeBytesRead = 0;
-		size_t bytesRead = 1;
-		while (completeBytesRead < bufSize && bytesRead != 0) {
-			bytesRead = SDL_RWread(_rwops, b, 1, (bufSize - completeBytesRead));
-			b += bytesRead;
-			completeBytesRead += bytesRead;
-		}
-		if (completeBytesRead != bufSize) {
-			return -1;
+		if (buffered(bufSize)) {
+			core_memcpy((void*)&val, _buffer + (_pos - _bufferPos), bufSize);
+			return 0;
 		}
-		const Ret *word = (const Ret*) (void*) buf;
-		val = *word;
-		return 0;
+		return peekBuf((uint8_t*)&val, bufSize);
 	}
 
 	template<class Type>
 	inline bool write(Type val) {
-		SDL_RWseek(_rwops, _pos, RW_SEEK_SET);
 		const size_t bufSize = sizeof(Type);
 		uint8_t buf[bufSize];
 		for (size_t i = 0; i < bufSize; ++i) {
 			buf[i] = uint8_t(val >> (i * CHAR_BIT));
 		}
-
-		uint8_t *b = buf;
-		size_t completeBytesWritten = 0;
-		int32_t bytesWritten = 1;
-		while (completeBytesWritten < bufSize && bytesWritten > 0) {
-			bytesWritten = (int32_t)SDL_RWwrite(_rwops, b, 1, (bufSize - completeBytesWritten));
-			b += bytesWritten;
-			completeBytesWritten += bytesWritten;
-		}
-		if (completeBytesWritten != bufSize) {
-			return false;
-		}
-		if (_pos >= _size) {
-			_size += sizeof(val);
-		}
-		_pos += sizeof(val);
-		return true;
+		return append(buf, bufSize);
 	}
 
 	template<class Ret>
@@ -67,10 +67,62 @@ TEST_F(FileStreamTest, testFileStreamWrite) {
 	EXPECT_EQ(4l, stream.size());
 	EXPECT_TRUE(stream.addInt(1));
 	EXPECT_EQ(8l, stream.size());
+	EXPECT_TRUE(stream.flush());
 	file->close();
 	file->open(io::FileMode::Read);
 	EXPECT_TRUE(file->exists());
 	EXPECT_EQ(8l, file->length());
 }
 
+TEST_F(FileStreamTest, testFileStreamBufferedWrite) {
+	io::Filesystem fs;
+	EXPECT_TRUE(fs.init("test", "test")) << "Failed to initialize the filesystem";
+	const int values = (int)(FileStream::BufferSize / sizeof(uint32_t)) * 3;
+	{
+		const FilePtr& file = fs.open("filestream-bufferedwritetest", io::FileMode::SysWrite);
+		ASSERT_TRUE(file->validHandle());
+		FileStream stream(file);
+		// placeholder that is overwritten once the buffer window was left
+		EXPECT_TRUE(stream.addInt(0u));
+		for (int i = 0; i < values; ++i) {
+			EXPECT_TRUE(stream.addInt((uint32_t)i));
+		}
+		uint8_t big[FileStream::BufferSize + 16];
+		for (size_t i = 0; i < sizeof(big); ++i) {
+			big[i] = (uint8_t)i;
+		}
+		EXPECT_TRUE(stream.append(big, sizeof(big)));
+		EXPECT_TRUE(stream.addString("end"));
+		const int64_t size = stream.size();
+		EXPECT_EQ(0, stream.seek(0));
+		EXPECT_TRUE(stream.addInt((uint32_t)values));
+		EXPECT_EQ(size, stream.size()) << "Overwriting must not change the size";
+		EXPECT_TRUE(stream.flush());
+	}
+	const FilePtr& file = fs.open("filestream-bufferedwritetest", io::FileMode::SysRead);
+	ASSERT_TRUE(file->exists());
+	FileStream stream(file);
+	EXPECT_EQ((int64_t)(sizeof(uint32_t) * (values + 1) + FileStream::BufferSize + 16 + 4), stream.size());
+	uint32_t val;
+	ASSERT_EQ(0, stream.readInt(val));
+	EXPECT_EQ((uint32_t)values, val);
+	for (int i = 0; i < values; ++i) {
+		ASSERT_EQ(0, stream.readInt(val));
+		ASSERT_EQ((uint32_t)i, val);
+	}
+	uint8_t big[FileStream::BufferSize + 16];
+	ASSERT_EQ(0, stream.readBuf(big, sizeof(big)));
+	for (size_t i = 0; i < sizeof(big); ++i) {
+		ASSERT_EQ((uint8_t)i, big[i]);
+	}
+	char str[4];
+	ASSERT_TRUE(stream.readString(sizeof(str), str, true));
+	EXPECT_STREQ("end", str);
+	EXPECT_EQ(0, stream.remaining());
+	EXPECT_NE(0, stream.readByte(big[0]));
+	EXPECT_EQ(0, stream.seek(4));
+	ASSERT_EQ(0, stream.readInt(val));
+	EXPECT_EQ(0u, val);
+}
+
 }
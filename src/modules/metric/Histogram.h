@@ -0,0 +1,141 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <SDL_bits.h>
+
+namespace metric {
+
+/**
+ * @brief Fixed size log-linear histogram for timings
+ *
+ * Values below @c SubBuckets are recorded exactly, every power of two above is split into @c SubBuckets
+ * buckets. The relative error of the percentiles is below 1 / @c SubBuckets. Recording a value doesn't
+ * allocate memory.
+ */
+class Histogram {
+public:
+	static constexpr int SubBucketBits = 4;
+	static constexpr int SubBuckets = 1 << SubBucketBits;
+	static constexpr int Buckets = SubBuckets + (32 - SubBucketBits) * SubBuckets;
+private:
+	uint32_t _buckets[Buckets];
+	uint32_t _count = 0u;
+	uint32_t _min = UINT32_MAX;
+	uint32_t _max = 0u;
+	uint64_t _sum = 0u;
+
+	static inline int bucket(uint32_t value) {
+		if (value < (uint32_t)SubBuckets) {
+			return (int)value;
+		}
+		const int msb = SDL_MostSignificantBitIndex32(value);
+		const int shift = msb - SubBucketBits;
+		const int sub = (int)(value >> shift) & (SubBuckets - 1);
+		return SubBuckets + shift * SubBuckets + sub;
+	}
+
+	/**
+	 * @return The value in the middle of the given bucket
+	 */
+	static inline uint32_t value(int bucket) {
+		if (bucket < SubBuckets) {
+			return (uint32_t)bucket;
+		}
+		const int shift = (bucket - SubBuckets) / SubBuckets;
+		const uint64_t lower = (uint64_t)(SubBuckets + bucket % SubBuckets) << shift;
+		return (uint32_t)(lower + ((1ull << shift) - 1u) / 2u);
+	}
+public:
+	Histogram() {
+		reset();
+	}
+
+	inline void add(uint32_t value) {
+		++_buckets[bucket(value)];
+		++_count;
+		_sum += value;
+		if (value < _min) {
+			_min = value;
+		}
+		if (value > _max) {
+			_max = value;
+		}
+	}
+
+	/**
+	 * @param[in] p The percentile in the range [0, 100]
+	 * @return The value below which @c p percent of the recorded values are
+	 */
+	uint32_t percentile(float p) const {
+		if (_count == 0u) {
+			return 0u;
+		}
+		uint64_t rank = (uint64_t)((double)p / 100.0 * (double)_count + 0.5);
+		if (rank >= _count) {
+			return _max;
+		}
+		if (rank < 1u) {
+			rank = 1u;
+		}
+		uint64_t seen = 0u;
+		for (int i = 0; i < Buckets; ++i) {
+			seen += _buckets[i];
+			if (seen >= rank) {
+				const uint32_t v = value(i);
+				return v < _min ? _min : (v > _max ? _max : v);
+			}
+		}
+		return _max;
+	}
+
+	inline uint32_t count() const {
+		return _count;
+	}
+
+	inline uint32_t min() const {
+		return _count == 0u ? 0u : _min;
+	}
+
+	inline uint32_t max() const {
+		return _max;
+	}
+
+	inline uint32_t mean() const {
+		return _count == 0u ? 0u : (uint32_t)(_sum / _count);
+	}
+
+	/**
+	 * @brief Adds the recorded values of the given histogram to this one
+	 */
+	void merge(const Histogram& other) {
+		if (other._count == 0u) {
+			return;
+		}
+		for (int i = 0; i < Buckets; ++i) {
+			_buckets[i] += other._buckets[i];
+		}
+		_count += other._count;
+		_sum += other._sum;
+		if (other._min < _min) {
+			_min = other._min;
+		}
+		if (other._max > _max) {
+			_max = other._max;
+		}
+	}
+
+	inline void reset() {
+		memset(_buckets, 0, sizeof(_buckets));
+		_count = 0u;
+		_min = UINT32_MAX;
+		_max = 0u;
+		_sum = 0u;
+	}
+};
+
+}
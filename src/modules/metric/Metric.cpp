@@ -6,12 +6,24 @@
 #include "core/Log.h"
 #include "core/Var.h"
 #include "core/Assert.h"
+#include "core/TimeProvider.h"
 #include <stdio.h>
 #include <string.h>
 #include <SDL_stdinc.h>
 
 namespace metric {
 
+static std::atomic<uint32_t> _nextId { 1u };
+
+const TagMap& noTags() {
+	static const TagMap tags(2);
+	return tags;
+}
+
+Metric::Metric() :
+		_id(_nextId++) {
+}
+
 Metric::~Metric() {
 	shutdown();
 }
@@ -34,14 +46,233 @@ bool Metric::init(const char *prefix, const IMetricSenderPtr& messageSender) {
 	} else {
 		Log::warn("Invalid %s given - using telegraf", cfg::MetricFlavor);
 	}
+	const int flushInterval = core::Var::get(cfg::MetricFlushInterval, "0")->intVal();
+	_flushIntervalMillis = flushInterval > 0 ? (uint64_t)flushInterval : 0u;
+	_nextFlushMillis = core::TimeProvider::systemMillis() + _flushIntervalMillis;
 	_messageSender = messageSender;
 	return true;
 }
 
 void Metric::shutdown() {
+	flush();
 	_messageSender = IMetricSenderPtr();
 }
 
+Metric::ThreadBuffer* Metric::threadBuffer() const {
+	// the buffer of the last used instance is cached to not lock on every call
+	static thread_local uint32_t cachedId = 0u;
+	static thread_local ThreadBuffer* cachedBuffer = nullptr;
+	if (cachedId == _id) {
+		return cachedBuffer;
+	}
+	const std::thread::id threadId = std::this_thread::get_id();
+	core::ScopedLock lock(_buffersLock);
+	ThreadBuffer* buffer = nullptr;
+	for (const auto& e : _buffers) {
+		if (e.first == threadId) {
+			buffer = e.second.get();
+			break;
+		}
+	}
+	if (buffer == nullptr) {
+		_buffers.emplace_back(threadId, std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+		buffer = _buffers.back().second.get();
+	}
+	cachedId = _id;
+	cachedBuffer = buffer;
+	return buffer;
+}
+
+bool Metric::aggregate(const char* key, int value, const char* type, const TagMap& tags) const {
+	char id[512];
+	int idLen = SDL_snprintf(id, sizeof(id), "%s|%s", type, key);
+	for (const auto& e : tags) {
+		if (idLen >= (int)sizeof(id)) {
+			break;
+		}
+		idLen += SDL_snprintf(id + idLen, sizeof(id) - idLen, "|%s=%s", e->key.c_str(), e->value.c_str());
+	}
+	if (idLen >= (int)sizeof(id)) {
+		return false;
+	}
+
+	ThreadBuffer* buffer = threadBuffer();
+	{
+		core::ScopedLock lock(buffer->lock);
+		auto i = buffer->aggregates.find(id);
+		if (i == buffer->aggregates.end()) {
+			Aggregate aggregate;
+			aggregate.key = key;
+			aggregate.tags = tags;
+			aggregate.type = type;
+			if (type[0] == 'g') {
+				aggregate.aggregation = Aggregation::Last;
+			} else if (type[0] == 'c' || (type[0] == 'm' && type[1] == '\0')) {
+				aggregate.aggregation = Aggregation::Sum;
+			} else {
+				aggregate.aggregation = Aggregation::Distribution;
+				aggregate.histogram = std::unique_ptr<Histogram>(new Histogram());
+			}
+			i = buffer->aggregates.emplace(id, core::move(aggregate)).first;
+		}
+		Aggregate& aggregate = i->second;
+		switch (aggregate.aggregation) {
+		case Aggregation::Sum:
+			aggregate.value += value;
+			break;
+		case Aggregation::Last:
+			aggregate.value = value;
+			aggregate.sequence = ++_sequence;
+			break;
+		case Aggregation::Distribution:
+			aggregate.histogram->add((uint32_t)value);
+			break;
+		}
+		aggregate.dirty = true;
+	}
+	update();
+	return true;
+}
+
+void Metric::update() const {
+	if (_flushIntervalMillis == 0u) {
+		return;
+	}
+	const uint64_t now = core::TimeProvider::systemMillis();
+	uint64_t next = _nextFlushMillis;
+	if (now < next) {
+		return;
+	}
+	// only one of the threads that noticed the end of the interval flushes
+	if (!_nextFlushMillis.compare_exchange_strong(next, now + _flushIntervalMillis)) {
+		return;
+	}
+	flush();
+}
+
+bool Metric::pack(char* datagram, int& datagramLen, const char* key, int value, const char* type, const TagMap& tags) const {
+	char line[256];
+	const int lineLen = format(line, sizeof(line), key, value, type, tags);
+	if (lineLen < 0) {
+		return false;
+	}
+	bool sent = true;
+	if (datagramLen > 0 && datagramLen + 1 + lineLen >= MaxDatagramSize) {
+		sent = _messageSender->send(datagram);
+		datagramLen = 0;
+	}
+	if (datagramLen > 0) {
+		datagram[datagramLen++] = '\n';
+	}
+	SDL_memcpy(datagram + datagramLen, line, lineLen + 1);
+	datagramLen += lineLen;
+	return sent;
+}
+
+bool Metric::flushAggregate(char* datagram, int& datagramLen, const Aggregate& aggregate) const {
+	const char* key = aggregate.key.c_str();
+	if (aggregate.aggregation != Aggregation::Distribution) {
+		return pack(datagram, datagramLen, key, (int)aggregate.value, aggregate.type, aggregate.tags);
+	}
+	const Histogram& histogram = *aggregate.histogram;
+	const struct {
+		const char *suffix;
+		uint32_t value;
+	} stats[] = {
+		{"count", histogram.count()},
+		{"min", histogram.min()},
+		{"max", histogram.max()},
+		{"mean", histogram.mean()},
+		{"p50", histogram.percentile(50.0f)},
+		{"p90", histogram.percentile(90.0f)},
+		{"p99", histogram.percentile(99.0f)}
+	};
+	bool success = true;
+	for (const auto& stat : stats) {
+		char statKey[256];
+		if (SDL_snprintf(statKey, sizeof(statKey), "%s.%s", key, stat.suffix) >= (int)sizeof(statKey)) {
+			return false;
+		}
+		success &= pack(datagram, datagramLen, statKey, (int)stat.value, "g", aggregate.tags);
+	}
+	return success;
+}
+
+void Metric::merge(Aggregates& merged, const core::String& id, const Aggregate& aggregate) {
+	auto i = merged.find(id);
+	if (i == merged.end()) {
+		Aggregate copy;
+		copy.key = aggregate.key;
+		copy.tags = aggregate.tags;
+		copy.type = aggregate.type;
+		copy.aggregation = aggregate.aggregation;
+		copy.value = aggregate.value;
+		copy.sequence = aggregate.sequence;
+		if (aggregate.histogram) {
+			copy.histogram = std::unique_ptr<Histogram>(new Histogram(*aggregate.histogram));
+		}
+		merged.emplace(id, core::move(copy));
+		return;
+	}
+	Aggregate& target = i->second;
+	switch (target.aggregation) {
+	case Aggregation::Sum:
+		target.value += aggregate.value;
+		break;
+	case Aggregation::Last:
+		if (aggregate.sequence > target.sequence) {
+			target.value = aggregate.value;
+			target.sequence = aggregate.sequence;
+		}
+		break;
+	case Aggregation::Distribution:
+		target.histogram->merge(*aggregate.histogram);
+		break;
+	}
+}
+
+bool Metric::flush() const {
+	if (!_messageSender) {
+		return false;
+	}
+	core_trace_scoped(MetricFlush);
+	core::ScopedLock flushLock(_flushLock);
+	// the same metric can be recorded by several threads - they are sent as one line
+	Aggregates merged;
+	{
+		core::ScopedLock lock(_buffersLock);
+		for (const auto& e : _buffers) {
+			ThreadBuffer* buffer = e.second.get();
+			core::ScopedLock bufferLock(buffer->lock);
+			for (auto i = buffer->aggregates.begin(); i != buffer->aggregates.end();) {
+				Aggregate& aggregate = i->second;
+				if (!aggregate.dirty) {
+					// nothing was recorded for a whole interval - release the memory
+					i = buffer->aggregates.erase(i);
+					continue;
+				}
+				merge(merged, i->first, aggregate);
+				aggregate.dirty = false;
+				aggregate.value = aggregate.aggregation == Aggregation::Last ? aggregate.value : 0;
+				if (aggregate.histogram) {
+					aggregate.histogram->reset();
+				}
+				++i;
+			}
+		}
+	}
+	char datagram[MaxDatagramSize];
+	int datagramLen = 0;
+	bool success = true;
+	for (const auto& e : merged) {
+		success &= flushAggregate(datagram, datagramLen, e.second);
+	}
+	if (datagramLen > 0) {
+		success &= _messageSender->send(datagram);
+	}
+	return success;
+}
+
 bool Metric::createTags(char* buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split) {
 	if (tags.empty()) {
 		return true;
@@ -81,39 +312,48 @@ bool Metric::assemble(const char* key, int value, const char* type, const TagMap
 	if (!_messageSender) {
 		return false;
 	}
-	constexpr int metricSize = 256;
-	char buffer[metricSize];
+	if (_flushIntervalMillis > 0u) {
+		return aggregate(key, value, type, tags);
+	}
+	char buffer[256];
+	if (format(buffer, sizeof(buffer), key, value, type, tags) < 0) {
+		return false;
+	}
+	return _messageSender->send(buffer);
+}
+
+int Metric::format(char* buffer, size_t len, const char* key, int value, const char* type, const TagMap& tags) const {
 	constexpr int tagsSize = 256;
 	char tagsBuffer[tagsSize] = "";
 	int written;
 	switch (_flavor) {
 	case Flavor::Etsy:
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s", _prefix.c_str(), key, value, type);
+		written = SDL_snprintf(buffer, len, "%s.%s:%i|%s", _prefix.c_str(), key, value, type);
 		break;
 	case Flavor::Datadog:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, ":", "|#", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s:%i|%s%s", _prefix.c_str(), key, value, type, tagsBuffer);
+		written = SDL_snprintf(buffer, len, "%s.%s:%i|%s%s", _prefix.c_str(), key, value, type, tagsBuffer);
 		break;
 	case Flavor::Influx:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s_%s,type=%s%s value=%i", _prefix.c_str(), key, type, tagsBuffer, value);
+		written = SDL_snprintf(buffer, len, "%s_%s,type=%s%s value=%i", _prefix.c_str(), key, type, tagsBuffer, value);
 		break;
 	case Flavor::Telegraf:
 	default:
 		if (!createTags(tagsBuffer, sizeof(tagsBuffer), tags, "=", ",", ",")) {
-			return false;
+			return -1;
 		}
-		written = SDL_snprintf(buffer, sizeof(buffer), "%s.%s%s:%i|%s", _prefix.c_str(), key, tagsBuffer, value, type);
+		written = SDL_snprintf(buffer, len, "%s.%s%s:%i|%s", _prefix.c_str(), key, tagsBuffer, value, type);
 		break;
 	}
-	if (written >= metricSize) {
-		return false;
+	if (written < 0 || written >= (int)len) {
+		return -1;
 	}
-	return _messageSender->send(buffer);
+	return written;
 }
 
 }
@@ -11,9 +11,16 @@
 #pragma once
 
 #include "IMetricSender.h"
+#include "Histogram.h"
 #include "core/NonCopyable.h"
 #include "core/collection/StringMap.h"
+#include "core/concurrent/Lock.h"
+#include "core/Trace.h"
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <stdint.h>
 
 namespace metric {
@@ -33,14 +40,84 @@ enum class Flavor {
  */
 using TagMap = core::StringMap<core::String, 4>;
 
+/**
+ * @brief Shared empty tags - a default constructed @c TagMap initializes its whole allocation pool
+ */
+extern const TagMap& noTags();
+
 /**
  * @brief The Metric class generates and publishes metrics
+ *
+ * If the cvar @c metric_flushinterval is bigger than @c 0 the metrics are not sent for each call. They are
+ * aggregated per thread and flushed in packed datagrams (newline separated lines) once per interval. The
+ * aggregates of all threads are merged by key, type and tags before they are sent:
+ * @li counters and meters are summed up
+ * @li gauges keep the last value
+ * @li timings and histograms are sent as @c count, @c min, @c max, @c mean, @c p50, @c p90 and @c p99
+ * gauges with the suffix appended to the key
+ *
+ * @note The aggregation changes what is sent over the wire - the receiver doesn't get the single timing and
+ * histogram values anymore, but the gauges mentioned above. That's why it's disabled by default.
  */
 class Metric : public core::NonCopyable {
 private:
+	/**
+	 * @brief Max size of a datagram with multiple metric lines - fits into the ethernet mtu
+	 */
+	static constexpr int MaxDatagramSize = 1432;
+
+	enum class Aggregation {
+		Sum, Last, Distribution
+	};
+	struct Aggregate {
+		core::String key;
+		TagMap tags;
+		const char* type;
+		Aggregation aggregation;
+		int64_t value = 0;
+		std::unique_ptr<Histogram> histogram;
+		// the order of the gauge values of different threads - the highest one is the last value
+		uint64_t sequence = 0u;
+		// values were recorded since the last flush
+		bool dirty = false;
+	};
+	using Aggregates = std::unordered_map<core::String, Aggregate, core::StringHash>;
+	/**
+	 * @brief Every thread records into its own buffer - the lock is only contended while the buffer is flushed
+	 */
+	struct ThreadBuffer {
+		core_trace_mutex(core::Lock, lock, "MetricBuffer");
+		Aggregates aggregates;
+	};
+
 	core::String _prefix;
 	Flavor _flavor = Flavor::Telegraf;
 	IMetricSenderPtr _messageSender;
+	// unique id of the instance to find the buffer of the calling thread
+	const uint32_t _id;
+	uint64_t _flushIntervalMillis = 0u;
+	mutable std::atomic<uint64_t> _nextFlushMillis { 0u };
+	mutable std::atomic<uint64_t> _sequence { 0u };
+	mutable core_trace_mutex(core::Lock, _buffersLock, "MetricBuffers");
+	mutable std::vector<std::pair<std::thread::id, std::unique_ptr<ThreadBuffer>>> _buffers;
+	mutable core_trace_mutex(core::Lock, _flushLock, "MetricFlush");
+
+	ThreadBuffer* threadBuffer() const;
+	bool aggregate(const char* key, int value, const char* type, const TagMap& tags) const;
+	/**
+	 * @brief Writes the metric line for the configured flavor into the given buffer
+	 * @return The length of the line or @c -1 if it didn't fit
+	 */
+	int format(char* buffer, size_t len, const char* key, int value, const char* type, const TagMap& tags) const;
+	/**
+	 * @brief Appends the line to the datagram - the datagram is sent if the line doesn't fit anymore
+	 */
+	bool pack(char* datagram, int& datagramLen, const char* key, int value, const char* type, const TagMap& tags) const;
+	bool flushAggregate(char* datagram, int& datagramLen, const Aggregate& aggregate) const;
+	/**
+	 * @brief Adds the values of the given thread buffer aggregate to the merged aggregate of all threads
+	 */
+	static void merge(Aggregates& merged, const core::String& id, const Aggregate& aggregate);
 
 	/**
 	 * @brief Create the needed tag list if it is supported by the specified flavor
@@ -52,26 +129,42 @@ private:
 	 * @return @c false if not all tags could get written into the specified target buffer, @c true otherwise
 	 */
 	static bool createTags(char *buffer, size_t len, const TagMap& tags, const char* sep, const char* preamble, const char *split = ",");
-	bool assemble(const char* key, int value, const char* type, const TagMap& tags = {}) const;
+	bool assemble(const char* key, int value, const char* type, const TagMap& tags = noTags()) const;
 public:
+	Metric();
 	~Metric();
 
 	/**
 	 * @param[in] messageSender @c IMessageSender - must already be initialized
-	 * @note Reads the @c metric_flavor cvar to configure the flavor.
+	 * @note Reads the @c metric_flavor and @c metric_flushinterval cvars to configure the flavor and the aggregation.
 	 */
 	bool init(const char *prefix, const IMetricSenderPtr& messageSender);
+	/**
+	 * @note Sends the aggregated metrics
+	 */
 	void shutdown();
 
+	/**
+	 * @brief Sends the aggregated metrics of all threads
+	 * @return @c false if not all metrics could get sent
+	 */
+	bool flush() const;
+
+	/**
+	 * @brief Flushes the aggregated metrics if the flush interval is over. This is also done on recording
+	 * a metric - but metrics that are not recorded frequently would otherwise stay in the buffers.
+	 */
+	void update() const;
+
 	/**
 	 * @brief Increments the key
 	 */
-	bool increment(const char* key, const TagMap& tags = {}) const;
+	bool increment(const char* key, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Decrements the key
 	 */
-	bool decrement(const char* key, const TagMap& tags = {}) const;
+	bool decrement(const char* key, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Add the specified delta to the given key
@@ -83,7 +176,7 @@ public:
 	 * @code <metric name>:<value>|c[|@<sample rate>] @endcode
 	 * @note Record event counts
 	 */
-	bool count(const char* key, int delta, const TagMap& tags = {}, float sampleRate = 1.0f) const;
+	bool count(const char* key, int delta, const TagMap& tags = noTags(), float sampleRate = 1.0f) const;
 
 	/**
 	 * @brief Records a gauge with the give value for the key
@@ -94,7 +187,7 @@ public:
 	 * @code <metric name>:<value>|g @endcode
 	 * @note Record raw values
 	 */
-	bool gauge(const char* key, uint32_t value, const TagMap& tags = {}) const;
+	bool gauge(const char* key, uint32_t value, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a timing in millis for a key
@@ -104,7 +197,7 @@ public:
 	 * @code <metric name>:<value>|ms @endcode
 	 * @note Record execution times
 	 */
-	bool timing(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool timing(const char* key, uint32_t millis, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a histogram
@@ -115,7 +208,7 @@ public:
 	 * @code <metric name>:<value>|h @endcode
 	 * @note Record value distributions
 	 */
-	bool histogram(const char* key, uint32_t millis, const TagMap& tags = {}) const;
+	bool histogram(const char* key, uint32_t millis, const TagMap& tags = noTags()) const;
 
 	/**
 	 * @brief Records a meter
@@ -130,7 +223,7 @@ public:
 	 * The shortened form is documented here for completeness.
 	 * @note Record execution rates
 	 */
-	bool meter(const char* key, int value, const TagMap& tags = {}) const;
+	bool meter(const char* key, int value, const TagMap& tags = noTags()) const;
 };
 
 inline bool Metric::increment(const char* key, const TagMap& tags) const {
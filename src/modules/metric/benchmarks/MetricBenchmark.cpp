@@ -0,0 +1,87 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "metric/Metric.h"
+#include "metric/UDPMetricSender.h"
+#include "core/StringUtil.h"
+#include "core/Var.h"
+
+class MetricBenchmark: public app::AbstractBenchmark {
+protected:
+	std::shared_ptr<metric::UDPMetricSender> _sender;
+	metric::Metric _metric;
+
+	void init(int flushIntervalMillis) {
+		core::Var::get(cfg::MetricFlushInterval, "")->setVal(core::string::toString(flushIntervalMillis));
+		// nobody is listening - but every metric is still a sendto() call
+		_sender = std::make_shared<metric::UDPMetricSender>("127.0.0.1", 8125);
+		_sender->init();
+		_metric.init("bench", _sender);
+	}
+
+public:
+	void TearDown(benchmark::State& st) override {
+		_metric.shutdown();
+		if (_sender) {
+			_sender->shutdown();
+		}
+		app::AbstractBenchmark::TearDown(st);
+	}
+};
+
+BENCHMARK_DEFINE_F(MetricBenchmark, countImmediate) (benchmark::State& state) {
+	init(0);
+	for (auto _ : state) {
+		_metric.increment("count.packet");
+	}
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, countAggregated) (benchmark::State& state) {
+	init(1000);
+	for (auto _ : state) {
+		_metric.increment("count.packet");
+	}
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, countTagsImmediate) (benchmark::State& state) {
+	init(0);
+	const metric::TagMap tags {{"type", "move"}, {"map", "1"}};
+	for (auto _ : state) {
+		_metric.increment("count.packet", tags);
+	}
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, countTagsAggregated) (benchmark::State& state) {
+	init(1000);
+	const metric::TagMap tags {{"type", "move"}, {"map", "1"}};
+	for (auto _ : state) {
+		_metric.increment("count.packet", tags);
+	}
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, timingImmediate) (benchmark::State& state) {
+	init(0);
+	uint32_t millis = 0u;
+	for (auto _ : state) {
+		_metric.timing("time.tick", ++millis & 63u);
+	}
+}
+
+BENCHMARK_DEFINE_F(MetricBenchmark, timingAggregated) (benchmark::State& state) {
+	init(1000);
+	uint32_t millis = 0u;
+	for (auto _ : state) {
+		_metric.timing("time.tick", ++millis & 63u);
+	}
+}
+
+BENCHMARK_REGISTER_F(MetricBenchmark, countImmediate);
+BENCHMARK_REGISTER_F(MetricBenchmark, countAggregated);
+BENCHMARK_REGISTER_F(MetricBenchmark, countTagsImmediate);
+BENCHMARK_REGISTER_F(MetricBenchmark, countTagsAggregated);
+BENCHMARK_REGISTER_F(MetricBenchmark, timingImmediate);
+BENCHMARK_REGISTER_F(MetricBenchmark, timingAggregated);
+
+BENCHMARK_MAIN();
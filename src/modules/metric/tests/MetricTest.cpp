@@ -6,22 +6,39 @@
 #include "metric/Metric.h"
 #include "metric/IMetricSender.h"
 #include "core/Var.h"
+#include "core/StringUtil.h"
+#include <thread>
+#include <vector>
 
 namespace metric {
 
 class BufferSender : public IMetricSender {
 private:
 	mutable core::String _lastBuffer;
+	mutable core::DynamicArray<core::String> _datagrams;
 public:
 
 	bool send(const char* buffer) const override {
 		_lastBuffer = buffer;
+		_datagrams.push_back(buffer);
 		return true;
 	}
 
 	inline const core::String& metricLine() const {
 		return _lastBuffer;
 	}
+
+	inline const core::DynamicArray<core::String>& datagrams() const {
+		return _datagrams;
+	}
+
+	core::DynamicArray<core::String> lines() const {
+		core::DynamicArray<core::String> lines;
+		for (const core::String& datagram : _datagrams) {
+			core::string::splitString(datagram, lines, "\n");
+		}
+		return lines;
+	}
 };
 
 #define PREFIX "test"
@@ -32,6 +49,20 @@ protected:
 	void SetUp() override {
 		sender = std::make_shared<BufferSender>();
 		ASSERT_TRUE(sender->init());
+		setFlushInterval(0);
+	}
+
+	inline void setFlushInterval(int millis) const {
+		core::Var::get("metric_flushinterval", "")->setVal(core::string::toString(millis));
+	}
+
+	bool contains(const core::DynamicArray<core::String>& lines, const char *line) const {
+		for (const core::String& l : lines) {
+			if (l == line) {
+				return true;
+			}
+		}
+		return false;
 	}
 
 	void TearDown() override {
@@ -122,4 +153,148 @@ TEST_F(MetricTest, DISABLED_testTimingMultipleTags) {
 		<< "Expected to get tags after type in datadog flavor";
 }
 
+TEST_F(MetricTest, testAggregateCounter) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	EXPECT_TRUE(m.count("test", 2));
+	EXPECT_TRUE(m.increment("test"));
+	EXPECT_TRUE(m.count("test", 3));
+	EXPECT_TRUE(m.gauge("gauge", 2));
+	EXPECT_TRUE(m.gauge("gauge", 5));
+	EXPECT_TRUE(sender->datagrams().empty()) << "Nothing should be sent before the interval is over";
+	EXPECT_TRUE(m.flush());
+	ASSERT_EQ(1u, sender->datagrams().size()) << "All metrics should be packed into one datagram";
+	const core::DynamicArray<core::String>& lines = sender->lines();
+	ASSERT_EQ(2u, lines.size());
+	EXPECT_TRUE(contains(lines, PREFIX ".test:6|c"));
+	EXPECT_TRUE(contains(lines, PREFIX ".gauge:5|g"));
+
+	// the counter starts from zero after a flush
+	EXPECT_TRUE(m.increment("test"));
+	EXPECT_TRUE(m.flush());
+	EXPECT_EQ(PREFIX ".test:1|c", sender->metricLine());
+}
+
+TEST_F(MetricTest, testAggregateTags) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Telegraf);
+	Metric m;
+	m.init(PREFIX, sender);
+	EXPECT_TRUE(m.increment("test", {{"key1", "value1"}}));
+	EXPECT_TRUE(m.increment("test", {{"key1", "value2"}}));
+	EXPECT_TRUE(m.increment("test", {{"key1", "value1"}}));
+	EXPECT_TRUE(m.flush());
+	const core::DynamicArray<core::String>& lines = sender->lines();
+	ASSERT_EQ(2u, lines.size());
+	EXPECT_TRUE(contains(lines, PREFIX ".test,key1=value1:2|c"));
+	EXPECT_TRUE(contains(lines, PREFIX ".test,key1=value2:1|c"));
+}
+
+TEST_F(MetricTest, testAggregateTiming) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	for (int i = 1; i <= 10; ++i) {
+		EXPECT_TRUE(m.timing("time", i));
+	}
+	EXPECT_TRUE(m.flush());
+	const core::DynamicArray<core::String>& lines = sender->lines();
+	ASSERT_EQ(7u, lines.size());
+	EXPECT_TRUE(contains(lines, PREFIX ".time.count:10|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.min:1|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.max:10|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.mean:5|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.p50:5|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.p90:9|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.p99:10|g"));
+}
+
+TEST_F(MetricTest, testAggregateDatagramSize) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Influx);
+	Metric m;
+	m.init(PREFIX, sender);
+	const int n = 200;
+	for (int i = 0; i < n; ++i) {
+		EXPECT_TRUE(m.increment(core::string::format("key%i", i).c_str()));
+	}
+	EXPECT_TRUE(m.flush());
+	EXPECT_GT(sender->datagrams().size(), 1u);
+	for (const core::String& datagram : sender->datagrams()) {
+		EXPECT_LT((int)datagram.size(), 1432);
+	}
+	EXPECT_EQ((size_t)n, sender->lines().size());
+}
+
+TEST_F(MetricTest, testAggregateThreads) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&m] () {
+			for (int i = 0; i < 1000; ++i) {
+				m.increment("test");
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	EXPECT_TRUE(m.flush());
+	// every thread has its own buffer - they are merged on flushing
+	const core::DynamicArray<core::String>& lines = sender->lines();
+	ASSERT_EQ(1u, lines.size());
+	EXPECT_EQ(PREFIX ".test:4000|c", lines[0]);
+}
+
+TEST_F(MetricTest, testAggregateThreadsHistogram) {
+	setFlushInterval(100000);
+	setFlavor(Flavor::Etsy);
+	Metric m;
+	m.init(PREFIX, sender);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&m, t] () {
+			m.timing("time", (uint32_t)(t + 1) * 10u);
+			m.gauge("gauge", (uint32_t)t);
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	m.gauge("gauge", 42u);
+	EXPECT_TRUE(m.flush());
+	const core::DynamicArray<core::String>& lines = sender->lines();
+	EXPECT_EQ(8u, lines.size());
+	EXPECT_TRUE(contains(lines, PREFIX ".time.count:4|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.min:10|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.max:40|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".time.mean:25|g"));
+	EXPECT_TRUE(contains(lines, PREFIX ".gauge:42|g")) << "The last recorded gauge value of all threads should win";
+}
+
+TEST_F(MetricTest, testHistogram) {
+	Histogram histogram;
+	EXPECT_EQ(0u, histogram.percentile(50.0f));
+	for (uint32_t i = 1u; i <= 1000u; ++i) {
+		histogram.add(i * 1000u);
+	}
+	EXPECT_EQ(1000u, histogram.count());
+	EXPECT_EQ(1000u, histogram.min());
+	EXPECT_EQ(1000000u, histogram.max());
+	EXPECT_EQ(500500u, histogram.mean());
+	EXPECT_NEAR(500000.0, (double)histogram.percentile(50.0f), 500000.0 / Histogram::SubBuckets);
+	EXPECT_NEAR(990000.0, (double)histogram.percentile(99.0f), 990000.0 / Histogram::SubBuckets);
+	EXPECT_EQ(1000000u, histogram.percentile(100.0f));
+	histogram.add(UINT32_MAX);
+	EXPECT_GE(histogram.percentile(100.0f), UINT32_MAX - UINT32_MAX / Histogram::SubBuckets);
+	histogram.reset();
+	EXPECT_EQ(0u, histogram.count());
+}
+
 }
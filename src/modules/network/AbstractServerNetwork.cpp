@@ -58,16 +58,20 @@ bool AbstractServerNetwork::broadcast(ENetPacket* packet, int channel) {
 		return false;
 	}
 	Log::debug("Broadcasting a message on channel %i", channel);
+	core::ScopedLock lock(_hostLock);
 	enet_host_broadcast(_server, channel, packet);
 	return true;
 }
 
 void AbstractServerNetwork::shutdown() {
-	if (_server != nullptr) {
-		enet_host_flush(_server);
-		enet_host_destroy(_server);
+	{
+		core::ScopedLock lock(_hostLock);
+		if (_server != nullptr) {
+			enet_host_flush(_server);
+			enet_host_destroy(_server);
+		}
+		_server = nullptr;
 	}
-	_server = nullptr;
 	Super::shutdown();
 }
 
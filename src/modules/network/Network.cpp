@@ -42,25 +42,50 @@ bool Network::disconnectPeer(ENetPeer *peer, DisconnectReason reason) {
 		return false;
 	}
 	Log::info("trying to disconnect peer: %u", peer->connectID);
-	enet_peer_disconnect(peer, core::enumVal(reason));
-	if (peer->state == ENET_PEER_STATE_DISCONNECTED) {
+	bool disconnected;
+	{
+		core::ScopedLock lock(_hostLock);
+		enet_peer_disconnect(peer, core::enumVal(reason));
+		disconnected = peer->state == ENET_PEER_STATE_DISCONNECTED;
+	}
+	if (disconnected) {
+		peerDisconnected(peer);
 		_eventBus->publish(DisconnectEvent(peer, reason));
 	}
 	return true;
 }
 
+bool Network::queuePacket(ENetPeer* peer, ENetPacket* packet, int channel) {
+	core::ScopedLock lock(_hostLock);
+	if (packet->dataLength >= peer->host->maximumPacketSize) {
+		return false;
+	}
+	return enet_peer_send(peer, (enet_uint8)channel, packet) == 0;
+}
+
 void Network::updateHost(ENetHost* host) {
 	if (host == nullptr) {
 		return;
 	}
-	enet_host_flush(host);
-	ENetEvent event;
-	while (enet_host_service(host, &event, 0) > 0) {
+	{
+		core::ScopedLock lock(_hostLock);
+		enet_host_flush(host);
+	}
+	for (;;) {
+		ENetEvent event;
+		{
+			// the handlers might send messages - they lock on their own
+			core::ScopedLock lock(_hostLock);
+			if (enet_host_service(host, &event, 0) <= 0) {
+				break;
+			}
+		}
 		core_trace_scoped(NetworkEventHandling);
 		switch (event.type) {
 		case ENET_EVENT_TYPE_CONNECT: {
 			core_trace_scoped(NetworkConnect);
 			Log::info("New connection event received");
+			peerConnected(event.peer);
 			_eventBus->publish(NewConnectionEvent(event.peer));
 			break;
 		}
@@ -78,6 +103,7 @@ void Network::updateHost(ENetHost* host) {
 			core_trace_scoped(NetworkDisconnect);
 			const DisconnectReason reason = (DisconnectReason)event.data;
 			Log::info("New disconnect event received with reason: %i", (int)reason);
+			peerDisconnected(event.peer);
 			_eventBus->publish(DisconnectEvent(event.peer, reason));
 			break;
 		}
@@ -13,6 +13,8 @@
 #include "core/EventBus.h"
 #include "core/IComponent.h"
 #include "core/String.h"
+#include "core/Trace.h"
+#include "core/concurrent/Lock.h"
 #include <stdint.h>
 #include <memory>
 
@@ -33,6 +35,11 @@ private:
 protected:
 	ProtocolHandlerRegistryPtr _protocolHandlerRegistry;
 	core::EventBusPtr _eventBus;
+	/**
+	 * enet is not thread safe - all calls that touch the host or its peers are done with this lock held
+	 * @note The events of the host are dispatched without the lock
+	 */
+	core_trace_mutex(core::Lock, _hostLock, "NetworkHost");
 
 	/**
 	 * @brief Package deserialization
@@ -40,6 +47,14 @@ protected:
 	 * @c true if everything went smooth.
 	 */
 	virtual bool packetReceived(ENetEvent& event) = 0;
+	/**
+	 * @brief Called for a new peer before the @c NewConnectionEvent is published
+	 */
+	virtual void peerConnected(ENetPeer* peer) {}
+	/**
+	 * @brief Called before the @c DisconnectEvent of the peer is published
+	 */
+	virtual void peerDisconnected(ENetPeer* peer) {}
 	bool disconnectPeer(ENetPeer *peer, DisconnectReason reason);
 	void updateHost(ENetHost* host);
 public:
@@ -51,7 +66,16 @@ public:
 
 	const ProtocolHandlerRegistryPtr& registry();
 
+	/**
+	 * @brief Sends the packet to the peer - the packet is destroyed if this fails
+	 */
 	bool sendMessage(ENetPeer* peer, ENetPacket* packet, int channel = 0);
+	/**
+	 * @brief Queues the packet for the peer
+	 * @note Can be called from any thread
+	 * @return @c false if the packet is too big or enet refused it. The caller keeps the ownership in this case.
+	 */
+	bool queuePacket(ENetPeer* peer, ENetPacket* packet, int channel = 0);
 };
 
 inline bool Network::sendMessage(ENetPeer* peer, ENetPacket* packet, int channel) {
@@ -60,7 +84,7 @@ inline bool Network::sendMessage(ENetPeer* peer, ENetPacket* packet, int channel
 		enet_packet_destroy(packet);
 		return false;
 	}
-	if (enet_peer_send(peer, channel, packet) == 0) {
+	if (queuePacket(peer, packet, channel)) {
 		return true;
 	}
 	enet_packet_destroy(packet);
@@ -0,0 +1,71 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include <SDL_endian.h>
+#include <SDL_stdinc.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace network {
+
+/**
+ * @brief Several messages can get coalesced into one packet. Each message is stored in a frame.
+ *
+ * A frame starts with the message size as little endian uint32 followed by four bytes of padding.
+ * The message itself is padded to a multiple of @c FrameAlignment - this keeps every flatbuffer
+ * at the same alignment that it had in the builder.
+ */
+static constexpr size_t FrameAlignment = 8u;
+static constexpr size_t FrameHeaderSize = 8u;
+
+inline size_t frameSize(size_t messageSize) {
+	return FrameHeaderSize + ((messageSize + FrameAlignment - 1u) & ~(FrameAlignment - 1u));
+}
+
+/**
+ * @param[out] out The buffer must be able to hold @c frameSize(messageSize) bytes
+ * @return The position right after the written frame
+ */
+inline uint8_t* writeFrame(uint8_t* out, const void* message, size_t messageSize) {
+	const uint32_t size = SDL_SwapLE32((uint32_t)messageSize);
+	const size_t total = frameSize(messageSize);
+	SDL_memcpy(out, &size, sizeof(size));
+	SDL_memset(out + sizeof(size), 0, FrameHeaderSize - sizeof(size));
+	SDL_memcpy(out + FrameHeaderSize, message, messageSize);
+	SDL_memset(out + FrameHeaderSize + messageSize, 0, total - FrameHeaderSize - messageSize);
+	return out + total;
+}
+
+/**
+ * @brief Calls the given functor for every message of the packet
+ * @param func @c bool(const uint8_t* message, size_t messageSize) - return @c false to stop
+ * @return @c false if the packet is malformed or the functor returned @c false
+ */
+template<class FUNC>
+bool visitFrames(const uint8_t* data, size_t dataLength, FUNC&& func) {
+	size_t offset = 0u;
+	if (dataLength == 0u) {
+		return false;
+	}
+	while (offset < dataLength) {
+		if (dataLength - offset < FrameHeaderSize) {
+			return false;
+		}
+		uint32_t size;
+		SDL_memcpy(&size, data + offset, sizeof(size));
+		size = SDL_SwapLE32(size);
+		if (size == 0u || frameSize(size) > dataLength - offset) {
+			return false;
+		}
+		if (!func(data + offset + FrameHeaderSize, (size_t)size)) {
+			return false;
+		}
+		offset += frameSize(size);
+	}
+	return true;
+}
+
+}
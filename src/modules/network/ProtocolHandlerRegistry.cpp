@@ -15,6 +15,7 @@ ProtocolHandlerRegistry::~ProtocolHandlerRegistry() {
 
 void ProtocolHandlerRegistry::shutdown() {
 	_registry.clear();
+	_table.clear();
 }
 
 }
@@ -9,6 +9,7 @@
 #include "core/Enum.h"
 #include "core/SharedPtr.h"
 #include "core/collection/Map.h"
+#include <vector>
 
 namespace network {
 
@@ -16,6 +17,8 @@ class ProtocolHandlerRegistry {
 private:
 	typedef core::Map<uint32_t, ProtocolHandlerPtr> ProtocolHandlers;
 	ProtocolHandlers _registry;
+	// dense lookup table that is indexed by the message type - the handlers are owned by the map
+	std::vector<IProtocolHandler*> _table;
 
 public:
 	ProtocolHandlerRegistry();
@@ -34,9 +37,27 @@ public:
 		return ProtocolHandlerPtr();
 	}
 
+	/**
+	 * @brief Lookup for the per packet dispatching - doesn't touch the map or the reference count of the handler
+	 * @return @c nullptr if no handler is registered for the given type
+	 */
+	template <typename ENUM>
+	inline IProtocolHandler* handler(ENUM type) const {
+		const uint32_t index = core::enumVal(type);
+		if (index >= _table.size()) {
+			return nullptr;
+		}
+		return _table[index];
+	}
+
 	template <typename ENUM>
 	inline void registerHandler(const ENUM type, const ProtocolHandlerPtr &handler) {
-		_registry.put(core::enumVal(type), handler);
+		const uint32_t index = core::enumVal(type);
+		_registry.put(index, handler);
+		if (index >= _table.size()) {
+			_table.resize(index + 1, nullptr);
+		}
+		_table[index] = handler.get();
 	}
 };
 
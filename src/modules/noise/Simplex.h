@@ -36,6 +36,14 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat2x2.hpp>
+#include <float.h>
+
+// The batched fBm() is using sse2 if the scalar code is evaluated in single precision sse registers, too. With fma
+// the compiler might contract the scalar code differently - the results would no longer be bit-identical.
+#if (defined(__SSE2__) || defined(_M_X64)) && FLT_EVAL_METHOD == 0 && !defined(__FMA__)
+#define SIMPLEX_SSE2
+#include <emmintrin.h>
+#endif
 
 // This brings back the returned noise of the dnoise functions into -1,1 range. For some reason this is not the case in Stefan Gustavson implementation
 //#define SIMPLEX_DERIVATIVES_RESCALE
@@ -118,6 +126,12 @@ inline float fBm(const glm::vec2 &v, uint8_t octaves = 4, float lacunarity = 2.0
 inline float fBm(const glm::vec3 &v, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
 //! Returns a 4D simplex noise fractal brownian motion sum
 inline float fBm(const glm::vec4 &v, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
+/**
+ * @brief Computes the 3D simplex noise fractal brownian motion sum for @c amount positions at once
+ * @note The results are bit-identical to calling fBm(const glm::vec3&) for each position. Four positions
+ * are evaluated in parallel if sse2 is available.
+ */
+inline void fBm(const float *x, const float *y, const float *z, float *out, int amount, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
 
 //! Returns a 2D simplex cellular/worley noise fractal brownian motion sum
 inline float worleyfBm(const glm::vec2 &v, uint8_t octaves = 4, float lacunarity = 2.0f, float gain = 0.5f);
@@ -2037,6 +2051,148 @@ float fBm(const glm::vec4 &v, uint8_t octaves, float lacunarity, float gain) {
 	return details::fBm_t(v, octaves, lacunarity, gain);
 }
 
+#ifdef SIMPLEX_SSE2
+namespace details {
+// (float)((double)v * f) - the skew factors are double constants in the scalar code
+inline __m128 mulDouble(__m128 v, double f) {
+	const __m128d factor = _mm_set1_pd(f);
+	const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(v), factor));
+	const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), factor));
+	return _mm_movelh_ps(lo, hi);
+}
+
+// (float)((double)v + f)
+inline __m128 addDouble(__m128 v, double f) {
+	const __m128d summand = _mm_set1_pd(f);
+	const __m128 lo = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(v), summand));
+	const __m128 hi = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), summand));
+	return _mm_movelh_ps(lo, hi);
+}
+
+// FASTFLOOR - which also subtracts one for values that are exactly zero or a negative integer
+inline __m128i fastFloor4(__m128 v) {
+	const __m128i truncated = _mm_cvttps_epi32(v);
+	const __m128i positive = _mm_castps_si128(_mm_cmpgt_ps(v, _mm_setzero_ps()));
+	return _mm_add_epi32(truncated, _mm_andnot_si128(positive, _mm_set1_epi32(-1)));
+}
+
+inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// grad(int hash, float x, float y, float z) for four hashes
+inline __m128 grad4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+	const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+	const __m128 lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+	const __m128 lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+	const __m128 is12or14 = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+	const __m128 u = select4(lt8, x, y);
+	const __m128 v = select4(lt4, y, select4(is12or14, x, z));
+	const __m128i signBit = _mm_set1_epi32((int)0x80000000);
+	const __m128i negU = _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), _mm_set1_epi32(1));
+	const __m128i negV = _mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), _mm_set1_epi32(2));
+	const __m128 su = _mm_xor_ps(u, _mm_castsi128_ps(_mm_and_si128(negU, signBit)));
+	const __m128 sv = _mm_xor_ps(v, _mm_castsi128_ps(_mm_and_si128(negV, signBit)));
+	return _mm_add_ps(su, sv);
+}
+
+inline __m128 contribution4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+	__m128 t = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.6f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	const __m128 inside = _mm_cmpnlt_ps(t, _mm_setzero_ps());
+	t = _mm_mul_ps(t, t);
+	return _mm_and_ps(inside, _mm_mul_ps(_mm_mul_ps(t, t), grad4(hash, x, y, z)));
+}
+
+// noise(const glm::vec3&) for four positions - every operation mirrors the scalar version
+inline __m128 noise4(__m128 x, __m128 y, __m128 z) {
+	const __m128 s = mulDouble(_mm_add_ps(_mm_add_ps(x, y), z), F3);
+	const __m128i i = fastFloor4(_mm_add_ps(x, s));
+	const __m128i j = fastFloor4(_mm_add_ps(y, s));
+	const __m128i k = fastFloor4(_mm_add_ps(z, s));
+	const __m128 t = mulDouble(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(i, j), k)), G3);
+	const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+	const __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+	const __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(_mm_cvtepi32_ps(k), t));
+
+	// the branches of the scalar version to find the simplex expressed as masks
+	const __m128 xy = _mm_cmpge_ps(x0, y0);
+	const __m128 yz = _mm_cmpge_ps(y0, z0);
+	const __m128 xz = _mm_cmpge_ps(x0, z0);
+	const __m128 allBits = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	const __m128 i1 = _mm_and_ps(xy, _mm_or_ps(yz, xz));
+	const __m128 j1 = _mm_andnot_ps(xy, yz);
+	const __m128 k1 = _mm_andnot_ps(_mm_or_ps(i1, j1), allBits);
+	const __m128 i2 = _mm_or_ps(xy, xz);
+	const __m128 j2 = _mm_or_ps(_mm_andnot_ps(xy, allBits), yz);
+	const __m128 k2 = _mm_andnot_ps(_mm_and_ps(i2, j2), allBits);
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 x1 = addDouble(_mm_sub_ps(x0, _mm_and_ps(i1, one)), G3);
+	const __m128 y1 = addDouble(_mm_sub_ps(y0, _mm_and_ps(j1, one)), G3);
+	const __m128 z1 = addDouble(_mm_sub_ps(z0, _mm_and_ps(k1, one)), G3);
+	const __m128 x2 = addDouble(_mm_sub_ps(x0, _mm_and_ps(i2, one)), 2.0f * G3);
+	const __m128 y2 = addDouble(_mm_sub_ps(y0, _mm_and_ps(j2, one)), 2.0f * G3);
+	const __m128 z2 = addDouble(_mm_sub_ps(z0, _mm_and_ps(k2, one)), 2.0f * G3);
+	const __m128 x3 = addDouble(_mm_sub_ps(x0, one), 3.0f * G3);
+	const __m128 y3 = addDouble(_mm_sub_ps(y0, one), 3.0f * G3);
+	const __m128 z3 = addDouble(_mm_sub_ps(z0, one), 3.0f * G3);
+
+	// the permutation table lookups are done per lane
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i oneMask = _mm_set1_epi32(1);
+	alignas(16) int32_t ii[4], jj[4], kk[4];
+	alignas(16) int32_t oi1[4], oj1[4], ok1[4], oi2[4], oj2[4], ok2[4];
+	_mm_store_si128((__m128i*)ii, _mm_and_si128(i, mask));
+	_mm_store_si128((__m128i*)jj, _mm_and_si128(j, mask));
+	_mm_store_si128((__m128i*)kk, _mm_and_si128(k, mask));
+	_mm_store_si128((__m128i*)oi1, _mm_and_si128(_mm_castps_si128(i1), oneMask));
+	_mm_store_si128((__m128i*)oj1, _mm_and_si128(_mm_castps_si128(j1), oneMask));
+	_mm_store_si128((__m128i*)ok1, _mm_and_si128(_mm_castps_si128(k1), oneMask));
+	_mm_store_si128((__m128i*)oi2, _mm_and_si128(_mm_castps_si128(i2), oneMask));
+	_mm_store_si128((__m128i*)oj2, _mm_and_si128(_mm_castps_si128(j2), oneMask));
+	_mm_store_si128((__m128i*)ok2, _mm_and_si128(_mm_castps_si128(k2), oneMask));
+	alignas(16) int32_t h0[4], h1[4], h2[4], h3[4];
+	for (int l = 0; l < 4; ++l) {
+		h0[l] = perm[ii[l] + perm[jj[l] + perm[kk[l]]]];
+		h1[l] = perm[ii[l] + oi1[l] + perm[jj[l] + oj1[l] + perm[kk[l] + ok1[l]]]];
+		h2[l] = perm[ii[l] + oi2[l] + perm[jj[l] + oj2[l] + perm[kk[l] + ok2[l]]]];
+		h3[l] = perm[ii[l] + 1 + perm[jj[l] + 1 + perm[kk[l] + 1]]];
+	}
+
+	const __m128 n0 = contribution4(_mm_load_si128((const __m128i*)h0), x0, y0, z0);
+	const __m128 n1 = contribution4(_mm_load_si128((const __m128i*)h1), x1, y1, z1);
+	const __m128 n2 = contribution4(_mm_load_si128((const __m128i*)h2), x2, y2, z2);
+	const __m128 n3 = contribution4(_mm_load_si128((const __m128i*)h3), x3, y3, z3);
+	return _mm_mul_ps(_mm_set1_ps(32.0f), _mm_add_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), n3));
+}
+}
+#endif
+
+void fBm(const float *x, const float *y, const float *z, float *out, int amount, uint8_t octaves, float lacunarity, float gain) {
+	int i = 0;
+#ifdef SIMPLEX_SSE2
+	for (; i + 4 <= amount; i += 4) {
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		__m128 sum = _mm_setzero_ps();
+		float freq = 1.0f;
+		float amp = 0.5f;
+		for (uint8_t o = 0; o < octaves; ++o) {
+			const __m128 f = _mm_set1_ps(freq);
+			const __m128 n = details::noise4(_mm_mul_ps(vx, f), _mm_mul_ps(vy, f), _mm_mul_ps(vz, f));
+			sum = _mm_add_ps(sum, _mm_mul_ps(n, _mm_set1_ps(amp)));
+			freq *= lacunarity;
+			amp *= gain;
+		}
+		_mm_storeu_ps(out + i, sum);
+	}
+#endif
+	for (; i < amount; ++i) {
+		out[i] = fBm(glm::vec3(x[i], y[i], z[i]), octaves, lacunarity, gain);
+	}
+}
+
 namespace details {
 template<typename T>
 float worleyfBm_t(const T &input, uint8_t octaves, float lacunarity, float gain) {
@@ -2271,5 +2427,6 @@ void seed(uint32_t s) {
 #undef G3
 #undef F4
 #undef G4
+#undef SIMPLEX_SSE2
 
 }
@@ -5,6 +5,8 @@
 #include "app/tests/AbstractTest.h"
 #include "compute/Compute.h"
 #include "noise/Noise.h"
+#include "noise/Simplex.h"
+#include "math/Random.h"
 #include "image/Image.h"
 #include "core/GLM.h"
 #include "core/StringUtil.h"
@@ -52,4 +54,31 @@ TEST_F(NoiseTest, testSeamlessNoiseCPU) {
 	seamlessNoise(false);
 }
 
+TEST_F(NoiseTest, testfBmBatch) {
+	constexpr int amount = 4099;
+	float x[amount], y[amount], z[amount], out[amount];
+	math::Random random(42);
+	for (int i = 0; i < amount; ++i) {
+		// integer coordinates (zero and negative ones included) are hitting the edge cases of the floor
+		if (i % 3 == 0) {
+			x[i] = (float)random.random(-100, 100);
+			y[i] = (float)random.random(-100, 100);
+			z[i] = (float)random.random(-100, 100);
+		} else {
+			x[i] = random.randomf(-100000.0f, 100000.0f);
+			y[i] = random.randomf(-255.0f, 255.0f);
+			z[i] = random.randomf(-100000.0f, 100000.0f);
+		}
+	}
+	const uint8_t octaves = 3;
+	const float lacunarity = 0.3f;
+	const float gain = 0.5f;
+	noise::fBm(x, y, z, out, amount, octaves, lacunarity, gain);
+	for (int i = 0; i < amount; ++i) {
+		const float expected = noise::fBm(glm::vec3(x[i], y[i], z[i]), octaves, lacunarity, gain);
+		ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float)))
+			<< "Batch result " << out[i] << " differs from " << expected << " at " << x[i] << ":" << y[i] << ":" << z[i];
+	}
+}
+
 }
@@ -31,7 +31,9 @@ public:
 	 * just return the pointers the these members. The data inside the models is not modified.
 	 * You won't get auto generated fields back into the @c Model instances. You should not
 	 * operate on the models outside of this method.
-	 * @note This is called in an own thread - make sure you synchronize this.
+	 * @note The @c PersistenceMgr copies the returned models right away and writes the copies in its own
+	 * thread. The models are only accessed in this call - but this might still be called from a different thread
+	 * than the one you are modifying your models in - make sure you synchronize this. @c Blob data is not copied.
 	 * @return A list of pointers to @c Model instances. The memory ownership stays at this
 	 * object. Might also return @c false if there is nothing to persist at the moment, @c true
 	 * if @c Model pointers were added to the list
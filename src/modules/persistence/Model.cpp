@@ -8,6 +8,7 @@
 #include "core/StringUtil.h"
 #include "core/Singleton.h"
 #include "core/Assert.h"
+#include "core/StandardLib.h"
 
 namespace persistence {
 
@@ -26,6 +27,42 @@ Model::Model(const Meta* s) :
 }
 
 Model::~Model() {
+	if (!_ownsBlobs) {
+		return;
+	}
+	for (const Field& f : _s->_fields) {
+		if (f.type != FieldType::BLOB) {
+			continue;
+		}
+		Blob* blob = (Blob*)(_membersPointer + f.offset);
+		core_free(blob->data);
+		blob->data = nullptr;
+	}
+}
+
+static uint8_t* copyBlobData(const Blob& blob) {
+	if (blob.data == nullptr || blob.length == 0u) {
+		return nullptr;
+	}
+	uint8_t* data = (uint8_t*)core_malloc(blob.length);
+	core_memcpy(data, blob.data, blob.length);
+	return data;
+}
+
+void Model::ownBlobs() {
+	core_assert(!_ownsBlobs);
+	for (const Field& f : _s->_fields) {
+		if (f.type != FieldType::BLOB) {
+			continue;
+		}
+		core_assert(f.offset >= 0);
+		Blob* blob = (Blob*)(_membersPointer + f.offset);
+		blob->data = copyBlobData(*blob);
+		if (blob->data == nullptr) {
+			blob->length = 0u;
+		}
+	}
+	_ownsBlobs = true;
 }
 
 const Field& Model::getField(const char* name) const {
@@ -107,6 +144,104 @@ bool Model::fillModelValues(State& state) {
 	return true;
 }
 
+template<class T>
+static inline void copyMemberValue(uint8_t* target, const uint8_t* source) {
+	*(T*)target = *(const T*)source;
+}
+
+template<class T>
+static inline void addMemberValue(uint8_t* target, const uint8_t* source) {
+	*(T*)target += *(const T*)source;
+}
+
+static void copyMember(FieldType type, uint8_t* target, const uint8_t* source) {
+	switch (type) {
+	case FieldType::PASSWORD:
+	case FieldType::STRING:
+	case FieldType::TEXT:
+		copyMemberValue<core::String>(target, source);
+		break;
+	case FieldType::TIMESTAMP:
+		copyMemberValue<Timestamp>(target, source);
+		break;
+	case FieldType::BLOB:
+		copyMemberValue<Blob>(target, source);
+		break;
+	case FieldType::BOOLEAN:
+		copyMemberValue<bool>(target, source);
+		break;
+	case FieldType::INT:
+		copyMemberValue<int32_t>(target, source);
+		break;
+	case FieldType::SHORT:
+		copyMemberValue<int16_t>(target, source);
+		break;
+	case FieldType::BYTE:
+		copyMemberValue<uint8_t>(target, source);
+		break;
+	case FieldType::LONG:
+		copyMemberValue<int64_t>(target, source);
+		break;
+	case FieldType::DOUBLE:
+		copyMemberValue<double>(target, source);
+		break;
+	case FieldType::MAX:
+		break;
+	}
+}
+
+static bool addMember(FieldType type, uint8_t* target, const uint8_t* source) {
+	switch (type) {
+	case FieldType::INT:
+		addMemberValue<int32_t>(target, source);
+		return true;
+	case FieldType::SHORT:
+		addMemberValue<int16_t>(target, source);
+		return true;
+	case FieldType::BYTE:
+		addMemberValue<uint8_t>(target, source);
+		return true;
+	case FieldType::LONG:
+		addMemberValue<int64_t>(target, source);
+		return true;
+	case FieldType::DOUBLE:
+		addMemberValue<double>(target, source);
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+void Model::merge(const Model& other) {
+	core_assert_msg(_s == other._s, "Can't merge models of different tables");
+	for (const Field& f : _s->_fields) {
+		if (!other.isValid(f)) {
+			continue;
+		}
+		core_assert(f.offset >= 0);
+		uint8_t* target = _membersPointer + f.offset;
+		const uint8_t* source = other._membersPointer + f.offset;
+		// both deltas are applied to the same row - so they are summed up for the subtract operator, too
+		const bool relative = f.updateOperator == Operator::ADD || f.updateOperator == Operator::SUBTRACT;
+		if (relative && isValid(f) && !isNull(f) && !other.isNull(f) && addMember(f.type, target, source)) {
+			continue;
+		}
+		if (_ownsBlobs && f.type == FieldType::BLOB) {
+			// don't share the blob data with the other model
+			Blob* blob = (Blob*)target;
+			core_free(blob->data);
+			const Blob* otherBlob = (const Blob*)source;
+			blob->data = copyBlobData(*otherBlob);
+			blob->length = blob->data == nullptr ? 0u : otherBlob->length;
+		} else {
+			copyMember(f.type, target, source);
+		}
+		setIsNull(f, other.isNull(f));
+		setValid(f, true);
+	}
+}
+
 void Model::setValue(const Field& f, const core::String& value) {
 	core_assert(f.offset >= 0);
 	uint8_t* target = (uint8_t*)(_membersPointer + f.offset);
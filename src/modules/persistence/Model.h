@@ -54,6 +54,8 @@ protected:
 	friend class DBHandler;
 	friend class MassQuery;
 	bool _flagToDelete = false;
+	// @c true if the @c Blob data was copied by @c ownBlobs() and must be freed by this instance
+	bool _ownsBlobs = false;
 	uint8_t* _membersPointer;
 	const Meta* _s;
 	/**
@@ -63,10 +65,31 @@ protected:
 	 */
 	bool fillModelValues(State& state);
 
+	/**
+	 * @brief Replaces the @c Blob data of this instance by copies that are freed with the model
+	 * @note Used by @c clone() - the copy must survive the release of the original blob data
+	 */
+	void ownBlobs();
+
 public:
 	Model(const Meta* s);
 	virtual ~Model();
 
+	/**
+	 * @brief Creates a copy of the model that also keeps the delete flag
+	 * @note The caller takes the ownership of the returned instance. The copy owns its own @c Blob data.
+	 */
+	virtual Model* clone() const = 0;
+
+	/**
+	 * @brief Applies the valid fields of a newer state of the same row to this model.
+	 *
+	 * Relative fields (@c Operator::ADD and @c Operator::SUBTRACT) are summed up if both models have
+	 * a value for them - all other fields are overwritten by the values of the given model.
+	 * @note Both models must be of the same table
+	 */
+	void merge(const Model& other);
+
 	/**
 	 * @return The table name without schema
 	 * @see schema()
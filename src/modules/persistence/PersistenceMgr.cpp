@@ -3,15 +3,54 @@
  */
 
 #include "PersistenceMgr.h"
+#include "BindParam.h"
 #include "DBHandler.h"
-#include "MassQuery.h"
+#include "Model.h"
 #include "core/Common.h"
+#include "core/StringUtil.h"
+#include "core/TimeProvider.h"
 #include "core/Trace.h"
+#include <inttypes.h>
 
 namespace persistence {
 
-PersistenceMgr::PersistenceMgr(const DBHandlerPtr& dbHandler) :
-		_lock("persistencemgr"), _dbHandler(dbHandler) {
+/**
+ * @brief The amount of rows that are written in one statement
+ */
+static constexpr size_t WriteBatchSize = 1000u;
+
+/**
+ * @brief Builds the key that identifies the row the model is written to
+ * @return @c false if the model can't be identified - e.g. because there is no primary key set
+ */
+static bool rowKey(const Model& model, core::String& key) {
+	const PrimaryKeys& primaryKeys = model.primaryKeys();
+	if (primaryKeys.empty()) {
+		return false;
+	}
+	BindParam params((int)primaryKeys.size());
+	for (const core::String& name : primaryKeys) {
+		const Field& f = model.getField(name);
+		if (f.name != name || f.type == FieldType::BLOB || !model.isValid(f) || model.isNull(f)) {
+			return false;
+		}
+		params.push(model, f);
+	}
+	for (int i = 0; i < params.position; ++i) {
+		key += params.values[i];
+		key += '\x1f';
+	}
+	return true;
+}
+
+PersistenceMgr::PersistenceMgr(const DBHandlerPtr& dbHandler, size_t maxPending, uint32_t maxBackPressureMillis) :
+		_lock("persistencemgr"), _dbHandler(dbHandler), _maxPending(maxPending),
+		_maxBackPressureMillis(maxBackPressureMillis), _writer(1, "Persistence") {
+}
+
+PersistenceMgr::~PersistenceMgr() {
+	// the writer accesses the pending rows - make sure it's gone before they are
+	_writer.shutdown(true);
 }
 
 bool PersistenceMgr::registerSavable(uint32_t fourcc, ISavable *savable) {
@@ -34,9 +73,15 @@ bool PersistenceMgr::unregisterSavable(uint32_t fourcc, ISavable *savable) {
 	if (s != i->second.end()) {
 		i->second.erase(s);
 		// make sure to persist the dirty state
-		MassQuery stmt = _dbHandler->massQuery();
-		stmt.add(savable);
-		stmt.commit();
+		snapshot(savable);
+		bool start;
+		{
+			core::ScopedLock pendingLock(_pendingLock);
+			start = kick();
+		}
+		if (start) {
+			startWriter();
+		}
 		Log::trace(logid, "Removed savable (fourcc: %u, savable: %p)", fourcc, savable);
 		return true;
 	}
@@ -45,30 +90,211 @@ bool PersistenceMgr::unregisterSavable(uint32_t fourcc, ISavable *savable) {
 }
 
 bool PersistenceMgr::init() {
+	if (!_writerRunning) {
+		_writer.init();
+		_writerRunning = true;
+	}
 	return true;
 }
 
 void PersistenceMgr::shutdown() {
 	core_trace_scoped(PersistenceMgrShutdown);
 	update(0l);
+	flush();
+	if (_writerRunning) {
+		_writerRunning = false;
+		_writer.shutdown(true);
+	}
 	core::ScopedWriteLock lock(_lock);
 	_savables.clear();
 }
 
 void PersistenceMgr::update(long dt) {
 	core_trace_scoped(PersistenceMgrUpdate);
-	core::ScopedReadLock lock(_lock);
-	for (auto& collection : _savables) {
-		if (collection.second.empty()) {
-			continue;
+	int models = 0;
+	{
+		core::ScopedReadLock lock(_lock);
+		for (auto& collection : _savables) {
+			for (ISavable *savable : collection.second) {
+				models += snapshot(savable);
+			}
+		}
+	}
+	bool start;
+	{
+		core::ScopedLock lock(_pendingLock);
+		start = kick();
+	}
+	if (start) {
+		startWriter();
+	}
+	core::ScopedLock lock(_pendingLock);
+	if (_pendingCount >= _maxPending) {
+		core_trace_scoped(PersistenceMgrBackPressure);
+		Log::debug(logid, "Wait for the writer - %i rows are pending", (int)_pendingCount);
+		const uint64_t start = core::TimeProvider::systemMillis();
+		uint64_t waited = 0u;
+		_pendingCondition.wait(_pendingLock, [&] {
+			waited = core::TimeProvider::systemMillis() - start;
+			return _pendingCount < _maxPending || waited >= _maxBackPressureMillis;
+		}, _maxBackPressureMillis);
+		++_backPressureWaits;
+		_backPressureMillis += (uint32_t)waited;
+		if (_pendingCount >= _maxPending) {
+			Log::warn(logid, "The writer didn't catch up in %u ms - %i rows are pending", _maxBackPressureMillis, (int)_pendingCount);
+		}
+	}
+	Log::debug(logid, "Collected %i dirty models for the writer", models);
+}
+
+void PersistenceMgr::flush() {
+	core_trace_scoped(PersistenceMgrFlush);
+	bool start;
+	{
+		core::ScopedLock lock(_pendingLock);
+		start = kick();
+	}
+	if (start) {
+		startWriter();
+	}
+	core::ScopedLock lock(_pendingLock);
+	_pendingCondition.wait(_pendingLock, [this] {
+		return !_writing && _pendingCount == 0u;
+	});
+}
+
+size_t PersistenceMgr::pending() const {
+	core::ScopedLock lock(_pendingLock);
+	return _pendingCount;
+}
+
+PersistenceMgr::Stats PersistenceMgr::stats() const {
+	Stats stats;
+	stats.failedRows = (uint32_t)(int)_failedRows;
+	core::ScopedLock lock(_pendingLock);
+	stats.pending = _pendingCount;
+	stats.backPressureWaits = _backPressureWaits;
+	stats.backPressureMillis = _backPressureMillis;
+	return stats;
+}
+
+int PersistenceMgr::snapshot(ISavable *savable) {
+	core_assert(savable != nullptr);
+	std::vector<const Model*> models;
+	if (!savable->getDirtyModels(models)) {
+		return 0;
+	}
+	// copy the models outside of the lock - this is the expensive part
+	std::vector<Model*> copies;
+	copies.reserve(models.size());
+	for (const Model* m : models) {
+		copies.push_back(m->clone());
+	}
+	core::ScopedLock lock(_pendingLock);
+	for (Model* m : copies) {
+		enqueue(m);
+	}
+	return (int)copies.size();
+}
+
+void PersistenceMgr::enqueue(Model* model) {
+	core::String key;
+	if (!rowKey(*model, key)) {
+		// can't get coalesced
+		key = core::string::format("#%" PRIu64, _uniqueRows++);
+	}
+	PendingRow& row = _pending[core::string::format("%s.%s", model->schema(), model->tableName())][key];
+	if (model->shouldBeDeleted()) {
+		// a pending upsert would get deleted anyway
+		if (row.upsert) {
+			row.upsert.reset();
+			--_pendingCount;
+		}
+		if (!row.remove) {
+			++_pendingCount;
+		}
+		row.remove.reset(model);
+		return;
+	}
+	if (row.upsert) {
+		row.upsert->merge(*model);
+		delete model;
+		return;
+	}
+	row.upsert.reset(model);
+	++_pendingCount;
+}
+
+bool PersistenceMgr::kick() {
+	if (_writing || _pendingCount == 0u) {
+		return false;
+	}
+	_writing = true;
+	return true;
+}
+
+void PersistenceMgr::startWriter() {
+	if (_writerRunning && _writer.schedule([this] () { drain(); })) {
+		return;
+	}
+	// the writer is not running - write on the calling thread
+	drain();
+}
+
+void PersistenceMgr::drain() {
+	for (;;) {
+		PendingRows rows;
+		{
+			core::ScopedLock lock(_pendingLock);
+			if (_pendingCount == 0u) {
+				_writing = false;
+				_pendingCondition.notify_all();
+				return;
+			}
+			rows.swap(_pending);
+			_pendingCount = 0u;
+			// wake up the threads that wait because of the back-pressure
+			_pendingCondition.notify_all();
+		}
+		write(rows);
+	}
+}
+
+void PersistenceMgr::write(PendingRows& rows) {
+	core_trace_scoped(PersistenceMgrWrite);
+	std::vector<const Model*> models;
+	models.reserve(WriteBatchSize);
+	for (auto& table : rows) {
+		// deletes first - the upsert of the same row was queued after the delete
+		for (auto& row : table.second) {
+			if (row.second.remove) {
+				models.push_back(row.second.remove.get());
+			}
+		}
+		if (!models.empty() && !_dbHandler->deleteModels(models)) {
+			Log::error(logid, "Failed to delete %i rows from %s", (int)models.size(), table.first.c_str());
+			_failedRows.increment((int)models.size());
+		}
+		models.clear();
+		for (auto& row : table.second) {
+			if (!row.second.upsert) {
+				continue;
+			}
+			models.push_back(row.second.upsert.get());
+			if (models.size() >= WriteBatchSize) {
+				if (!_dbHandler->insert(models)) {
+					Log::error(logid, "Failed to write %i rows to %s", (int)models.size(), table.first.c_str());
+					_failedRows.increment((int)models.size());
+				}
+				models.clear();
+			}
 		}
-		MassQuery stmt = _dbHandler->massQuery();
-		for (ISavable *savable : collection.second) {
-			stmt.add(savable);
+		if (!models.empty() && !_dbHandler->insert(models)) {
+			Log::error(logid, "Failed to write %i rows to %s", (int)models.size(), table.first.c_str());
+			_failedRows.increment((int)models.size());
 		}
-		stmt.commit();
+		models.clear();
 	}
-	Log::debug(logid, "Persisted dirty states of %i savables", (int)_savables.size());
 }
 
 }
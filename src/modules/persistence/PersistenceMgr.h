@@ -6,11 +6,17 @@
 
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include "ISavable.h"
 #include "DBHandler.h"
 #include "core/IComponent.h"
+#include "core/Trace.h"
+#include "core/concurrent/Atomic.h"
+#include "core/concurrent/ConditionVariable.h"
+#include "core/concurrent/Lock.h"
 #include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/ThreadPool.h"
 
 /**
  * Persistence layer
@@ -20,6 +26,14 @@ namespace persistence {
 /**
  * @brief This class is responsible for calling the update mechanisms for the single components of each player.
  * It will collect all database actions in prepared statements to write delta values into the database.
+ *
+ * The dirty models are copied in @c update() on the calling thread and are written to the database by a
+ * background writer (write-behind). Multiple pending updates of the same row (same table and primary key)
+ * are coalesced into one statement - relative updates (@c Operator::ADD and @c Operator::SUBTRACT) are summed
+ * up. If the writer can't keep up and more than @c maxPending rows are waiting to get written, @c update()
+ * blocks until the writer took them (back-pressure) - but not longer than @c maxBackPressureMillis. Rows that
+ * the database rejects are logged and dropped. See @c stats() for the numbers.
+ *
  * @note Your @c ISavable instances must be registered and unregistered.
  */
 class PersistenceMgr : public core::IComponent {
@@ -30,20 +44,108 @@ private:
 	Map _savables core_thread_guarded_by(_lock);
 	core::ReadWriteLock _lock;
 	const DBHandlerPtr _dbHandler;
+
+	/**
+	 * @brief The pending write operations for one row
+	 * @note A delete is always executed before the upsert - this is the only order that can
+	 * survive the coalescing of the row operations.
+	 */
+	struct PendingRow {
+		std::unique_ptr<Model> remove;
+		std::unique_ptr<Model> upsert;
+	};
+	// table name to row key to pending operations
+	using PendingRows = std::map<core::String, std::unordered_map<core::String, PendingRow, core::StringHash>>;
+
+	const size_t _maxPending;
+	const uint32_t _maxBackPressureMillis;
+	core::ThreadPool _writer;
+	core_trace_mutex(core::Lock, _pendingLock, "PersistenceMgrPending");
+	core::ConditionVariable _pendingCondition;
+	PendingRows _pending core_thread_guarded_by(_pendingLock);
+	size_t _pendingCount core_thread_guarded_by(_pendingLock) = 0u;
+	// @c true while the writer works on a batch of rows
+	bool _writing core_thread_guarded_by(_pendingLock) = false;
+	// used to create unique row keys for models that can't be coalesced
+	uint64_t _uniqueRows core_thread_guarded_by(_pendingLock) = 0u;
+	core::AtomicBool _writerRunning { false };
+	core::AtomicInt _failedRows { 0 };
+	uint32_t _backPressureWaits core_thread_guarded_by(_pendingLock) = 0u;
+	uint32_t _backPressureMillis core_thread_guarded_by(_pendingLock) = 0u;
+
+	/**
+	 * @brief Copies the dirty models of the given savable into the pending rows
+	 * @return The amount of models that were taken
+	 */
+	int snapshot(ISavable *savable);
+	void enqueue(Model* model) core_thread_requires(_pendingLock);
+	/**
+	 * @return @c true if the writer was idle and must be started with @c startWriter()
+	 */
+	bool kick() core_thread_requires(_pendingLock);
+	/**
+	 * @brief Schedules the writer - or writes on the calling thread if the writer isn't running
+	 */
+	void startWriter();
+	/**
+	 * @brief Writes the pending rows until there are no more left
+	 */
+	void drain();
+	void write(PendingRows& rows);
 public:
-	PersistenceMgr(const DBHandlerPtr& dbHandler);
-	virtual ~PersistenceMgr() {}
+	struct Stats {
+		// rows that are waiting for the writer
+		size_t pending = 0u;
+		// rows that were dropped because the database rejected them
+		uint32_t failedRows = 0u;
+		// how often update() had to wait for the writer
+		uint32_t backPressureWaits = 0u;
+		// the accumulated time update() was waiting for the writer
+		uint32_t backPressureMillis = 0u;
+	};
+
+	/**
+	 * @param[in] maxPending The amount of rows that might wait for the writer before @c update() blocks
+	 * @param[in] maxBackPressureMillis The max time @c update() blocks because of @c maxPending. The rows
+	 * are kept and the pending queue grows if the writer didn't catch up in this time.
+	 */
+	PersistenceMgr(const DBHandlerPtr& dbHandler, size_t maxPending = 10000u, uint32_t maxBackPressureMillis = 1000u);
+	virtual ~PersistenceMgr();
 
 	virtual bool registerSavable(uint32_t fourcc, ISavable *savable);
+	/**
+	 * @brief Removes the savable and queues its last dirty state for the writer
+	 * @note The savable can be destroyed after this call - the models were already copied
+	 */
 	virtual bool unregisterSavable(uint32_t fourcc, ISavable *savable);
 
 	bool init() override;
 	/**
+	 * @brief Collects the dirty states of all savables and waits until they are written
 	 * @note You have to make sure, that the update is not called anymore and also not called currently.
 	 */
 	void shutdown() override;
 
+	/**
+	 * @brief Collects the dirty models of all savables and hands them over to the writer
+	 * @note This doesn't wait for the database.
+	 */
 	void update(long dt);
+
+	/**
+	 * @brief Blocks until all pending rows are written to the database
+	 */
+	void flush();
+
+	/**
+	 * @return The amount of rows that are waiting for the writer
+	 */
+	size_t pending() const;
+
+	/**
+	 * @return The counters since the start of the manager
+	 */
+	Stats stats() const;
 };
 
 typedef std::shared_ptr<PersistenceMgr> PersistenceMgrPtr;
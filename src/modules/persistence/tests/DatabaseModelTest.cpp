@@ -390,4 +390,58 @@ TEST_F(DatabaseModelTest, testNullField) {
 	ASSERT_TRUE(_dbHandler.update(mdl));
 }
 
+TEST_F(DatabaseModelTest, testClone) {
+	db::TestModel mdl = m("foo@b.ar", "123");
+	mdl.setPoints(5);
+	mdl.flagForDelete();
+	std::unique_ptr<Model> copy(mdl.clone());
+	ASSERT_STREQ(mdl.tableName(), copy->tableName());
+	const db::TestModel* testModel = static_cast<const db::TestModel*>(copy.get());
+	EXPECT_TRUE(testModel->shouldBeDeleted());
+	EXPECT_EQ("foo@b.ar", testModel->email());
+	ASSERT_NE(nullptr, testModel->points());
+	EXPECT_EQ(5, *testModel->points());
+}
+
+TEST_F(DatabaseModelTest, testCloneBlob) {
+	uint8_t data[] = {1, 2, 3, 4};
+	db::BlobtestModel mdl;
+	mdl.setId(1);
+	mdl.setData(Blob(data, sizeof(data)));
+	std::unique_ptr<Model> copy(mdl.clone());
+	// the original blob data might get released while the copy is still queued for the writer
+	data[0] = 0;
+	const db::BlobtestModel* blobModel = static_cast<const db::BlobtestModel*>(copy.get());
+	ASSERT_EQ(sizeof(data), blobModel->data().length);
+	EXPECT_NE(data, blobModel->data().data);
+	EXPECT_EQ(1, blobModel->data().data[0]);
+
+	uint8_t newer[] = {5, 6};
+	db::BlobtestModel newerMdl;
+	newerMdl.setData(Blob(newer, sizeof(newer)));
+	copy->merge(newerMdl);
+	newer[0] = 0;
+	ASSERT_EQ(sizeof(newer), blobModel->data().length);
+	EXPECT_EQ(5, blobModel->data().data[0]);
+}
+
+TEST_F(DatabaseModelTest, testMerge) {
+	db::TestModel mdl = m("foo@b.ar", "123");
+	mdl.setPoints(5);
+	db::TestModel newer;
+	newer.setName("bar");
+	newer.setPoints(-2);
+	mdl.merge(newer);
+	// set operator overwrites
+	EXPECT_EQ("bar", mdl.name());
+	// unset fields are kept
+	EXPECT_EQ("foo@b.ar", mdl.email());
+	// add operator accumulates the relative updates
+	ASSERT_NE(nullptr, mdl.points());
+	EXPECT_EQ(3, *mdl.points());
+	newer.setPoints(nullptr);
+	mdl.merge(newer);
+	EXPECT_EQ(nullptr, mdl.points());
+}
+
 }
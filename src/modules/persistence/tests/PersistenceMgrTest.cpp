@@ -140,4 +140,36 @@ TEST_F(PersistenceMgrTest, testSavableRelativeUpdateNegative) {
 	relativeUpdate(mgr, create(), 100, -110);
 }
 
+TEST_F(PersistenceMgrTest, testSavableCoalescedRelativeUpdate) {
+	if (!_supported) {
+		return;
+	}
+	PersistenceMgr mgr(_dbHandler);
+	db::TestModel mdl = create();
+	mdl.setPoints(10);
+	db::TestModel out;
+	update(mgr, mdl, &out);
+
+	// two relative updates of the same row end up in one statement
+	ASSERT_TRUE(mgr.init());
+	EXPECT_TRUE(mgr.registerSavable(FourCC('F','O','O','O'), this));
+	db::TestModel delta1 = create();
+	delta1.setPoints(2);
+	db::TestModel delta2 = create();
+	delta2.setPoints(3);
+	_dirtyModels.push_back(&delta1);
+	_dirtyModels.push_back(&delta2);
+	mgr.update(0l);
+	mgr.flush();
+	EXPECT_EQ(0u, mgr.pending());
+	EXPECT_TRUE(mgr.unregisterSavable(FourCC('F','O','O','O'), this));
+	mgr.shutdown();
+
+	EXPECT_TRUE(_dbHandler->select(db::TestModel(), DBConditionOne(), [&] (db::TestModel&& m) {
+		out = m;
+	}));
+	ASSERT_NE(out.points(), nullptr);
+	EXPECT_EQ(*out.points(), 15);
+}
+
 }
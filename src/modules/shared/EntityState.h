@@ -0,0 +1,61 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "ServerMessages_generated.h"
+#include <glm/vec3.hpp>
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+#include <stdint.h>
+
+/**
+ * Shared between client and server
+ */
+namespace shared {
+
+/**
+ * @brief Positions in a @c network::EntityState are given in 1/64 world units
+ */
+constexpr float EntityStatePositionScale = 64.0f;
+
+inline int32_t quantizePosition(float value) {
+	return (int32_t)glm::round(value * EntityStatePositionScale);
+}
+
+inline float dequantizePosition(int32_t value) {
+	return (float)value / EntityStatePositionScale;
+}
+
+/**
+ * @brief Maps the orientation in radians to 1/65536 of a full turn
+ */
+inline uint16_t quantizeOrientation(float radians) {
+	const float turns = radians / glm::two_pi<float>();
+	const float fraction = turns - glm::floor(turns);
+	return (uint16_t)((int32_t)glm::round(fraction * 65536.0f) & 0xFFFF);
+}
+
+inline float dequantizeOrientation(uint16_t value) {
+	return (float)value / 65536.0f * glm::two_pi<float>();
+}
+
+inline network::EntityState quantizeEntityState(int64_t id, const glm::vec3& pos, float orientation, network::Animation animation) {
+	return network::EntityState(id, quantizePosition(pos.x), quantizePosition(pos.y), quantizePosition(pos.z),
+			quantizeOrientation(orientation), animation);
+}
+
+inline glm::vec3 dequantizePosition(const network::EntityState& state) {
+	return glm::vec3(dequantizePosition(state.x()), dequantizePosition(state.y()), dequantizePosition(state.z()));
+}
+
+/**
+ * @return @c true if both states would look the same on the client
+ */
+inline bool sameEntityState(const network::EntityState& a, const network::EntityState& b) {
+	return a.id() == b.id() && a.x() == b.x() && a.y() == b.y() && a.z() == b.z()
+			&& a.rotation() == b.rotation() && a.animation() == b.animation();
+}
+
+}
@@ -4,6 +4,10 @@
 
 #include "CubicSurfaceExtractor.h"
 #include "core/Common.h"
+#include "core/concurrent/ThreadPool.h"
+#include <glm/common.hpp>
+#include <limits.h>
+#include <unordered_map>
 
 namespace voxel {
 
@@ -76,20 +80,21 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientO
 		equal = isSameColor;
 	}
 
-	for (QuadList::iterator outerIter = quads.begin(); outerIter != quads.end(); ++outerIter) {
-		QuadList::iterator innerIter = outerIter;
-		++innerIter;
-		while (innerIter != quads.end()) {
-			Quad& q1 = *outerIter;
-			Quad& q2 = *innerIter;
+	for (size_t outer = 0; outer < quads.size(); ++outer) {
+		size_t inner = outer + 1;
+		while (inner < quads.size()) {
+			Quad& q1 = quads[outer];
+			Quad& q2 = quads[inner];
 
 			const bool result = mergeQuads(q1, q2, meshCurrent, equal);
 
 			if (result) {
 				didMerge = true;
-				innerIter = quads.erase(innerIter);
+				// the order of the quads doesn't matter - swap remove the merged quad
+				q2 = quads.back();
+				quads.pop_back();
 			} else {
-				++innerIter;
+				++inner;
 			}
 		}
 	}
@@ -97,6 +102,151 @@ static bool performQuadMerging(QuadList& quads, Mesh* meshCurrent, bool ambientO
 	return didMerge;
 }
 
+/**
+ * @brief Merges the quads of one slice by sweeping over a 2d mask of the quad positions. Two quads are merged
+ * under the same conditions as in @c mergeQuads() - they must share the vertices of their common edge and all
+ * their vertices must be equal - but every quad is only visited once.
+ *
+ * @param[out] merged The merged quads
+ * @param mask Reusable buffer for the mask
+ * @note The quads are expected to be unit quads - like they are generated by @c extractCubicMesh()
+ */
+static void performGreedyQuadMerging(const QuadList& quads, Mesh* meshCurrent, bool ambientOcclusion, std::vector<const Quad*>& mask, std::vector<Quad>& merged) {
+	core_trace_scoped(PerformGreedyQuadMerging);
+	auto* equal = isSameVertex;
+	if (!ambientOcclusion) {
+		equal = isSameColor;
+	}
+
+	const VertexArray& vv = meshCurrent->getVertexVector();
+	// vertex 0 and 2 are opposite corners - the two axes where they differ are spanning the plane of the slice
+	const Quad& first = quads.front();
+	const glm::ivec3 diagonal = glm::ivec3(vv[first.vertices[2]].position) - glm::ivec3(vv[first.vertices[0]].position);
+	int axisU = -1;
+	int axisV = -1;
+	for (int i = 0; i < 3; ++i) {
+		if (diagonal[i] == 0) {
+			continue;
+		}
+		if (axisU == -1) {
+			axisU = i;
+		} else {
+			axisV = i;
+		}
+	}
+	core_assert(axisU != -1 && axisV != -1);
+
+	int minsU = INT_MAX;
+	int minsV = INT_MAX;
+	int maxsU = INT_MIN;
+	int maxsV = INT_MIN;
+	for (const Quad& quad : quads) {
+		for (int i = 0; i < 4; ++i) {
+			const glm::i16vec3& pos = vv[quad.vertices[i]].position;
+			minsU = core_min(minsU, (int)pos[axisU]);
+			minsV = core_min(minsV, (int)pos[axisV]);
+			maxsU = core_max(maxsU, (int)pos[axisU]);
+			maxsV = core_max(maxsV, (int)pos[axisV]);
+		}
+	}
+	const int width = maxsU - minsU;
+	const int height = maxsV - minsV;
+	mask.assign(width * height, nullptr);
+
+	// the slot of each quad corner - the orientation is the same for all quads of a slice
+	int slot[2][2];
+	{
+		int quadU = INT_MAX;
+		int quadV = INT_MAX;
+		for (int i = 0; i < 4; ++i) {
+			const glm::i16vec3& pos = vv[first.vertices[i]].position;
+			quadU = core_min(quadU, (int)pos[axisU]);
+			quadV = core_min(quadV, (int)pos[axisV]);
+		}
+		for (int i = 0; i < 4; ++i) {
+			const glm::i16vec3& pos = vv[first.vertices[i]].position;
+			slot[pos[axisU] - quadU][pos[axisV] - quadV] = i;
+		}
+	}
+
+	for (const Quad& quad : quads) {
+		int quadU = INT_MAX;
+		int quadV = INT_MAX;
+		for (int i = 0; i < 4; ++i) {
+			const glm::i16vec3& pos = vv[quad.vertices[i]].position;
+			quadU = core_min(quadU, (int)pos[axisU]);
+			quadV = core_min(quadV, (int)pos[axisV]);
+		}
+		mask[(quadV - minsV) * width + (quadU - minsU)] = &quad;
+	}
+
+	auto isEqual = [&] (const Quad* q1, const Quad* q2) {
+		for (int i = 0; i < 4; ++i) {
+			if (!equal(vv[q1->vertices[i]], vv[q2->vertices[i]])) {
+				return false;
+			}
+		}
+		return true;
+	};
+	// q2 is the right neighbour of q1
+	auto isAdjacentU = [&] (const Quad* q1, const Quad* q2) {
+		return q1->vertices[slot[1][0]] == q2->vertices[slot[0][0]] && q1->vertices[slot[1][1]] == q2->vertices[slot[0][1]];
+	};
+	// q2 is the upper neighbour of q1
+	auto isAdjacentV = [&] (const Quad* q1, const Quad* q2) {
+		return q1->vertices[slot[0][1]] == q2->vertices[slot[0][0]] && q1->vertices[slot[1][1]] == q2->vertices[slot[1][0]];
+	};
+
+	for (int v = 0; v < height; ++v) {
+		const Quad** row = &mask[v * width];
+		for (int u = 0; u < width; ++u) {
+			const Quad* start = row[u];
+			if (start == nullptr) {
+				continue;
+			}
+			int w = 1;
+			while (u + w < width) {
+				const Quad* next = row[u + w];
+				if (next == nullptr || !isAdjacentU(row[u + w - 1], next) || !isEqual(start, next)) {
+					break;
+				}
+				++w;
+			}
+			int h = 1;
+			for (; v + h < height; ++h) {
+				const Quad** below = &mask[(v + h - 1) * width + u];
+				const Quad** current = &mask[(v + h) * width + u];
+				bool expand = true;
+				for (int i = 0; i < w; ++i) {
+					const Quad* next = current[i];
+					if (next == nullptr || !isAdjacentV(below[i], next) || (i > 0 && !isAdjacentU(current[i - 1], next)) || !isEqual(start, next)) {
+						expand = false;
+						break;
+					}
+				}
+				if (!expand) {
+					break;
+				}
+			}
+
+			Quad quad = *start;
+			for (int du = 0; du < 2; ++du) {
+				for (int dv = 0; dv < 2; ++dv) {
+					const int i = slot[du][dv];
+					quad.vertices[i] = mask[(v + dv * (h - 1)) * width + u + du * (w - 1)]->vertices[i];
+				}
+			}
+			merged.push_back(quad);
+
+			for (int dv = 0; dv < h; ++dv) {
+				for (int du = 0; du < w; ++du) {
+					mask[(v + dv) * width + u + du] = nullptr;
+				}
+			}
+		}
+	}
+}
+
 /**
  * @brief We are checking the voxels above us. There are four possible ambient occlusion values
  * for a vertex.
@@ -118,8 +268,42 @@ SDL_FORCE_INLINE bool isQuadFlipped(const VoxelVertex& v00, const VoxelVertex& v
 	return v00.ambientOcclusion + v11.ambientOcclusion > v01.ambientOcclusion + v10.ambientOcclusion;
 }
 
-void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads) {
+static void addQuad(Mesh* result, const Quad& quad) {
+	const IndexType i0 = quad.vertices[0];
+	const IndexType i1 = quad.vertices[1];
+	const IndexType i2 = quad.vertices[2];
+	const IndexType i3 = quad.vertices[3];
+	const VoxelVertex& v00 = result->getVertex(i3);
+	const VoxelVertex& v01 = result->getVertex(i0);
+	const VoxelVertex& v10 = result->getVertex(i2);
+	const VoxelVertex& v11 = result->getVertex(i1);
+
+	if (isQuadFlipped(v00, v01, v10, v11)) {
+		result->addTriangle(i1, i2, i3);
+		result->addTriangle(i1, i3, i0);
+	} else {
+		result->addTriangle(i0, i1, i2);
+		result->addTriangle(i0, i2, i3);
+	}
+}
+
+void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads, bool greedyMeshing) {
 	core_trace_scoped(GenerateMeshify);
+	if (mergeQuads && greedyMeshing) {
+		std::vector<const Quad*> mask;
+		std::vector<Quad> merged;
+		for (const QuadList& listQuads : vecListQuads) {
+			if (listQuads.empty()) {
+				continue;
+			}
+			merged.clear();
+			performGreedyQuadMerging(listQuads, result, ambientOcclusion, mask, merged);
+			for (const Quad& quad : merged) {
+				addQuad(result, quad);
+			}
+		}
+		return;
+	}
 	for (QuadList& listQuads : vecListQuads) {
 		if (mergeQuads) {
 			core_trace_scoped(MergeQuads);
@@ -130,22 +314,7 @@ void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVecto
 		}
 
 		for (const Quad& quad : listQuads) {
-			const IndexType i0 = quad.vertices[0];
-			const IndexType i1 = quad.vertices[1];
-			const IndexType i2 = quad.vertices[2];
-			const IndexType i3 = quad.vertices[3];
-			const VoxelVertex& v00 = result->getVertex(i3);
-			const VoxelVertex& v01 = result->getVertex(i0);
-			const VoxelVertex& v10 = result->getVertex(i2);
-			const VoxelVertex& v11 = result->getVertex(i1);
-
-			if (isQuadFlipped(v00, v01, v10, v11)) {
-				result->addTriangle(i1, i2, i3);
-				result->addTriangle(i1, i3, i0);
-			} else {
-				result->addTriangle(i0, i1, i2);
-				result->addTriangle(i0, i2, i3);
-			}
+			addQuad(result, quad);
 		}
 	}
 }
@@ -187,4 +356,107 @@ IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, cons
 	return 0; //Should never happen.
 }
 
+static inline uint64_t weldKey(const VoxelVertex& vertex) {
+	return (uint64_t)(uint16_t)vertex.position.x | ((uint64_t)(uint16_t)vertex.position.y << 16)
+			| ((uint64_t)(uint16_t)vertex.position.z << 32) | ((uint64_t)vertex.ambientOcclusion << 48)
+			| ((uint64_t)vertex.colorIndex << 56);
+}
+
+/**
+ * @brief Appends the tile meshes to the result. Vertices that lie on the border between two tiles are looked up
+ * by position, color and ambient occlusion to let the neighbouring tiles share them.
+ */
+static void stitchMeshes(const std::vector<Mesh>& meshes, Mesh* result, const glm::ivec3& translate, int tileSize, bool weldVertices) {
+	core_trace_scoped(StitchMeshes);
+	size_t vertices = 0u;
+	size_t indices = 0u;
+	for (const Mesh& mesh : meshes) {
+		vertices += mesh.getNoOfVertices();
+		indices += mesh.getNoOfIndices();
+	}
+	VertexArray& resultVertices = result->getVertexVector();
+	IndexArray& resultIndices = result->getIndexVector();
+	resultVertices.reserve(vertices + 1);
+	resultIndices.reserve(indices + 1);
+
+	std::unordered_map<uint64_t, IndexType> borderVertices;
+	IndexArray remap;
+	for (const Mesh& mesh : meshes) {
+		const VertexArray& meshVertices = mesh.getVertexVector();
+		const IndexArray& meshIndices = mesh.getIndexVector();
+		if (!weldVertices) {
+			const IndexType base = (IndexType)resultVertices.size();
+			resultVertices.append(meshVertices.data(), meshVertices.size());
+			for (size_t i = 0u; i < meshIndices.size(); ++i) {
+				resultIndices.push_back(base + meshIndices[i]);
+			}
+			continue;
+		}
+		remap.resize(meshVertices.size());
+		for (size_t i = 0u; i < meshVertices.size(); ++i) {
+			const VoxelVertex& vertex = meshVertices[i];
+			const glm::ivec3 local = glm::ivec3(vertex.position) - translate;
+			const bool border = (local.x > 0 && local.x % tileSize == 0) || (local.y > 0 && local.y % tileSize == 0)
+					|| (local.z > 0 && local.z % tileSize == 0);
+			if (!border) {
+				remap[i] = (IndexType)resultVertices.size();
+				resultVertices.push_back(vertex);
+				continue;
+			}
+			auto iter = borderVertices.emplace(weldKey(vertex), (IndexType)resultVertices.size());
+			if (iter.second) {
+				resultVertices.push_back(vertex);
+			}
+			remap[i] = iter.first->second;
+		}
+		for (size_t i = 0u; i < meshIndices.size(); ++i) {
+			resultIndices.push_back(remap[meshIndices[i]]);
+		}
+	}
+}
+
+void extractParallel(core::ThreadPool& threadPool, const Region& region, Mesh* result, const glm::ivec3& translate,
+		int tileSize, bool weldVertices, const ExtractTileFunc& extractTile) {
+	core_assert_msg(tileSize > 0, "Invalid tile size given: %i", tileSize);
+	result->clear();
+	const glm::ivec3& mins = region.getLowerCorner();
+	const glm::ivec3& maxs = region.getUpperCorner();
+	result->setOffset(mins);
+
+	std::vector<Region> tiles;
+	for (int32_t z = mins.z; z <= maxs.z; z += tileSize) {
+		for (int32_t y = mins.y; y <= maxs.y; y += tileSize) {
+			for (int32_t x = mins.x; x <= maxs.x; x += tileSize) {
+				const glm::ivec3 tileMins(x, y, z);
+				const glm::ivec3 tileMaxs = glm::min(tileMins + (tileSize - 1), maxs);
+				tiles.emplace_back(tileMins, tileMaxs);
+			}
+		}
+	}
+
+	std::vector<Mesh> meshes(tiles.size());
+	std::vector<std::future<void>> futures;
+	futures.reserve(tiles.size());
+	for (size_t i = 0u; i < tiles.size(); ++i) {
+		const Region& tile = tiles[i];
+		Mesh* mesh = &meshes[i];
+		const glm::ivec3 tileTranslate = translate + tile.getLowerCorner() - mins;
+		futures.emplace_back(threadPool.enqueue([&extractTile, &tile, tileTranslate, mesh] () {
+			extractTile(tile, tileTranslate, mesh);
+		}));
+		if (!futures.back().valid()) {
+			// the pool is shutting down - extract on the calling thread instead
+			extractTile(tile, tileTranslate, mesh);
+		}
+	}
+	for (std::future<void>& future : futures) {
+		if (future.valid()) {
+			future.get();
+		}
+	}
+
+	stitchMeshes(meshes, result, translate, tileSize, weldVertices);
+	result->compressIndices();
+}
+
 }
@@ -17,9 +17,14 @@
 #include "Face.h"
 #include <glm/fwd.hpp>
 #include <glm/vec3.hpp>
-#include <list>
+#include <glm/vector_relational.hpp>
+#include <functional>
 #include <vector>
 
+namespace core {
+class ThreadPool;
+}
+
 namespace voxel {
 
 /**
@@ -86,9 +91,10 @@ public:
 };
 
 /**
- * @brief Should be a list because random inserts which we need in @c performQuadMerging are O(1)
+ * @brief The quads are kept in a flat vector - @c performQuadMerging swap-removes the merged quads, as the
+ * order of the quads doesn't matter
  */
-typedef std::list<Quad> QuadList;
+typedef std::vector<Quad> QuadList;
 typedef std::vector<QuadList> QuadListVector;
 
 /**
@@ -98,7 +104,11 @@ typedef std::vector<QuadList> QuadListVector;
 extern IndexType addVertex(bool reuseVertices, uint32_t x, uint32_t y, uint32_t z, const Voxel& materialIn, Array& existingVertices,
 		Mesh* meshCurrent, const VoxelType face1, const VoxelType face2, const VoxelType corner, const glm::ivec3& offset);
 
-extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads);
+/**
+ * @param greedyMeshing Merge the quads with a greedy sweep over a 2d mask per slice instead of the repeated pairwise
+ * comparison of all quads in the slice. Only used if @c mergeQuads is @c true.
+ */
+extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadListVector& vecListQuads, bool greedyMeshing = false);
 
 /**
  * The CubicSurfaceExtractor creates a mesh in which each voxel appears to be rendered as a cube
@@ -185,9 +195,12 @@ extern void meshify(Mesh* result, bool mergeQuads, bool ambientOcclusion, QuadLi
  * @li It leaves the user in control of memory allocation and would allow them to implement e.g. a mesh pooling system.
  * @li The user-provided mesh could have a different index type (e.g. 16-bit indices) to reduce memory usage.
  * @li The user could provide a custom mesh class, e.g a thin wrapper around an openGL VBO to allow direct writing into this structure.
+ *
+ * @param greedyMeshing Merges the quads of a slice in one sweep over a 2d mask. The merged surface is the same as
+ * with the default merging - but the extraction is a lot faster for large surfaces. See @c meshify()
  */
 template<typename VolumeType, typename IsQuadNeeded>
-void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true) {
+void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded, const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true, bool greedyMeshing = false) {
 	core_trace_scoped(ExtractCubicMesh);
 
 	result->clear();
@@ -408,7 +421,7 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 	{
 		core_trace_scoped(GenerateMesh);
 		for (QuadListVector& vecListQuads : vecQuads) {
-			meshify(result, mergeQuads, ambientOcclusion, vecListQuads);
+			meshify(result, mergeQuads, ambientOcclusion, vecListQuads, greedyMeshing);
 		}
 	}
 
@@ -416,6 +429,45 @@ void extractCubicMesh(VolumeType* volData, const Region& region, Mesh* result, I
 	result->compressIndices();
 }
 
+using ExtractTileFunc = std::function<void(const Region& tile, const glm::ivec3& translate, Mesh* mesh)>;
+
+/**
+ * @brief Splits the given region into tiles of @c tileSize cells, runs @c extractTile for each of them on the given
+ * thread pool and stitches the tile meshes into @c result.
+ * @note Blocks until all tiles are extracted - don't call this from a task of the same thread pool.
+ */
+extern void extractParallel(core::ThreadPool& threadPool, const Region& region, Mesh* result, const glm::ivec3& translate,
+		int tileSize, bool weldVertices, const ExtractTileFunc& extractTile);
+
+/**
+ * @brief Extracts the region with @c extractCubicMesh() in tiles that are distributed over the given thread pool.
+ *
+ * The tiles don't overlap - a quad on the border between two tiles is generated by the tile with the greater
+ * coordinate, just like for two neighbouring extraction regions of a chunked world. The faces of the resulting mesh
+ * are therefore the same as if the whole region was extracted at once, but quads are not merged across tile borders.
+ *
+ * @param threadPool An initialized thread pool. The volume must support concurrent reads.
+ * @param tileSize The edge length of the tiles in cells. The region is extracted on the calling thread if it
+ * doesn't exceed one tile.
+ * @param weldVertices Merge the vertices with the same position, color and ambient occlusion value that two
+ * neighbouring tiles created on their shared border. Only has an effect if @c reuseVertices is @c true.
+ */
+template<typename VolumeType, typename IsQuadNeeded>
+void extractCubicMeshParallel(core::ThreadPool& threadPool, VolumeType* volData, const Region& region, Mesh* result, IsQuadNeeded isQuadNeeded,
+		const glm::ivec3& translate, bool mergeQuads = true, bool reuseVertices = true, bool ambientOcclusion = true, bool greedyMeshing = false,
+		int tileSize = 64, bool weldVertices = true) {
+	core_trace_scoped(ExtractCubicMeshParallel);
+	const glm::ivec3& cells = region.getUpperCorner() - region.getLowerCorner() + 1;
+	if (glm::all(glm::lessThanEqual(cells, glm::ivec3(tileSize)))) {
+		extractCubicMesh(volData, region, result, isQuadNeeded, translate, mergeQuads, reuseVertices, ambientOcclusion, greedyMeshing);
+		return;
+	}
+	extractParallel(threadPool, region, result, translate, tileSize, weldVertices && reuseVertices,
+		[=] (const Region& tile, const glm::ivec3& tileTranslate, Mesh* mesh) {
+			extractCubicMesh(volData, tile, mesh, isQuadNeeded, tileTranslate, mergeQuads, reuseVertices, ambientOcclusion, greedyMeshing);
+		});
+}
+
 }
 
 #undef BUFFERED_SAMPLER
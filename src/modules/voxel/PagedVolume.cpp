@@ -7,6 +7,9 @@
 #include "core/Log.h"
 #include "core/Common.h"
 #include "core/Trace.h"
+#include "core/TimeProvider.h"
+#include "core/concurrent/ThreadPool.h"
+#include "core/collection/DynamicArray.h"
 #include "math/Functions.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/round.hpp>
@@ -21,9 +24,11 @@ namespace voxel {
  * @param targetMemoryUsageInBytes The upper limit to how much memory this PagedVolume should aim to use.
  * @param chunkSideLength The size of the chunks making up the volume. Small chunks will compress/decompress faster, but there will also be
  * more of them meaning voxel access could be slower.
+ * @param compressedMemoryUsageInBytes The upper limit of memory that is used to keep evicted chunks compressed in memory. If this is @c 0
+ * the evicted chunks are directly handed over to the pager.
  */
-PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength) :
-		_chunkSideLength(chunkSideLength), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
+PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16_t chunkSideLength, uint32_t compressedMemoryUsageInBytes) :
+		_compressedMemoryLimit(compressedMemoryUsageInBytes), _chunkSideLength(chunkSideLength), _pager(pager), _region(0, 0, 0, -1, -1, -1) {
 	// Validation of parameters
 	core_assert_msg(_pager, "You must provide a valid pager when constructing a PagedVolume");
 	core_assert_msg(targetMemoryUsageInBytes >= 1 * 1024 * 1024, "Target memory usage is too small to be practical");
@@ -36,21 +41,35 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
 	// Use to perform modulo by bit operations
 	_chunkMask = _chunkSideLength - 1;
 
-	// Calculate the number of chunks based on the memory limit and the size of each chunk.
+	// Calculate the number of dense chunks based on the memory limit and the size of each chunk.
 	uint32_t chunkSizeInBytes = PagedVolume::Chunk::calculateSizeInBytes(_chunkSideLength);
-	_chunkCountLimit = targetMemoryUsageInBytes / chunkSizeInBytes;
+	uint32_t denseChunks = targetMemoryUsageInBytes / chunkSizeInBytes;
 
 	// Enforce sensible limits on the number of chunks.
 	const uint32_t minPracticalNoOfChunks = 32; // Enough to make sure a chunks and it's neighbours can be loaded, with a few to spare.
-	if (_chunkCountLimit < minPracticalNoOfChunks) {
+	if (denseChunks < minPracticalNoOfChunks) {
 		Log::warn("Requested memory usage limit of %uMb is too low and cannot be adhered to. Chunk limit is at %i, Chunk size: %uKb",
-				targetMemoryUsageInBytes / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+				targetMemoryUsageInBytes / (1024 * 1024), denseChunks, chunkSizeInBytes / 1024);
+	}
+	denseChunks = core_max(denseChunks, minPracticalNoOfChunks);
+	_memoryLimit = (uint64_t)denseChunks * chunkSizeInBytes;
+	// uniform and palette chunks only need a fraction of the dense size - more of them fit into the budget
+	const uint32_t maxChunksPerDenseChunk = 8u;
+	_chunkCountLimit = denseChunks * maxChunksPerDenseChunk;
+
+	// The chunks are not evenly distributed over the shards - leave some headroom. The map of a shard is
+	// grown if it runs full anyway.
+	const int shardSize = (int)(_chunkCountLimit / ChunkShards) * 2 + 16;
+	for (int i = 0; i < ChunkShards; ++i) {
+		_shards[i] = new ChunkShard(shardSize);
 	}
-	_chunkCountLimit = core_max(_chunkCountLimit, minPracticalNoOfChunks);
 
 	// Inform the user about the chosen memory configuration.
-	Log::info("Memory usage limit for volume now set to %uMb (%u chunks of %uKb each).",
-			(_chunkCountLimit * chunkSizeInBytes) / (1024 * 1024), _chunkCountLimit, chunkSizeInBytes / 1024);
+	Log::info("Memory usage limit for volume now set to %uMb (%u dense chunks of %uKb each, %u chunks at most).",
+			(uint32_t)(_memoryLimit / (1024 * 1024)), denseChunks, chunkSizeInBytes / 1024, _chunkCountLimit);
+	if (_compressedMemoryLimit > 0u) {
+		Log::info("Memory usage limit for compressed chunks now set to %uMb.", _compressedMemoryLimit / (1024 * 1024));
+	}
 }
 
 /**
@@ -58,7 +77,35 @@ PagedVolume::PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes, uint16
  * data via the dataOverflowHandler() if desired.
  */
 PagedVolume::~PagedVolume() {
+	stopAsyncPaging();
 	flushAll();
+	for (int i = 0; i < ChunkShards; ++i) {
+		delete _shards[i];
+	}
+	core_free(_compressBuffer);
+}
+
+bool PagedVolume::isUniform(const Region& region) const {
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	VoxelType material = VoxelType::Max;
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				const ChunkPtr& c = chunk(x, y, z);
+				if (!c->isUniform()) {
+					return false;
+				}
+				const VoxelType m = c->voxel(0, 0, 0).getMaterial();
+				if (material == VoxelType::Max) {
+					material = m;
+				} else if (material != m) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
 }
 
 /**
@@ -169,32 +216,302 @@ void PagedVolume::setVoxels(int32_t uXPos, int32_t uYPos, int32_t uZPos, int nx,
  * Removes all voxels from memory by removing all chunks. The application has the chance to persist the data via @c Pager::pageOut
  */
 void PagedVolume::flushAll() {
-	core::ScopedWriteLock writeLock(_volumeLock);
-	_chunks.clear();
+	{
+		core::ScopedLock pageInLock(_pageInLock);
+		while (_compressedTail != nullptr) {
+			CompressedChunk* compressedChunk = _compressedTail;
+			pageOutCompressedChunk(compressedChunk);
+			freeCompressedChunk(compressedChunk);
+		}
+	}
+	{
+		core::ScopedLock lock(_lruLock);
+		_lruHead = nullptr;
+		_lruTail = nullptr;
+		_chunkCount = 0u;
+	}
+	for (int i = 0; i < ChunkShards; ++i) {
+		ChunkShard& s = *_shards[i];
+		core::DynamicArray<ChunkPtr> chunks;
+		{
+			core::ScopedWriteLock writeLock(s.lock);
+			chunks.reserve(s.chunks.size());
+			for (auto iter = s.chunks.begin(); iter != s.chunks.end(); ++iter) {
+				chunks.push_back(iter->second);
+			}
+			s.chunks.clear();
+		}
+		for (const ChunkPtr& chunk : chunks) {
+			chunk->trackMemoryUsage(nullptr);
+		}
+		// the pager is called for modified chunks - the shard lock is not reentrant
+		chunks.clear();
+	}
 }
 
 /**
- * As we have added a chunk we may have exceeded our target chunk limit. Search through the array to
- * determine how many chunks we have, as well as finding the oldest timestamp. Note that this is potentially
- * wasteful and we may instead wish to track how many chunks we have and/or delete a chunk at random (or
- * just check e.g. 10 and delete the oldest of those) but we'll see if this is a bottleneck first. Paging
- * the data in is probably more expensive.
+ * @brief Doubles the capacity of the given map if no further entry fits into it
  */
-void PagedVolume::deleteOldestChunkIfNeeded() const {
+template<class MAP>
+static void growIfFull(MAP& map) {
+	if (map.size() < map.capacity()) {
+		return;
+	}
+	MAP grown((int)map.capacity() * 2);
+	for (auto i = map.begin(); i != map.end(); ++i) {
+		grown.put(i->key, i->value);
+	}
+	map = grown;
+}
+
+PagedVolume::ChunkShard& PagedVolume::shard(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
+	// don't use the glm::hash here - the map buckets inside the shard are also selected by this hash
+	const uint32_t h = ((uint32_t)chunkX * 73856093u) ^ ((uint32_t)chunkY * 19349663u) ^ ((uint32_t)chunkZ * 83492791u);
+	return *_shards[(h >> 4) & (ChunkShards - 1)];
+}
+
+void PagedVolume::lruLinkFront(Chunk* chunk) const {
+	chunk->_lruStamp = chunk->_chunkLastAccessed;
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = _lruHead;
+	if (_lruHead != nullptr) {
+		_lruHead->_lruPrev = chunk;
+	}
+	_lruHead = chunk;
+	if (_lruTail == nullptr) {
+		_lruTail = chunk;
+	}
+}
+
+void PagedVolume::lruUnlink(Chunk* chunk) const {
+	if (chunk->_lruPrev != nullptr) {
+		chunk->_lruPrev->_lruNext = chunk->_lruNext;
+	} else {
+		_lruHead = chunk->_lruNext;
+	}
+	if (chunk->_lruNext != nullptr) {
+		chunk->_lruNext->_lruPrev = chunk->_lruPrev;
+	} else {
+		_lruTail = chunk->_lruPrev;
+	}
+	chunk->_lruPrev = nullptr;
+	chunk->_lruNext = nullptr;
+}
+
+/**
+ * As we have added a chunk we may have exceeded our memory or chunk limit. Chunks that were promoted to the dense
+ * representation since the last page in might have increased the memory usage, too - that's why a few chunks are
+ * evicted per call.
+ * @param keep The chunk that was just paged in and is not yet handed out to the caller
+ */
+void PagedVolume::deleteOldestChunkIfNeeded(const Chunk* keep) const {
 	core_trace_scoped(DeleteOldestChunk);
-	ChunkMap::iterator oldestChunk = _chunks.end();
-	uint32_t oldestChunkTimestamp = _timestamper;
-	for (ChunkMap::iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
-		const ChunkPtr& chunk = i->second;
-		if (chunk->_chunkLastAccessed < oldestChunkTimestamp) {
-			oldestChunkTimestamp = chunk->_chunkLastAccessed;
-			oldestChunk = i;
+	const int maxEvictions = 4;
+	for (int i = 0; i < maxEvictions; ++i) {
+		if (!deleteOldestChunk(keep)) {
+			break;
+		}
+	}
+}
+
+/**
+ * Chunk hits don't touch the lru list (they would need the lru lock for this) but only update the access timestamp
+ * of the chunk. The chunk at the tail of the list is evicted if it wasn't accessed since it was linked - otherwise it
+ * gets a second chance and is moved to the front again. After @c MaxSecondChances moves the current tail is evicted
+ * anyway - this bounds the time the lru lock is held if all resident chunks are accessed all the time.
+ *
+ * Chunks that are still referenced outside of the index are not evicted - they are moved to the front, too. Writes
+ * via such a reference would get lost, or a page in of the same position would return stale data while the old
+ * chunk is still modified. With the index reference being the only one, nobody can get hold of the chunk once it
+ * is removed from the index, and the position stays marked as being paged until its data was compressed or paged out.
+ */
+bool PagedVolume::deleteOldestChunk(const Chunk* keep) const {
+	ChunkPtr evicted;
+	glm::ivec3 pos;
+	{
+		core::ScopedLock lock(_lruLock);
+		if (_chunkCount < _chunkCountLimit && _memoryUsage.load() <= (int64_t)_memoryLimit) {
+			return false;
+		}
+		static constexpr int MaxSecondChances = 16;
+		int secondChances = 0;
+		// bounds the walk if all chunks are referenced
+		uint32_t referenced = 0u;
+		while (_lruTail != nullptr && _lruTail != _lruHead && referenced < _chunkCount) {
+			Chunk* oldest = _lruTail;
+			lruUnlink(oldest);
+			if (oldest == keep) {
+				lruLinkFront(oldest);
+				continue;
+			}
+			if (secondChances < MaxSecondChances && (int32_t)((uint32_t)(int)oldest->_chunkLastAccessed - (uint32_t)oldest->_lruStamp) > 0) {
+				++secondChances;
+				lruLinkFront(oldest);
+				continue;
+			}
+			pos = oldest->chunkPos();
+			ChunkShard& s = shard(pos.x, pos.y, pos.z);
+			core::ScopedWriteLock writeLock(s.lock);
+			auto i = s.chunks.find(pos);
+			core_assert(i != s.chunks.end());
+			// new references are only handed out by the index - and we hold its write lock
+			if (i->second.use_count() != 1) {
+				++referenced;
+				lruLinkFront(oldest);
+				continue;
+			}
+			// keep a reference to not page out the chunk while holding the locks
+			evicted = i->second;
+			s.chunks.erase(i);
+			--_chunkCount;
+			// the chunk must not be paged in again before its data was compressed or paged out
+			core::ScopedLock pageInLock(_pageInLock);
+			growIfFull(_pagingIn);
+			_pagingIn.put(pos, true);
+			break;
 		}
 	}
-	if (oldestChunk != _chunks.end()) {
-		Log::debug("delete oldest chunk - reached %u", _chunkCountLimit);
-		_chunks.erase(oldestChunk);
+	if (!evicted) {
+		return false;
 	}
+	core_assert(evicted.use_count() == 1);
+	Log::debug("delete oldest chunk - reached %u chunks or %uKb", _chunkCountLimit, (uint32_t)(_memoryLimit / 1024));
+	evicted->trackMemoryUsage(nullptr);
+	if (_compressedMemoryLimit > 0u) {
+		core::ScopedLock pageInLock(_pageInLock);
+		compressChunk(evicted);
+		deleteOldestCompressedChunkIfNeeded();
+	}
+	// the destructor pages out the modified data if the chunk wasn't compressed
+	evicted.release();
+	endPageIn(pos);
+	return true;
+}
+
+/**
+ * @note This is called with the page in lock held. The evicted chunk is still marked as being paged - that's
+ * why no other thread can page in the evicted chunk again while it is not yet part of the compressed chunks.
+ * @note Only chunks that are not referenced anymore are evicted - otherwise writes via the
+ * remaining references would get lost.
+ */
+void PagedVolume::compressChunk(const ChunkPtr& chunk) const {
+	core_trace_scoped(CompressChunk);
+	const uint32_t rawSize = chunk->dataSizeInBytes();
+	if (_compressBuffer == nullptr) {
+		_compressBuffer = (uint8_t*)core_malloc(rawSize);
+	}
+	uint32_t size = chunk->compress(_compressBuffer, rawSize);
+	const bool raw = size == 0u;
+	const uint8_t* src = _compressBuffer;
+	if (raw) {
+		size = rawSize;
+		src = (const uint8_t*)chunk->data();
+	}
+
+	CompressedChunk* compressedChunk = new CompressedChunk();
+	compressedChunk->pos = chunk->chunkPos();
+	compressedChunk->data = (uint8_t*)core_malloc(size);
+	core_memcpy(compressedChunk->data, src, size);
+	compressedChunk->size = size;
+	compressedChunk->raw = raw;
+	// the compressed chunk is now responsible to page out the data
+	compressedChunk->dataModified = chunk->_dataModified;
+	chunk->_dataModified = false;
+
+	if (_compressedChunks.size() >= _compressedChunks.capacity()) {
+		pageOutCompressedChunk(_compressedTail);
+		freeCompressedChunk(_compressedTail);
+	}
+	_compressedChunks.put(compressedChunk->pos, compressedChunk);
+	compressedChunk->lruNext = _compressedHead;
+	if (_compressedHead != nullptr) {
+		_compressedHead->lruPrev = compressedChunk;
+	}
+	_compressedHead = compressedChunk;
+	if (_compressedTail == nullptr) {
+		_compressedTail = compressedChunk;
+	}
+	_compressedMemoryUsage += size;
+	Log::debug("compressed chunk at %i:%i:%i to %u bytes", compressedChunk->pos.x, compressedChunk->pos.y, compressedChunk->pos.z, size);
+}
+
+bool PagedVolume::decompressChunk(const ChunkPtr& chunk) const {
+	auto i = _compressedChunks.find(chunk->chunkPos());
+	if (i == _compressedChunks.end()) {
+		return false;
+	}
+	core_trace_scoped(DecompressChunk);
+	CompressedChunk* compressedChunk = i->second;
+	bool success;
+	if (compressedChunk->raw) {
+		success = chunk->setData((const Voxel*)compressedChunk->data, compressedChunk->size);
+	} else {
+		success = chunk->decompress(compressedChunk->data, compressedChunk->size);
+	}
+	if (!success) {
+		Log::error("Failed to decompress chunk at %i:%i:%i", compressedChunk->pos.x, compressedChunk->pos.y, compressedChunk->pos.z);
+		freeCompressedChunk(compressedChunk);
+		return false;
+	}
+	chunk->_dataModified = compressedChunk->dataModified;
+	freeCompressedChunk(compressedChunk);
+	return true;
+}
+
+void PagedVolume::deleteOldestCompressedChunkIfNeeded() const {
+	while (_compressedMemoryUsage > _compressedMemoryLimit && _compressedTail != nullptr) {
+		CompressedChunk* oldest = _compressedTail;
+		pageOutCompressedChunk(oldest);
+		freeCompressedChunk(oldest);
+	}
+}
+
+void PagedVolume::pageOutCompressedChunk(CompressedChunk* compressedChunk) const {
+	if (!compressedChunk->dataModified) {
+		return;
+	}
+	core_trace_scoped(PageOutCompressedChunk);
+	// the pager only knows about uncompressed chunks
+	Chunk chunk(compressedChunk->pos, _chunkSideLength, _pager);
+	if (compressedChunk->raw) {
+		chunk.setData((const Voxel*)compressedChunk->data, compressedChunk->size);
+	} else if (!chunk.decompress(compressedChunk->data, compressedChunk->size)) {
+		Log::error("Failed to decompress chunk at %i:%i:%i", compressedChunk->pos.x, compressedChunk->pos.y, compressedChunk->pos.z);
+		return;
+	}
+	// the destructor is calling the pager
+	chunk._dataModified = true;
+}
+
+void PagedVolume::freeCompressedChunk(CompressedChunk* compressedChunk) const {
+	_compressedChunks.remove(compressedChunk->pos);
+	if (compressedChunk->lruPrev != nullptr) {
+		compressedChunk->lruPrev->lruNext = compressedChunk->lruNext;
+	} else {
+		_compressedHead = compressedChunk->lruNext;
+	}
+	if (compressedChunk->lruNext != nullptr) {
+		compressedChunk->lruNext->lruPrev = compressedChunk->lruPrev;
+	} else {
+		_compressedTail = compressedChunk->lruPrev;
+	}
+	_compressedMemoryUsage -= compressedChunk->size;
+	core_free(compressedChunk->data);
+	delete compressedChunk;
+}
+
+uint64_t PagedVolume::memoryUsage() const {
+	return (uint64_t)_memoryUsage.load();
+}
+
+uint32_t PagedVolume::compressedChunks() const {
+	core::ScopedLock pageInLock(_pageInLock);
+	return (uint32_t)_compressedChunks.size();
+}
+
+uint32_t PagedVolume::compressedMemoryUsage() const {
+	core::ScopedLock pageInLock(_pageInLock);
+	return _compressedMemoryUsage;
 }
 
 PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
@@ -203,7 +520,18 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 	glm::ivec3 pos(chunkX, chunkY, chunkZ);
 	Log::debug("create new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
 	ChunkPtr chunk = core::make_shared<Chunk>(pos, _chunkSideLength, _pager);
-	chunk->_chunkLastAccessed = ++_timestamper; // Important, as we may soon delete the oldest chunk
+	chunk->_chunkLastAccessed = _timestamper.increment(1) + 1; // Important, as we may soon delete the oldest chunk
+
+	bool restored;
+	{
+		core::ScopedLock pageInLock(_pageInLock);
+		restored = decompressChunk(chunk);
+	}
+	if (restored) {
+		Log::debug("restored compressed chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
+		chunk->compact();
+		return chunk;
+	}
 
 	// Pass the chunk to the Pager to give it a chance to initialise it with any data
 	// From the coordinates of the chunk we deduce the coordinates of the contained voxels.
@@ -215,28 +543,207 @@ PagedVolume::ChunkPtr PagedVolume::createNewChunk(int32_t chunkX, int32_t chunkY
 
 	// Page the data in
 	// We'll use this later to decide if data needs to be paged out again.
+	const uint64_t start = core::TimeProvider::systemMillis();
 	chunk->_dataModified = _pager->pageIn(pctx);
+	const int millis = (int)(core::TimeProvider::systemMillis() - start);
+	_pageIns.increment(1);
+	_pageInMillis.increment(millis);
+	for (;;) {
+		const int maxMillis = _maxPageInMillis;
+		if (millis <= maxMillis || _maxPageInMillis.compare_exchange(maxMillis, millis)) {
+			break;
+		}
+	}
+	// uniform and low entropy chunks (e.g. air or solid rock) don't need the full voxel array
+	chunk->compact();
 	Log::debug("finished creating new chunk at %i:%i:%i", chunkX, chunkY, chunkZ);
 
 	return chunk;
 }
 
+PagedVolume::ChunkPtr PagedVolume::residentChunk(const glm::ivec3& pos) const {
+	ChunkShard& s = shard(pos.x, pos.y, pos.z);
+	core::ScopedReadLock readLock(s.lock);
+	auto i = s.chunks.find(pos);
+	if (i == s.chunks.end()) {
+		return ChunkPtr();
+	}
+	const ChunkPtr& chunk = i->second;
+	chunk->_chunkLastAccessed = _timestamper.increment(1) + 1;
+	return chunk;
+}
+
+void PagedVolume::prefetch(const Region& region, const glm::ivec3& referencePos) const {
+	core_trace_scoped(PagedVolumePrefetch);
+	const glm::ivec3& mins = chunkPos(region.getLowerCorner());
+	const glm::ivec3& maxs = chunkPos(region.getUpperCorner());
+	const int32_t halfSideLength = _chunkSideLength / 2;
+	for (int32_t x = mins.x; x <= maxs.x; ++x) {
+		for (int32_t y = mins.y; y <= maxs.y; ++y) {
+			for (int32_t z = mins.z; z <= maxs.z; ++z) {
+				const glm::ivec3 p(x, y, z);
+				if (residentChunk(p)) {
+					continue;
+				}
+				const glm::ivec3& d = p * (int32_t)_chunkSideLength + halfSideLength - referencePos;
+				queuePrefetch(p, d.x * d.x + d.y * d.y + d.z * d.z);
+			}
+		}
+	}
+}
+
+/**
+ * A chunk that is already queued is queued again if the new priority is at least twice as high - e.g. the player
+ * moved towards the chunk. The old request is skipped by the workers. Halving the priority each time bounds the
+ * amount of stale requests per chunk.
+ */
+void PagedVolume::queuePrefetch(const glm::ivec3& chunkPos, int priority) const {
+	{
+		core::ScopedLock lock(_prefetchLock);
+		int queuedPriority;
+		if (_prefetchQueued.get(chunkPos, queuedPriority)) {
+			if (priority >= queuedPriority / 2) {
+				return;
+			}
+		} else if (_prefetchQueued.size() >= _prefetchQueued.capacity()) {
+			Log::debug("prefetch queue is full");
+			return;
+		}
+		_prefetchQueued.put(chunkPos, priority);
+	}
+	_prefetchQueue.push(PrefetchRequest{chunkPos, priority});
+}
+
+void PagedVolume::prefetchWorker() {
+	PrefetchRequest request;
+	while (_prefetchQueue.waitAndPop(request)) {
+		const glm::ivec3& p = request.chunkPos;
+		{
+			core::ScopedLock lock(_prefetchLock);
+			int queuedPriority;
+			if (!_prefetchQueued.get(p, queuedPriority) || queuedPriority != request.priority) {
+				// the chunk was queued again with a higher priority or is already paged in
+				continue;
+			}
+		}
+		chunk(p.x, p.y, p.z);
+		// the chunk is resident now - so it's fine if it gets queued again from here on
+		core::ScopedLock lock(_prefetchLock);
+		_prefetchQueued.remove(p);
+	}
+}
+
+void PagedVolume::startAsyncPaging(int threads) {
+	if (_prefetchPool != nullptr || threads <= 0) {
+		return;
+	}
+	Log::info("Start async paging with %i threads", threads);
+	_prefetchQueue.reset();
+	_prefetchPool = new core::ThreadPool(threads, "PagedVolume");
+	_prefetchPool->init();
+	for (int i = 0; i < threads; ++i) {
+		_prefetchPool->enqueue([this] () { prefetchWorker(); });
+	}
+}
+
+void PagedVolume::stopAsyncPaging() {
+	if (_prefetchPool == nullptr) {
+		return;
+	}
+	_prefetchQueue.clear();
+	_prefetchQueue.abortWait();
+	_prefetchPool->shutdown();
+	delete _prefetchPool;
+	_prefetchPool = nullptr;
+	core::ScopedLock lock(_prefetchLock);
+	_prefetchQueued.clear();
+}
+
+PagedVolume::PagingStats PagedVolume::pagingStats() const {
+	PagingStats stats;
+	stats.queueDepth = _prefetchQueue.size();
+	stats.pageIns = (uint32_t)(int)_pageIns;
+	stats.pageInMillis = (uint32_t)(int)_pageInMillis;
+	stats.maxPageInMillis = (uint32_t)(int)_maxPageInMillis;
+	return stats;
+}
+
 PagedVolume::ChunkPtr PagedVolume::chunk(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const {
 	core_trace_scoped(PagedVolumeChunk);
-	core::ScopedWriteLock chunkWriteLock(_volumeLock);
 	const glm::ivec3 pos(chunkX, chunkY, chunkZ);
-	auto i = _chunks.find(pos);
-	if (i == _chunks.end()) {
-		const ChunkPtr& chunk = createNewChunk(chunkX, chunkY, chunkZ);
-		_chunks.put(pos, chunk);
-		const size_t chunkCount = _chunks.size();
-		if (chunkCount >= _chunkCountLimit) {
-			deleteOldestChunkIfNeeded();
+	{
+		const ChunkPtr& chunk = residentChunk(pos);
+		if (chunk) {
+			return chunk;
 		}
-		return chunk;
 	}
-	const ChunkPtr& chunk = i->second;
-	chunk->_chunkLastAccessed = ++_timestamper;
+	if (!_pager->concurrentPageIn()) {
+		core::ScopedLock pagerLock(_pagerLock);
+		return pageInChunk(pos);
+	}
+	return pageInChunk(pos);
+}
+
+bool PagedVolume::beginPageIn(const glm::ivec3& pos) const {
+	core::ScopedLock pageInLock(_pageInLock);
+	if (!_pagingIn.hasKey(pos)) {
+		growIfFull(_pagingIn);
+		_pagingIn.put(pos, true);
+		return true;
+	}
+	_pageInCondition.wait(_pageInLock);
+	return false;
+}
+
+void PagedVolume::endPageIn(const glm::ivec3& pos) const {
+	{
+		core::ScopedLock pageInLock(_pageInLock);
+		_pagingIn.remove(pos);
+	}
+	_pageInCondition.notify_all();
+}
+
+/**
+ * Only one thread pages in a particular chunk - the other threads that need the same chunk wait for it. The pager
+ * is not called with any of the locks held - it might need other chunks.
+ */
+PagedVolume::ChunkPtr PagedVolume::pageInChunk(const glm::ivec3& pos) const {
+	for (;;) {
+		if (beginPageIn(pos)) {
+			break;
+		}
+		const ChunkPtr& chunk = residentChunk(pos);
+		if (chunk) {
+			return chunk;
+		}
+	}
+	{
+		// another thread might have paged in the chunk before we marked it
+		const ChunkPtr& chunk = residentChunk(pos);
+		if (chunk) {
+			endPageIn(pos);
+			return chunk;
+		}
+	}
+	const ChunkPtr& chunk = createNewChunk(pos.x, pos.y, pos.z);
+	{
+		ChunkShard& s = shard(pos.x, pos.y, pos.z);
+		core::ScopedWriteLock writeLock(s.lock);
+		// a chunk that is handed out without being indexed would be paged in a second time
+		if (s.chunks.size() >= s.chunks.capacity()) {
+			Log::debug("chunk shard is full - grow it to %i chunks", (int)s.chunks.capacity() * 2);
+			growIfFull(s.chunks);
+		}
+		s.chunks.put(pos, chunk);
+	}
+	endPageIn(pos);
+	chunk->trackMemoryUsage(&_memoryUsage);
+	{
+		core::ScopedLock lock(_lruLock);
+		lruLinkFront(chunk.get());
+		++_chunkCount;
+	}
+	deleteOldestChunkIfNeeded(chunk.get());
 	return chunk;
 }
 
@@ -7,12 +7,22 @@
 #include "Voxel.h"
 #include "Region.h"
 #include "core/NonCopyable.h"
+#include "core/Common.h"
 #include "core/GLM.h"
 #include "core/Assert.h"
-#include "core/concurrent/ReadWriteLock.h"
+#include "core/concurrent/SharedLock.h"
+#include "core/concurrent/Lock.h"
+#include "core/concurrent/ConditionVariable.h"
 #include "core/concurrent/Atomic.h"
 #include "core/collection/Map.h"
+#include "core/collection/ConcurrentPriorityQueue.h"
 #include "core/SharedPtr.h"
+#include "core/Trace.h"
+#include <atomic>
+
+namespace core {
+class ThreadPool;
+}
 
 namespace voxel {
 
@@ -36,6 +46,7 @@ public:
 	class Chunk;
 	/// The Pager class is responsible for the loading and unloading of Chunks, and can be subclassed by the user.
 	class Pager;
+	class Sampler;
 
 	class Chunk {
 		friend class PagedVolume;
@@ -46,7 +57,10 @@ public:
 		~Chunk();
 
 		bool setData(const Voxel* voxels, size_t sizeInBytes);
-		Voxel* data() const;
+		/**
+		 * @note This converts the chunk into the dense representation
+		 */
+		Voxel* data();
 		uint32_t dataSizeInBytes() const;
 		uint32_t voxels() const;
 
@@ -61,13 +75,85 @@ public:
 		const glm::ivec3& chunkPos() const;
 		int16_t sideLength() const;
 
+		/**
+		 * @brief Run length encodes the voxels of the chunk into the given buffer
+		 * @return The amount of bytes written - or @c 0 if the buffer is too small
+		 */
+		uint32_t compress(uint8_t* buf, uint32_t bufSize) const;
+		/**
+		 * @brief Restores the voxels from the data that was encoded by @c compress()
+		 */
+		bool decompress(const uint8_t* buf, uint32_t bufSize);
+
+		/**
+		 * @brief Converts the dense voxel data into a uniform or palette representation if the chunk
+		 * doesn't contain more than @c MaxPaletteEntries different voxels.
+		 * @note Any write access to the chunk will transparently convert it back to the dense representation.
+		 * @return @c true if the dense data could be released
+		 */
+		bool compact();
+		/**
+		 * @return @c true if every voxel in the chunk is the same
+		 */
+		bool isUniform() const;
+		/**
+		 * @return The amount of bytes that are allocated for the voxels of this chunk in its current representation
+		 */
+		uint32_t memoryUsageInBytes() const;
+
+		static constexpr int MaxPaletteEntries = 16;
+
 	private:
+		friend class Sampler;
+
+		enum class Storage : uint8_t {
+			// every voxel is stored in _data
+			Dense,
+			// the whole chunk consists of _palette[0]
+			Uniform,
+			// bit packed indices into _palette
+			Palette
+		};
+
+		// ensure that the dense voxel data is available - this is done before each write access
+		void promoteToDense();
+		// the storage type is published after the data for it is available - readers don't take the lock
+		inline Storage storage() const {
+			return _storage.load(std::memory_order_acquire);
+		}
+		/**
+		 * @brief Moves the memory accounting of this chunk to the given counter
+		 * @param memoryUsage The counter of the volume - or @c nullptr if the chunk is no longer resident
+		 */
+		void trackMemoryUsage(std::atomic<int64_t>* memoryUsage);
+		void updateMemoryUsage() core_thread_requires(_storageLock);
+		const Voxel& voxelByIndex(uint32_t index) const;
+		const Voxel& paletteVoxel(uint32_t index) const;
+
 		// This is updated by the PagedVolume and used to discard the least recently used chunks.
-		uint32_t _chunkLastAccessed = 0u;
+		// It's atomic because chunk hits only hold the shard read lock.
+		core::AtomicInt _chunkLastAccessed { 0 };
+		// The value of _chunkLastAccessed at the time the chunk was (re-)linked into the lru list.
+		int32_t _lruStamp = 0;
+		// Intrusive lru list - guarded by PagedVolume::_lruLock
+		Chunk* _lruPrev = nullptr;
+		Chunk* _lruNext = nullptr;
 
 		static uint32_t calculateSizeInBytes(uint32_t sideLength);
 
 		Voxel* _data = nullptr;
+		// The palette and the indices are kept alive until the chunk is destroyed after the chunk was
+		// promoted to dense storage - a sampler might still reference them.
+		Voxel _palette[MaxPaletteEntries];
+		uint8_t* _paletteIndices = nullptr;
+		uint8_t _paletteEntries = 0u;
+		uint8_t _bitsPerIndex = 0u;
+		std::atomic<Storage> _storage { Storage::Uniform };
+		// serializes the promotion to the dense storage and the memory accounting
+		core_trace_mutex(core::Lock, _storageLock, "PagedVolumeChunk");
+		std::atomic<int64_t>* _memoryUsage core_thread_guarded_by(_storageLock) = nullptr;
+		// the bytes of this chunk that are added to _memoryUsage
+		uint32_t _accountedBytes core_thread_guarded_by(_storageLock) = 0u;
 		uint16_t _sideLength = 0u;
 
 		// This is so we can tell whether a uncompressed chunk has to be recompressed and whether
@@ -107,6 +193,14 @@ public:
 		 */
 		virtual bool pageIn(PagerContext& ctx) = 0;
 		virtual void pageOut(Chunk* chunk) = 0;
+
+		/**
+		 * @return @c true if @c pageIn() can be called for different chunks at the same time. Such a pager must not
+		 * request other chunks from the volume in @c pageIn(). Otherwise the page ins are serialized.
+		 */
+		virtual bool concurrentPageIn() const {
+			return false;
+		}
 	};
 
 	typedef core::SharedPtr<Pager> PagerPtr;
@@ -191,6 +285,14 @@ public:
 		const Voxel& peekVoxel1px1py1pz() const;
 
 	protected:
+		/**
+		 * @brief Resolves the voxel pointer and the delta tables of the current chunk for the current position in the chunk
+		 * @note Uniform chunks are walked with zero deltas - every move and peek inside such a chunk is the same voxel
+		 */
+		void updateCurrentVoxel();
+		const Voxel& peekVoxel(int32_t offset) const;
+		void moveCurrentVoxel(int32_t offset);
+
 		const PagedVolume* _volume;
 
 		//The current position in the volume
@@ -200,6 +302,13 @@ public:
 
 		//Other current position information
 		Voxel* _currentVoxel = nullptr;
+		// morton index of the current position - only maintained for palette chunks
+		uint32_t _currentIndex = 0u;
+		// set if the current chunk stores its voxels as palette indices
+		const Chunk* _paletteChunk = nullptr;
+		const int32_t* _deltaX = nullptr;
+		const int32_t* _deltaY = nullptr;
+		const int32_t* _deltaZ = nullptr;
 		ChunkPtr _currentChunk;
 		mutable ChunkPtr _cachedChunk;
 
@@ -216,7 +325,7 @@ public:
 
 public:
 	/** @brief Constructor for creating a fixed size volume. */
-	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32);
+	PagedVolume(Pager* pager, uint32_t targetMemoryUsageInBytes = 256 * 1024 * 1024, uint16_t chunkSideLength = 32, uint32_t compressedMemoryUsageInBytes = 0u);
 	~PagedVolume();
 
 	/** @brief Gets a voxel at the position given by <tt>x,y,z</tt> coordinates */
@@ -239,6 +348,44 @@ public:
 
 	ChunkPtr chunk(const glm::ivec3& pos) const;
 
+	/**
+	 * @brief Queues the chunks that intersect the given region for the asynchronous page in. The priority of
+	 * each chunk is the squared distance of its center to the given reference position.
+	 * @note Chunks that are already resident are skipped. Chunks that are already queued are only queued again if
+	 * the new priority is at least twice as high.
+	 */
+	void prefetch(const Region& region, const glm::ivec3& referencePos) const;
+
+	/**
+	 * @brief Starts worker threads that page in the chunks that were queued by @c prefetch()
+	 * @note The workers only page in different chunks at the same time if the pager supports it. See
+	 * @c Pager::concurrentPageIn()
+	 */
+	void startAsyncPaging(int threads);
+	/**
+	 * @brief Stops the worker threads and drops all chunks that are not yet paged in
+	 * @note Must be called before the pager is shut down
+	 */
+	void stopAsyncPaging();
+
+	struct PagingStats {
+		// amount of chunks that are waiting for the asynchronous page in
+		uint32_t queueDepth = 0u;
+		// amount of chunks that were handed over to the pager
+		uint32_t pageIns = 0u;
+		// accumulated time the pager needed for the page in
+		uint32_t pageInMillis = 0u;
+		// the longest page in
+		uint32_t maxPageInMillis = 0u;
+	};
+	PagingStats pagingStats() const;
+
+	/**
+	 * @return @c true if all chunks that intersect the given region are uniform chunks of the same material.
+	 * There can't be any faces for such a region - the mesh extraction can be skipped entirely.
+	 */
+	bool isUniform(const Region& region) const;
+
 	glm::ivec3 chunkPos(int x, int y, int z) const;
 
 	inline glm::ivec3 chunkPos(const glm::ivec3& worldPos) const {
@@ -249,6 +396,19 @@ public:
 		return _chunkSideLength;
 	}
 
+	/**
+	 * @return The amount of memory in bytes that is used by the resident chunks in their current representation
+	 */
+	uint64_t memoryUsage() const;
+	/**
+	 * @return The amount of chunks that are kept compressed in memory
+	 */
+	uint32_t compressedChunks() const;
+	/**
+	 * @return The amount of memory in bytes that is used by the compressed chunks
+	 */
+	uint32_t compressedMemoryUsage() const;
+
 protected:
 	/// Copy constructor
 	PagedVolume(const PagedVolume& rhs);
@@ -258,15 +418,127 @@ protected:
 
 private:
 	ChunkPtr chunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
+	ChunkPtr pageInChunk(const glm::ivec3& pos) const;
 	ChunkPtr createNewChunk(int32_t uChunkX, int32_t uChunkY, int32_t uChunkZ) const;
-	void deleteOldestChunkIfNeeded() const;
+	/**
+	 * @brief Marks the chunk as being paged in (or out) by the calling thread
+	 * @return @c false if another thread is already paging the chunk - the call waits for any page in to finish
+	 * in this case and the caller has to look up the chunk again.
+	 * @sa endPageIn()
+	 */
+	bool beginPageIn(const glm::ivec3& pos) const;
+	void endPageIn(const glm::ivec3& pos) const;
+	// only returns resident chunks - the pager is not called
+	ChunkPtr residentChunk(const glm::ivec3& chunkPos) const;
+	void deleteOldestChunkIfNeeded(const Chunk* keep) const;
+	/**
+	 * @return @c false if the limits are not exceeded or there is no chunk left that can be evicted
+	 */
+	bool deleteOldestChunk(const Chunk* keep) const;
 
-	mutable int32_t _timestamper = 0;
+	typedef core::Map<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
+
+	/**
+	 * @brief The chunk index is split into several shards - each guarded by its own lock. A chunk hit only
+	 * takes the read lock of the shard the chunk lives in. Inserting and evicting chunks are the only
+	 * operations that need the write lock.
+	 */
+	struct ChunkShard {
+		ChunkShard(int maxChunks) : chunks(maxChunks) {
+		}
+		core::SharedLock lock;
+		ChunkMap chunks core_thread_guarded_by(lock);
+	};
+	static constexpr int ChunkShards = 16;
+	ChunkShard& shard(int32_t chunkX, int32_t chunkY, int32_t chunkZ) const;
+
+	void lruLinkFront(Chunk* chunk) const;
+	void lruUnlink(Chunk* chunk) const;
+
+	/**
+	 * @brief Evicted chunks are kept run length encoded in memory until the compressed
+	 * memory budget is exceeded. Only then the pager is asked to page them out. This
+	 * is the second residency tier between the uncompressed chunks and the pager.
+	 */
+	struct CompressedChunk {
+		glm::ivec3 pos;
+		uint8_t* data = nullptr;
+		uint32_t size = 0u;
+		// the encoding didn't save any memory - the data is stored as is
+		bool raw = false;
+		bool dataModified = false;
+		CompressedChunk* lruPrev = nullptr;
+		CompressedChunk* lruNext = nullptr;
+	};
+	typedef core::Map<glm::ivec3, CompressedChunk*, 64, glm::hash<glm::ivec3>> CompressedChunkMap;
 
+	void compressChunk(const ChunkPtr& chunk) const;
+	bool decompressChunk(const ChunkPtr& chunk) const;
+	void deleteOldestCompressedChunkIfNeeded() const;
+	void pageOutCompressedChunk(CompressedChunk* compressedChunk) const;
+	void freeCompressedChunk(CompressedChunk* compressedChunk) const;
+
+	struct PrefetchRequest {
+		glm::ivec3 chunkPos;
+		int priority;
+	};
+	struct PrefetchRequestComparator {
+		inline bool operator()(const PrefetchRequest& lhs, const PrefetchRequest& rhs) const {
+			return lhs.priority > rhs.priority;
+		}
+	};
+	void queuePrefetch(const glm::ivec3& chunkPos, int priority) const;
+	void prefetchWorker();
+
+	mutable core::ConcurrentPriorityQueue<PrefetchRequest, PrefetchRequestComparator> _prefetchQueue;
+	// fast lookup for chunks that are already queued - also limits the size of the queue. The value is the
+	// priority of the latest request - older requests for the same chunk are skipped.
+	typedef core::Map<glm::ivec3, int, 64, glm::hash<glm::ivec3>> PrefetchMap;
+	mutable core_trace_mutex(core::Lock, _prefetchLock, "PagedVolumePrefetch");
+	mutable PrefetchMap _prefetchQueued core_thread_guarded_by(_prefetchLock);
+	core::ThreadPool* _prefetchPool = nullptr;
+	mutable core::AtomicInt _pageIns { 0 };
+	mutable core::AtomicInt _pageInMillis { 0 };
+	mutable core::AtomicInt _maxPageInMillis { 0 };
+
+	mutable core::AtomicInt _timestamper { 0 };
+
+	// the resident chunks are limited by the memory they need in their current representation
+	uint64_t _memoryLimit = 0u;
+	mutable std::atomic<int64_t> _memoryUsage { 0 };
+	// uniform chunks need almost no memory - this limits the amount of chunks that are kept anyway
 	uint32_t _chunkCountLimit = 0u;
 
-	typedef core::Map<glm::ivec3, ChunkPtr, 64, glm::hash<glm::ivec3>> ChunkMap;
-	mutable ChunkMap _chunks core_thread_guarded_by(_volumeLock);
+	// allocated in the constructor - the size of the maps depends on the chunk limit
+	ChunkShard* _shards[ChunkShards];
+
+	// Serializes the page in of new chunks if the pager doesn't support concurrent page ins - the pager might
+	// recursively request other chunks, so this must be reentrant.
+	mutable core_trace_mutex(core::Lock, _pagerLock, "PagedVolumePager");
+	// Guards the chunks that are currently paged in or evicted and the compressed chunks. This is never held while
+	// calling the pager for a page in.
+	mutable core_trace_mutex(core::Lock, _pageInLock, "PagedVolumePageIn");
+	mutable core::ConditionVariable _pageInCondition;
+	typedef core::Map<glm::ivec3, bool, 64, glm::hash<glm::ivec3>> PageInMap;
+	mutable PageInMap _pagingIn core_thread_guarded_by(_pageInLock) {1024};
+	// Guards the intrusive lru list and the chunk counter
+	mutable core_trace_mutex(core::Lock, _lruLock, "PagedVolumeLru");
+	// Most recently linked chunk
+	mutable Chunk* _lruHead core_thread_guarded_by(_lruLock) = nullptr;
+	// Eviction candidate
+	mutable Chunk* _lruTail core_thread_guarded_by(_lruLock) = nullptr;
+	mutable uint32_t _chunkCount core_thread_guarded_by(_lruLock) = 0u;
+
+	// the compressed chunks are only touched by the page in and the eviction of chunks
+	mutable CompressedChunkMap _compressedChunks core_thread_guarded_by(_pageInLock);
+	// Most recently compressed chunk
+	mutable CompressedChunk* _compressedHead core_thread_guarded_by(_pageInLock) = nullptr;
+	// Eviction candidate
+	mutable CompressedChunk* _compressedTail core_thread_guarded_by(_pageInLock) = nullptr;
+	mutable uint32_t _compressedMemoryUsage core_thread_guarded_by(_pageInLock) = 0u;
+	// scratch buffer for the compression - a chunk is never encoded to more than its uncompressed size
+	mutable uint8_t* _compressBuffer core_thread_guarded_by(_pageInLock) = nullptr;
+	uint32_t _compressedMemoryLimit = 0u;
 
 	// The size of the chunks
 	uint16_t _chunkSideLength;
@@ -276,8 +548,6 @@ private:
 	Pager* _pager = nullptr;
 
 	Region _region;
-
-	mutable core::ReadWriteLock _volumeLock{"pagedvolume"};
 };
 
 inline const Voxel& PagedVolume::Sampler::voxel() const {
@@ -313,6 +583,8 @@ static const int32_t deltaZ[256] = { 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 22
 		220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 898780, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4,
 		14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 112348, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 220, 4, 28, 4, 14044, 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28,
 		4, 220, 4, 28, 4 };
+// Used for uniform chunks - there is no need to move the voxel pointer as every voxel in the chunk is the same
+static const int32_t deltaNone[256] = { 0 };
 
 #define CAN_GO_NEG_X(val) ((val) > 0)
 #define CAN_GO_POS_X(val)  ((val) < this->_chunkSideLengthMinusOne)
@@ -321,100 +593,137 @@ static const int32_t deltaZ[256] = { 4, 28, 4, 220, 4, 28, 4, 1756, 4, 28, 4, 22
 #define CAN_GO_NEG_Z(val) ((val) > 0)
 #define CAN_GO_POS_Z(val)  ((val) < this->_chunkSideLengthMinusOne)
 
-#define NEG_X_DELTA (-(deltaX[this->_xPosInChunk-1]))
-#define POS_X_DELTA (deltaX[this->_xPosInChunk])
-#define NEG_Y_DELTA (-(deltaY[this->_yPosInChunk-1]))
-#define POS_Y_DELTA (deltaY[this->_yPosInChunk])
-#define NEG_Z_DELTA (-(deltaZ[this->_zPosInChunk-1]))
-#define POS_Z_DELTA (deltaZ[this->_zPosInChunk])
+#define NEG_X_DELTA (-(this->_deltaX[this->_xPosInChunk-1]))
+#define POS_X_DELTA (this->_deltaX[this->_xPosInChunk])
+#define NEG_Y_DELTA (-(this->_deltaY[this->_yPosInChunk-1]))
+#define POS_Y_DELTA (this->_deltaY[this->_yPosInChunk])
+#define NEG_Z_DELTA (-(this->_deltaZ[this->_zPosInChunk-1]))
+#define POS_Z_DELTA (this->_deltaZ[this->_zPosInChunk])
+
+inline const Voxel& PagedVolume::Chunk::paletteVoxel(uint32_t index) const {
+	const uint32_t bitOffset = index * _bitsPerIndex;
+	const uint32_t paletteIndex = (_paletteIndices[bitOffset >> 3] >> (bitOffset & 7u)) & ((1u << _bitsPerIndex) - 1u);
+	return _palette[paletteIndex];
+}
+
+inline const Voxel& PagedVolume::Chunk::voxelByIndex(uint32_t index) const {
+	const Storage storageType = storage();
+	if (core_likely(storageType == Storage::Dense)) {
+		return _data[index];
+	}
+	if (storageType == Storage::Uniform) {
+		return _palette[0];
+	}
+	return paletteVoxel(index);
+}
+
+inline bool PagedVolume::Chunk::isUniform() const {
+	return storage() == Storage::Uniform;
+}
+
+inline const Voxel& PagedVolume::Sampler::peekVoxel(int32_t offset) const {
+	if (core_unlikely(_paletteChunk != nullptr)) {
+		return _paletteChunk->paletteVoxel(_currentIndex + offset);
+	}
+	return *(_currentVoxel + offset);
+}
+
+inline void PagedVolume::Sampler::moveCurrentVoxel(int32_t offset) {
+	if (core_unlikely(_paletteChunk != nullptr)) {
+		_currentIndex += offset;
+		_currentVoxel = const_cast<Voxel*>(&_paletteChunk->paletteVoxel(_currentIndex));
+		return;
+	}
+	_currentVoxel += offset;
+}
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + NEG_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1ny1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA);
+		return this->peekVoxel(NEG_X_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx0py1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py1nz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py0pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + POS_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1nx1py1pz() const {
 	if (CAN_GO_NEG_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(NEG_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume - 1, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny1nz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny0pz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA);
+		return this->peekVoxel(NEG_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1ny1pz() const {
 	if (CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py1nz() const {
 	if (CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + NEG_Z_DELTA);
+		return this->peekVoxel(NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
@@ -425,91 +734,91 @@ inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py0pz() const {
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px0py1pz() const {
 	if (CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Z_DELTA);
+		return this->peekVoxel(POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py1nz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py0pz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA);
+		return this->peekVoxel(POS_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel0px1py1pz() const {
 	if (CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + NEG_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA);
+		return this->peekVoxel(POS_X_DELTA + NEG_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1ny1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + NEG_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume - 1, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA);
+		return this->peekVoxel(POS_X_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px0py1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume, this->_zPosInVolume + 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py1nz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_NEG_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + POS_Y_DELTA + NEG_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume - 1);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py0pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA);
+		return this->peekVoxel(POS_X_DELTA + POS_Y_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume);
 }
 
 inline const Voxel& PagedVolume::Sampler::peekVoxel1px1py1pz() const {
 	if (CAN_GO_POS_X(this->_xPosInChunk) && CAN_GO_POS_Y(this->_yPosInChunk) && CAN_GO_POS_Z(this->_zPosInChunk)) {
-		return *(_currentVoxel + POS_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
+		return this->peekVoxel(POS_X_DELTA + POS_Y_DELTA + POS_Z_DELTA);
 	}
 	return this->voxelAt(this->_xPosInVolume + 1, this->_yPosInVolume + 1, this->_zPosInVolume + 1);
 }
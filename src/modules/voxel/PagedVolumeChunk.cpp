@@ -7,6 +7,7 @@
 #include "math/Functions.h"
 #include "core/Common.h"
 #include "core/StandardLib.h"
+#include "core/Trace.h"
 
 namespace voxel {
 
@@ -19,31 +20,173 @@ PagedVolume::Chunk::Chunk(const glm::ivec3& pos, uint16_t sideLength, Pager* pag
 	_sideLength = sideLength;
 	_sideLengthPower = math::logBase2(sideLength);
 
-	// Allocate the data
-	const uint32_t uNoOfVoxels = _sideLength * _sideLength * _sideLength;
-	_data = (Voxel*)core_malloc(uNoOfVoxels * sizeof(Voxel));
-	core_memset(_data, 0, uNoOfVoxels * sizeof(Voxel));
+	// The chunk starts as uniform air - the dense data is only allocated on the first write
+	_palette[0] = Voxel();
 }
 
 PagedVolume::Chunk::~Chunk() {
 	if (_dataModified && _pager) {
 		_pager->pageOut(this);
 	}
+	trackMemoryUsage(nullptr);
 
 	core_free(_data);
 	_data = nullptr;
+	core_free(_paletteIndices);
+	_paletteIndices = nullptr;
+}
+
+void PagedVolume::Chunk::promoteToDense() {
+	if (core_likely(storage() == Storage::Dense)) {
+		return;
+	}
+	core_trace_scoped(PromoteChunkToDense);
+	core::ScopedLock lock(_storageLock);
+	// another writer might have promoted the chunk while we were waiting
+	const Storage storageType = _storage.load(std::memory_order_relaxed);
+	if (storageType == Storage::Dense) {
+		return;
+	}
+	const uint32_t n = voxels();
+	if (_data == nullptr) {
+		_data = (Voxel*)core_malloc(n * sizeof(Voxel));
+	}
+	if (storageType == Storage::Uniform) {
+		for (uint32_t i = 0u; i < n; ++i) {
+			_data[i] = _palette[0];
+		}
+	} else {
+		for (uint32_t i = 0u; i < n; ++i) {
+			_data[i] = paletteVoxel(i);
+		}
+	}
+	// readers that see the old storage type still get valid voxels from the palette - the ones that
+	// see the new storage type also see the filled dense data
+	_storage.store(Storage::Dense, std::memory_order_release);
+	updateMemoryUsage();
+}
+
+void PagedVolume::Chunk::trackMemoryUsage(std::atomic<int64_t>* memoryUsage) {
+	core::ScopedLock lock(_storageLock);
+	if (_memoryUsage != nullptr) {
+		_memoryUsage->fetch_sub(_accountedBytes);
+	}
+	_memoryUsage = memoryUsage;
+	_accountedBytes = 0u;
+	updateMemoryUsage();
+}
+
+void PagedVolume::Chunk::updateMemoryUsage() {
+	if (_memoryUsage == nullptr) {
+		return;
+	}
+	// the palette indices are kept alive after the promotion to the dense storage
+	uint32_t bytes = (uint32_t)sizeof(*this) + memoryUsageInBytes();
+	if (_paletteIndices != nullptr && storage() == Storage::Dense) {
+		bytes += voxels() * _bitsPerIndex / 8u;
+	}
+	_memoryUsage->fetch_add((int64_t)bytes - (int64_t)_accountedBytes);
+	_accountedBytes = bytes;
+}
+
+bool PagedVolume::Chunk::compact() {
+	if (storage() != Storage::Dense) {
+		return true;
+	}
+	core_trace_scoped(CompactChunk);
+	const uint32_t n = voxels();
+	Voxel palette[MaxPaletteEntries];
+	int entries = 0;
+	int last = 0;
+	for (uint32_t i = 0u; i < n; ++i) {
+		const Voxel& v = _data[i];
+		if (entries > 0 && palette[last].isSame(v)) {
+			continue;
+		}
+		int idx = 0;
+		for (; idx < entries; ++idx) {
+			if (palette[idx].isSame(v)) {
+				break;
+			}
+		}
+		if (idx == entries) {
+			if (entries == MaxPaletteEntries) {
+				return false;
+			}
+			palette[entries++] = v;
+		}
+		last = idx;
+	}
+
+	for (int i = 0; i < entries; ++i) {
+		_palette[i] = palette[i];
+	}
+	_paletteEntries = (uint8_t)entries;
+	if (entries == 1) {
+		_storage.store(Storage::Uniform, std::memory_order_release);
+	} else {
+		if (entries <= 2) {
+			_bitsPerIndex = 1u;
+		} else if (entries <= 4) {
+			_bitsPerIndex = 2u;
+		} else {
+			_bitsPerIndex = 4u;
+		}
+		const uint32_t indexBytes = n * _bitsPerIndex / 8u;
+		// the chunk is not yet handed out when it gets compacted - so a previous palette can't be referenced by a sampler
+		uint8_t* indices = (uint8_t*)core_malloc(indexBytes);
+		core_memset(indices, 0, indexBytes);
+		int idx = 0;
+		for (uint32_t i = 0u; i < n; ++i) {
+			const Voxel& v = _data[i];
+			if (!_palette[idx].isSame(v)) {
+				for (idx = 0; idx < entries; ++idx) {
+					if (_palette[idx].isSame(v)) {
+						break;
+					}
+				}
+			}
+			const uint32_t bitOffset = i * _bitsPerIndex;
+			indices[bitOffset >> 3] |= (uint8_t)(idx << (bitOffset & 7u));
+		}
+		core_free(_paletteIndices);
+		_paletteIndices = indices;
+		_storage.store(Storage::Palette, std::memory_order_release);
+	}
+	core_free(_data);
+	_data = nullptr;
+	return true;
+}
+
+uint32_t PagedVolume::Chunk::memoryUsageInBytes() const {
+	switch (storage()) {
+	case Storage::Dense:
+		return dataSizeInBytes();
+	case Storage::Palette:
+		return voxels() * _bitsPerIndex / 8u;
+	case Storage::Uniform:
+		break;
+	}
+	return 0u;
 }
 
 bool PagedVolume::Chunk::setData(const Voxel* voxels, size_t sizeInBytes) {
 	if (sizeInBytes != dataSizeInBytes()) {
 		return false;
 	}
+	core::ScopedLock lock(_storageLock);
+	if (_data == nullptr) {
+		_data = (Voxel*)core_malloc(sizeInBytes);
+	}
 	_dataModified = true;
 	core_memcpy((uint8_t*)_data, (const uint8_t*)voxels, sizeInBytes);
+	_storage.store(Storage::Dense, std::memory_order_release);
+	updateMemoryUsage();
 	return true;
 }
 
-Voxel* PagedVolume::Chunk::data() const {
+Voxel* PagedVolume::Chunk::data() {
+	promoteToDense();
 	return _data;
 }
 
@@ -61,10 +204,9 @@ const Voxel& PagedVolume::Chunk::voxel(uint32_t x, uint32_t y, uint32_t z) const
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", x, _sideLength);
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", y, _sideLength);
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk. asserted %u > %u", z, _sideLength);
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
-	return _data[index];
+	return voxelByIndex(index);
 }
 
 const Voxel& PagedVolume::Chunk::voxel(const glm::i16vec3& pos) const {
@@ -77,8 +219,12 @@ void PagedVolume::Chunk::setVoxel(uint32_t x, uint32_t y, uint32_t z, const Voxe
 	core_assert_msg(x < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
+	if (storage() == Storage::Uniform && _palette[0].isSame(value)) {
+		_dataModified = true;
+		return;
+	}
+	promoteToDense();
 	const uint32_t index = morton256_x[x] | morton256_y[y] | morton256_z[z];
 	_data[index] = value;
 	_dataModified = true;
@@ -95,8 +241,8 @@ void PagedVolume::Chunk::setVoxels(uint32_t x, uint32_t y, uint32_t z, const Vox
 	core_assert_msg(x < _sideLength, "Supplied x position is outside of the chunk");
 	core_assert_msg(y < _sideLength, "Supplied y position is outside of the chunk");
 	core_assert_msg(z < _sideLength, "Supplied z position is outside of the chunk");
-	core_assert_msg(_data, "No uncompressed data - chunk must be decompressed before accessing voxels.");
 
+	promoteToDense();
 	for (int i = y; i < amount; ++i) {
 		const uint32_t index = morton256_x[x] | morton256_y[i] | morton256_z[z];
 		_data[index] = values[i];
@@ -116,6 +262,52 @@ void PagedVolume::Chunk::setVoxel(const glm::i16vec3& pos, const Voxel& value) {
 	setVoxel(pos.x, pos.y, pos.z, value);
 }
 
+// each run is stored as 16 bit length followed by the voxel
+static constexpr uint32_t RunSize = sizeof(uint16_t) + sizeof(Voxel);
+
+uint32_t PagedVolume::Chunk::compress(uint8_t* buf, uint32_t bufSize) const {
+	const uint32_t n = voxels();
+	uint32_t offset = 0u;
+	uint32_t i = 0u;
+	while (i < n) {
+		const Voxel& v = voxelByIndex(i);
+		uint32_t run = 1u;
+		while (i + run < n && run < 0xFFFFu && voxelByIndex(i + run).isSame(v)) {
+			++run;
+		}
+		if (offset + RunSize > bufSize) {
+			return 0u;
+		}
+		buf[offset++] = (uint8_t)(run & 0xFFu);
+		buf[offset++] = (uint8_t)(run >> 8);
+		core_memcpy(&buf[offset], &v, sizeof(Voxel));
+		offset += sizeof(Voxel);
+		i += run;
+	}
+	return offset;
+}
+
+bool PagedVolume::Chunk::decompress(const uint8_t* buf, uint32_t bufSize) {
+	promoteToDense();
+	const uint32_t n = voxels();
+	uint32_t offset = 0u;
+	uint32_t i = 0u;
+	while (offset + RunSize <= bufSize) {
+		const uint32_t run = (uint32_t)buf[offset] | ((uint32_t)buf[offset + 1] << 8);
+		offset += sizeof(uint16_t);
+		Voxel v;
+		core_memcpy(&v, &buf[offset], sizeof(Voxel));
+		offset += sizeof(Voxel);
+		if (i + run > n) {
+			return false;
+		}
+		for (uint32_t j = 0u; j < run; ++j) {
+			_data[i++] = v;
+		}
+	}
+	return i == n && offset == bufSize;
+}
+
 uint32_t PagedVolume::Chunk::calculateSizeInBytes(uint32_t sideLength) {
 	// Note: We disregard the size of the other class members as they are likely to be very small compared to the size of the
 	// allocated voxel data. This also keeps the reported size as a power of two, which makes other memory calculations easier.
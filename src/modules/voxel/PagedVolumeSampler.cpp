@@ -16,19 +16,19 @@ namespace voxel {
 #define CAN_GO_NEG_Z(val) ((val) > 0)
 #define CAN_GO_POS_Z(val) ((val) < this->_chunkSideLengthMinusOne)
 
-#define NEG_X_DELTA (-(deltaX[this->_xPosInChunk-1]))
-#define POS_X_DELTA (deltaX[this->_xPosInChunk])
-#define NEG_Y_DELTA (-(deltaY[this->_yPosInChunk-1]))
-#define POS_Y_DELTA (deltaY[this->_yPosInChunk])
-#define NEG_Z_DELTA (-(deltaZ[this->_zPosInChunk-1]))
-#define POS_Z_DELTA (deltaZ[this->_zPosInChunk])
+#define NEG_X_DELTA (-(this->_deltaX[this->_xPosInChunk-1]))
+#define POS_X_DELTA (this->_deltaX[this->_xPosInChunk])
+#define NEG_Y_DELTA (-(this->_deltaY[this->_yPosInChunk-1]))
+#define POS_Y_DELTA (this->_deltaY[this->_yPosInChunk])
+#define NEG_Z_DELTA (-(this->_deltaZ[this->_zPosInChunk-1]))
+#define POS_Z_DELTA (this->_deltaZ[this->_zPosInChunk])
 
 PagedVolume::Sampler::Sampler(const PagedVolume* volume) :
-		_volume(volume), _chunkSideLengthMinusOne(volume->_chunkSideLength - 1) {
+		_volume(volume), _deltaX(deltaX), _deltaY(deltaY), _deltaZ(deltaZ), _chunkSideLengthMinusOne(volume->_chunkSideLength - 1) {
 }
 
 PagedVolume::Sampler::Sampler(const PagedVolume& volume) :
-		_volume(&volume), _chunkSideLengthMinusOne(volume._chunkSideLength - 1) {
+		_volume(&volume), _deltaX(deltaX), _deltaY(deltaY), _deltaZ(deltaZ), _chunkSideLengthMinusOne(volume._chunkSideLength - 1) {
 }
 
 PagedVolume::Sampler::~Sampler() {
@@ -41,6 +41,12 @@ const Voxel& PagedVolume::Sampler::voxelAt(int x, int y, int z) const {
 	const uint32_t xOffset = static_cast<uint32_t>(x & _volume->_chunkMask);
 	const uint32_t yOffset = static_cast<uint32_t>(y & _volume->_chunkMask);
 	const uint32_t zOffset = static_cast<uint32_t>(z & _volume->_chunkMask);
+	if (_currentChunk) {
+		const glm::ivec3& chunkPos = _currentChunk->chunkPos();
+		if (chunkPos.x == xChunk && chunkPos.y == yChunk && chunkPos.z == zChunk) {
+			return _currentChunk->voxel(xOffset, yOffset, zOffset);
+		}
+	}
 	if (_cachedChunk) {
 		const glm::ivec3& chunkPos = _cachedChunk->chunkPos();
 		if (chunkPos.x == xChunk && chunkPos.y == yChunk && chunkPos.z == zChunk) {
@@ -85,8 +91,33 @@ void PagedVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos)
 	_yPosInChunk = static_cast<uint32_t>(yPos & _volume->_chunkMask);
 	_zPosInChunk = static_cast<uint32_t>(zPos & _volume->_chunkMask);
 
-	const uint32_t voxelIndexInChunk = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
-	_currentVoxel = _currentChunk->_data + voxelIndexInChunk;
+	updateCurrentVoxel();
+}
+
+void PagedVolume::Sampler::updateCurrentVoxel() {
+	const Chunk* chunk = _currentChunk.get();
+	_currentIndex = morton256_x[_xPosInChunk] | morton256_y[_yPosInChunk] | morton256_z[_zPosInChunk];
+	switch (chunk->storage()) {
+	case Chunk::Storage::Uniform:
+		_paletteChunk = nullptr;
+		_deltaX = _deltaY = _deltaZ = deltaNone;
+		_currentVoxel = const_cast<Voxel*>(&chunk->_palette[0]);
+		break;
+	case Chunk::Storage::Palette:
+		_paletteChunk = chunk;
+		_deltaX = deltaX;
+		_deltaY = deltaY;
+		_deltaZ = deltaZ;
+		_currentVoxel = const_cast<Voxel*>(&chunk->paletteVoxel(_currentIndex));
+		break;
+	case Chunk::Storage::Dense:
+		_paletteChunk = nullptr;
+		_deltaX = deltaX;
+		_deltaY = deltaY;
+		_deltaZ = deltaZ;
+		_currentVoxel = chunk->_data + _currentIndex;
+		break;
+	}
 }
 
 bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
@@ -96,6 +127,12 @@ bool PagedVolume::Sampler::setVoxel(const Voxel& voxel) {
 	//Need to think what effect this has on any existing iterators.
 	//core_assert_msg(false, "This function cannot be used on PagedVolume samplers.");
 	//TODO: the region is not updated properly - but we might not need this for paged volumes.
+	if (_paletteChunk != nullptr || _deltaX == deltaNone || _currentChunk->storage() != Chunk::Storage::Dense) {
+		// the chunk must be promoted to dense storage first
+		_currentChunk->setVoxel(_xPosInChunk, _yPosInChunk, _zPosInChunk, voxel);
+		updateCurrentVoxel();
+		return true;
+	}
 	*_currentVoxel = voxel;
 	return true;
 }
@@ -106,7 +143,7 @@ void PagedVolume::Sampler::movePositiveX() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_X(_xPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_X_DELTA;
+		moveCurrentVoxel(POS_X_DELTA);
 		_xPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -120,7 +157,7 @@ void PagedVolume::Sampler::movePositiveY() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_Y(_yPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_Y_DELTA;
+		moveCurrentVoxel(POS_Y_DELTA);
 		_yPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -134,7 +171,7 @@ void PagedVolume::Sampler::movePositiveZ() {
 	// Then we update the voxel pointer
 	if (CAN_GO_POS_Z(_zPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += POS_Z_DELTA;
+		moveCurrentVoxel(POS_Z_DELTA);
 		_zPosInChunk++;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -148,7 +185,7 @@ void PagedVolume::Sampler::moveNegativeX() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_X(_xPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_X_DELTA;
+		moveCurrentVoxel(NEG_X_DELTA);
 		_xPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -162,7 +199,7 @@ void PagedVolume::Sampler::moveNegativeY() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_Y(_yPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_Y_DELTA;
+		moveCurrentVoxel(NEG_Y_DELTA);
 		_yPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -176,7 +213,7 @@ void PagedVolume::Sampler::moveNegativeZ() {
 	// Then we update the voxel pointer
 	if (CAN_GO_NEG_Z(_zPosInChunk)) {
 		//No need to compute new chunk.
-		_currentVoxel += NEG_Z_DELTA;
+		moveCurrentVoxel(NEG_Z_DELTA);
 		_zPosInChunk--;
 	} else {
 		//We've hit the chunk boundary. Just calling setPosition() is the easiest way to resolve this.
@@ -6,14 +6,11 @@
 #include "core/Assert.h"
 #include "core/StandardLib.h"
 #include <glm/common.hpp>
+#include <glm/vector_relational.hpp>
 #include <limits>
 
 namespace voxel {
 
-static const uint8_t SAMPLER_INVALIDX = 1 << 0;
-static const uint8_t SAMPLER_INVALIDY = 1 << 1;
-static const uint8_t SAMPLER_INVALIDZ = 1 << 2;
-
 RawVolume::RawVolume(const Region& regValid) :
 		_region(regValid), _mins((std::numeric_limits<int>::max)()), _maxs((std::numeric_limits<int>::min)()), _boundsValid(false) {
 	//Create a volume of the right size.
@@ -42,7 +39,73 @@ RawVolume::RawVolume(const RawVolume& copy) :
 	core_memcpy((void*)_data, (void*)copy._data, size);
 }
 
+RawVolume::RawVolume(const RawVolume& copy, const Region& region) :
+		_region(region), _mins((std::numeric_limits<int>::max)()), _maxs((std::numeric_limits<int>::min)()), _boundsValid(false) {
+	core_assert_msg(intersects(copy.region(), region), "The region doesn't intersect the volume");
+	_region.cropTo(copy.region());
+	setBorderValue(copy.borderValue());
+	const int32_t w = width();
+	const int32_t h = height();
+	const int32_t d = depth();
+	_data = (Voxel*)core_malloc(w * h * d * sizeof(Voxel));
+	// the voxels are stored in x rows - copy them row by row
+	const glm::ivec3& offset = _region.getLowerCorner() - copy.region().getLowerCorner();
+	const int32_t srcWidth = copy.width();
+	const int32_t srcHeight = copy.height();
+	for (int32_t z = 0; z < d; ++z) {
+		for (int32_t y = 0; y < h; ++y) {
+			const Voxel* src = copy._data + offset.x + (offset.y + y) * srcWidth + (offset.z + z) * srcWidth * srcHeight;
+			core_memcpy((void*)(_data + y * w + z * w * h), (const void*)src, w * sizeof(Voxel));
+		}
+	}
+	if (copy._boundsValid) {
+		const glm::ivec3 mins = (glm::max)(copy._mins, _region.getLowerCorner());
+		const glm::ivec3 maxs = (glm::min)(copy._maxs, _region.getUpperCorner());
+		if (glm::all(glm::lessThanEqual(mins, maxs))) {
+			_mins = mins;
+			_maxs = maxs;
+			_boundsValid = true;
+		}
+	}
+}
+
+bool RawVolume::copyInto(const RawVolume& source) {
+	core_assert(&source != this);
+	Region region = source.region();
+	if (!intersects(region, _region)) {
+		return false;
+	}
+	region.cropTo(_region);
+	const int32_t w = region.getWidthInVoxels();
+	const int32_t h = region.getHeightInVoxels();
+	const int32_t d = region.getDepthInVoxels();
+	const glm::ivec3& srcOffset = region.getLowerCorner() - source.region().getLowerCorner();
+	const glm::ivec3& dstOffset = region.getLowerCorner() - _region.getLowerCorner();
+	const int32_t srcWidth = source.width();
+	const int32_t srcHeight = source.height();
+	const int32_t dstWidth = width();
+	const int32_t dstHeight = height();
+	for (int32_t z = 0; z < d; ++z) {
+		for (int32_t y = 0; y < h; ++y) {
+			const Voxel* src = source._data + srcOffset.x + (srcOffset.y + y) * srcWidth + (srcOffset.z + z) * srcWidth * srcHeight;
+			Voxel* dst = _data + dstOffset.x + (dstOffset.y + y) * dstWidth + (dstOffset.z + z) * dstWidth * dstHeight;
+			core_memcpy((void*)dst, (const void*)src, w * sizeof(Voxel));
+		}
+	}
+	if (source._boundsValid) {
+		const glm::ivec3 mins = (glm::max)(source._mins, region.getLowerCorner());
+		const glm::ivec3 maxs = (glm::min)(source._maxs, region.getUpperCorner());
+		if (glm::all(glm::lessThanEqual(mins, maxs))) {
+			_mins = (glm::min)(_mins, mins);
+			_maxs = (glm::max)(_maxs, maxs);
+			_boundsValid = true;
+		}
+	}
+	return true;
+}
+
 RawVolume::RawVolume(RawVolume&& move) noexcept {
+	_borderVoxel = move._borderVoxel;
 	_data = move._data;
 	move._data = nullptr;
 	_mins = move._mins;
@@ -171,11 +234,14 @@ void RawVolume::clear() {
 }
 
 RawVolume::Sampler::Sampler(const RawVolume* volume) :
-		_volume(const_cast<RawVolume*>(volume)) {
+		_volume(const_cast<RawVolume*>(volume)), _data(_volume->_data), _strideY(volume->width()),
+		_strideZ(volume->width() * volume->height()), _lower(volume->region().getLowerCorner()),
+		_upper(volume->region().getUpperCorner()) {
+	setPosition(_lower);
 }
 
 RawVolume::Sampler::Sampler(const RawVolume& volume) :
-		_volume(const_cast<RawVolume*>(&volume)) {
+		Sampler(&volume) {
 }
 
 RawVolume::Sampler::~Sampler() {
@@ -185,169 +251,11 @@ bool RawVolume::Sampler::setVoxel(const Voxel& voxel) {
 	if (_currentPositionInvalid) {
 		return false;
 	}
-	*_currentVoxel = voxel;
+	_data[_currentIndex] = voxel;
 	_volume->_mins = (glm::min)(_volume->_mins, _posInVolume);
 	_volume->_maxs = (glm::max)(_volume->_maxs, _posInVolume);
 	_volume->_boundsValid = true;
 	return true;
 }
 
-bool RawVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos) {
-	_posInVolume.x = xPos;
-	_posInVolume.y = yPos;
-	_posInVolume.z = zPos;
-
-	const voxel::Region& region = _volume->region();
-	_currentPositionInvalid = 0u;
-	if (!region.containsPointInX(xPos)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDX;
-	}
-	if (!region.containsPointInY(yPos)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDY;
-	}
-	if (!region.containsPointInZ(zPos)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDZ;
-	}
-
-	// Then we update the voxel pointer
-	if (currentPositionValid()) {
-		const glm::ivec3& v3dLowerCorner = region.getLowerCorner();
-		const int32_t iLocalXPos = xPos - v3dLowerCorner.x;
-		const int32_t iLocalYPos = yPos - v3dLowerCorner.y;
-		const int32_t iLocalZPos = zPos - v3dLowerCorner.z;
-		const int32_t uVoxelIndex = iLocalXPos + iLocalYPos * _volume->width() + iLocalZPos * _volume->width() * _volume->height();
-
-		_currentVoxel = _volume->_data + uVoxelIndex;
-		return true;
-	}
-	_currentVoxel = nullptr;
-	return false;
-}
-
-void RawVolume::Sampler::movePositiveX() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	++_posInVolume.x;
-
-	if (!_volume->region().containsPointInX(_posInVolume.x)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDX;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDX;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		++_currentVoxel;
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
-void RawVolume::Sampler::movePositiveY() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	++_posInVolume.y;
-
-	if (!_volume->region().containsPointInY(_posInVolume.y)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDY;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDY;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel += _volume->width();
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
-void RawVolume::Sampler::movePositiveZ() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	_posInVolume.z++;
-
-	if (!_volume->region().containsPointInZ(_posInVolume.z)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDZ;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel += _volume->width() * _volume->height();
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
-void RawVolume::Sampler::moveNegativeX() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	--_posInVolume.x;
-
-	if (!_volume->region().containsPointInX(_posInVolume.x)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDX;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDX;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		--_currentVoxel;
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
-void RawVolume::Sampler::moveNegativeY() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	--_posInVolume.y;
-
-	if (!_volume->region().containsPointInY(_posInVolume.y)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDY;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDY;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel -= _volume->width();
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
-void RawVolume::Sampler::moveNegativeZ() {
-	const bool bIsOldPositionValid = currentPositionValid();
-
-	--_posInVolume.z;
-
-	if (!_volume->region().containsPointInZ(_posInVolume.z)) {
-		_currentPositionInvalid |= SAMPLER_INVALIDZ;
-	} else {
-		_currentPositionInvalid &= ~SAMPLER_INVALIDZ;
-	}
-
-	// Then we update the voxel pointer
-	if (!bIsOldPositionValid) {
-		setPosition(_posInVolume);
-	} else if (currentPositionValid()) {
-		_currentVoxel -= _volume->width() * _volume->height();
-	} else {
-		_currentVoxel = nullptr;
-	}
-}
-
 }
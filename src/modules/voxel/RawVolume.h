@@ -7,9 +7,14 @@
 #include "Voxel.h"
 #include "Region.h"
 #include <glm/vec3.hpp>
+#include <stdint.h>
 
 namespace voxel {
 
+static constexpr uint8_t SAMPLER_INVALIDX = 1 << 0;
+static constexpr uint8_t SAMPLER_INVALIDY = 1 << 1;
+static constexpr uint8_t SAMPLER_INVALIDZ = 1 << 2;
+
 /**
  * Simple volume implementation which stores data in a single large 3D array.
  *
@@ -18,6 +23,11 @@ namespace voxel {
  */
 class RawVolume {
 public:
+	/**
+	 * @brief Walks the voxels of the volume with precomputed strides. Moving the sampler is an index addition -
+	 * the border of the volume is only checked for the positions at the edges of the region.
+	 * @note The region of the volume is cached - don't translate the volume while a sampler is in use
+	 */
 	class Sampler {
 	public:
 		Sampler(const RawVolume& volume);
@@ -73,15 +83,32 @@ public:
 
 	protected:
 		RawVolume* _volume;
+		Voxel* _data;
+
+		// the index deltas to the neighbour voxel in y and z direction
+		const int32_t _strideY;
+		const int32_t _strideZ;
+		const glm::ivec3 _lower;
+		const glm::ivec3 _upper;
 
 		//The current position in the volume
 		glm::ivec3 _posInVolume { 0, 0, 0 };
 
-		/** Other current position information */
-		Voxel* _currentVoxel = nullptr;
+		/** The index of the current position - only valid if the position is inside the volume */
+		int32_t _currentIndex = 0;
 
 		/** Whether the current position is inside the volume */
 		uint8_t _currentPositionInvalid = 0u;
+		/**
+		 * The axes on which the position is not surrounded by voxels of the volume. The peeks can only
+		 * use the strides if this is @c 0 - otherwise they have to check the border of the volume.
+		 */
+		uint8_t _border = 0u;
+
+		void updateX();
+		void updateY();
+		void updateZ();
+		const Voxel& peek(int32_t offset, int32_t x, int32_t y, int32_t z) const;
 	};
 
 	RawVolume(const Voxel* data, const voxel::Region& region);
@@ -92,6 +119,11 @@ public:
 	RawVolume(const Region& region);
 	RawVolume(const RawVolume* copy);
 	RawVolume(const RawVolume& copy);
+	/**
+	 * @brief Only copies the voxels of the given region. The region is cropped to the region of the given volume.
+	 * @note The region must intersect the region of the given volume
+	 */
+	RawVolume(const RawVolume& copy, const Region& region);
 	RawVolume(RawVolume&& move) noexcept;
 
 	static RawVolume* createRaw(const Voxel* data, const voxel::Region& region) {
@@ -140,6 +172,12 @@ public:
 
 	void clear();
 
+	/**
+	 * @brief Copies the voxels of the given volume into this volume. Only the intersection of both regions is copied.
+	 * @return @c false if the regions don't intersect
+	 */
+	bool copyInto(const RawVolume& source);
+
 	inline const uint8_t* data() const {
 		return (const uint8_t*)_data;
 	}
@@ -234,252 +272,209 @@ inline const Voxel& RawVolume::voxel(const glm::ivec3& pos) const {
 	return voxel(pos.x, pos.y, pos.z);
 }
 
-#define CAN_GO_NEG_X(val) ((val) > region.getLowerX())
-#define CAN_GO_POS_X(val) ((val) < region.getUpperX())
-#define CAN_GO_NEG_Y(val) ((val) > region.getLowerY())
-#define CAN_GO_POS_Y(val) ((val) < region.getUpperY())
-#define CAN_GO_NEG_Z(val) ((val) > region.getLowerZ())
-#define CAN_GO_POS_Z(val) ((val) < region.getUpperZ())
-
 inline const glm::ivec3& RawVolume::Sampler::position() const {
 	return _posInVolume;
 }
 
-inline const Voxel& RawVolume::Sampler::voxel() const {
-	if (this->currentPositionValid()) {
-		return *_currentVoxel;
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z);
-}
-
 inline bool RawVolume::Sampler::currentPositionValid() const {
 	return !_currentPositionInvalid;
 }
 
+inline const Voxel& RawVolume::Sampler::voxel() const {
+	if (currentPositionValid()) {
+		return _data[_currentIndex];
+	}
+	return _volume->voxel(_posInVolume.x, _posInVolume.y, _posInVolume.z);
+}
+
 inline bool RawVolume::Sampler::setPosition(const glm::ivec3& v3dNewPos) {
 	return setPosition(v3dNewPos.x, v3dNewPos.y, v3dNewPos.z);
 }
 
-inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels() - region.stride());
+inline void RawVolume::Sampler::updateX() {
+	const uint32_t x = (uint32_t)(_posInVolume.x - _lower.x);
+	const uint32_t size = (uint32_t)(_upper.x - _lower.x);
+	_currentPositionInvalid = (_currentPositionInvalid & ~SAMPLER_INVALIDX) | (x > size ? SAMPLER_INVALIDX : 0u);
+	_border = (_border & ~SAMPLER_INVALIDX) | (x - 1u >= size - 1u ? SAMPLER_INVALIDX : 0u);
+}
+
+inline void RawVolume::Sampler::updateY() {
+	const uint32_t y = (uint32_t)(_posInVolume.y - _lower.y);
+	const uint32_t size = (uint32_t)(_upper.y - _lower.y);
+	_currentPositionInvalid = (_currentPositionInvalid & ~SAMPLER_INVALIDY) | (y > size ? SAMPLER_INVALIDY : 0u);
+	_border = (_border & ~SAMPLER_INVALIDY) | (y - 1u >= size - 1u ? SAMPLER_INVALIDY : 0u);
+}
+
+inline void RawVolume::Sampler::updateZ() {
+	const uint32_t z = (uint32_t)(_posInVolume.z - _lower.z);
+	const uint32_t size = (uint32_t)(_upper.z - _lower.z);
+	_currentPositionInvalid = (_currentPositionInvalid & ~SAMPLER_INVALIDZ) | (z > size ? SAMPLER_INVALIDZ : 0u);
+	_border = (_border & ~SAMPLER_INVALIDZ) | (z - 1u >= size - 1u ? SAMPLER_INVALIDZ : 0u);
+}
+
+inline bool RawVolume::Sampler::setPosition(int32_t xPos, int32_t yPos, int32_t zPos) {
+	_posInVolume.x = xPos;
+	_posInVolume.y = yPos;
+	_posInVolume.z = zPos;
+	_currentIndex = (xPos - _lower.x) + (yPos - _lower.y) * _strideY + (zPos - _lower.z) * _strideZ;
+	updateX();
+	updateY();
+	updateZ();
+	return currentPositionValid();
+}
+
+inline void RawVolume::Sampler::movePositiveX() {
+	++_posInVolume.x;
+	++_currentIndex;
+	updateX();
+}
+
+inline void RawVolume::Sampler::movePositiveY() {
+	++_posInVolume.y;
+	_currentIndex += _strideY;
+	updateY();
+}
+
+inline void RawVolume::Sampler::movePositiveZ() {
+	++_posInVolume.z;
+	_currentIndex += _strideZ;
+	updateZ();
+}
+
+inline void RawVolume::Sampler::moveNegativeX() {
+	--_posInVolume.x;
+	--_currentIndex;
+	updateX();
+}
+
+inline void RawVolume::Sampler::moveNegativeY() {
+	--_posInVolume.y;
+	_currentIndex -= _strideY;
+	updateY();
+}
+
+inline void RawVolume::Sampler::moveNegativeZ() {
+	--_posInVolume.z;
+	_currentIndex -= _strideZ;
+	updateZ();
+}
+
+/**
+ * @brief Only the positions that are at the border of the volume (or outside) have to be checked - all
+ * other positions can use the strides to get the neighbour
+ */
+inline const Voxel& RawVolume::Sampler::peek(int32_t offset, int32_t x, int32_t y, int32_t z) const {
+	if (_border == 0u) {
+		return _data[_currentIndex + offset];
 	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return _volume->voxel(_posInVolume.x + x, _posInVolume.y + y, _posInVolume.z + z);
+}
+
+inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1nz() const {
+	return peek(-1 - _strideY - _strideZ, -1, -1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(-1 - _strideY, -1, -1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1ny1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(-1 - _strideY + _strideZ, -1, -1, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(-1 - _strideZ, -1, 0, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x)) {
-		return *(_currentVoxel - 1);
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z);
+	return peek(-1, -1, 0, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx0py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(-1 + _strideZ, -1, 0, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels() - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(-1 + _strideY - _strideZ, -1, 1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(-1 + _strideY, -1, 1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1nx1py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - 1 + region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x - 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(-1 + _strideY + _strideZ, -1, 1, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.getWidthInVoxels() - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return peek(-_strideY - _strideZ, 0, -1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel - region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(-_strideY, 0, -1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1ny1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(-_strideY + _strideZ, 0, -1, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px0py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(-_strideZ, 0, 0, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px0py0pz() const {
-	if (this->currentPositionValid()) {
-		return *_currentVoxel;
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z);
+	return voxel();
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px0py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(_strideZ, 0, 0, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.getWidthInVoxels() - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(_strideY - _strideZ, 0, 1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(_strideY, 0, 1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel0px1py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(_strideY + _strideZ, 0, 1, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels() - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z - 1);
+	return peek(1 - _strideY - _strideZ, 1, -1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z);
+	return peek(1 - _strideY, 1, -1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1ny1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y - 1, this->_posInVolume.z + 1);
+	return peek(1 - _strideY + _strideZ, 1, -1, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z - 1);
+	return peek(1 - _strideZ, 1, 0, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x)) {
-		return *(_currentVoxel + 1);
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z);
+	return peek(1, 1, 0, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px0py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y, this->_posInVolume.z + 1);
+	return peek(1 + _strideZ, 1, 0, 1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py1nz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_NEG_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels() - region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z - 1);
+	return peek(1 + _strideY - _strideZ, 1, 1, -1);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py0pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z);
+	return peek(1 + _strideY, 1, 1, 0);
 }
 
 inline const Voxel& RawVolume::Sampler::peekVoxel1px1py1pz() const {
-	const Region& region = this->_volume->region();
-	if (this->currentPositionValid() && CAN_GO_POS_X(this->_posInVolume.x) && CAN_GO_POS_Y(this->_posInVolume.y) && CAN_GO_POS_Z(this->_posInVolume.z)) {
-		return *(_currentVoxel + 1 + region.getWidthInVoxels() + region.stride());
-	}
-	return this->_volume->voxel(this->_posInVolume.x + 1, this->_posInVolume.y + 1, this->_posInVolume.z + 1);
+	return peek(1 + _strideY + _strideZ, 1, 1, 1);
 }
-
-#undef CAN_GO_NEG_X
-#undef CAN_GO_POS_X
-#undef CAN_GO_NEG_Y
-#undef CAN_GO_POS_Y
-#undef CAN_GO_NEG_Z
-#undef CAN_GO_POS_Z
-
 }
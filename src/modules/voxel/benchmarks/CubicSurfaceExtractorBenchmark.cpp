@@ -9,6 +9,8 @@
 #include "voxel/Constants.h"
 #include "voxel/RawVolume.h"
 #include "voxel/PagedVolume.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ThreadPool.h"
 
 static constexpr int MAX_BENCHMARK_VOLUME_SIZE = 64;
 static const int meshSize = voxel::MAX_MESH_CHUNK_HEIGHT;
@@ -30,6 +32,26 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Hills with a few color layers and caves - the quads can only partially be merged
+	 */
+	template<class Volume>
+	void fillTerrain(const voxel::Region& region, Volume* v) const {
+		const voxel::Voxel colors[] = {voxel::createColorVoxel(voxel::VoxelType::Dirt, 0),
+				voxel::createColorVoxel(voxel::VoxelType::Grass, 0), voxel::createColorVoxel(voxel::VoxelType::Rock, 0)};
+		for (int z = region.getLowerZ(); z < region.getUpperZ(); ++z) {
+			for (int x = region.getLowerX(); x < region.getUpperX(); ++x) {
+				const int height = region.getLowerY() + 8 + (x / 3 + z / 5) % 16;
+				for (int y = region.getLowerY(); y < height && y < region.getUpperY(); ++y) {
+					if (y > 1 && (x * 7 + z * 3 + y) % 11 == 0) {
+						continue;
+					}
+					v->setVoxel(x, y, z, colors[(y / 4) % 3]);
+				}
+			}
+		}
+	}
+
 	class BenchmarkPager: public voxel::PagedVolume::Pager {
 	public:
 		bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
@@ -132,11 +154,54 @@ BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractEmpty)(benc
 	}
 }
 
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainMergeQuads)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true, true, false);
+	}
+	state.counters["indices"] = (double)mesh.getNoOfIndices();
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainGreedyMeshing)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fillTerrain(region, &volume);
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMesh(&volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true, true, true);
+	}
+	state.counters["indices"] = (double)mesh.getNoOfIndices();
+}
+
+BENCHMARK_DEFINE_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainParallel)(benchmark::State &state) {
+	const voxel::Region region(glm::ivec3(0), glm::ivec3(state.range(0), meshSize, state.range(0)));
+	constexpr voxel::Region volumeRegion(0, MAX_BENCHMARK_VOLUME_SIZE);
+	voxel::RawVolume volume(volumeRegion);
+	fillTerrain(region, &volume);
+	core::ThreadPool threadPool(core::cpus(), "ExtractBench");
+	threadPool.init();
+	voxel::Mesh mesh(1024 * 1024, 1024 * 1024, false);
+	for (auto _ : state) {
+		voxel::extractCubicMeshParallel(threadPool, &volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true, true, true, 16);
+	}
+	state.counters["indices"] = (double)mesh.getNoOfIndices();
+	threadPool.shutdown();
+}
+
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainMergeQuads)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainGreedyMeshing)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
+BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, RawVolumeExtractTerrainParallel)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE)->UseRealTime();
+
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedy)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtract)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
 BENCHMARK_REGISTER_F(CubicSurfaceExtractorBenchmark, PagedVolumeExtractGreedyEmpty)->RangeMultiplier(2)->Range(16, MAX_BENCHMARK_VOLUME_SIZE);
@@ -0,0 +1,156 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxel/CubicSurfaceExtractor.h"
+#include "voxel/IsQuadNeeded.h"
+#include "voxel/RawVolume.h"
+#include "core/concurrent/ThreadPool.h"
+#include <glm/geometric.hpp>
+#include <limits.h>
+#include <array>
+#include <map>
+
+namespace voxel {
+
+class CubicSurfaceExtractorTest: public AbstractVoxelTest {
+protected:
+	/**
+	 * @brief The normal and the position of each unit face that is covered by the mesh mapped to its color
+	 */
+	typedef std::map<std::array<int, 6>, uint8_t> Surface;
+
+	void fill(RawVolume& volume) const {
+		const Voxel colors[] = {createColorVoxel(VoxelType::Dirt, 0), createColorVoxel(VoxelType::Grass, 0), createColorVoxel(VoxelType::Rock, 0)};
+		const Region& region = volume.region();
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				const int height = 4 + (x / 3 + z / 5) % 6;
+				for (int y = region.getLowerY(); y < height; ++y) {
+					// leave some caves
+					if (y > 1 && (x * 7 + z * 3 + y) % 11 == 0) {
+						continue;
+					}
+					volume.setVoxel(x, y, z, colors[(y / 3) % lengthof(colors)]);
+				}
+			}
+		}
+	}
+
+	void surface(const Mesh& mesh, Surface& out) const {
+		const IndexType* indices = mesh.getRawIndexData();
+		const VoxelVertex* vertices = mesh.getRawVertexData();
+		const size_t amount = mesh.getNoOfIndices();
+		ASSERT_EQ(0u, amount % 6) << "Expected two triangles per quad";
+		for (size_t i = 0; i < amount; i += 6) {
+			glm::ivec3 mins(INT_MAX);
+			glm::ivec3 maxs(INT_MIN);
+			for (size_t j = i; j < i + 6; ++j) {
+				const glm::ivec3 pos(vertices[indices[j]].position);
+				mins = glm::min(mins, pos);
+				maxs = glm::max(maxs, pos);
+			}
+			const glm::vec3 p0(vertices[indices[i + 0]].position);
+			const glm::vec3 p1(vertices[indices[i + 1]].position);
+			const glm::vec3 p2(vertices[indices[i + 2]].position);
+			const glm::ivec3 normal(glm::sign(glm::cross(p1 - p0, p2 - p0)));
+			const uint8_t color = vertices[indices[i]].colorIndex;
+			// the quad is flat along the normal axis
+			maxs = glm::max(maxs, mins + glm::abs(normal));
+			for (int x = mins.x; x < maxs.x; ++x) {
+				for (int y = mins.y; y < maxs.y; ++y) {
+					for (int z = mins.z; z < maxs.z; ++z) {
+						const std::array<int, 6> key {{normal.x, normal.y, normal.z, x, y, z}};
+						ASSERT_TRUE(out.find(key) == out.end()) << "Face at " << x << ":" << y << ":" << z << " is covered twice";
+						out[key] = color;
+					}
+				}
+			}
+		}
+	}
+
+	void compare(bool ambientOcclusion) {
+		RawVolume volume(Region(0, 31));
+		fill(volume);
+		const Region& region = volume.region();
+		Mesh unmerged;
+		Mesh merged;
+		Mesh greedy;
+		extractCubicMesh(&volume, region, &unmerged, IsQuadNeeded(), region.getLowerCorner(), false, true, ambientOcclusion);
+		extractCubicMesh(&volume, region, &merged, IsQuadNeeded(), region.getLowerCorner(), true, true, ambientOcclusion);
+		extractCubicMesh(&volume, region, &greedy, IsQuadNeeded(), region.getLowerCorner(), true, true, ambientOcclusion, true);
+
+		Surface unmergedSurface;
+		Surface mergedSurface;
+		Surface greedySurface;
+		surface(unmerged, unmergedSurface);
+		surface(merged, mergedSurface);
+		surface(greedy, greedySurface);
+		ASSERT_FALSE(unmergedSurface.empty());
+		EXPECT_TRUE(unmergedSurface == mergedSurface) << "The merged quads don't cover the same surface";
+		EXPECT_TRUE(unmergedSurface == greedySurface) << "The greedy quads don't cover the same surface";
+		EXPECT_LT(greedy.getNoOfIndices(), unmerged.getNoOfIndices());
+		EXPECT_LE(greedy.getNoOfIndices(), merged.getNoOfIndices());
+	}
+};
+
+TEST_F(CubicSurfaceExtractorTest, testParallelExtraction) {
+	RawVolume volume(Region(0, 31));
+	fill(volume);
+	const Region& region = volume.region();
+	core::ThreadPool threadPool(2, "Extract");
+	threadPool.init();
+	Mesh single;
+	Mesh tiled;
+	Mesh welded;
+	extractCubicMesh(&volume, region, &single, IsQuadNeeded(), region.getLowerCorner(), false);
+	extractCubicMeshParallel(threadPool, &volume, region, &tiled, IsQuadNeeded(), region.getLowerCorner(), false, true, true, false, 8, false);
+	extractCubicMeshParallel(threadPool, &volume, region, &welded, IsQuadNeeded(), region.getLowerCorner(), false, true, true, false, 8, true);
+
+	Surface singleSurface;
+	Surface tiledSurface;
+	Surface weldedSurface;
+	surface(single, singleSurface);
+	surface(tiled, tiledSurface);
+	surface(welded, weldedSurface);
+	ASSERT_FALSE(singleSurface.empty());
+	EXPECT_TRUE(singleSurface == tiledSurface) << "The tiles don't cover the same surface";
+	EXPECT_TRUE(singleSurface == weldedSurface) << "The welded tiles don't cover the same surface";
+	EXPECT_EQ(single.getNoOfIndices(), tiled.getNoOfIndices());
+	EXPECT_EQ(single.getNoOfIndices(), welded.getNoOfIndices());
+	EXPECT_LT(single.getNoOfVertices(), tiled.getNoOfVertices()) << "Expected duplicated vertices on the tile borders";
+	EXPECT_EQ(single.getNoOfVertices(), welded.getNoOfVertices());
+	EXPECT_EQ(region.getLowerCorner(), welded.getOffset());
+	threadPool.shutdown();
+}
+
+TEST_F(CubicSurfaceExtractorTest, testExtractFromRegionCopy) {
+	RawVolume volume(Region(0, 31));
+	fill(volume);
+	// the tiles are extracted like the RawVolumeRenderer does - with the upper corner shifted by one
+	const Region tiles[] = {Region(0, 7), Region(glm::ivec3(8, 0, 16), glm::ivec3(15, 7, 23)), Region(24, 31)};
+	for (const Region& tile : tiles) {
+		Region reg = tile;
+		reg.shiftUpperCorner(1, 1, 1);
+		const RawVolume copy(volume, Region(tile.getLowerCorner() - 1, tile.getUpperCorner() + 2));
+		Mesh full;
+		Mesh partial;
+		extractCubicMesh(&volume, reg, &full, IsQuadNeeded(), reg.getLowerCorner());
+		extractCubicMesh(&copy, reg, &partial, IsQuadNeeded(), reg.getLowerCorner());
+		ASSERT_EQ(full.getNoOfVertices(), partial.getNoOfVertices());
+		ASSERT_EQ(full.getNoOfIndices(), partial.getNoOfIndices());
+		EXPECT_EQ(0, SDL_memcmp(full.getRawVertexData(), partial.getRawVertexData(), full.getNoOfVertices() * sizeof(VoxelVertex)));
+		EXPECT_EQ(0, SDL_memcmp(full.getRawIndexData(), partial.getRawIndexData(), full.getNoOfIndices() * sizeof(IndexType)));
+	}
+}
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyMeshing) {
+	compare(true);
+}
+
+TEST_F(CubicSurfaceExtractorTest, testGreedyMeshingWithoutAmbientOcclusion) {
+	compare(false);
+}
+
+}
@@ -0,0 +1,408 @@
+/**
+ * @file
+ */
+
+#include "app/tests/AbstractTest.h"
+#include "voxel/PagedVolume.h"
+#include "core/concurrent/Atomic.h"
+#include "core/StandardLib.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace voxel {
+
+class PagedVolumeTest: public app::AbstractTest {
+protected:
+	class CountingPager: public PagedVolume::Pager {
+	public:
+		core::AtomicInt pageIns { 0 };
+		core::AtomicInt pageOuts { 0 };
+		// fill the ground chunks with more different voxels than a palette can hold
+		bool dense = false;
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			pageIns.increment(1);
+			// the chunks above the ground stay uniform
+			if (ctx.chunk->chunkPos().y != 0) {
+				return false;
+			}
+			if (dense) {
+				for (int i = 0; i <= PagedVolume::Chunk::MaxPaletteEntries; ++i) {
+					ctx.chunk->setVoxel(i, 0, 0, createVoxel(VoxelType::Generic, i));
+				}
+				return true;
+			}
+			ctx.chunk->setVoxel(0, 0, 0, createVoxel(VoxelType::Generic, 1));
+			return true;
+		}
+
+		void pageOut(PagedVolume::Chunk* chunk) override {
+			pageOuts.increment(1);
+		}
+
+		bool concurrentPageIn() const override {
+			return true;
+		}
+	};
+
+	// blocks the page in of the chunk at the origin until it gets released
+	class BlockingPager: public CountingPager {
+	public:
+		core::AtomicBool blocked { true };
+		core::AtomicBool entered { false };
+
+		bool pageIn(PagedVolume::PagerContext& ctx) override {
+			if (ctx.chunk->chunkPos() == glm::ivec3(0)) {
+				entered = true;
+				while (blocked) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			}
+			return CountingPager::pageIn(ctx);
+		}
+	};
+
+	static constexpr uint16_t ChunkSideLength = 32;
+	// 2MB with 64KB per dense chunk
+	static constexpr int ChunkLimit = 32;
+};
+
+TEST_F(PagedVolumeTest, testChunkHit) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	const PagedVolume::ChunkPtr& chunk1 = volume.chunk(glm::ivec3(0));
+	const PagedVolume::ChunkPtr& chunk2 = volume.chunk(glm::ivec3(ChunkSideLength - 1));
+	EXPECT_EQ(chunk1, chunk2);
+	EXPECT_EQ(1, (int)pager.pageIns);
+	EXPECT_EQ(VoxelType::Generic, volume.voxel(0, 0, 0).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testEvictLeastRecentlyUsed) {
+	CountingPager pager;
+	pager.dense = true;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	for (int i = 0; i < ChunkLimit - 1; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(ChunkLimit - 1, (int)pager.pageIns);
+	// touch the oldest chunk - this one should survive the eviction
+	volume.chunk(glm::ivec3(0));
+	// this exceeds the limit and evicts the oldest chunk that wasn't accessed anymore
+	volume.chunk(glm::ivec3((ChunkLimit - 1) * ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns);
+	EXPECT_EQ(1, (int)pager.pageOuts);
+
+	volume.chunk(glm::ivec3(0));
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns) << "The recently used chunk should not get evicted";
+	volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	EXPECT_EQ(ChunkLimit + 1, (int)pager.pageIns) << "The least recently used chunk should get evicted";
+
+	volume.flushAll();
+	EXPECT_EQ((int)pager.pageIns, (int)pager.pageOuts);
+}
+
+TEST_F(PagedVolumeTest, testFullShard) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	// collect more chunks of one shard than the shard was sized for - the same hash as PagedVolume::shard()
+	std::vector<glm::ivec3> positions;
+	for (int x = 0; positions.size() < 64u; ++x) {
+		const uint32_t h = ((uint32_t)x * 73856093u) ^ (1u * 19349663u);
+		if (((h >> 4) & 15u) == 0u) {
+			positions.push_back(glm::ivec3(x, 1, 0) * (int)ChunkSideLength);
+		}
+	}
+	std::vector<PagedVolume::ChunkPtr> chunks;
+	for (const glm::ivec3& pos : positions) {
+		chunks.push_back(volume.chunk(pos));
+	}
+	EXPECT_EQ((int)positions.size(), (int)pager.pageIns);
+	for (size_t i = 0; i < positions.size(); ++i) {
+		EXPECT_EQ(chunks[i], volume.chunk(positions[i])) << "Every chunk should be indexed - even if the shard was full";
+	}
+	EXPECT_EQ((int)positions.size(), (int)pager.pageIns);
+}
+
+TEST_F(PagedVolumeTest, testMemoryLimit) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	for (int i = 0; i < ChunkLimit * 2; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(0, (int)pager.pageOuts) << "The palette chunks need less memory than dense chunks - more of them should fit";
+	const uint64_t memoryUsage = volume.memoryUsage();
+	EXPECT_GT(memoryUsage, 0u);
+	EXPECT_LT(memoryUsage, 2u * 1024u * 1024u);
+
+	volume.setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 2));
+	const uint32_t denseSize = ChunkSideLength * ChunkSideLength * ChunkSideLength * sizeof(Voxel);
+	EXPECT_EQ(memoryUsage + denseSize, volume.memoryUsage()) << "The promotion to dense storage should be accounted";
+
+	volume.flushAll();
+	EXPECT_EQ(0u, volume.memoryUsage());
+}
+
+TEST_F(PagedVolumeTest, testChunkCompression) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 2));
+	chunk.setVoxel(31, 31, 31, createVoxel(VoxelType::Rock, 3));
+	uint8_t buf[1024];
+	const uint32_t size = chunk.compress(buf, sizeof(buf));
+	ASSERT_GT(size, 0u);
+	EXPECT_EQ(0u, chunk.compress(buf, 4u)) << "Buffer should be too small";
+
+	PagedVolume::Chunk restored(glm::ivec3(0), ChunkSideLength, &pager);
+	ASSERT_TRUE(restored.decompress(buf, size));
+	EXPECT_EQ(0, core_memcmp(chunk.data(), restored.data(), chunk.dataSizeInBytes()));
+	EXPECT_FALSE(restored.decompress(buf, size - 1u));
+}
+
+TEST_F(PagedVolumeTest, testCompressedTier) {
+	CountingPager pager;
+	pager.dense = true;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength, 1 * 1024 * 1024);
+	volume.setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 2));
+	for (int i = 1; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns);
+	EXPECT_EQ(1u, volume.compressedChunks());
+	EXPECT_EQ(0, (int)pager.pageOuts) << "The evicted chunk should be kept compressed";
+	EXPECT_GT(volume.compressedMemoryUsage(), 0u);
+
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(1, 2, 3).getMaterial());
+	EXPECT_EQ(VoxelType::Generic, volume.voxel(0, 0, 0).getMaterial());
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns) << "The chunk should be restored from the compressed chunks";
+
+	volume.flushAll();
+	EXPECT_EQ(0u, volume.compressedChunks());
+	EXPECT_EQ(0u, volume.compressedMemoryUsage());
+	EXPECT_EQ((int)pager.pageIns, (int)pager.pageOuts);
+}
+
+TEST_F(PagedVolumeTest, testCompressedTierReferencedChunk) {
+	CountingPager pager;
+	pager.dense = true;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength, 1 * 1024 * 1024);
+	PagedVolume::ChunkPtr chunk = volume.chunk(glm::ivec3(0));
+	for (int i = 1; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(1u, volume.compressedChunks()) << "Another chunk should have been evicted";
+	chunk->setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 2));
+	EXPECT_EQ(chunk, volume.chunk(glm::ivec3(0))) << "A chunk that is still referenced must not be evicted";
+	chunk = PagedVolume::ChunkPtr();
+	EXPECT_EQ(0, (int)pager.pageOuts);
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(1, 2, 3).getMaterial());
+	EXPECT_EQ(ChunkLimit, (int)pager.pageIns) << "The referenced chunk should not be paged in a second time";
+}
+
+TEST_F(PagedVolumeTest, testCompressedTierBudget) {
+	CountingPager pager;
+	pager.dense = true;
+	// the budget is too small to keep any compressed chunk
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength, 1);
+	for (int i = 0; i < ChunkLimit; ++i) {
+		volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+	}
+	EXPECT_EQ(0u, volume.compressedChunks());
+	EXPECT_EQ(1, (int)pager.pageOuts);
+}
+
+TEST_F(PagedVolumeTest, testUniformChunk) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	EXPECT_TRUE(chunk.isUniform());
+	EXPECT_EQ(0u, chunk.memoryUsageInBytes());
+	chunk.setVoxel(1, 2, 3, Voxel());
+	EXPECT_TRUE(chunk.isUniform()) << "Writing the uniform voxel should not promote the chunk";
+	chunk.setVoxel(1, 2, 3, createVoxel(VoxelType::Rock, 1));
+	EXPECT_FALSE(chunk.isUniform());
+	EXPECT_EQ(chunk.dataSizeInBytes(), chunk.memoryUsageInBytes());
+	EXPECT_EQ(VoxelType::Rock, chunk.voxel(1, 2, 3).getMaterial());
+	EXPECT_EQ(VoxelType::Air, chunk.voxel(3, 2, 1).getMaterial());
+	chunk.setVoxel(1, 2, 3, Voxel());
+	EXPECT_TRUE(chunk.compact());
+	EXPECT_TRUE(chunk.isUniform());
+}
+
+TEST_F(PagedVolumeTest, testPaletteChunk) {
+	CountingPager pager;
+	PagedVolume::Chunk chunk(glm::ivec3(0), ChunkSideLength, &pager);
+	for (int i = 0; i < 5; ++i) {
+		chunk.setVoxel(i, i, i, createVoxel(VoxelType::Rock, i + 1));
+	}
+	PagedVolume::Chunk dense(glm::ivec3(0), ChunkSideLength, &pager);
+	ASSERT_TRUE(dense.setData(chunk.data(), chunk.dataSizeInBytes()));
+	ASSERT_TRUE(chunk.compact());
+	EXPECT_FALSE(chunk.isUniform());
+	EXPECT_EQ(chunk.voxels() / 2u, chunk.memoryUsageInBytes()) << "6 palette entries should need 4 bits per voxel";
+	for (uint32_t x = 0; x < ChunkSideLength; ++x) {
+		for (uint32_t y = 0; y < ChunkSideLength; ++y) {
+			for (uint32_t z = 0; z < ChunkSideLength; ++z) {
+				ASSERT_TRUE(dense.voxel(x, y, z).isSame(chunk.voxel(x, y, z)));
+			}
+		}
+	}
+	uint8_t buf[1024];
+	const uint32_t size = chunk.compress(buf, sizeof(buf));
+	ASSERT_GT(size, 0u);
+	PagedVolume::Chunk restored(glm::ivec3(0), ChunkSideLength, &pager);
+	ASSERT_TRUE(restored.decompress(buf, size));
+	EXPECT_EQ(0, core_memcmp(dense.data(), restored.data(), dense.dataSizeInBytes()));
+
+	// a write promotes the chunk to dense storage again
+	chunk.setVoxel(31, 0, 0, createVoxel(VoxelType::Grass, 1));
+	EXPECT_EQ(chunk.dataSizeInBytes(), chunk.memoryUsageInBytes());
+	EXPECT_EQ(VoxelType::Grass, chunk.voxel(31, 0, 0).getMaterial());
+	EXPECT_TRUE(chunk.voxel(4, 4, 4).isSame(createVoxel(VoxelType::Rock, 5)));
+
+	dense.setVoxel(0, 0, 0, createVoxel(VoxelType::Rock, 100));
+	for (int i = 0; i < PagedVolume::Chunk::MaxPaletteEntries; ++i) {
+		dense.setVoxel(i, 0, 1, createVoxel(VoxelType::Rock, 101 + i));
+	}
+	EXPECT_FALSE(dense.compact()) << "Too many different voxels for the palette";
+}
+
+TEST_F(PagedVolumeTest, testSampler) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	// the first chunk is a palette chunk, the chunks above are uniform
+	volume.setVoxel(2, 1, 2, createVoxel(VoxelType::Rock, 1));
+	volume.chunk(glm::ivec3(0))->compact();
+	ASSERT_FALSE(volume.chunk(glm::ivec3(0))->isUniform());
+	ASSERT_TRUE(volume.chunk(glm::ivec3(0, ChunkSideLength, 0))->isUniform());
+
+	PagedVolume::Sampler sampler(volume);
+	for (int x = 1; x < 3; ++x) {
+		for (int z = 1; z < 3; ++z) {
+			sampler.setPosition(x, 1, z);
+			for (int y = 1; y < ChunkSideLength * 2; ++y) {
+				ASSERT_TRUE(volume.voxel(x, y, z).isSame(sampler.voxel()));
+				ASSERT_TRUE(volume.voxel(x - 1, y - 1, z - 1).isSame(sampler.peekVoxel1nx1ny1nz()));
+				ASSERT_TRUE(volume.voxel(x + 1, y - 1, z).isSame(sampler.peekVoxel1px1ny0pz()));
+				ASSERT_TRUE(volume.voxel(x, y + 1, z + 1).isSame(sampler.peekVoxel0px1py1pz()));
+				sampler.movePositiveY();
+			}
+		}
+	}
+
+	sampler.setPosition(5, ChunkSideLength + 5, 5);
+	EXPECT_TRUE(sampler.setVoxel(createVoxel(VoxelType::Grass, 1)));
+	EXPECT_FALSE(volume.chunk(glm::ivec3(0, ChunkSideLength, 0))->isUniform());
+	EXPECT_EQ(VoxelType::Grass, volume.voxel(5, ChunkSideLength + 5, 5).getMaterial());
+	EXPECT_EQ(VoxelType::Grass, sampler.voxel().getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testUniformRegion) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	EXPECT_TRUE(volume.isUniform(Region(ChunkSideLength, ChunkSideLength * 3 - 1)));
+	EXPECT_FALSE(volume.isUniform(Region(0, ChunkSideLength * 3 - 1)));
+}
+
+TEST_F(PagedVolumeTest, testConcurrentAccess) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&] () {
+			for (int n = 0; n < 100; ++n) {
+				for (int i = 0; i < ChunkLimit / 2; ++i) {
+					const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(i * ChunkSideLength, 0, 0));
+					ASSERT_EQ(VoxelType::Generic, chunk->voxel(0, 0, 0).getMaterial());
+				}
+			}
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(ChunkLimit / 2, (int)pager.pageIns) << "Each chunk should only be paged in once";
+}
+
+TEST_F(PagedVolumeTest, testConcurrentPromoteToDense) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(0));
+	ASSERT_FALSE(chunk->isUniform());
+	std::vector<std::thread> threads;
+	// the readers must either see the palette or the filled dense data
+	for (int t = 0; t < 3; ++t) {
+		threads.emplace_back([&] () {
+			for (int n = 0; n < 1000; ++n) {
+				ASSERT_EQ(VoxelType::Generic, chunk->voxel(0, 0, 0).getMaterial());
+			}
+		});
+	}
+	threads.emplace_back([&] () {
+		chunk->setVoxel(1, 2, 3, createVoxel(VoxelType::Grass, 2));
+	});
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(chunk->dataSizeInBytes(), chunk->memoryUsageInBytes());
+	EXPECT_EQ(VoxelType::Grass, chunk->voxel(1, 2, 3).getMaterial());
+}
+
+TEST_F(PagedVolumeTest, testConcurrentPageIn) {
+	BlockingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	std::thread blockedThread([&] () {
+		volume.chunk(glm::ivec3(0));
+	});
+	for (int i = 0; i < 1000 && !pager.entered; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	EXPECT_TRUE(pager.entered);
+	std::thread waitingThread([&] () {
+		volume.chunk(glm::ivec3(0));
+	});
+	// the page in of another chunk doesn't have to wait for the blocked one
+	const PagedVolume::ChunkPtr& chunk = volume.chunk(glm::ivec3(ChunkSideLength, 0, 0));
+	EXPECT_TRUE(chunk);
+	EXPECT_TRUE(pager.blocked);
+	EXPECT_EQ(1, (int)pager.pageIns);
+	pager.blocked = false;
+	blockedThread.join();
+	waitingThread.join();
+	EXPECT_EQ(2, (int)pager.pageIns) << "The same chunk should only be paged in once";
+}
+
+TEST_F(PagedVolumeTest, testPrefetchRequeue) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	const Region region(0, ChunkSideLength * 2 - 1);
+	volume.prefetch(region, glm::ivec3(ChunkSideLength * 100));
+	EXPECT_EQ(8u, volume.pagingStats().queueDepth);
+	volume.prefetch(region, glm::ivec3(ChunkSideLength * 100));
+	EXPECT_EQ(8u, volume.pagingStats().queueDepth) << "The same priority should not queue the chunks again";
+	volume.prefetch(region, glm::ivec3(0));
+	EXPECT_EQ(16u, volume.pagingStats().queueDepth) << "The chunks should get queued again with the higher priority";
+
+	volume.startAsyncPaging(1);
+	for (int i = 0; i < 1000 && volume.pagingStats().queueDepth > 0u; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	volume.stopAsyncPaging();
+	EXPECT_EQ(8, (int)pager.pageIns) << "The outdated requests should be skipped";
+}
+
+TEST_F(PagedVolumeTest, testPrefetch) {
+	CountingPager pager;
+	PagedVolume volume(&pager, 2 * 1024 * 1024, ChunkSideLength);
+	volume.startAsyncPaging(2);
+	volume.prefetch(Region(0, ChunkSideLength * 2 - 1), glm::ivec3(0));
+	for (int i = 0; i < 1000 && (int)pager.pageIns < 8; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	volume.stopAsyncPaging();
+	EXPECT_EQ(8, (int)pager.pageIns);
+	// all chunks are resident now - nothing is paged in again
+	volume.prefetch(Region(0, ChunkSideLength * 2 - 1), glm::ivec3(0));
+	EXPECT_EQ(8, (int)pager.pageIns);
+}
+
+}
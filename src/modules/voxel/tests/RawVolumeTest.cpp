@@ -0,0 +1,145 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxel/RawVolume.h"
+
+namespace voxel {
+
+class RawVolumeTest: public AbstractVoxelTest {
+};
+
+TEST_F(RawVolumeTest, testCopyRegion) {
+	RawVolume volume(Region(0, 15));
+	const Voxel border = createVoxel(VoxelType::Rock, 0);
+	volume.setBorderValue(border);
+	for (int z = 0; z < 16; ++z) {
+		for (int y = 0; y < 16; ++y) {
+			for (int x = 0; x < 16; ++x) {
+				volume.setVoxel(x, y, z, createVoxel(VoxelType::Generic, (x + y * 3 + z * 5) % 256));
+			}
+		}
+	}
+
+	const RawVolume copy(volume, Region(glm::ivec3(-2, 4, 6), glm::ivec3(5, 9, 20)));
+	EXPECT_EQ(Region(glm::ivec3(0, 4, 6), glm::ivec3(5, 9, 15)), copy.region()) << "The region should be cropped to the source volume";
+	EXPECT_TRUE(copy.borderValue().isSame(border));
+	const Region& region = copy.region();
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				ASSERT_TRUE(volume.voxel(x, y, z).isSame(copy.voxel(x, y, z))) << "Voxel differs at " << x << ":" << y << ":" << z;
+			}
+		}
+	}
+	EXPECT_TRUE(copy.voxel(6, 4, 6).isSame(border));
+	EXPECT_EQ(region.getLowerCorner(), copy.mins());
+	EXPECT_EQ(region.getUpperCorner(), copy.maxs());
+
+	RawVolume small(volume, Region(0, 1));
+	RawVolume moved(std::move(small));
+	EXPECT_TRUE(moved.borderValue().isSame(border)) << "The border value should survive the move";
+}
+
+TEST_F(RawVolumeTest, testCopyInto) {
+	RawVolume volume(Region(0, 7));
+	RawVolume source(Region(glm::ivec3(4, -2, 2), glm::ivec3(10, 3, 5)));
+	const Region& sourceRegion = source.region();
+	for (int z = sourceRegion.getLowerZ(); z <= sourceRegion.getUpperZ(); ++z) {
+		for (int y = sourceRegion.getLowerY(); y <= sourceRegion.getUpperY(); ++y) {
+			for (int x = sourceRegion.getLowerX(); x <= sourceRegion.getUpperX(); ++x) {
+				source.setVoxel(x, y, z, createVoxel(VoxelType::Generic, (x + y * 3 + z * 5) & 255));
+			}
+		}
+	}
+	ASSERT_TRUE(volume.copyInto(source));
+	const Region expected(glm::ivec3(4, 0, 2), glm::ivec3(7, 3, 5));
+	const Region& region = volume.region();
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				if (expected.containsPoint(x, y, z)) {
+					ASSERT_TRUE(volume.voxel(x, y, z).isSame(source.voxel(x, y, z))) << "Voxel differs at " << x << ":" << y << ":" << z;
+				} else {
+					ASSERT_TRUE(isAir(volume.voxel(x, y, z).getMaterial())) << "Voxel outside the source region was modified at " << x << ":" << y << ":" << z;
+				}
+			}
+		}
+	}
+	EXPECT_EQ(expected.getLowerCorner(), volume.mins());
+	EXPECT_EQ(expected.getUpperCorner(), volume.maxs());
+
+	const RawVolume outside(Region(20, 25));
+	EXPECT_FALSE(volume.copyInto(outside));
+}
+
+TEST_F(RawVolumeTest, testSamplerPeeks) {
+	const Region region(glm::ivec3(-2, 1, 3), glm::ivec3(2, 4, 5));
+	RawVolume volume(region);
+	volume.setBorderValue(createVoxel(VoxelType::Rock, 0));
+	for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+		for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+			for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+				volume.setVoxel(x, y, z, createVoxel(VoxelType::Generic, (x * 7 + y * 3 + z * 5) & 255));
+			}
+		}
+	}
+	using Peek = const Voxel& (RawVolume::Sampler::*)() const;
+	const Peek peeks[3][3][3] = {
+		{{&RawVolume::Sampler::peekVoxel1nx1ny1nz, &RawVolume::Sampler::peekVoxel1nx1ny0pz, &RawVolume::Sampler::peekVoxel1nx1ny1pz},
+		 {&RawVolume::Sampler::peekVoxel1nx0py1nz, &RawVolume::Sampler::peekVoxel1nx0py0pz, &RawVolume::Sampler::peekVoxel1nx0py1pz},
+		 {&RawVolume::Sampler::peekVoxel1nx1py1nz, &RawVolume::Sampler::peekVoxel1nx1py0pz, &RawVolume::Sampler::peekVoxel1nx1py1pz}},
+		{{&RawVolume::Sampler::peekVoxel0px1ny1nz, &RawVolume::Sampler::peekVoxel0px1ny0pz, &RawVolume::Sampler::peekVoxel0px1ny1pz},
+		 {&RawVolume::Sampler::peekVoxel0px0py1nz, &RawVolume::Sampler::peekVoxel0px0py0pz, &RawVolume::Sampler::peekVoxel0px0py1pz},
+		 {&RawVolume::Sampler::peekVoxel0px1py1nz, &RawVolume::Sampler::peekVoxel0px1py0pz, &RawVolume::Sampler::peekVoxel0px1py1pz}},
+		{{&RawVolume::Sampler::peekVoxel1px1ny1nz, &RawVolume::Sampler::peekVoxel1px1ny0pz, &RawVolume::Sampler::peekVoxel1px1ny1pz},
+		 {&RawVolume::Sampler::peekVoxel1px0py1nz, &RawVolume::Sampler::peekVoxel1px0py0pz, &RawVolume::Sampler::peekVoxel1px0py1pz},
+		 {&RawVolume::Sampler::peekVoxel1px1py1nz, &RawVolume::Sampler::peekVoxel1px1py0pz, &RawVolume::Sampler::peekVoxel1px1py1pz}}
+	};
+	auto check = [&] (const RawVolume::Sampler& sampler) {
+		const glm::ivec3& pos = sampler.position();
+		ASSERT_EQ(region.containsPoint(pos), sampler.currentPositionValid());
+		for (int x = -1; x <= 1; ++x) {
+			for (int y = -1; y <= 1; ++y) {
+				for (int z = -1; z <= 1; ++z) {
+					const Voxel& expected = volume.voxel(pos.x + x, pos.y + y, pos.z + z);
+					ASSERT_TRUE(expected.isSame((sampler.*peeks[x + 1][y + 1][z + 1])()))
+						<< "Peek " << x << ":" << y << ":" << z << " differs at " << pos.x << ":" << pos.y << ":" << pos.z;
+				}
+			}
+		}
+	};
+
+	// walk the region and one voxel outside of it - with and without moving the sampler
+	RawVolume::Sampler walker(volume);
+	for (int z = region.getLowerZ() - 1; z <= region.getUpperZ() + 1; ++z) {
+		for (int y = region.getLowerY() - 1; y <= region.getUpperY() + 1; ++y) {
+			walker.setPosition(region.getLowerX() - 1, y, z);
+			for (int x = region.getLowerX() - 1; x <= region.getUpperX() + 1; ++x) {
+				RawVolume::Sampler sampler(volume);
+				sampler.setPosition(x, y, z);
+				check(sampler);
+				check(walker);
+				walker.movePositiveX();
+			}
+		}
+	}
+
+	RawVolume::Sampler sampler(volume);
+	sampler.setPosition(region.getUpperCorner() + 1);
+	for (int i = 0; i < 8; ++i) {
+		sampler.moveNegativeX();
+		sampler.moveNegativeY();
+		sampler.moveNegativeZ();
+		check(sampler);
+	}
+	sampler.setPosition(region.getLowerCorner() - 1);
+	for (int i = 0; i < 8; ++i) {
+		sampler.movePositiveZ();
+		sampler.movePositiveY();
+		check(sampler);
+	}
+}
+
+}
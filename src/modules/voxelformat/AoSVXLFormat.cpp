@@ -6,9 +6,7 @@
 #include "core/Assert.h"
 #include "voxel/MaterialColor.h"
 #include "core/StringUtil.h"
-#include "core/collection/Map.h"
 #include "core/Log.h"
-#include "core/Color.h"
 #include <SDL_stdinc.h>
 #include <string.h>
 
@@ -35,8 +33,6 @@ bool AoSVXLFormat::loadGroups(const io::FilePtr &file, VoxelVolumes &volumes) {
 	}
 
 	const uint8_t *base = v;
-	const MaterialColorArray& materialColors = getMaterialColors();
-	core::Map<uint32_t, int, 521> paletteMap(32768);
 	for (int y = 0; y < height; ++y) {
 		for (int x = 0; x < width; ++x) {
 			int z = 0;
@@ -53,13 +49,7 @@ bool AoSVXLFormat::loadGroups(const io::FilePtr &file, VoxelVolumes &volumes) {
 					return false;
 				}
 				for (z = topColorStart; z <= topColorEnd; ++z) {
-					if (!paletteMap.get(*rgba, paletteIndex)) {
-						const glm::vec4& color = core::Color::fromRGBA(*rgba);
-						paletteIndex = core::Color::getClosestMatch(color, materialColors);
-						if (paletteMap.size() < paletteMap.capacity()) {
-							paletteMap.put(*rgba, paletteIndex);
-						}
-					}
+					paletteIndex = paletteLookup().findClosestIndex(*rgba);
 					volume->setVoxel(x, flipHeight - z, y, voxel::createVoxel(voxel::VoxelType::Generic, paletteIndex));
 					++rgba;
 				}
@@ -92,13 +82,7 @@ bool AoSVXLFormat::loadGroups(const io::FilePtr &file, VoxelVolumes &volumes) {
 				}
 
 				for (z = bottomColorStart; z < bottomColorEnd; ++z) {
-					if (!paletteMap.get(*rgba, paletteIndex)) {
-						const glm::vec4& color = core::Color::fromRGBA(*rgba);
-						paletteIndex = core::Color::getClosestMatch(color, materialColors);
-						if (paletteMap.size() < paletteMap.capacity()) {
-							paletteMap.put(*rgba, paletteIndex);
-						}
-					}
+					paletteIndex = paletteLookup().findClosestIndex(*rgba);
 					volume->setVoxel(x, flipHeight - z, y, voxel::createVoxel(voxel::VoxelType::Generic, paletteIndex));
 					++rgba;
 				}
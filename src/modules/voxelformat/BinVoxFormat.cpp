@@ -266,7 +266,7 @@ bool BinVoxFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& fi
 			voxels, expectedVoxels, width, height, depth);
 		return false;
 	}
-	return true;
+	return stream.flush();
 }
 
 }
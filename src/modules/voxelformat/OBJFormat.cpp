@@ -35,6 +35,9 @@ void OBJFormat::writeMtlFile(const core::String& mtlName) const {
 	stream.addStringFormat(false, "illum 1\n");
 	stream.addStringFormat(false, "Ns 0.000000\n");
 	stream.addStringFormat(false, "map_Kd palette-%s.png\n", voxel::getDefaultPaletteName());
+	if (!stream.flush()) {
+		Log::error("Failed to write mtl file at %s", file->name().c_str());
+	}
 }
 
 bool OBJFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float scale, bool quad, bool withColor, bool withTexCoords) {
@@ -145,7 +148,7 @@ bool OBJFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 	mtlname.append(".mtl");
 	writeMtlFile(mtlname);
 
-	return true;
+	return stream.flush();
 }
 
 }
@@ -112,7 +112,7 @@ bool PLYFormat::saveMeshes(const Meshes& meshes, const io::FilePtr &file, float
 		}
 		idxOffset += nv;
 	}
-	return true;
+	return stream.flush();
 }
 
 }
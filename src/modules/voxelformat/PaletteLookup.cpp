@@ -0,0 +1,75 @@
+/**
+ * @file
+ */
+
+#include "PaletteLookup.h"
+#include "core/Color.h"
+#include "core/GLM.h"
+#include <float.h>
+
+namespace voxel {
+
+PaletteLookup::PaletteLookup(const MaterialColorArray& colors) : _cache(new CacheEntry[1u << CacheBits]()) {
+	_hsb.reserve(colors.size());
+	for (const glm::vec4& c : colors) {
+		glm::vec3 hsb;
+		core::Color::getHSB(c, hsb.x, hsb.y, hsb.z);
+		_hsb.push_back(hsb);
+	}
+}
+
+PaletteLookup::~PaletteLookup() {
+	delete[] _cache;
+}
+
+int PaletteLookup::closestMatch(const glm::vec4& color) const {
+	float hue;
+	float saturation;
+	float brightness;
+	core::Color::getHSB(color, hue, saturation, brightness);
+
+	float minDistance = FLT_MAX;
+	int minIndex = -1;
+	for (size_t i = 0; i < _hsb.size(); ++i) {
+		const glm::vec3& c = _hsb[i];
+		const float val = core::Color::getDistance(c.x, c.y, c.z, hue, saturation, brightness);
+		if (val < minDistance) {
+			minDistance = val;
+			minIndex = (int)i;
+		}
+	}
+	return minIndex;
+}
+
+uint8_t PaletteLookup::findClosestIndex(uint32_t rgba) {
+	core::RGBA key;
+	key.rgba = rgba;
+	key.a = 0xFF;
+	CacheEntry& entry = _cache[(key.rgba * 2654435761u) >> (32u - CacheBits)];
+	if (entry.rgba != key.rgba) {
+		entry.rgba = key.rgba;
+		entry.index = (uint8_t)closestMatch(core::Color::fromRGBA(key.r, key.g, key.b, key.a));
+	}
+	return entry.index;
+}
+
+uint8_t PaletteLookup::findClosestIndex(uint8_t r, uint8_t g, uint8_t b) {
+	core::RGBA key;
+	key.r = r;
+	key.g = g;
+	key.b = b;
+	key.a = 0xFF;
+	return findClosestIndex(key.rgba);
+}
+
+uint8_t PaletteLookup::findClosestIndex(const glm::vec4& color) {
+	const glm::u8vec4 rgb = glm::u8vec4(glm::round(glm::clamp(color, 0.0f, 1.0f) * core::Color::magnitudef));
+	const glm::vec4& quantized = core::Color::fromRGBA(rgb.r, rgb.g, rgb.b, 255u);
+	if (quantized.r != color.r || quantized.g != color.g || quantized.b != color.b) {
+		// not an 8 bit color - the cache key would not be exact
+		return (uint8_t)closestMatch(color);
+	}
+	return findClosestIndex(rgb.r, rgb.g, rgb.b);
+}
+
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ */
+
+#pragma once
+
+#include "core/collection/DynamicArray.h"
+#include "voxel/MaterialColor.h"
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <stdint.h>
+
+namespace voxel {
+
+/**
+ * @brief Maps colors to the index of the closest match in the material colors
+ *
+ * The hue, saturation and brightness of the palette entries are computed only once, and the results
+ * for 8 bit colors are remembered in a direct mapped cache - truecolor formats repeat the same colors
+ * for a lot of voxels. The returned indices are the same that @c core::Color::getClosestMatch() returns.
+ *
+ * @note The palette is captured on construction - create one instance per import
+ */
+class PaletteLookup {
+private:
+	static constexpr uint32_t CacheBits = 15;
+	struct CacheEntry {
+		// the rgba value with full alpha - 0 marks an unused entry
+		uint32_t rgba;
+		uint8_t index;
+	};
+	core::DynamicArray<glm::vec3> _hsb;
+	CacheEntry* _cache;
+
+	int closestMatch(const glm::vec4& color) const;
+public:
+	PaletteLookup(const MaterialColorArray& colors = getMaterialColors());
+	~PaletteLookup();
+	PaletteLookup(const PaletteLookup&) = delete;
+	PaletteLookup& operator=(const PaletteLookup&) = delete;
+
+	/**
+	 * @param rgba The color in the format of @c core::Color::fromRGBA(unsigned int)
+	 * @return The palette index - the alpha value is not taken into account
+	 */
+	uint8_t findClosestIndex(uint32_t rgba);
+	uint8_t findClosestIndex(uint8_t r, uint8_t g, uint8_t b);
+	uint8_t findClosestIndex(const glm::vec4& color);
+};
+
+}
@@ -157,7 +157,7 @@ bool QBFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 			return false;
 		}
 	}
-	return true;
+	return stream.flush();
 }
 
 bool QBFormat::setVoxel(voxel::RawVolume* volume, uint32_t x, uint32_t y, uint32_t z, const glm::ivec3& offset, const voxel::Voxel& voxel) {
@@ -190,17 +190,12 @@ voxel::Voxel QBFormat::getVoxel(io::FileStream& stream) {
 	if (alpha == 0) {
 		return voxel::Voxel();
 	}
-	glm::vec4 color(0.0f);
+	uint8_t index;
 	if (_colorFormat == ColorFormat::RGBA) {
-		color.r = (float)red / 255.0f;
-		color.b = (float)blue / 255.0f;
+		index = findClosestIndex(red, green, blue);
 	} else {
-		color.r = (float)blue / 255.0f;
-		color.b = (float)red / 255.0f;
+		index = findClosestIndex(blue, green, red);
 	}
-	color.g = (float)green / 255.0f;
-	color.a = (float)alpha / 255.0f;
-	const uint8_t index = findClosestIndex(color);
 	voxel::VoxelType voxelType = voxel::VoxelType::Generic;
 	if (index == 0 && alpha == 0u) {
 		voxelType = voxel::VoxelType::Air;
@@ -209,7 +209,7 @@ bool QBTFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 	}
 	saveModel(stream, volumes, colorMap);
 	Log::debug("Saved %i layers", layers);
-	return success;
+	return success && stream.flush();
 }
 
 bool QBTFormat::skipNode(io::FileStream& stream) {
@@ -369,8 +369,7 @@ bool QBTFormat::loadMatrix(io::FileStream& stream, VoxelVolumes& volumes) {
 					const voxel::Voxel& voxel = voxel::createVoxel(voxel::VoxelType::Generic, red);
 					volume->setVoxel(position.x + x, position.y + y, position.z + z, voxel);
 				} else {
-					const glm::vec4& color = core::Color::fromRGBA(red | green | blue | alpha);
-					const uint8_t index = findClosestIndex(color);
+					const uint8_t index = paletteLookup().findClosestIndex(red | green | blue | alpha);
 					const voxel::Voxel& voxel = voxel::createVoxel(voxel::VoxelType::Generic, index);
 					volume->setVoxel(position.x + x, position.y + y, position.z + z, voxel);
 				}
@@ -153,7 +153,7 @@ bool QEFFormat::saveGroups(const VoxelVolumes &volumes, const io::FilePtr &file)
 		}
 	}
 	delete mergedVolume;
-	return true;
+	return stream.flush();
 }
 
 #undef wrap
@@ -189,7 +189,7 @@ bool VXLFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 	for (uint32_t i = 0; i < volumes.size(); ++i) {
 		wrapBool(writeLimbFooter(stream, volumes, i, limbOffsets[i]))
 	}
-	return true;
+	return stream.flush();
 }
 
 bool VXLFormat::readLimb(io::FileStream& stream, vxl_mdl& mdl, uint32_t limbIdx, VoxelVolumes& volumes) const {
@@ -362,12 +362,9 @@ bool VXLFormat::readHeader(io::FileStream& stream, vxl_mdl& mdl) {
 
 	if (valid) {
 		// convert to our palette
-		const MaterialColorArray& materialColors = getMaterialColors();
 		for (uint32_t i = 0; i < _paletteSize; ++i) {
 			const uint8_t *p = hdr.palette[i];
-			const glm::vec4& color = core::Color::fromRGBA(p[0], p[1], p[2], 0xffu);
-			const int index = core::Color::getClosestMatch(color, materialColors);
-			_palette[i] = index;
+			_palette[i] = findClosestIndex(p[0], p[1], p[2]);
 		}
 	} else {
 		_paletteSize = 0;
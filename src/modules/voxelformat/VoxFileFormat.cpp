@@ -5,6 +5,8 @@
 #include "VoxFileFormat.h"
 #include "core/Var.h"
 #include "core/collection/DynamicArray.h"
+#include "core/concurrent/Concurrency.h"
+#include "core/concurrent/ThreadPool.h"
 #include "voxel/CubicSurfaceExtractor.h"
 #include "voxel/IsQuadNeeded.h"
 #include "voxel/MaterialColor.h"
@@ -33,16 +35,25 @@ uint8_t VoxFileFormat::convertPaletteIndex(uint32_t paletteIndex) const {
 	return _palette[paletteIndex];
 }
 
-glm::vec4 VoxFileFormat::findClosestMatch(const glm::vec4& color) const {
+PaletteLookup& VoxFileFormat::paletteLookup() {
+	if (!_paletteLookup) {
+		_paletteLookup = std::make_shared<PaletteLookup>(voxel::getMaterialColors());
+	}
+	return *_paletteLookup;
+}
+
+glm::vec4 VoxFileFormat::findClosestMatch(const glm::vec4& color) {
 	const int index = findClosestIndex(color);
-	voxel::MaterialColorArray materialColors = voxel::getMaterialColors();
+	const voxel::MaterialColorArray& materialColors = voxel::getMaterialColors();
 	return materialColors[index];
 }
 
-uint8_t VoxFileFormat::findClosestIndex(const glm::vec4& color) const {
-	const voxel::MaterialColorArray& materialColors = voxel::getMaterialColors();
-	//materialColors.erase(materialColors.begin());
-	return core::Color::getClosestMatch(color, materialColors);
+uint8_t VoxFileFormat::findClosestIndex(const glm::vec4& color) {
+	return paletteLookup().findClosestIndex(color);
+}
+
+uint8_t VoxFileFormat::findClosestIndex(uint8_t r, uint8_t g, uint8_t b) {
+	return paletteLookup().findClosestIndex(r, g, b);
 }
 
 RawVolume* VoxFileFormat::merge(const VoxelVolumes& volumes) const {
@@ -79,14 +90,17 @@ bool MeshExporter::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& fi
 	const bool withColor = core::Var::get("voxformat_withcolor", "true", core::CV_NOPERSIST)->boolVal();
 	const bool withTexCoords = core::Var::get("voxformat_withtexcoords", "true", core::CV_NOPERSIST)->boolVal();
 
+	core::ThreadPool threadPool(core::cpus(), "MeshExport");
+	threadPool.init();
 	Meshes meshes;
 	for (const VoxelVolume& v : volumes) {
 		voxel::Mesh *mesh = new voxel::Mesh();
 		voxel::Region region = v.volume->region();
 		region.shiftUpperCorner(1, 1, 1);
-		voxel::extractCubicMesh(v.volume, region, mesh, voxel::IsQuadNeeded(), glm::ivec3(0), mergeQuads, reuseVertices, ambientOcclusion);
+		voxel::extractCubicMeshParallel(threadPool, v.volume, region, mesh, voxel::IsQuadNeeded(), glm::ivec3(0), mergeQuads, reuseVertices, ambientOcclusion);
 		meshes.emplace_back(mesh, v.name);
 	}
+	threadPool.shutdown();
 	Log::debug("Save meshes");
 	const bool state = saveMeshes(meshes, file, scale, quads, withColor, withTexCoords);
 	for (MeshExt& meshext : meshes) {
@@ -9,7 +9,9 @@
 #include "voxel/RawVolume.h"
 #include "io/File.h"
 #include "VoxelVolumes.h"
+#include "PaletteLookup.h"
 #include <glm/fwd.hpp>
+#include <memory>
 
 namespace voxel {
 
@@ -19,10 +21,16 @@ class VoxFileFormat {
 protected:
 	core::Array<uint8_t, 256> _palette;
 	size_t _paletteSize = 0;
+	std::shared_ptr<PaletteLookup> _paletteLookup;
 
 	const glm::vec4& getColor(const Voxel& voxel) const;
-	glm::vec4 findClosestMatch(const glm::vec4& color) const;
-	uint8_t findClosestIndex(const glm::vec4& color) const;
+	/**
+	 * @brief The closest match lookup is created on first use with the current material colors
+	 */
+	PaletteLookup& paletteLookup();
+	glm::vec4 findClosestMatch(const glm::vec4& color);
+	uint8_t findClosestIndex(const glm::vec4& color);
+	uint8_t findClosestIndex(uint8_t r, uint8_t g, uint8_t b);
 	/**
 	 * @brief Maps a custum palette index to our own 256 color palette by a closest match
 	 */
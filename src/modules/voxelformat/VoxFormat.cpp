@@ -317,7 +317,7 @@ bool VoxFormat::saveGroups(const VoxelVolumes& volumes, const io::FilePtr& file)
 
 	wrapBool(saveSceneGraph(stream, volumes, modelId))
 
-	return true;
+	return stream.flush();
 }
 
 bool VoxFormat::readAttributes(Attributes& attributes, io::FileStream& stream) const {
@@ -389,12 +389,8 @@ void VoxFormat::initPalette() {
 
 	_paletteSize = lengthof(palette);
 	// convert to our palette
-	const MaterialColorArray& materialColors = getMaterialColors();
 	for (size_t i = 0u; i < _paletteSize; ++i) {
-		const uint32_t p = palette[i];
-		const glm::vec4& color = core::Color::fromRGBA(p);
-		const int index = core::Color::getClosestMatch(color, materialColors);
-		_palette[i] = index;
+		_palette[i] = paletteLookup().findClosestIndex(palette[i]);
 	}
 }
 
@@ -437,7 +433,7 @@ bool VoxFormat::loadChunk_RGBA(io::FileStream& stream, const ChunkHeader& header
 		uint32_t rgba;
 		wrap(stream.readInt(rgba))
 		const glm::vec4& color = core::Color::fromRGBA(rgba);
-		const int index = core::Color::getClosestMatch(color, materialColors);
+		const int index = paletteLookup().findClosestIndex(rgba);
 		Log::trace("rgba %x, r: %f, g: %f, b: %f, a: %f, index: %i, r2: %f, g2: %f, b2: %f, a2: %f",
 				rgba, color.r, color.g, color.b, color.a, index, materialColors[index].r, materialColors[index].g, materialColors[index].b, materialColors[index].a);
 		_palette[i + 1] = (uint8_t)index;
@@ -0,0 +1,83 @@
+/**
+ * @file
+ */
+
+#include "app/benchmark/AbstractBenchmark.h"
+#include "core/ArrayLength.h"
+#include "core/Log.h"
+#include "io/Filesystem.h"
+#include "voxel/MaterialColor.h"
+#include "voxelformat/VolumeFormat.h"
+#include "voxelformat/VoxelVolumes.h"
+
+/**
+ * @brief Loads and saves the test models of the supported formats
+ */
+class VoxelFormatBenchmark: public app::AbstractBenchmark {
+protected:
+	voxel::VoxelVolumes _volumes;
+
+	bool onInitApp() override {
+		return voxel::initDefaultMaterialColors();
+	}
+
+	bool load(const char *filename, voxel::VoxelVolumes& volumes) {
+		const io::FilePtr& file = io::filesystem()->open(filename);
+		if (!voxelformat::loadVolumeFormat(file, volumes)) {
+			Log::error("Failed to load %s", filename);
+			return false;
+		}
+		return true;
+	}
+
+public:
+	void TearDown(benchmark::State& st) override {
+		voxelformat::clearVolumes(_volumes);
+		app::AbstractBenchmark::TearDown(st);
+	}
+};
+
+static const char *LoadFiles[] = {
+	"qubicle.qb", "qubicle.qbt", "qubicle.qef", "aceofspades.vxl", "chronovox-studio.csm", "cc.vxl",
+	"test.binvox", "test.kvx", "test.kv6", "magicavoxel.vox", "test.vxm", "cw.cub", "rgb.vxl",
+	"rgb.vox", "rgb.qb", "rgb.cub"
+};
+
+// binvox is missing - the exporter only supports volumes with the same height and depth
+static const char *SaveExtensions[] = {
+	"qb", "qbt", "vox", "qef", "cub", "vxl"
+};
+
+BENCHMARK_DEFINE_F(VoxelFormatBenchmark, load) (benchmark::State& state) {
+	const char *filename = LoadFiles[state.range(0)];
+	state.SetLabel(filename);
+	for (auto _ : state) {
+		if (!load(filename, _volumes)) {
+			state.SkipWithError("Failed to load the model");
+			break;
+		}
+		voxelformat::clearVolumes(_volumes);
+	}
+}
+
+BENCHMARK_DEFINE_F(VoxelFormatBenchmark, save) (benchmark::State& state) {
+	const char *extension = SaveExtensions[state.range(0)];
+	state.SetLabel(extension);
+	if (!load("qubicle.qb", _volumes)) {
+		state.SkipWithError("Failed to load the model");
+		return;
+	}
+	const core::String filename = core::String("benchmark-save.") + extension;
+	for (auto _ : state) {
+		const io::FilePtr& file = io::filesystem()->open(filename, io::FileMode::Write);
+		if (!voxelformat::saveVolumeFormat(file, _volumes)) {
+			state.SkipWithError("Failed to save the model");
+			break;
+		}
+	}
+}
+
+BENCHMARK_REGISTER_F(VoxelFormatBenchmark, load)->DenseRange(0, lengthof(LoadFiles) - 1)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(VoxelFormatBenchmark, save)->DenseRange(0, lengthof(SaveExtensions) - 1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
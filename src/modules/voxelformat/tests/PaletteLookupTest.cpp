@@ -0,0 +1,54 @@
+/**
+ * @file
+ */
+
+#include "voxel/tests/AbstractVoxelTest.h"
+#include "voxelformat/PaletteLookup.h"
+#include "voxel/MaterialColor.h"
+#include "core/Color.h"
+
+namespace voxel {
+
+class PaletteLookupTest: public AbstractVoxelTest {
+};
+
+TEST_F(PaletteLookupTest, testMatchesClosestMatch) {
+	const MaterialColorArray& materialColors = getMaterialColors();
+	ASSERT_FALSE(materialColors.empty());
+	PaletteLookup lookup(materialColors);
+	// query every color twice to also check the cached results
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int r = 0; r < 256; r += 15) {
+			for (int g = 0; g < 256; g += 17) {
+				for (int b = 0; b < 256; b += 13) {
+					const glm::vec4& color = core::Color::fromRGBA(r, g, b, 255);
+					const uint8_t expected = (uint8_t)core::Color::getClosestMatch(color, materialColors);
+					ASSERT_EQ(expected, lookup.findClosestIndex(r, g, b)) << r << ":" << g << ":" << b;
+					ASSERT_EQ(expected, lookup.findClosestIndex(color)) << r << ":" << g << ":" << b;
+				}
+			}
+		}
+	}
+}
+
+TEST_F(PaletteLookupTest, testPaletteColors) {
+	const MaterialColorArray& materialColors = getMaterialColors();
+	PaletteLookup lookup(materialColors);
+	for (size_t i = 0; i < materialColors.size(); ++i) {
+		const uint32_t rgba = core::Color::getRGBA(materialColors[i]);
+		const glm::vec4& color = core::Color::fromRGBA(rgba);
+		EXPECT_EQ((uint8_t)core::Color::getClosestMatch(color, materialColors), lookup.findClosestIndex(rgba));
+	}
+}
+
+TEST_F(PaletteLookupTest, testNonByteColors) {
+	const MaterialColorArray& materialColors = getMaterialColors();
+	PaletteLookup lookup(materialColors);
+	const glm::vec4 colors[] = {glm::vec4(0.1f, 0.2f, 0.3f, 1.0f), glm::vec4(0.123f, 0.9f, 0.5f, 0.5f),
+								glm::vec4(0.999f, 0.001f, 0.5f, 1.0f)};
+	for (const glm::vec4& color : colors) {
+		EXPECT_EQ((uint8_t)core::Color::getClosestMatch(color, materialColors), lookup.findClosestIndex(color));
+	}
+}
+
+}
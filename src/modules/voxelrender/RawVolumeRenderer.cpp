@@ -385,7 +385,10 @@ bool RawVolumeRenderer::extractRegion(int idx, const voxel::Region& region) {
 					continue;
 				}
 
-				voxel::RawVolume copy(volume);
+				// the extractor peeks at the neighbours of the voxels in the region - and the upper corner is
+				// shifted by one below. Only this part of the volume is copied for the extraction task.
+				voxel::Region copyRegion(finalRegion.getLowerCorner() - 1, finalRegion.getUpperCorner() + 2);
+				voxel::RawVolume copy(*volume, copyRegion);
 				_threadPool.enqueue([movedCopy = core::move(copy), mins, idx, finalRegion, this] () {
 					++_runningExtractorTasks;
 					voxel::Region reg = finalRegion;
@@ -29,12 +29,14 @@ template<typename MergeCondition = MergeSkipEmpty, class Volume1, class Volume2>
 int mergeVolumes(Volume1* destination, const Volume2* source, const Region& destReg, const Region& sourceReg, MergeCondition mergeCondition = MergeCondition()) {
 	core_trace_scoped(MergeRawVolumes);
 	int cnt = 0;
+	typename Volume2::Sampler sourceSampler(source);
 	for (int32_t z = sourceReg.getLowerZ(); z <= sourceReg.getUpperZ(); ++z) {
 		const int destZ = destReg.getLowerZ() + z - sourceReg.getLowerZ();
 		for (int32_t y = sourceReg.getLowerY(); y <= sourceReg.getUpperY(); ++y) {
 			const int destY = destReg.getLowerY() + y - sourceReg.getLowerY();
-			for (int32_t x = sourceReg.getLowerX(); x <= sourceReg.getUpperX(); ++x) {
-				const Voxel& voxel = source->voxel(x, y, z);
+			sourceSampler.setPosition(sourceReg.getLowerX(), y, z);
+			for (int32_t x = sourceReg.getLowerX(); x <= sourceReg.getUpperX(); ++x, sourceSampler.movePositiveX()) {
+				const Voxel& voxel = sourceSampler.voxel();
 				if (!mergeCondition(voxel)) {
 					continue;
 				}
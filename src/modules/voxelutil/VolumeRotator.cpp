@@ -53,8 +53,8 @@ RawVolume* rotateVolume(const RawVolume* source, const glm::vec3& angles, const
 
 	for (int32_t z = srcRegion.getLowerZ(); z <= srcRegion.getUpperZ(); ++z) {
 		for (int32_t y = srcRegion.getLowerY(); y <= srcRegion.getUpperY(); ++y) {
-			for (int32_t x = srcRegion.getLowerX(); x <= srcRegion.getUpperX(); ++x) {
-				srcSampler.setPosition(x, y, z);
+			srcSampler.setPosition(srcRegion.getLowerX(), y, z);
+			for (int32_t x = srcRegion.getLowerX(); x <= srcRegion.getUpperX(); ++x, srcSampler.movePositiveX()) {
 				const Voxel& v = srcSampler.voxel();
 				if (v == empty) {
 					continue;
@@ -103,8 +103,8 @@ RawVolume* rotateAxis(const RawVolume* source, math::Axis axis) {
 
 	for (int32_t z = srcRegion.getLowerZ(); z <= srcRegion.getUpperZ(); ++z) {
 		for (int32_t y = srcRegion.getLowerY(); y <= srcRegion.getUpperY(); ++y) {
-			for (int32_t x = srcRegion.getLowerX(); x <= srcRegion.getUpperX(); ++x) {
-				srcSampler.setPosition(x, y, z);
+			srcSampler.setPosition(srcRegion.getLowerX(), y, z);
+			for (int32_t x = srcRegion.getLowerX(); x <= srcRegion.getUpperX(); ++x, srcSampler.movePositiveX()) {
 				const Voxel& v = srcSampler.voxel();
 				glm::ivec3 pos(x, y, z);
 				if (axis == math::Axis::X) {
@@ -51,11 +51,28 @@ voxel::PagedVolume::Sampler WorldMgr::sampler() {
 	return voxel::PagedVolume::Sampler(_volumeData);
 }
 
-bool WorldMgr::init(uint32_t volumeMemoryMegaBytes, uint16_t chunkSideLength) {
-	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength);
+bool WorldMgr::init(uint32_t volumeMemoryMegaBytes, uint16_t chunkSideLength, uint32_t compressedMemoryMegaBytes) {
+	_volumeData = new voxel::PagedVolume(_pager.get(), volumeMemoryMegaBytes * 1024 * 1024, chunkSideLength, compressedMemoryMegaBytes * 1024 * 1024);
 	return true;
 }
 
+void WorldMgr::startAsyncPaging(int threads) {
+	core_assert_msg(_volumeData != nullptr, "WorldMgr is not initialized");
+	_volumeData->startAsyncPaging(threads);
+}
+
+void WorldMgr::prefetch(const glm::ivec3& position, int distance) const {
+	core_assert_msg(_volumeData != nullptr, "WorldMgr is not initialized");
+	const glm::ivec3 mins(position.x - distance, 0, position.z - distance);
+	const glm::ivec3 maxs(position.x + distance, voxel::MAX_HEIGHT - 1, position.z + distance);
+	_volumeData->prefetch(voxel::Region(mins, maxs), position);
+}
+
+voxel::PagedVolume::PagingStats WorldMgr::pagingStats() const {
+	core_assert_msg(_volumeData != nullptr, "WorldMgr is not initialized");
+	return _volumeData->pagingStats();
+}
+
 void WorldMgr::shutdown() {
 	delete _volumeData;
 	_volumeData = nullptr;
@@ -47,10 +47,29 @@ public:
 	 */
 	voxelutil::FloorTraceResult findWalkableFloor(const glm::ivec3& position, int maxDistanceUpwards = voxel::MAX_HEIGHT) const;
 
-	bool init(uint32_t volumeMemoryMegaBytes = 1024, uint16_t chunkSideLength = 256);
+	/**
+	 * @param volumeMemoryMegaBytes The memory budget for the uncompressed chunks
+	 * @param chunkSideLength The side length of a chunk - must be a power of two
+	 * @param compressedMemoryMegaBytes The memory budget for evicted chunks that are kept compressed in memory
+	 * before they are handed over to the pager. @c 0 disables the compressed tier.
+	 */
+	bool init(uint32_t volumeMemoryMegaBytes = 1024, uint16_t chunkSideLength = 256, uint32_t compressedMemoryMegaBytes = 512);
 	void shutdown();
 	void reset();
 
+	/**
+	 * @brief Chunks are paged in by the given amount of background threads once they were requested via
+	 * @c prefetch(). Call this after the pager was initialized.
+	 * @sa voxel::PagedVolume::startAsyncPaging()
+	 */
+	void startAsyncPaging(int threads);
+	/**
+	 * @brief Queues the chunks around the given position (over the full world height) for async paging.
+	 * Closer chunks are paged in first.
+	 */
+	void prefetch(const glm::ivec3& position, int distance) const;
+	voxel::PagedVolume::PagingStats pagingStats() const;
+
 	/**
 	 * @brief Returns a random position inside the boundaries of the world (on the surface)
 	 */
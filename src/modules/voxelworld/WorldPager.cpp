@@ -72,6 +72,7 @@ bool WorldPager::init(voxel::PagedVolume *volumeData, const core::String& worldP
 
 void WorldPager::shutdown() {
 	if (_volumeData != nullptr) {
+		_volumeData->stopAsyncPaging();
 		_volumeData->flushAll();
 	}
 	_noise.shutdown();
@@ -136,19 +137,47 @@ int WorldPager::terrainHeight(int x, int y, int z) const {
 	return terrainHeight(x, y, z, n);
 }
 
-int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
-	core_trace_scoped(TerrainHeight);
+void WorldPager::getDensities(int x, int minsY, int maxsY, int z, float n, float* densities) const {
+	core_trace_scoped(DensityValues);
+	const int amount = maxsY - minsY;
+	if (amount <= 0) {
+		return;
+	}
+	core_assert(minsY >= 0 && maxsY <= voxel::MAX_TERRAIN_HEIGHT);
+	// the same values that getDensity() would feed into the noise - but as separate arrays for the batch fBm
+	float noiseX[voxel::MAX_TERRAIN_HEIGHT];
+	float noiseY[voxel::MAX_TERRAIN_HEIGHT];
+	float noiseZ[voxel::MAX_TERRAIN_HEIGHT];
+	const float frequency = _worldCtx.caveNoiseFrequency;
+	const float columnX = (_noiseSeedOffset.x + (float)x) * frequency;
+	const float columnZ = (_noiseSeedOffset.y + (float)z) * frequency;
+	for (int i = 0; i < amount; ++i) {
+		noiseX[i] = columnX;
+		noiseY[i] = (float)(minsY + i) * frequency;
+		noiseZ[i] = columnZ;
+	}
+	float* out = densities + minsY;
+	noise::fBm(noiseX, noiseY, noiseZ, out, amount, _worldCtx.caveNoiseOctaves, _worldCtx.caveNoiseLacunarity, _worldCtx.caveNoiseGain);
+	for (int i = 0; i < amount; ++i) {
+		out[i] = n + noise::norm(out[i]);
+	}
+}
+
+int WorldPager::surfaceHeight(int x, int z, float n) const {
 	const int maxHeight = voxel::MAX_TERRAIN_HEIGHT - 1;
 	int centerHeight;
 	// the center of a city should make the terrain more even
 	const float cityMultiplier = _biomeManager.getCityMultiplier(glm::ivec2(x, z), &centerHeight);
-	int ni;
 	if (cityMultiplier < 1.0f) {
 		const float revn = (1.0f - cityMultiplier);
-		ni = revn * centerHeight + (cityMultiplier * n * maxHeight);
-	} else {
-		ni = n * maxHeight;
+		return revn * centerHeight + (cityMultiplier * n * maxHeight);
 	}
+	return n * maxHeight;
+}
+
+int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
+	core_trace_scoped(TerrainHeight);
+	int ni = surfaceHeight(x, z, n);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
 		const float density = getDensity(x, y, z, n);
 		if (density > _worldCtx.caveDensityThreshold) {
@@ -162,7 +191,17 @@ int WorldPager::terrainHeight(int x, int minsY, int z, float n) const {
 int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const {
 	core_trace_scoped(FillVoxels);
 	const float n = getNoiseValue(x, z);
-	const int ni = terrainHeight(x, minsY, z, n);
+	// evaluate the cave noise for the whole column at once - the carving and the filling below share the values
+	const int surface = surfaceHeight(x, z, n);
+	float densities[voxel::MAX_TERRAIN_HEIGHT];
+	getDensities(x, minsY + 1, surface, z, n, densities);
+	int ni = surface;
+	for (int y = ni - 1; y >= minsY + 1; --y) {
+		if (densities[y] > _worldCtx.caveDensityThreshold) {
+			break;
+		}
+		--ni;
+	}
 	if (ni < minsY) {
 		return 0;
 	}
@@ -174,8 +213,7 @@ int WorldPager::fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const
 	voxels[0] = dirt;
 	glm::ivec3 pos(x, 0, z);
 	for (int y = ni - 1; y >= minsY + 1; --y) {
-		const float density = getDensity(x, y, z, n);
-		if (density > _worldCtx.caveDensityThreshold) {
+		if (densities[y] > _worldCtx.caveDensityThreshold) {
 			const bool cave = y < ni - 1;
 			pos.y = y;
 			const voxel::Voxel& voxel = _biomeManager.getVoxel(pos, cave);
@@ -31,6 +31,8 @@ namespace voxelworld {
  */
 class WorldPager: public voxel::PagedVolume::Pager {
 private:
+	friend class WorldPagerTest;
+
 	unsigned int _seed = 0l;
 	glm::vec2 _noiseSeedOffset;
 
@@ -47,6 +49,10 @@ private:
 
 	int terrainHeight(int x, int minsY, int z) const;
 	int terrainHeight(int x, int minsY, int z, float n) const;
+	/**
+	 * @return The height of the terrain before the caves are carved out
+	 */
+	int surfaceHeight(int x, int z, float n) const;
 	int fillVoxels(int x, int minsY, int z, voxel::Voxel* voxels) const;
 
 	/**
@@ -54,6 +60,11 @@ private:
 	 */
 	float getNoiseValue(float x, float z) const;
 	float getDensity(float x, float y, float z, float n) const;
+	/**
+	 * @brief Computes getDensity() for a whole column in one batch
+	 * @param[out] densities Receives the density values in the slots [minsY, maxsY)
+	 */
+	void getDensities(int x, int minsY, int maxsY, int z, float n, float* densities) const;
 
 public:
 	WorldPager(const voxelformat::VolumeCachePtr& volumeCache, const ChunkPersisterPtr& chunkPersister);
@@ -86,8 +97,17 @@ public:
 	 */
 	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override;
 	void pageOut(voxel::PagedVolume::Chunk* chunk) override;
+	/**
+	 * @note The world generation only writes into the chunk that is paged in, the tree volumes are loaded from the
+	 * (locked) volume cache and each chunk is persisted into its own file.
+	 */
+	bool concurrentPageIn() const override;
 };
 
+inline bool WorldPager::concurrentPageIn() const {
+	return true;
+}
+
 inline const ChunkPersisterPtr& WorldPager::chunkPersister() const {
 	return _chunkPersister;
 }
@@ -8,6 +8,7 @@
 #include "voxelworld/BiomeManager.h"
 #include "voxel/Constants.h"
 #include "voxelformat/VolumeCache.h"
+#include "noise/Simplex.h"
 
 class PagedVolumeBenchmark: public app::AbstractBenchmark {
 protected:
@@ -45,4 +46,83 @@ BENCHMARK_DEFINE_F(PagedVolumeBenchmark, pageIn) (benchmark::State& state) {
 
 BENCHMARK_REGISTER_F(PagedVolumeBenchmark, pageIn);
 
+class ContentionPager: public voxel::PagedVolume::Pager {
+public:
+	bool pageIn(voxel::PagedVolume::PagerContext& ctx) override {
+		return false;
+	}
+
+	void pageOut(voxel::PagedVolume::Chunk* chunk) override {
+	}
+};
+
+static ContentionPager contentionPager;
+static voxel::PagedVolume *contentionVolume = nullptr;
+
+/**
+ * Several threads are looking up chunks of the same volume - like the mesh extraction, the floor
+ * resolving and the server map updates are doing. Four rows of chunks with the given range as length
+ * are touched - the uniform chunks only need a few bytes, the volume is limited to 256 of them and is evicting
+ * chunks for the largest range.
+ */
+static void chunkContention(benchmark::State& state) {
+	const int chunkSideLength = 32;
+	if (state.thread_index == 0) {
+		contentionVolume = new voxel::PagedVolume(&contentionPager, 2 * 1024 * 1024, chunkSideLength);
+	}
+	const int chunks = (int)state.range(0);
+	int i = state.thread_index;
+	while (state.KeepRunning()) {
+		const glm::ivec3 pos((i % chunks) * chunkSideLength, 0, ((i / chunks) % 4) * chunkSideLength);
+		benchmark::DoNotOptimize(contentionVolume->chunk(pos));
+		++i;
+	}
+	if (state.thread_index == 0) {
+		delete contentionVolume;
+		contentionVolume = nullptr;
+	}
+}
+
+BENCHMARK(chunkContention)->Arg(4)->Arg(16)->Arg(64)->ThreadRange(1, 8)->UseRealTime();
+
+/**
+ * The cave noise of a terrain column like WorldPager::fillVoxels() is evaluating it - once for each voxel and
+ * once with the batched fBm.
+ */
+static void caveNoiseColumn(benchmark::State& state) {
+	const int height = (int)state.range(0);
+	int column = 0;
+	while (state.KeepRunning()) {
+		for (int y = 0; y < height; ++y) {
+			const glm::vec3 pos((float)column, (float)y, (float)-column);
+			benchmark::DoNotOptimize(noise::fBm(pos * 0.02f, 1, 0.1f, 0.1f));
+		}
+		++column;
+	}
+	state.SetItemsProcessed(state.iterations() * height);
+}
+
+static void caveNoiseColumnBatch(benchmark::State& state) {
+	const int height = (int)state.range(0);
+	float x[voxel::MAX_TERRAIN_HEIGHT];
+	float y[voxel::MAX_TERRAIN_HEIGHT];
+	float z[voxel::MAX_TERRAIN_HEIGHT];
+	float out[voxel::MAX_TERRAIN_HEIGHT];
+	int column = 0;
+	while (state.KeepRunning()) {
+		for (int i = 0; i < height; ++i) {
+			x[i] = (float)column * 0.02f;
+			y[i] = (float)i * 0.02f;
+			z[i] = (float)-column * 0.02f;
+		}
+		noise::fBm(x, y, z, out, height, 1, 0.1f, 0.1f);
+		benchmark::DoNotOptimize(out);
+		++column;
+	}
+	state.SetItemsProcessed(state.iterations() * height);
+}
+
+BENCHMARK(caveNoiseColumn)->Arg(16)->Arg(voxel::MAX_TERRAIN_HEIGHT);
+BENCHMARK(caveNoiseColumnBatch)->Arg(16)->Arg(voxel::MAX_TERRAIN_HEIGHT);
+
 BENCHMARK_MAIN();
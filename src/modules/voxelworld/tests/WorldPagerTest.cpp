@@ -0,0 +1,90 @@
+/**
+ * @file
+ */
+
+#include "AbstractVoxelTest.h"
+#include "voxelworld/WorldPager.h"
+#include "voxelformat/VolumeCache.h"
+#include "io/Filesystem.h"
+
+namespace voxelworld {
+
+class WorldPagerTest: public AbstractVoxelTest {
+protected:
+	voxelformat::VolumeCachePtr _volumeCache;
+	WorldPager* _worldPager = nullptr;
+	voxel::PagedVolume* _worldVolume = nullptr;
+
+	/**
+	 * @return fnv1a hash over the terrain heights and the voxel materials of the given columns. The colors are
+	 * not part of the hash, they are randomized by the biomes.
+	 */
+	uint32_t hashColumns(int lowerX, int lowerZ, int size) const {
+		uint32_t hash = 2166136261u;
+		auto hashValue = [&hash] (int value) {
+			hash = (hash ^ (uint32_t)value) * 16777619u;
+		};
+		for (int z = lowerZ; z < lowerZ + size; z += 2) {
+			for (int x = lowerX; x < lowerX + size; x += 2) {
+				voxel::Voxel voxels[voxel::MAX_TERRAIN_HEIGHT];
+				const int n = fillVoxels(x, z, voxels);
+				hashValue(n);
+				for (int y = 0; y < n; ++y) {
+					hashValue((int)voxels[y].getMaterial());
+				}
+			}
+		}
+		return hash;
+	}
+
+	int fillVoxels(int x, int z, voxel::Voxel* voxels) const {
+		return _worldPager->fillVoxels(x, 0, z, voxels);
+	}
+
+	int terrainHeight(int x, int z) const {
+		return _worldPager->terrainHeight(x, 0, z);
+	}
+
+public:
+	void SetUp() override {
+		AbstractVoxelTest::SetUp();
+		_volumeCache = std::make_shared<voxelformat::VolumeCache>();
+		ASSERT_TRUE(_volumeCache->init());
+		_worldPager = new WorldPager(_volumeCache, std::make_shared<ChunkPersister>());
+		_worldPager->setSeed(1);
+		_worldVolume = new voxel::PagedVolume(_worldPager, 16 * 1024 * 1024, 64);
+		const io::FilesystemPtr& filesystem = io::filesystem();
+		ASSERT_TRUE(_worldPager->init(_worldVolume, filesystem->load("worldparams.lua"), filesystem->load("biomes.lua")));
+	}
+
+	void TearDown() override {
+		_worldPager->shutdown();
+		delete _worldVolume;
+		delete _worldPager;
+		_volumeCache->shutdown();
+		AbstractVoxelTest::TearDown();
+	}
+};
+
+/**
+ * The expected hashes were recorded with the scalar terrain generation - the batched noise evaluation must produce
+ * exactly the same terrain for a given seed.
+ */
+TEST_F(WorldPagerTest, testFillVoxelsGolden) {
+	EXPECT_EQ(1516963530u, hashColumns(-128, -128, 256));
+	EXPECT_EQ(2379831577u, hashColumns(10000, -7000, 256));
+	EXPECT_EQ(4032248190u, hashColumns(-123457, 98765, 128));
+}
+
+TEST_F(WorldPagerTest, testTerrainHeight) {
+	for (int z = -64; z < 64; z += 2) {
+		for (int x = -64; x < 64; x += 2) {
+			voxel::Voxel voxels[voxel::MAX_TERRAIN_HEIGHT];
+			const int n = fillVoxels(x, z, voxels);
+			const int height = terrainHeight(x, z);
+			ASSERT_EQ(core_max(height, voxel::MAX_WATER_HEIGHT), n) << "Column " << x << ":" << z;
+		}
+	}
+}
+
+}
@@ -97,12 +97,16 @@ void WorldMeshExtractor::extractScheduledMesh() {
 	const glm::ivec3 mins(pos);
 	const glm::ivec3 maxs(pos.x + size.x - 1, pos.y + size.y - 2, pos.z + size.z - 1);
 	const voxel::Region region(mins, maxs);
+	// the extraction also looks at the voxels in front of the lower corner
+	if (_volume->isUniform(voxel::Region(mins - 1, maxs))) {
+		return;
+	}
 	// these numbers are made up mostly by try-and-error - we need to revisit them from time to time to prevent extra mem allocs
 	// they also heavily depend on the size of the mesh region we extract
 	const int factor = 64;
 	const int vertices = region.getWidthInVoxels() * region.getDepthInVoxels() * factor;
 	voxel::Mesh mesh(vertices, vertices);
-	voxel::extractCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner());
+	voxel::extractCubicMesh(_volume, region, &mesh, voxel::IsQuadNeeded(), region.getLowerCorner(), true, true, true, true);
 	if (!mesh.isEmpty()) {
 		_extracted.push(std::move(mesh));
 	}
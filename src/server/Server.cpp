@@ -51,8 +51,17 @@ app::AppState Server::onConstruct() {
 	core::Var::get(cfg::ServerPort, SERVER_PORT);
 	core::Var::get(cfg::ServerHost, "0.0.0.0");
 	core::Var::get(cfg::ServerMaxClients, "1024");
+	core::Var::get(cfg::ServerTrustedHosts, "");
 	core::Var::get(cfg::ServerHttpPort, HTTP_SERVER_PORT, core::CV_REPLICATE);
 	core::Var::get(cfg::ServerSeed, "1", core::CV_REPLICATE);
+	core::Var::get(cfg::ServerPagingThreads, "1");
+	core::Var::get(cfg::ServerZoneThreads, "2");
+	core::Var::get(cfg::ServerMaps, "1");
+	core::Var::get(cfg::ServerMapThreads, "2");
+	core::Var::get(cfg::ServerInterestCellSize, "64");
+	core::Var::get(cfg::ServerTickMillis, "100");
+	core::Var::get(cfg::ServerMaxCatchUpTicks, "3");
+	core::Var::get(cfg::ServerMapTickBudget, "50");
 	core::Var::get(cfg::VoxelMeshSize, "16", core::CV_READONLY);
 	core::Var::get(cfg::DatabaseMinConnections, "2");
 	core::Var::get(cfg::DatabaseMaxConnections, "100");
@@ -20,5 +20,6 @@ constexpr const char *VoxEditShowaxis = "ve_showaxis";
 constexpr const char *VoxEditShowlockedaxis = "ve_showlockedaxis";
 constexpr const char *VoxEditRendershadow = "ve_rendershadow";
 constexpr const char *VoxEditAnimationSpeed = "ve_animspeed";
+constexpr const char *VoxEditMaxUndoMemory = "ve_maxundomemory";
 
 }
@@ -3,12 +3,14 @@
  */
 
 #include "MementoHandler.h"
+#include "Config.h"
 
 #include "voxel/Voxel.h"
 #include "voxel/RawVolume.h"
 #include "voxel/Region.h"
 #include "command/Command.h"
 #include "core/Assert.h"
+#include "core/Common.h"
 #include "core/StandardLib.h"
 #include "core/Log.h"
 #include "core/Zip.h"
@@ -16,11 +18,10 @@
 namespace voxedit {
 
 static const MementoState InvalidMementoState{MementoType::Modification, MementoData(), -1, "", voxel::Region::InvalidRegion};
-const int MementoHandler::MaxStates = 64;
 
 MementoData::MementoData(const uint8_t* buf, size_t bufSize,
-		const voxel::Region& _region) :
-		_compressedSize(bufSize), _region(_region) {
+		const voxel::Region& _region, bool delta) :
+		_compressedSize(bufSize), _region(_region), _delta(delta) {
 	if (buf != nullptr) {
 		core_assert(_compressedSize > 0);
 		_buffer = (uint8_t*)core_malloc(_compressedSize);
@@ -33,7 +34,7 @@ MementoData::MementoData(const uint8_t* buf, size_t bufSize,
 MementoData::MementoData(MementoData&& o) noexcept :
 		_compressedSize(std::exchange(o._compressedSize, 0)),
 		_buffer(std::exchange(o._buffer, nullptr)),
-		_region(o._region) {
+		_region(o._region), _delta(o._delta) {
 }
 
 MementoData::~MementoData() {
@@ -45,7 +46,7 @@ MementoData::~MementoData() {
 
 MementoData::MementoData(const MementoData& o) :
 		_compressedSize(o._compressedSize),
-		_region(o._region) {
+		_region(o._region), _delta(o._delta) {
 	if (o._buffer != nullptr) {
 		core_assert(_compressedSize > 0);
 		_buffer = (uint8_t*)core_malloc(_compressedSize);
@@ -63,6 +64,7 @@ MementoData& MementoData::operator=(MementoData &&o) noexcept {
 		}
 		_buffer = std::exchange(o._buffer, nullptr);
 		_region = o._region;
+		_delta = o._delta;
 	}
 	return *this;
 }
@@ -71,6 +73,18 @@ MementoData MementoData::fromVolume(const voxel::RawVolume* volume) {
 	if (volume == nullptr) {
 		return MementoData();
 	}
+	return compress(volume, false);
+}
+
+MementoData MementoData::fromVolume(const voxel::RawVolume* volume, const voxel::Region& region) {
+	if (volume == nullptr || !voxel::intersects(volume->region(), region)) {
+		return MementoData();
+	}
+	const voxel::RawVolume copy(*volume, region);
+	return compress(&copy, true);
+}
+
+MementoData MementoData::compress(const voxel::RawVolume* volume, bool delta) {
 	const size_t uncompressedBufferSize = volume->region().voxels() * sizeof(voxel::Voxel);
 	const uint32_t compressedBufferSize = core::zip::compressBound(uncompressedBufferSize);
 	uint8_t* compressedBuf = (uint8_t*)core_malloc(compressedBufferSize);
@@ -79,7 +93,7 @@ MementoData MementoData::fromVolume(const voxel::RawVolume* volume) {
 		core_free(compressedBuf);
 		return MementoData();
 	}
-	MementoData data(compressedBuf, finalBufSize, volume->region());
+	MementoData data(compressedBuf, finalBufSize, volume->region(), delta);
 	core_free(compressedBuf);
 
 	Log::debug("Memento state. Volume: %i, compressed: %i",
@@ -94,11 +108,22 @@ voxel::RawVolume* MementoData::toVolume(const MementoData& mementoData) {
 	const size_t uncompressedBufferSize = mementoData._region.voxels() * sizeof(voxel::Voxel);
 	uint8_t *uncompressedBuf = (uint8_t*)core_malloc(uncompressedBufferSize);
 	if (!core::zip::uncompress(mementoData._buffer, mementoData._compressedSize, uncompressedBuf, uncompressedBufferSize)) {
+		core_free(uncompressedBuf);
 		return nullptr;
 	}
 	return voxel::RawVolume::createRaw((voxel::Voxel*)uncompressedBuf, mementoData._region);
 }
 
+bool MementoData::toVolume(voxel::RawVolume* volume, const MementoData& mementoData) {
+	voxel::RawVolume* v = toVolume(mementoData);
+	if (v == nullptr) {
+		return false;
+	}
+	const bool success = volume->copyInto(*v);
+	delete v;
+	return success;
+}
+
 MementoHandler::MementoHandler() {
 }
 
@@ -107,7 +132,8 @@ MementoHandler::~MementoHandler() {
 }
 
 bool MementoHandler::init() {
-	_states.reserve(MaxStates);
+	_maxMemory = core::Var::get(cfg::VoxEditMaxUndoMemory, DefaultMaxMemory);
+	_maxMemory->setHelp("The memory budget of the undo states in megabytes");
 	return true;
 }
 
@@ -126,13 +152,14 @@ void MementoHandler::unlock() {
 void MementoHandler::construct() {
 	command::Command::registerCommand("ve_mementoinfo", [&] (const command::CmdArgs& args) {
 		Log::info("Current memento state index: %i", _statePosition);
-		Log::info("Maximum memento states: %i", MaxStates);
+		Log::info("Memento states memory: %i/%i bytes", (int)_memory, (int)maxMemory());
 		int i = 0;
 		for (MementoState& state : _states) {
 			const glm::ivec3& mins = state.region.getLowerCorner();
 			const glm::ivec3& maxs = state.region.getUpperCorner();
-			Log::info("%4i: %i - %s (%s) [mins(%i:%i:%i)/maxs(%i:%i:%i)]",
-					i++, state.layer, state.name.c_str(), state.data._buffer == nullptr ? "empty" : "volume",
+			const char *content = state.data._buffer == nullptr ? "empty" : (state.isDelta() ? "delta" : "volume");
+			Log::info("%4i: %i - %s (%s, %i bytes) [mins(%i:%i:%i)/maxs(%i:%i:%i)]",
+					i++, state.layer, state.name.c_str(), content, (int)(state.data.size() + state.previousData.size()),
 							mins.x, mins.y, mins.z, maxs.x, maxs.y, maxs.z);
 		}
 	});
@@ -140,7 +167,66 @@ void MementoHandler::construct() {
 
 void MementoHandler::clearStates() {
 	_states.clear();
-	_statePosition = 0u;
+	_statePosition = 0;
+	_memory = 0u;
+	for (voxel::RawVolume* v : _volumes) {
+		delete v;
+	}
+	_volumes.clear();
+}
+
+static size_t volumeMemory(const voxel::RawVolume* volume) {
+	if (volume == nullptr) {
+		return 0u;
+	}
+	return (size_t)volume->region().voxels() * sizeof(voxel::Voxel);
+}
+
+size_t MementoHandler::maxMemory() const {
+	const int megabytes = _maxMemory ? _maxMemory->intVal() : DefaultMaxMemory;
+	return (size_t)core_max(megabytes, 0) * 1024u * 1024u;
+}
+
+voxel::RawVolume* MementoHandler::layerVolume(int layer) const {
+	if (layer < 0 || layer >= (int)_volumes.size()) {
+		return nullptr;
+	}
+	return _volumes[layer];
+}
+
+void MementoHandler::setLayerVolume(int layer, voxel::RawVolume* volume) {
+	if (layer < 0) {
+		delete volume;
+		return;
+	}
+	if (layer >= (int)_volumes.size()) {
+		_volumes.resize(layer + 1);
+	}
+	_memory -= volumeMemory(_volumes[layer]);
+	_memory += volumeMemory(volume);
+	delete _volumes[layer];
+	_volumes[layer] = volume;
+}
+
+void MementoHandler::storeWholeVolume(MementoState& state) {
+	if (!state.isDelta()) {
+		return;
+	}
+	const voxel::RawVolume* volume = layerVolume(state.layer);
+	if (volume == nullptr) {
+		Log::warn("No volume for layer %i to replace the region delta", state.layer);
+		return;
+	}
+	_memory -= state.data.size();
+	state.data = MementoData::fromVolume(volume);
+	_memory += state.data.size();
+}
+
+void MementoHandler::removeStates(int from, int to) {
+	for (int i = from; i < to; ++i) {
+		_memory -= _states[i].data.size() + _states[i].previousData.size();
+	}
+	_states.erase(from, to - from);
 }
 
 MementoState MementoHandler::undo() {
@@ -148,17 +234,32 @@ MementoState MementoHandler::undo() {
 		return InvalidMementoState;
 	}
 	core_assert(_statePosition >= 1);
+	const MementoState& current = state();
+	if (current.previousData._buffer != nullptr) {
+		// region delta - restore the voxels of the modified region
+		--_statePosition;
+		voxel::RawVolume* v = layerVolume(current.layer);
+		if (v != nullptr) {
+			MementoData::toVolume(v, current.previousData);
+		}
+		voxel::logRegion("Undo", current.region);
+		return MementoState{current.type, current.previousData, current.layer, current.name, current.region};
+	}
 	--_statePosition;
-	if (_states[_statePosition].data._buffer != nullptr
+	if (_statePosition > 0 && _states[_statePosition].data._buffer != nullptr
 			&& _states[_statePosition].type == MementoType::LayerAdded
 			&& _states[_statePosition + 1].type != MementoType::Modification) {
 		--_statePosition;
 	}
 	Log::debug("Available states: %i, current index: %i", (int)_states.size(), _statePosition);
 	const MementoState& s = state();
+	const MementoType type = _states[_statePosition + 1].type;
+	if (type != MementoType::LayerRenamed) {
+		setLayerVolume(s.layer, MementoData::toVolume(s.data));
+	}
 	const voxel::Region region = _states[_statePosition + 1].region;
 	voxel::logRegion("Undo", region);
-	return MementoState{_states[_statePosition + 1].type, s.data, s.layer, s.name, region};
+	return MementoState{type, s.data, s.layer, s.name, region};
 }
 
 MementoState MementoHandler::redo() {
@@ -167,6 +268,15 @@ MementoState MementoHandler::redo() {
 	}
 	Log::debug("Available states: %i, current index: %i", (int)_states.size(), _statePosition);
 	++_statePosition;
+	if (state().isDelta()) {
+		const MementoState& s = state();
+		voxel::RawVolume* v = layerVolume(s.layer);
+		if (v != nullptr) {
+			MementoData::toVolume(v, s.data);
+		}
+		voxel::logRegion("Redo", s.region);
+		return MementoState{s.type, s.data, s.layer, s.name, s.region};
+	}
 	if (_states[_statePosition].data._buffer == nullptr && _states[_statePosition].type == MementoType::LayerAdded) {
 		++_statePosition;
 	}
@@ -174,6 +284,9 @@ MementoState MementoHandler::redo() {
 		++_statePosition;
 	}
 	const MementoState& s = state();
+	if (s.type != MementoType::LayerRenamed) {
+		setLayerVolume(s.layer, MementoData::toVolume(s.data));
+	}
 	voxel::logRegion("Redo", s.region);
 	return MementoState{s.type, s.data, s.layer, s.name, s.region};
 }
@@ -203,16 +316,38 @@ void MementoHandler::markUndo(int layer, const core::String& name, const voxel::
 		// if we mark something as new undo state, we can throw away
 		// every other state that follows the new one (everything after
 		// the current state position)
-		_states.erase(_statePosition + 1, _states.size());
+		removeStates(_statePosition + 1, (int)_states.size());
 	}
 	Log::debug("New undo state for layer %i with name %s (memento state index: %i)", layer, name.c_str(), (int)_states.size());
 	voxel::logRegion("MarkUndo", region);
-	const MementoData& data = MementoData::fromVolume(volume);
-	_states.emplace_back(type, data, layer, name, region);
-	while (_states.size() > MaxStates) {
-		_states.erase(0);
+	voxel::RawVolume* previous = layerVolume(layer);
+	if (type == MementoType::Modification && volume != nullptr && previous != nullptr && region.isValid()
+			&& previous->region() == volume->region() && voxel::intersects(region, volume->region())) {
+		const voxel::RawVolume modified(*volume, region);
+		MementoData previousData = MementoData::fromVolume(previous, modified.region());
+		previous->copyInto(modified);
+		_states.emplace_back(type, MementoData::compress(&modified, true), layer, name, region);
+		_states.back().previousData = core::move(previousData);
+	} else {
+		if (!_states.empty() && type != MementoType::LayerRenamed) {
+			// the undo step of the new state returns to the data of the current state
+			storeWholeVolume(_states.back());
+		}
+		_states.emplace_back(type, MementoData::fromVolume(volume), layer, name, region);
+		if (type != MementoType::LayerRenamed) {
+			setLayerVolume(layer, volume != nullptr ? new voxel::RawVolume(volume) : nullptr);
+		}
+	}
+	_memory += _states.back().data.size() + _states.back().previousData.size();
+	const size_t maxMem = maxMemory();
+	while (_memory > maxMem && _states.size() > 2) {
+		removeStates(0, 1);
+		// the first state can't be undone anymore
+		MementoState& first = _states[0];
+		_memory -= first.previousData.size();
+		first.previousData = MementoData();
 	}
-	_statePosition = stateSize() - 1;
+	_statePosition = (int)stateSize() - 1;
 }
 
 }
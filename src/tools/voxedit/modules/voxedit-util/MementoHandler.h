@@ -5,6 +5,7 @@
 #pragma once
 
 #include "core/IComponent.h"
+#include "core/Var.h"
 #include "voxel/Region.h"
 #include "voxel/Voxel.h"
 #include "core/collection/DynamicArray.h"
@@ -28,7 +29,8 @@ enum class MementoType {
 /**
  * @brief Holds the data of a memento state
  *
- * The given buffer is owned by this class and represents a compressed volume
+ * The given buffer is owned by this class and represents a compressed volume. For delta states the buffer
+ * only contains the voxels of the modified region - they are applied to the existing volume of the layer.
  */
 class MementoData {
 	friend struct MementoState;
@@ -46,8 +48,13 @@ private:
 	 * The region the given volume data is for
 	 */
 	voxel::Region _region {};
+	/**
+	 * @brief The buffer only contains the voxels of @c _region and not the whole volume
+	 */
+	bool _delta = false;
 
-	MementoData(const uint8_t* buf, size_t bufSize, const voxel::Region& _region);
+	MementoData(const uint8_t* buf, size_t bufSize, const voxel::Region& _region, bool delta = false);
+	static MementoData compress(const voxel::RawVolume* volume, bool delta);
 public:
 	constexpr MementoData() {}
 	MementoData(MementoData&& o) noexcept;
@@ -56,6 +63,13 @@ public:
 
 	MementoData& operator=(MementoData &&o) noexcept;
 
+	/**
+	 * @return The size of the compressed buffer in bytes
+	 */
+	inline size_t size() const {
+		return _compressedSize;
+	}
+
 	/**
 	 * @brief Converts the given @c mementoData into a volume
 	 * @note Keep in mind that you own the returned memory
@@ -63,16 +77,31 @@ public:
 	 * did not contain a valid volume buffer
 	 */
 	static voxel::RawVolume* toVolume(const MementoData& mementoData);
+	/**
+	 * @brief Writes the voxels of the given @c mementoData into the given volume
+	 * @return @c false if the memento data didn't contain a valid buffer or the region doesn't intersect the volume
+	 */
+	static bool toVolume(voxel::RawVolume* volume, const MementoData& mementoData);
 	/**
 	 * @brief Converts the given volume into a @c MementoData structure (and perform the compression)
 	 * @param[in] volume The volume to create the memento state for. This might be @c null.
 	 */
 	static MementoData fromVolume(const voxel::RawVolume* volume);
+	/**
+	 * @brief Only compresses the voxels of the given region of the volume
+	 * @note The region is cropped to the region of the volume
+	 */
+	static MementoData fromVolume(const voxel::RawVolume* volume, const voxel::Region& region);
 };
 
 struct MementoState {
 	MementoType type;
 	MementoData data;
+	/**
+	 * @brief The voxels of the modified region before the modification. Only delta states have this - the other
+	 * states are undone by returning to the data of the previous state.
+	 */
+	MementoData previousData;
 	int layer;
 	core::String name;
 	/**
@@ -100,6 +129,14 @@ struct MementoState {
 		return data._buffer != nullptr;
 	}
 
+	/**
+	 * @brief Delta states have to be applied in place to the existing volume of the layer
+	 * @sa MementoData::toVolume(voxel::RawVolume*, const MementoData&)
+	 */
+	inline bool isDelta() const {
+		return data._delta;
+	}
+
 	inline const voxel::Region& dataRegion() const {
 		return data._region;
 	}
@@ -107,14 +144,40 @@ struct MementoState {
 
 /**
  * @brief Class that manages the undo and redo steps for the scene
+ *
+ * Modifications of a known region are stored as region deltas - the voxels of the region before and after
+ * the modification. The amount of states is limited by the memory of the compressed buffers and the layer volumes.
  */
 class MementoHandler : public core::IComponent {
 private:
 	core::DynamicArray<MementoState> _states;
-	uint8_t _statePosition = 0u;
+	int _statePosition = 0;
 	int _locked = 0;
+	/**
+	 * @brief The size of all compressed buffers of the states and of the uncompressed layer volumes
+	 */
+	size_t _memory = 0u;
+	core::VarPtr _maxMemory;
+	/**
+	 * @brief The volumes of the layers at the current state position. They provide the voxels of a modified
+	 * region before the modification. @c nullptr if the next modification of the layer has to store the whole volume.
+	 */
+	core::DynamicArray<voxel::RawVolume*> _volumes;
+
+	voxel::RawVolume* layerVolume(int layer) const;
+	void setLayerVolume(int layer, voxel::RawVolume* volume);
+	/**
+	 * @brief Replaces the region delta of the given state by the whole volume of the layer. This is needed
+	 * if the following state is undone by returning to the data of this state.
+	 */
+	void storeWholeVolume(MementoState& state);
+	size_t maxMemory() const;
+	void removeStates(int from, int to);
 public:
-	static const int MaxStates;
+	/**
+	 * @brief The memory budget in megabytes if the cvar isn't available
+	 */
+	static constexpr int DefaultMaxMemory = 256;
 
 	MementoHandler();
 	~MementoHandler();
@@ -139,11 +202,13 @@ public:
 	 * @brief Add a new state entry to the memento handler that you can return to.
 	 * @note This is adding the current active state to the handler - you can then undo to the previous state.
 	 * That is the reason why you always have to add the initial (maybe empty) state, too
-	 * @note Keep in mind, that there is a maximum of states that can get handled here.
+	 * @note Keep in mind, that the oldest states are removed if the memory budget is exceeded.
 	 * @param[in] layer The layer id that was modified
 	 * @param[in] name The name of the layer
 	 * @param[in] volume The state of the volume
 	 * @param[in] type The @c MementoType - has influence on undo() and redo() state position changes.
+	 * @param[in] region The modified region. If this is valid and the volume of the layer wasn't replaced, only
+	 * the voxels of this region are stored.
 	 */
 	void markUndo(int layer, const core::String& name, const voxel::RawVolume* volume, MementoType type = MementoType::Modification, const voxel::Region& region = voxel::Region::InvalidRegion);
 	void markLayerDeleted(int layer, const core::String& name, const voxel::RawVolume* volume);
@@ -151,10 +216,14 @@ public:
 
 	/**
 	 * @note Keep in mind that the returned state contains memory for the voxel::RawVolume that you take ownership for
+	 * @note If the returned state is a delta state (@c MementoState::isDelta()), the data must be applied to the
+	 * existing volume of the layer.
 	 */
 	MementoState undo();
 	/**
 	 * @note Keep in mind that the returned state contains memory for the voxel::RawVolume that you take ownership for
+	 * @note If the returned state is a delta state (@c MementoState::isDelta()), the data must be applied to the
+	 * existing volume of the layer.
 	 */
 	MementoState redo();
 	bool canUndo() const;
@@ -163,7 +232,11 @@ public:
 	const MementoState& state() const;
 
 	size_t stateSize() const;
-	uint8_t statePosition() const;
+	int statePosition() const;
+	/**
+	 * @return The size of the compressed buffers of all states in bytes
+	 */
+	size_t memory() const;
 };
 
 /**
@@ -187,10 +260,14 @@ inline const MementoState& MementoHandler::state() const {
 	return _states[_statePosition];
 }
 
-inline uint8_t MementoHandler::statePosition() const {
+inline int MementoHandler::statePosition() const {
 	return _statePosition;
 }
 
+inline size_t MementoHandler::memory() const {
+	return _memory;
+}
+
 inline size_t MementoHandler::stateSize() const {
 	return _states.size();
 }
@@ -212,7 +289,7 @@ inline bool MementoHandler::canRedo() const {
 	if (_states.empty()) {
 		return false;
 	}
-	return _statePosition < stateSize() - 1;
+	return _statePosition < (int)stateSize() - 1;
 }
 
 }
@@ -439,6 +439,15 @@ void SceneManager::undo() {
 		_layerMgr.rename(s.layer, s.name);
 		return;
 	}
+	if (s.isDelta()) {
+		voxel::RawVolume* v = volume(s.layer);
+		if (v == nullptr || !MementoData::toVolume(v, s.data)) {
+			Log::warn("Failed to apply the undo state to layer %i", s.layer);
+			return;
+		}
+		modified(s.layer, s.region, false);
+		return;
+	}
 	voxel::RawVolume* v = MementoData::toVolume(s.data);
 	if (v == nullptr) {
 		_layerMgr.deleteLayer(s.layer, false);
@@ -504,6 +513,15 @@ void SceneManager::redo() {
 		_layerMgr.rename(s.layer, s.name);
 		return;
 	}
+	if (s.isDelta()) {
+		voxel::RawVolume* v = volume(s.layer);
+		if (v == nullptr || !MementoData::toVolume(v, s.data)) {
+			Log::warn("Failed to apply the redo state to layer %i", s.layer);
+			return;
+		}
+		modified(s.layer, s.region, false);
+		return;
+	}
 	voxel::RawVolume* v = MementoData::toVolume(s.data);
 	if (v == nullptr) {
 		_layerMgr.deleteLayer(s.layer, false);
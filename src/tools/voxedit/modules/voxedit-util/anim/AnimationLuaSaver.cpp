@@ -59,6 +59,7 @@ bool saveAnimationEntityLua(const animation::AnimationSettings& settings, const
 	}
 	wrapBool(stream.addString("  return attributes\n", false))
 	wrapBool(stream.addString("end\n", false))
+	wrapBool(stream.flush())
 	return true;
 }
 
@@ -4,6 +4,8 @@
 
 #include "app/tests/AbstractTest.h"
 #include "../MementoHandler.h"
+#include "../Config.h"
+#include "core/Var.h"
 #include "voxel/RawVolume.h"
 #include <memory>
 
@@ -17,6 +19,15 @@ protected:
 		EXPECT_EQ(size, region.getWidthInVoxels());
 		return std::make_shared<voxel::RawVolume>(region);
 	}
+	void fill(voxel::RawVolume* volume, const voxel::Region& region, uint8_t color) const {
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					volume->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, color));
+				}
+			}
+		}
+	}
 	void SetUp() override {
 		ASSERT_TRUE(mementoHandler.init());
 	}
@@ -114,12 +125,108 @@ TEST_F(MementoHandlerTest, testUndoRedoDifferentLayers) {
 	EXPECT_EQ(2, undoState.dataRegion().getWidthInVoxels());
 }
 
-TEST_F(MementoHandlerTest, testMaxUndoStates) {
-	for (int i = 0; i < MementoHandler::MaxStates * 2; ++i) {
-		auto v = create(1);
-		mementoHandler.markUndo(i, "", v.get());
+TEST_F(MementoHandlerTest, testMaxUndoMemory) {
+	core::Var::get(cfg::VoxEditMaxUndoMemory, "")->setVal(1);
+	const int states = 16;
+	for (int i = 0; i < states; ++i) {
+		// the copy of the layer volume is part of the budget, too
+		auto v = create(48);
+		uint32_t seed = i + 1;
+		const voxel::Region& region = v->region();
+		for (int z = region.getLowerZ(); z <= region.getUpperZ(); ++z) {
+			for (int y = region.getLowerY(); y <= region.getUpperY(); ++y) {
+				for (int x = region.getLowerX(); x <= region.getUpperX(); ++x) {
+					seed = seed * 1103515245u + 12345u;
+					v->setVoxel(x, y, z, voxel::createVoxel(voxel::VoxelType::Generic, (seed >> 16) & 0xff));
+				}
+			}
+		}
+		mementoHandler.markUndo(0, "", v.get());
 	}
-	ASSERT_EQ(MementoHandler::MaxStates, (int)mementoHandler.stateSize());
+	EXPECT_GE((int)mementoHandler.stateSize(), 2);
+	EXPECT_LT((int)mementoHandler.stateSize(), states);
+	EXPECT_LE(mementoHandler.memory(), 1024u * 1024u);
+	EXPECT_EQ((int)mementoHandler.stateSize() - 1, mementoHandler.statePosition());
+	core::Var::get(cfg::VoxEditMaxUndoMemory, "")->setVal(MementoHandler::DefaultMaxMemory);
+}
+
+TEST_F(MementoHandlerTest, testRegionDelta) {
+	std::shared_ptr<voxel::RawVolume> volume = create(32);
+	mementoHandler.markUndo(0, "Layer 1", volume.get());
+	const size_t initialMemory = mementoHandler.memory();
+	EXPECT_GE(initialMemory, (size_t)volume->region().voxels() * sizeof(voxel::Voxel)) << "The copy of the layer volume should be accounted";
+
+	const voxel::Region first(glm::ivec3(2), glm::ivec3(5));
+	fill(volume.get(), first, 1);
+	mementoHandler.markUndo(0, "Layer 1", volume.get(), MementoType::Modification, first);
+	const voxel::Region second(glm::ivec3(4), glm::ivec3(9));
+	fill(volume.get(), second, 2);
+	mementoHandler.markUndo(0, "Layer 1", volume.get(), MementoType::Modification, second);
+	EXPECT_EQ(3, (int)mementoHandler.stateSize());
+	EXPECT_TRUE(mementoHandler.state().isDelta());
+	EXPECT_EQ(second, mementoHandler.state().dataRegion());
+
+	MementoState state = mementoHandler.undo();
+	ASSERT_TRUE(state.isDelta());
+	EXPECT_EQ(0, state.layer);
+	EXPECT_EQ(second, state.region);
+	ASSERT_TRUE(MementoData::toVolume(volume.get(), state.data));
+	EXPECT_EQ(1, volume->voxel(4, 4, 4).getColor()) << "The voxels of the first modification should be restored";
+	EXPECT_TRUE(voxel::isAir(volume->voxel(9, 9, 9).getMaterial()));
+	EXPECT_EQ(1, volume->voxel(2, 2, 2).getColor());
+
+	state = mementoHandler.undo();
+	ASSERT_TRUE(state.isDelta());
+	ASSERT_TRUE(MementoData::toVolume(volume.get(), state.data));
+	EXPECT_TRUE(voxel::isAir(volume->voxel(2, 2, 2).getMaterial()));
+	EXPECT_TRUE(voxel::isAir(volume->voxel(4, 4, 4).getMaterial()));
+	EXPECT_FALSE(mementoHandler.canUndo());
+
+	state = mementoHandler.redo();
+	ASSERT_TRUE(state.isDelta());
+	ASSERT_TRUE(MementoData::toVolume(volume.get(), state.data));
+	EXPECT_EQ(1, volume->voxel(4, 4, 4).getColor());
+	state = mementoHandler.redo();
+	ASSERT_TRUE(state.isDelta());
+	ASSERT_TRUE(MementoData::toVolume(volume.get(), state.data));
+	EXPECT_EQ(2, volume->voxel(4, 4, 4).getColor());
+	EXPECT_EQ(2, volume->voxel(9, 9, 9).getColor());
+	EXPECT_FALSE(mementoHandler.canRedo());
+	EXPECT_LT(mementoHandler.memory() - initialMemory, initialMemory * 2) << "The deltas should be smaller than the volume";
+}
+
+TEST_F(MementoHandlerTest, testRegionDeltaFollowedByVolume) {
+	std::shared_ptr<voxel::RawVolume> volume = create(16);
+	mementoHandler.markUndo(0, "Layer 1", volume.get());
+	const voxel::Region region(glm::ivec3(1), glm::ivec3(3));
+	fill(volume.get(), region, 1);
+	mementoHandler.markUndo(0, "Layer 1", volume.get(), MementoType::Modification, region);
+	EXPECT_TRUE(mementoHandler.state().isDelta());
+
+	// the volume is replaced - e.g. by a resize
+	std::shared_ptr<voxel::RawVolume> resized = create(8);
+	mementoHandler.markUndo(0, "Layer 1", resized.get(), MementoType::Modification, resized->region());
+	EXPECT_FALSE(mementoHandler.state().isDelta());
+
+	MementoState state = mementoHandler.undo();
+	ASSERT_FALSE(state.isDelta()) << "Undoing the replacement must return the whole volume of the previous state";
+	voxel::RawVolume* v = MementoData::toVolume(state.data);
+	ASSERT_NE(nullptr, v);
+	EXPECT_EQ(16, v->region().getWidthInVoxels());
+	EXPECT_EQ(1, v->voxel(2, 2, 2).getColor());
+	EXPECT_TRUE(voxel::isAir(v->voxel(4, 4, 4).getMaterial()));
+
+	// the undo restored the volume of the layer - the next modification is a delta again
+	const voxel::Region region2(glm::ivec3(5), glm::ivec3(6));
+	fill(v, region2, 3);
+	mementoHandler.markUndo(0, "Layer 1", v, MementoType::Modification, region2);
+	EXPECT_TRUE(mementoHandler.state().isDelta());
+	state = mementoHandler.undo();
+	ASSERT_TRUE(state.isDelta());
+	ASSERT_TRUE(MementoData::toVolume(v, state.data));
+	EXPECT_TRUE(voxel::isAir(v->voxel(5, 5, 5).getMaterial()));
+	EXPECT_EQ(1, v->voxel(2, 2, 2).getColor());
+	delete v;
 }
 
 TEST_F(MementoHandlerTest, testAddNewLayer) {